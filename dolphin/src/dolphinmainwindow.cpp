@@ -65,7 +65,6 @@
 #include <KMenu>
 #include <KMenuBar>
 #include <KMessageBox>
-#include <KFileItemListProperties>
 #include <konqmimedata.h>
 #include <KProtocolInfo>
 #include <KRun>
@@ -382,7 +381,7 @@ void DolphinMainWindow::slotEditableStateChanged(bool editable)
     editableLocationAction->setChecked(editable);
 }
 
-void DolphinMainWindow::slotSelectionChanged(const KFileItemList& selection)
+void DolphinMainWindow::slotSelectionChanged(const DolphinSelectionSnapshot& selection)
 {
     updateEditActions();
 
@@ -1694,8 +1693,8 @@ void DolphinMainWindow::setupDockWidgets()
     addDockWidget(Qt::RightDockWidgetArea, infoDock);
     connect(this, SIGNAL(urlChanged(KUrl)),
             infoPanel, SLOT(setUrl(KUrl)));
-    connect(this, SIGNAL(selectionChanged(KFileItemList)),
-            infoPanel, SLOT(setSelection(KFileItemList)));
+    connect(this, SIGNAL(selectionChanged(DolphinSelectionSnapshot)),
+            infoPanel, SLOT(setSelection(DolphinSelectionSnapshot)));
     connect(this, SIGNAL(requestItemInfo(KFileItem)),
             infoPanel, SLOT(requestDelayedItemInfo(KFileItem)));
 
@@ -1796,8 +1795,8 @@ void DolphinMainWindow::setupDockWidgets()
 
 void DolphinMainWindow::updateEditActions()
 {
-    const KFileItemList list = m_activeViewContainer->view()->selectedItems();
-    if (list.isEmpty()) {
+    const DolphinSelectionSnapshot selection = m_activeViewContainer->view()->selection();
+    if (selection.isEmpty()) {
         stateChanged("has_no_selection");
     } else {
         stateChanged("has_selection");
@@ -1809,14 +1808,15 @@ void DolphinMainWindow::updateEditActions()
         QAction* cutAction         = col->action(KStandardAction::name(KStandardAction::Cut));
         QAction* deleteWithTrashShortcut = col->action("delete_shortcut"); // see DolphinViewActionHandler
 
-        KFileItemListProperties capabilities(list);
-        const bool enableMoveToTrash = capabilities.isLocal() && capabilities.supportsMoving();
+        // The capabilities are calculated by the snapshot without creating a
+        // KFileItemList, and they are shared with other users of the snapshot.
+        const bool enableMoveToTrash = selection.isLocal() && selection.supportsMoving();
 
-        renameAction->setEnabled(capabilities.supportsMoving());
+        renameAction->setEnabled(selection.supportsMoving());
         moveToTrashAction->setEnabled(enableMoveToTrash);
-        deleteAction->setEnabled(capabilities.supportsDeleting());
-        deleteWithTrashShortcut->setEnabled(capabilities.supportsDeleting() && !enableMoveToTrash);
-        cutAction->setEnabled(capabilities.supportsMoving());
+        deleteAction->setEnabled(selection.supportsDeleting());
+        deleteWithTrashShortcut->setEnabled(selection.supportsDeleting() && !enableMoveToTrash);
+        cutAction->setEnabled(selection.supportsMoving());
     }
     updatePasteAction();
 }
@@ -1985,8 +1985,8 @@ void DolphinMainWindow::connectViewSignals(DolphinViewContainer* container)
             this, SLOT(slotWriteStateChanged(bool)));
 
     DolphinView* view = container->view();
-    connect(view, SIGNAL(selectionChanged(KFileItemList)),
-            this, SLOT(slotSelectionChanged(KFileItemList)));
+    connect(view, SIGNAL(selectionChanged(DolphinSelectionSnapshot)),
+            this, SLOT(slotSelectionChanged(DolphinSelectionSnapshot)));
     connect(view, SIGNAL(requestItemInfo(KFileItem)),
             this, SLOT(slotRequestItemInfo(KFileItem)));
     connect(view, SIGNAL(activated()),
@@ -41,6 +41,7 @@ class DolphinApplication;
 class DolphinSettingsDialog;
 class DolphinViewContainer;
 class DolphinRemoteEncoding;
+class DolphinSelectionSnapshot;
 class KAction;
 class KFileItem;
 class KFileItemList;
@@ -137,7 +138,7 @@ signals:
      * Is sent if the selection of the currently active view has
      * been changed.
      */
-    void selectionChanged(const KFileItemList& selection);
+    void selectionChanged(const DolphinSelectionSnapshot& selection);
 
     /**
      * Is sent if the url of the currently active view has
@@ -331,7 +332,7 @@ private slots:
      * Updates the state of the 'Edit' menu actions and emits
      * the signal selectionChanged().
      */
-    void slotSelectionChanged(const KFileItemList& selection);
+    void slotSelectionChanged(const DolphinSelectionSnapshot& selection);
 
     /** Emits the signal requestItemInfo(). */
     void slotRequestItemInfo(const KFileItem&);
@@ -59,6 +59,7 @@
 #include <QClipboard>
 #include <QDir>
 #include <QTextDocument>
+#include <QTimer>
 
 K_PLUGIN_FACTORY(DolphinPartFactory, registerPlugin<DolphinPart>();)
 K_EXPORT_PLUGIN(DolphinPartFactory("dolphinpart", "dolphin"))
@@ -67,6 +68,7 @@ DolphinPart::DolphinPart(QWidget* parentWidget, QObject* parent, const QVariantL
     : KParts::ReadOnlyPart(parent)
       ,m_openTerminalAction(0)
       ,m_removeAction(0)
+      ,m_selectionInfoTimer(0)
 {
     Q_UNUSED(args)
     setComponentData(DolphinPartFactory::componentData(), false);
@@ -102,10 +104,8 @@ DolphinPart::DolphinPart(QWidget* parentWidget, QObject* parent, const QVariantL
             this, SLOT(createNewWindow(KUrl)));
     connect(m_view, SIGNAL(requestContextMenu(QPoint,KFileItem,KUrl,QList<QAction*>)),
             this, SLOT(slotOpenContextMenu(QPoint,KFileItem,KUrl,QList<QAction*>)));
-    connect(m_view, SIGNAL(selectionChanged(KFileItemList)),
-            m_extension, SIGNAL(selectionInfo(KFileItemList)));
-    connect(m_view, SIGNAL(selectionChanged(KFileItemList)),
-            this, SLOT(slotSelectionChanged(KFileItemList)));
+    connect(m_view, SIGNAL(selectionChanged(DolphinSelectionSnapshot)),
+            this, SLOT(slotSelectionChanged(DolphinSelectionSnapshot)));
     connect(m_view, SIGNAL(requestItemInfo(KFileItem)),
             this, SLOT(slotRequestItemInfo(KFileItem)));
     connect(m_view, SIGNAL(modeChanged(DolphinView::Mode,DolphinView::Mode)),
@@ -116,7 +116,15 @@ DolphinPart::DolphinPart(QWidget* parentWidget, QObject* parent, const QVariantL
     // Watch for changes that should result in updates to the
     // status bar text.
     connect(m_view, SIGNAL(itemCountChanged()), this, SLOT(updateStatusBar()));
-    connect(m_view,  SIGNAL(selectionChanged(KFileItemList)), this, SLOT(updateStatusBar()));
+    connect(m_view,  SIGNAL(selectionChanged(DolphinSelectionSnapshot)), this, SLOT(updateStatusBar()));
+
+    // The browser extension expects a list of all selected items. Creating it
+    // for each change of a large selection, e.g. when selecting items with
+    // the rubberband, is expensive, so the host is informed delayed.
+    m_selectionInfoTimer = new QTimer(this);
+    m_selectionInfoTimer->setSingleShot(true);
+    m_selectionInfoTimer->setInterval(300);
+    connect(m_selectionInfoTimer, SIGNAL(timeout()), this, SLOT(emitSelectionInfo()));
 
     m_actionHandler = new DolphinViewActionHandler(actionCollection(), this);
     m_actionHandler->setCurrentView(m_view);
@@ -149,7 +157,7 @@ DolphinPart::DolphinPart(QWidget* parentWidget, QObject* parent, const QVariantL
 
     createActions();
     m_actionHandler->updateViewActions();
-    slotSelectionChanged(KFileItemList()); // initially disable selection-dependent actions
+    slotSelectionChanged(DolphinSelectionSnapshot()); // initially disable selection-dependent actions
 
     // Listen to events from the app so we can update the remove key by
     // checking for a Shift key press.
@@ -255,7 +263,7 @@ void DolphinPart::slotGoTriggered(QAction* action)
     emit m_extension->openUrlRequest(KUrl(url));
 }
 
-void DolphinPart::slotSelectionChanged(const KFileItemList& selection)
+void DolphinPart::slotSelectionChanged(const DolphinSelectionSnapshot& selection)
 {
     const bool hasSelection = !selection.isEmpty();
 
@@ -278,18 +286,30 @@ void DolphinPart::slotSelectionChanged(const KFileItemList& selection)
 
         // TODO share this code with DolphinMainWindow::updateEditActions (and the desktop code)
         // in libkonq
-        KFileItemListProperties capabilities(selection);
-        const bool enableMoveToTrash = capabilities.isLocal() && capabilities.supportsMoving();
+        const bool enableMoveToTrash = selection.isLocal() && selection.supportsMoving();
 
-        renameAction->setEnabled(capabilities.supportsMoving());
+        renameAction->setEnabled(selection.supportsMoving());
         moveToTrashAction->setEnabled(enableMoveToTrash);
-        deleteAction->setEnabled(capabilities.supportsDeleting());
-        deleteWithTrashShortcut->setEnabled(capabilities.supportsDeleting() && !enableMoveToTrash);
+        deleteAction->setEnabled(selection.supportsDeleting());
+        deleteWithTrashShortcut->setEnabled(selection.supportsDeleting() && !enableMoveToTrash);
         editMimeTypeAction->setEnabled(true);
         propertiesAction->setEnabled(true);
-        emit m_extension->enableAction("cut", capabilities.supportsMoving());
+        emit m_extension->enableAction("cut", selection.supportsMoving());
         emit m_extension->enableAction("copy", true);
     }
+
+    if (hasSelection) {
+        m_selectionInfoTimer->start();
+    } else {
+        // Clearing the selection is cheap and is passed immediately.
+        m_selectionInfoTimer->stop();
+        emit m_extension->selectionInfo(KFileItemList());
+    }
+}
+
+void DolphinPart::emitSelectionInfo()
+{
+    emit m_extension->selectionInfo(m_view->selection().items());
 }
 
 void DolphinPart::updatePasteAction()
@@ -29,12 +29,14 @@
 class DolphinNewFileMenu;
 class DolphinViewActionHandler;
 class QActionGroup;
+class QTimer;
 class KAction;
 class KFileItemList;
 class KFileItem;
 class DolphinPartBrowserExtension;
 class DolphinSortFilterProxyModel;
 class DolphinRemoteEncoding;
+class DolphinSelectionSnapshot;
 class DolphinModel;
 class KDirLister;
 class DolphinView;
@@ -160,10 +162,16 @@ private Q_SLOTS:
     void slotDirectoryRedirection(const KUrl& oldUrl, const KUrl& newUrl);
 
     /**
-     * Updates the state of the 'Edit' menu actions and emits
-     * the signal selectionChanged().
+     * Updates the state of the 'Edit' menu actions and informs
+     * the browser extension about the selection.
      */
-    void slotSelectionChanged(const KFileItemList& selection);
+    void slotSelectionChanged(const DolphinSelectionSnapshot& selection);
+
+    /**
+     * Informs the browser extension about the current selection. Is invoked
+     * delayed by slotSelectionChanged().
+     */
+    void emitSelectionInfo();
 
     /**
      * Updates the text of the paste action dependent from
@@ -249,6 +257,7 @@ private:
     KAction* m_openTerminalAction;
     QString m_nameFilter;
     DolphinRemoveAction* m_removeAction;
+    QTimer* m_selectionInfoTimer;
     Q_DISABLE_COPY(DolphinPart)
 };
 
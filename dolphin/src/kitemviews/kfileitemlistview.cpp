@@ -47,13 +47,21 @@ namespace {
     // the expensive re-generation of all previews is triggered repeatedly when
     // chaning the zoom level.
     const int LongInterval = 300;
+
+    // While scrolling, KFileItemModelRolesUpdater is informed about the
+    // visible index range and the scroll velocity every PrefetchInterval ms,
+    // so that it can prefetch the roles and previews for the pages ahead.
+    const int PrefetchInterval = 100;
 }
 
 KFileItemListView::KFileItemListView(QGraphicsWidget* parent) :
     KStandardItemListView(parent),
     m_modelRolesUpdater(0),
     m_updateVisibleIndexRangeTimer(0),
-    m_updateIconSizeTimer(0)
+    m_updateIconSizeTimer(0),
+    m_prefetchTimer(0),
+    m_scrollVelocity(0),
+    m_scrollVelocityTimer()
 {
     setAcceptDrops(true);
 
@@ -69,6 +77,11 @@ KFileItemListView::KFileItemListView(QGraphicsWidget* parent) :
     m_updateIconSizeTimer->setInterval(LongInterval);
     connect(m_updateIconSizeTimer, SIGNAL(timeout()), this, SLOT(updateIconSize()));
 
+    m_prefetchTimer = new QTimer(this);
+    m_prefetchTimer->setSingleShot(true);
+    m_prefetchTimer->setInterval(PrefetchInterval);
+    connect(m_prefetchTimer, SIGNAL(timeout()), this, SLOT(updatePrefetchRange()));
+
     setVisibleRoles(QList<QByteArray>() << "text");
 }
 
@@ -119,7 +132,7 @@ QStringList KFileItemListView::enabledPlugins() const
     return m_modelRolesUpdater ? m_modelRolesUpdater->enabledPlugins() : QStringList();
 }
 
-QPixmap KFileItemListView::createDragPixmap(const QSet<int>& indexes) const
+QPixmap KFileItemListView::createDragPixmap(const KItemSet& indexes) const
 {
     if (!model()) {
         return QPixmap();
@@ -165,10 +178,7 @@ QPixmap KFileItemListView::createDragPixmap(const QSet<int>& indexes) const
     QPainter painter(&dragPixmap);
     int x = 0;
     int y = 0;
-    QSetIterator<int> it(indexes);
-    while (it.hasNext()) {
-        const int index = it.next();
-
+    foreach (int index, indexes) {
         QPixmap pixmap = model()->data(index).value("iconPixmap").value<QPixmap>();
         if (pixmap.isNull()) {
             KIcon icon(model()->data(index).value("iconName").toString());
@@ -257,7 +267,21 @@ void KFileItemListView::onItemSizeChanged(const QSizeF& current, const QSizeF& p
 void KFileItemListView::onScrollOffsetChanged(qreal current, qreal previous)
 {
     KStandardItemListView::onScrollOffsetChanged(current, previous);
-    triggerVisibleIndexRangeUpdate();
+    if (!model()) {
+        return;
+    }
+
+    updateScrollVelocity(current - previous);
+
+    // KFileItemModelRolesUpdater is not paused while scrolling. Instead, it
+    // prefetches the roles and previews for the items that get visible next.
+    // The visible index range is updated as soon as the scrolling has stopped.
+    if (!m_updateIconSizeTimer->isActive()) {
+        m_updateVisibleIndexRangeTimer->start();
+        if (m_scrollVelocity != 0 && !m_prefetchTimer->isActive()) {
+            m_prefetchTimer->start();
+        }
+    }
 }
 
 void KFileItemListView::onVisibleRolesChanged(const QList<QByteArray>& current, const QList<QByteArray>& previous)
@@ -343,6 +367,8 @@ void KFileItemListView::updateVisibleIndexRange()
         return;
     }
 
+    resetScrollVelocity();
+
     const int index = firstVisibleIndex();
     const int count = lastVisibleIndex() - index + 1;
     m_modelRolesUpdater->setMaximumVisibleItems(maximumVisibleItems());
@@ -350,6 +376,19 @@ void KFileItemListView::updateVisibleIndexRange()
     m_modelRolesUpdater->setPaused(isTransactionActive());
 }
 
+void KFileItemListView::updatePrefetchRange()
+{
+    if (!m_modelRolesUpdater || isTransactionActive()) {
+        return;
+    }
+
+    const int index = firstVisibleIndex();
+    const int count = lastVisibleIndex() - index + 1;
+    m_modelRolesUpdater->setMaximumVisibleItems(maximumVisibleItems());
+    m_modelRolesUpdater->setScrollVelocity(m_scrollVelocity);
+    m_modelRolesUpdater->setVisibleIndexRange(index, count);
+}
+
 void KFileItemListView::triggerIconSizeUpdate()
 {
     if (!model()) {
@@ -362,6 +401,7 @@ void KFileItemListView::triggerIconSizeUpdate()
     // Stop m_updateVisibleIndexRangeTimer to prevent an expensive re-generation
     // of all previews (note that the user might change the icon size again soon).
     m_updateVisibleIndexRangeTimer->stop();
+    m_prefetchTimer->stop();
 }
 
 void KFileItemListView::updateIconSize()
@@ -370,6 +410,7 @@ void KFileItemListView::updateIconSize()
         return;
     }
 
+    resetScrollVelocity();
     m_modelRolesUpdater->setIconSize(availableIconSize());
 
     // Update the visible index range (which has most likely changed after the
@@ -423,4 +464,40 @@ QSize KFileItemListView::availableIconSize() const
     return QSize(iconSize, iconSize);
 }
 
+void KFileItemListView::updateScrollVelocity(qreal distance)
+{
+    qint64 elapsed = -1;
+    if (m_scrollVelocityTimer.isValid()) {
+        elapsed = m_scrollVelocityTimer.restart();
+    } else {
+        m_scrollVelocityTimer.start();
+    }
+
+    const qreal pageSize = (scrollOrientation() == Qt::Vertical) ? size().height() : size().width();
+    if (elapsed < 0 || elapsed > ShortInterval || pageSize <= 0) {
+        // The scrolling has just been started, so the velocity is still unknown
+        m_scrollVelocity = 0;
+        return;
+    }
+
+    const qreal velocity = distance / pageSize * 1000 / qMax(qint64(1), elapsed);
+    if (m_scrollVelocity == 0 || (velocity > 0) != (m_scrollVelocity > 0)) {
+        m_scrollVelocity = velocity;
+    } else {
+        // The intervals between the scroll steps vary, so the
+        // velocity is smoothed to get a stable prefetch range
+        m_scrollVelocity = (m_scrollVelocity + velocity) / 2;
+    }
+}
+
+void KFileItemListView::resetScrollVelocity()
+{
+    m_prefetchTimer->stop();
+    m_scrollVelocity = 0;
+    m_scrollVelocityTimer.invalidate();
+    if (m_modelRolesUpdater) {
+        m_modelRolesUpdater->setScrollVelocity(0);
+    }
+}
+
 #include "kfileitemlistview.moc"
@@ -24,6 +24,8 @@
 
 #include <kitemviews/kstandarditemlistview.h>
 
+#include <QElapsedTimer>
+
 class KFileItemModelRolesUpdater;
 class QTimer;
 
@@ -73,7 +75,7 @@ public:
     QStringList enabledPlugins() const;
 
     /** @reimp */
-    virtual QPixmap createDragPixmap(const QSet<int>& indexes) const;
+    virtual QPixmap createDragPixmap(const KItemSet& indexes) const;
 
 protected:
     virtual KItemListWidgetCreatorBase* defaultWidgetCreator() const;
@@ -99,6 +101,13 @@ private slots:
     void triggerVisibleIndexRangeUpdate();
     void updateVisibleIndexRange();
 
+    /**
+     * Informs KFileItemModelRolesUpdater about the visible index range and
+     * the scroll velocity while scrolling, so that the roles and previews for
+     * the pages ahead can be prefetched.
+     */
+    void updatePrefetchRange();
+
     void triggerIconSizeUpdate();
     void updateIconSize();
 
@@ -118,10 +127,23 @@ private:
      */
     QSize availableIconSize() const;
 
+    /**
+     * Updates m_scrollVelocity after the scroll offset has been
+     * changed by \a distance.
+     */
+    void updateScrollVelocity(qreal distance);
+    void resetScrollVelocity();
+
 private:
     KFileItemModelRolesUpdater* m_modelRolesUpdater;
     QTimer* m_updateVisibleIndexRangeTimer;
     QTimer* m_updateIconSizeTimer;
+    QTimer* m_prefetchTimer;
+
+    // Velocity of the scrolling in pages per second, see
+    // KFileItemModelRolesUpdater::setScrollVelocity()
+    qreal m_scrollVelocity;
+    QElapsedTimer m_scrollVelocityTimer;
 
     friend class KFileItemListViewTest; // For unit testing
 };
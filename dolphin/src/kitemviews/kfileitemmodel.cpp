@@ -32,10 +32,13 @@
 
 #include <QApplication>
 #include <QMimeData>
+#include <QMutex>
 #include <QTimer>
+#include <QWaitCondition>
 #include <QWidget>
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 // #define KFILEITEMMODEL_DEBUG
@@ -51,12 +54,15 @@ KFileItemModel::KFileItemModel(QObject* parent) :
     m_caseSensitivity(Qt::CaseInsensitive),
     m_itemData(),
     m_items(),
+    m_roleStore(),
     m_filter(),
     m_filteredItems(),
     m_requestRole(),
     m_maximumUpdateIntervalTimer(0),
     m_resortAllItemsTimer(0),
+    m_itemsToResort(),
     m_pendingItemsToInsert(),
+    m_pendingRunLengths(),
     m_groups(),
     m_expandedDirs(),
     m_urlsToExpand()
@@ -105,13 +111,14 @@ KFileItemModel::KFileItemModel(QObject* parent) :
     m_resortAllItemsTimer = new QTimer(this);
     m_resortAllItemsTimer->setInterval(500);
     m_resortAllItemsTimer->setSingleShot(true);
-    connect(m_resortAllItemsTimer, SIGNAL(timeout()), this, SLOT(resortAllItems()));
+    connect(m_resortAllItemsTimer, SIGNAL(timeout()), this, SLOT(resortChangedItems()));
 
     connect(KGlobalSettings::self(), SIGNAL(naturalSortingChanged()), this, SLOT(slotNaturalSortingChanged()));
 }
 
 KFileItemModel::~KFileItemModel()
 {
+    discardSortingBatches();
     qDeleteAll(m_itemData);
     qDeleteAll(m_filteredItems.values());
     qDeleteAll(m_pendingItemsToInsert);
@@ -152,7 +159,10 @@ int KFileItemModel::count() const
 QHash<QByteArray, QVariant> KFileItemModel::data(int index) const
 {
     if (index >= 0 && index < count()) {
-        return m_itemData.at(index)->values;
+        const ItemData* itemData = m_itemData.at(index);
+        QHash<QByteArray, QVariant> values = m_roleStore.values(itemData->slot);
+        values.insert(sharedValue("url"), itemData->item.url());
+        return values;
     }
     return QHash<QByteArray, QVariant>();
 }
@@ -163,7 +173,49 @@ bool KFileItemModel::setData(int index, const QHash<QByteArray, QVariant>& value
         return false;
     }
 
-    QHash<QByteArray, QVariant> currentValues = m_itemData.at(index)->values;
+    const QSet<QByteArray> changedRoles = storeValues(index, values);
+    if (changedRoles.isEmpty()) {
+        return false;
+    }
+
+    emitItemsChangedAndTriggerResorting(KItemRangeList() << KItemRange(index, 1), changedRoles);
+
+    return true;
+}
+
+bool KFileItemModel::setItemsData(const QHash<int, QHash<QByteArray, QVariant> >& values)
+{
+    QList<int> changedIndexes;
+    QSet<QByteArray> changedRoles;
+
+    QHashIterator<int, QHash<QByteArray, QVariant> > it(values);
+    while (it.hasNext()) {
+        it.next();
+        const int index = it.key();
+        if (index < 0 || index >= count()) {
+            continue;
+        }
+
+        const QSet<QByteArray> changedItemRoles = storeValues(index, it.value());
+        if (!changedItemRoles.isEmpty()) {
+            changedIndexes.append(index);
+            changedRoles += changedItemRoles;
+        }
+    }
+
+    if (changedIndexes.isEmpty()) {
+        return false;
+    }
+
+    qSort(changedIndexes);
+    emitItemsChangedAndTriggerResorting(KItemRangeList::fromSortedContainer(changedIndexes), changedRoles);
+
+    return true;
+}
+
+QSet<QByteArray> KFileItemModel::storeValues(int index, const QHash<QByteArray, QVariant>& values)
+{
+    const int slot = m_itemData.at(index)->slot;
 
     // Determine which roles have been changed
     QSet<QByteArray> changedRoles;
@@ -173,26 +225,23 @@ bool KFileItemModel::setData(int index, const QHash<QByteArray, QVariant>& value
         const QByteArray role = sharedValue(it.key());
         const QVariant value = it.value();
 
-        if (currentValues[role] != value) {
-            currentValues[role] = value;
+        if (m_roleStore.value(slot, role) != value) {
+            m_roleStore.setValue(slot, role, value);
             changedRoles.insert(role);
         }
     }
 
-    if (changedRoles.isEmpty()) {
-        return false;
-    }
-
-    m_itemData[index]->values = currentValues;
     if (changedRoles.contains("text")) {
         KUrl url = m_itemData[index]->item.url();
-        url.setFileName(currentValues["text"].toString());
+        m_items.remove(url);
+        url.setFileName(m_roleStore.text(slot));
         m_itemData[index]->item.setUrl(url);
+        m_items.insert(url, index);
+        m_itemData[index]->sortKey = sortKey(m_itemData[index]->item.text());
+        m_itemData[index]->lowerCaseText.clear();
     }
 
-    emitItemsChangedAndTriggerResorting(KItemRangeList() << KItemRange(index, 1), changedRoles);
-
-    return true;
+    return changedRoles;
 }
 
 void KFileItemModel::setSortDirectoriesFirst(bool dirsFirst)
@@ -232,7 +281,7 @@ bool KFileItemModel::showDirectoriesOnly() const
     return m_dirLister->dirOnlyMode();
 }
 
-QMimeData* KFileItemModel::createMimeData(const QSet<int>& indexes) const
+QMimeData* KFileItemModel::createMimeData(const KItemSet& indexes) const
 {
     QMimeData* data = new QMimeData();
 
@@ -243,9 +292,7 @@ QMimeData* KFileItemModel::createMimeData(const QSet<int>& indexes) const
     KUrl::List mostLocalUrls;
     bool canUseMostLocalUrls = true;
 
-    QSetIterator<int> it(indexes);
-    while (it.hasNext()) {
-        const int index = it.next();
+    foreach (int index, indexes) {
         const KFileItem item = fileItem(index);
         if (!item.isNull()) {
             urls << item.targetUrl();
@@ -404,7 +451,8 @@ void KFileItemModel::setRoles(const QSet<QByteArray>& roles)
         // Update m_data with the changed requested roles
         const int maxIndex = count() - 1;
         for (int i = 0; i <= maxIndex; ++i) {
-            m_itemData[i]->values = retrieveData(m_itemData.at(i)->item, m_itemData.at(i)->parent);
+            const ItemData* itemData = m_itemData.at(i);
+            m_roleStore.setValues(itemData->slot, retrieveData(itemData->item, itemData->parent));
         }
 
         kWarning() << "TODO: Emitting itemsChanged() with no information what has changed!";
@@ -452,7 +500,7 @@ bool KFileItemModel::setExpanded(int index, bool expanded)
 bool KFileItemModel::isExpanded(int index) const
 {
     if (index >= 0 && index < count()) {
-        return m_itemData.at(index)->values.value("isExpanded").toBool();
+        return m_roleStore.isExpanded(m_itemData.at(index)->slot);
     }
     return false;
 }
@@ -460,7 +508,7 @@ bool KFileItemModel::isExpanded(int index) const
 bool KFileItemModel::isExpandable(int index) const
 {
     if (index >= 0 && index < count()) {
-        return m_itemData.at(index)->values.value("isExpandable").toBool();
+        return m_roleStore.isExpandable(m_itemData.at(index)->slot);
     }
     return false;
 }
@@ -515,8 +563,7 @@ void KFileItemModel::setNameFilter(const QString& nameFilter)
 {
     if (m_filter.pattern() != nameFilter) {
         dispatchPendingItemsToInsert();
-        m_filter.setPattern(nameFilter);
-        applyFilters();
+        applyFilters(m_filter.setPattern(nameFilter));
     }
 }
 
@@ -529,8 +576,7 @@ void KFileItemModel::setMimeTypeFilters(const QStringList& filters)
 {
     if (m_filter.mimeTypes() != filters) {
         dispatchPendingItemsToInsert();
-        m_filter.setMimeTypes(filters);
-        applyFilters();
+        applyFilters(m_filter.setMimeTypes(filters));
     }
 }
 
@@ -540,43 +586,54 @@ QStringList KFileItemModel::mimeTypeFilters() const
 }
 
 
-void KFileItemModel::applyFilters()
+void KFileItemModel::applyFilters(KFileItemModelFilter::FilterChange change)
 {
-    // Check which shown items from m_itemData must get
-    // hidden and hence moved to m_filteredItems.
-    KFileItemList newFilteredItems;
+    // Check which hidden items from m_filteredItems should
+    // get visible again and hence removed from m_filteredItems.
+    // This is not necessary if the filter has been narrowed.
+    QList<ItemData*> newVisibleItems;
 
-    foreach (ItemData* itemData, m_itemData) {
-        // Only filter non-expanded items as child items may never
-        // exist without a parent item
-        if (!itemData->values.value("isExpanded").toBool()) {
-            const KFileItem item = itemData->item;
-            if (!m_filter.matches(item)) {
-                newFilteredItems.append(item);
-                m_filteredItems.insert(item, itemData);
+    if (change != KFileItemModelFilter::NarrowingChange) {
+        QHash<KFileItem, ItemData*>::iterator it = m_filteredItems.begin();
+        while (it != m_filteredItems.end()) {
+            if (matchesFilter(it.value())) {
+                newVisibleItems.append(it.value());
+                it = m_filteredItems.erase(it);
+            } else {
+                ++it;
             }
         }
     }
 
-    removeItems(newFilteredItems, KeepItemData);
-
-    // Check which hidden items from m_filteredItems should
-    // get visible again and hence removed from m_filteredItems.
-    QList<ItemData*> newVisibleItems;
-
-    QHash<KFileItem, ItemData*>::iterator it = m_filteredItems.begin();
-    while (it != m_filteredItems.end()) {
-        if (m_filter.matches(it.key())) {
-            newVisibleItems.append(it.value());
-            it = m_filteredItems.erase(it);
-        } else {
-            ++it;
+    // Check which shown items from m_itemData must get
+    // hidden and hence moved to m_filteredItems. This is
+    // not necessary if the filter has been widened.
+    if (change != KFileItemModelFilter::WideningChange) {
+        KFileItemList newFilteredItems;
+
+        foreach (ItemData* itemData, m_itemData) {
+            // Only filter non-expanded items as child items may never
+            // exist without a parent item
+            if (!m_roleStore.isExpanded(itemData->slot) && !matchesFilter(itemData)) {
+                newFilteredItems.append(itemData->item);
+                m_filteredItems.insert(itemData->item, itemData);
+            }
         }
+
+        removeItems(newFilteredItems, KeepItemData);
     }
 
     insertItems(newVisibleItems);
 }
 
+bool KFileItemModel::matchesFilter(ItemData* itemData) const
+{
+    if (itemData->lowerCaseText.isEmpty() && !m_filter.pattern().isEmpty()) {
+        itemData->lowerCaseText = itemData->item.text().toLower();
+    }
+    return m_filter.matches(itemData->item, itemData->lowerCaseText);
+}
+
 void KFileItemModel::removeFilteredChildren(const KFileItemList& parentsList)
 {
     if (m_filteredItems.isEmpty()) {
@@ -593,7 +650,7 @@ void KFileItemModel::removeFilteredChildren(const KFileItemList& parentsList)
         const ItemData* parent = it.value()->parent;
 
         if (parent && parents.contains(parent->item)) {
-            delete it.value();
+            deleteItemData(it.value());
             it = m_filteredItems.erase(it);
         } else {
             ++it;
@@ -660,6 +717,9 @@ void KFileItemModel::onSortOrderChanged(Qt::SortOrder current, Qt::SortOrder pre
 void KFileItemModel::resortAllItems()
 {
     m_resortAllItemsTimer->stop();
+    m_itemsToResort.clear();
+
+    resortPendingItemsToInsert();
 
     const int itemCount = count();
     if (itemCount <= 0) {
@@ -735,8 +795,167 @@ void KFileItemModel::resortAllItems()
 #endif
 }
 
+void KFileItemModel::resortChangedItems()
+{
+    m_resortAllItemsTimer->stop();
+
+    if (m_itemsToResort.isEmpty()) {
+        // The order of the items is still correct, but the groups might have
+        // changed (see KFileItemModel::emitItemsChangedAndTriggerResorting()).
+        if (groupedSorting()) {
+            const QList<QPair<int, QVariant> > oldGroups = m_groups;
+            m_groups.clear();
+            if (groups() != oldGroups) {
+                emit groupsChanged();
+            }
+        }
+        return;
+    }
+
+    const int itemCount = count();
+    const int changedCount = m_itemsToResort.count();
+
+    // Moving an expanded item requires to move all its children, too. As the
+    // benefit of a binary search is low if many items have been changed, the
+    // whole model is resorted in these cases.
+    bool resortAll = (changedCount * 8 > itemCount);
+    if (!resortAll) {
+        foreach (const ItemData* itemData, m_itemsToResort) {
+            if (m_roleStore.isExpanded(itemData->slot)) {
+                resortAll = true;
+                break;
+            }
+        }
+    }
+
+    if (resortAll) {
+        resortAllItems();
+        return;
+    }
+
+#ifdef KFILEITEMMODEL_DEBUG
+    QElapsedTimer timer;
+    timer.start();
+    kDebug() << "===========================================================";
+    kDebug() << "Resorting" << changedCount << "of" << itemCount << "items";
+#endif
+
+    // Step 1: Determine the old indexes of the changed items and sort the
+    //         changed items.
+    QList<int> oldIndexes;
+    oldIndexes.reserve(changedCount);
+    foreach (const ItemData* itemData, m_itemsToResort) {
+        oldIndexes.append(m_items.value(itemData->item.url()));
+    }
+    m_itemsToResort.clear();
+    std::sort(oldIndexes.begin(), oldIndexes.end());
+
+    QList<ItemData*> changedItems;
+    changedItems.reserve(changedCount);
+    foreach (int index, oldIndexes) {
+        changedItems.append(m_itemData.at(index));
+    }
+    sort(changedItems.begin(), changedItems.end());
+
+    // Step 2: Remove the changed items. The remaining items are sorted
+    //         (see KFileItemModel::emitItemsChangedAndTriggerResorting()).
+    const QList<ItemData*> oldItemData = m_itemData;
+
+    QList<ItemData*> remainingItems;
+    remainingItems.reserve(itemCount - changedCount);
+    int nextOldIndex = 0;
+    for (int i = 0; i < itemCount; ++i) {
+        if (nextOldIndex < changedCount && oldIndexes.at(nextOldIndex) == i) {
+            ++nextOldIndex;
+        } else {
+            remainingItems.append(oldItemData.at(i));
+        }
+    }
+
+    // Step 3: Find the new positions of the changed items by a binary search
+    //         and merge them into the remaining items.
+    m_itemData.clear();
+    m_itemData.reserve(itemCount);
+
+    int firstAffectedIndex = oldIndexes.first();
+    int lastAffectedIndex = oldIndexes.last();
+
+    int remainingIndex = 0;
+    foreach (ItemData* changedItem, changedItems) {
+        int low = remainingIndex;
+        int high = remainingItems.count();
+        while (low < high) {
+            const int middle = low + (high - low) / 2;
+            if (lessThan(changedItem, remainingItems.at(middle))) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+
+        while (remainingIndex < low) {
+            m_itemData.append(remainingItems.at(remainingIndex));
+            ++remainingIndex;
+        }
+
+        const int newIndex = m_itemData.count();
+        firstAffectedIndex = qMin(firstAffectedIndex, newIndex);
+        lastAffectedIndex = qMax(lastAffectedIndex, newIndex);
+        m_itemData.append(changedItem);
+    }
+
+    while (remainingIndex < remainingItems.count()) {
+        m_itemData.append(remainingItems.at(remainingIndex));
+        ++remainingIndex;
+    }
+
+    Q_ASSERT(m_itemData.count() == itemCount);
+
+    // Step 4: Only the indexes between firstAffectedIndex and lastAffectedIndex
+    //         can have been changed. Update m_items for these indexes.
+    for (int i = firstAffectedIndex; i <= lastAffectedIndex; ++i) {
+        m_items.insert(m_itemData.at(i)->item.url(), i);
+    }
+
+    int firstMovedIndex = firstAffectedIndex;
+    while (firstMovedIndex <= lastAffectedIndex
+           && oldItemData.at(firstMovedIndex) == m_itemData.at(firstMovedIndex)) {
+        ++firstMovedIndex;
+    }
+
+    if (firstMovedIndex <= lastAffectedIndex) {
+        m_groups.clear();
+
+        int lastMovedIndex = lastAffectedIndex;
+        while (lastMovedIndex > firstMovedIndex
+               && oldItemData.at(lastMovedIndex) == m_itemData.at(lastMovedIndex)) {
+            --lastMovedIndex;
+        }
+
+        const int movedItemsCount = lastMovedIndex - firstMovedIndex + 1;
+        QList<int> movedToIndexes;
+        movedToIndexes.reserve(movedItemsCount);
+        for (int i = firstMovedIndex; i <= lastMovedIndex; ++i) {
+            movedToIndexes.append(m_items.value(oldItemData.at(i)->item.url()));
+        }
+
+        emit itemsMoved(KItemRange(firstMovedIndex, movedItemsCount), movedToIndexes);
+    } else if (groupedSorting()) {
+        const QList<QPair<int, QVariant> > oldGroups = m_groups;
+        m_groups.clear();
+        if (groups() != oldGroups) {
+            emit groupsChanged();
+        }
+    }
+
+#ifdef KFILEITEMMODEL_DEBUG
+    kDebug() << "[TIME] Resorting of" << changedCount << "items:" << timer.elapsed();
+#endif
+}
+
 void KFileItemModel::slotCompleted()
 {
+    m_maximumUpdateIntervalTimer->stop();
     dispatchPendingItemsToInsert();
 
     if (!m_urlsToExpand.isEmpty()) {
@@ -808,7 +1027,7 @@ void KFileItemModel::slotItemsAdded(const KUrl& directoryUrl, const KFileItemLis
         // they got collapsed again with KFileItemModel::setExpanded(false). So it must be
         // checked whether the parent for new items is still expanded.
         const int parentIndex = m_items.value(parentUrl, -1);
-        if (parentIndex >= 0 && !m_itemData[parentIndex]->values.value("isExpanded").toBool()) {
+        if (parentIndex >= 0 && !m_roleStore.isExpanded(m_itemData[parentIndex]->slot)) {
             // The parent is not expanded.
             return;
         }
@@ -817,24 +1036,32 @@ void KFileItemModel::slotItemsAdded(const KUrl& directoryUrl, const KFileItemLis
     QList<ItemData*> itemDataList = createItemDataList(parentUrl, items);
 
     if (!m_filter.hasSetFilters()) {
-        m_pendingItemsToInsert.append(itemDataList);
+        appendPendingItemsToInsert(itemDataList);
     } else {
         // The name or type filter is active. Hide filtered items
         // before inserting them into the model and remember
         // the filtered items in m_filteredItems.
+        QList<ItemData*> matchingItems;
         foreach (ItemData* itemData, itemDataList) {
-            if (m_filter.matches(itemData->item)) {
-                m_pendingItemsToInsert.append(itemData);
+            if (matchesFilter(itemData)) {
+                matchingItems.append(itemData);
             } else {
                 m_filteredItems.insert(itemData->item, itemData);
             }
         }
+        appendPendingItemsToInsert(matchingItems);
     }
 
-    if (useMaximumUpdateInterval() && !m_maximumUpdateIntervalTimer->isActive()) {
-        // Assure that items get dispatched if no completed() or canceled() signal is
-        // emitted during the maximum update interval.
-        m_maximumUpdateIntervalTimer->start();
+    if (!m_maximumUpdateIntervalTimer->isActive()) {
+        if (m_itemData.isEmpty()) {
+            // Show the first items of huge directories as soon as possible, also
+            // for local directories (which might be located on slow NFS shares).
+            m_maximumUpdateIntervalTimer->start(300);
+        } else if (useMaximumUpdateInterval()) {
+            // Assure that items get dispatched if no completed() or canceled() signal is
+            // emitted during the maximum update interval.
+            m_maximumUpdateIntervalTimer->start(2000);
+        }
     }
 }
 
@@ -854,7 +1081,7 @@ void KFileItemModel::slotItemsDeleted(const KFileItemList& items)
         foreach (const KFileItem& item, itemsToRemove) {
             QHash<KFileItem, ItemData*>::iterator it = m_filteredItems.find(item);
             if (it != m_filteredItems.end()) {
-                delete it.value();
+                deleteItemData(it.value());
                 m_filteredItems.erase(it);
             }
         }
@@ -888,16 +1115,25 @@ void KFileItemModel::slotRefreshItems(const QList<QPair<KFileItem, KFileItem> >&
         const int index = m_items.value(oldItem.url(), -1);
         if (index >= 0) {
             m_itemData[index]->item = newItem;
+            if (oldItem.text() != newItem.text()) {
+                m_itemData[index]->sortKey = sortKey(newItem.text());
+                m_itemData[index]->lowerCaseText.clear();
+            }
+
+            // The URL is not part of m_roleStore, see KFileItemModel::data().
+            if (oldItem.url() != newItem.url()) {
+                changedRoles.insert(sharedValue("url"));
+            }
 
             // Keep old values as long as possible if they could not retrieved synchronously yet.
             // The update of the values will be done asynchronously by KFileItemModelRolesUpdater.
+            const int slot = m_itemData.at(index)->slot;
             QHashIterator<QByteArray, QVariant> it(retrieveData(newItem, m_itemData.at(index)->parent));
-            QHash<QByteArray, QVariant>& values = m_itemData[index]->values;
             while (it.hasNext()) {
                 it.next();
                 const QByteArray& role = it.key();
-                if (values.value(role) != it.value()) {
-                    values.insert(role, it.value());
+                if (m_roleStore.value(slot, role) != it.value()) {
+                    m_roleStore.setValue(slot, role, it.value());
                     changedRoles.insert(role);
                 }
             }
@@ -932,9 +1168,12 @@ void KFileItemModel::slotClear()
 
     m_maximumUpdateIntervalTimer->stop();
     m_resortAllItemsTimer->stop();
+    m_itemsToResort.clear();
 
+    discardSortingBatches();
     qDeleteAll(m_pendingItemsToInsert);
     m_pendingItemsToInsert.clear();
+    m_pendingRunLengths.clear();
 
     const int removedCount = m_itemData.count();
     if (removedCount > 0) {
@@ -944,6 +1183,9 @@ void KFileItemModel::slotClear()
         emit itemsRemoved(KItemRangeList() << KItemRange(0, removedCount));
     }
 
+    // All ItemData instances have been deleted, hence no slot is in use anymore.
+    m_roleStore.clear();
+
     m_expandedDirs.clear();
 }
 
@@ -955,14 +1197,24 @@ void KFileItemModel::slotClear(const KUrl& url)
 void KFileItemModel::slotNaturalSortingChanged()
 {
     m_naturalSorting = KGlobalSettings::naturalSorting();
+    updateSortKeys();
     resortAllItems();
 }
 
 void KFileItemModel::dispatchPendingItemsToInsert()
 {
+    finishSortingBatches();
+
     if (!m_pendingItemsToInsert.isEmpty()) {
-        insertItems(m_pendingItemsToInsert);
+        // The runs have been sorted already when they were appended.
+        // Only a few merges of runs are left.
+        while (m_pendingRunLengths.count() > 1) {
+            mergeLastPendingRuns();
+        }
+
+        insertSortedItems(m_pendingItemsToInsert);
         m_pendingItemsToInsert.clear();
+        m_pendingRunLengths.clear();
     }
 }
 
@@ -975,18 +1227,37 @@ void KFileItemModel::insertItems(QList<ItemData*>& newItems)
 #ifdef KFILEITEMMODEL_DEBUG
     QElapsedTimer timer;
     timer.start();
-    kDebug() << "===========================================================";
-    kDebug() << "Inserting" << newItems.count() << "items";
 #endif
 
-    m_groups.clear();
-
     sort(newItems.begin(), newItems.end());
 
 #ifdef KFILEITEMMODEL_DEBUG
-    kDebug() << "[TIME] Sorting:" << timer.elapsed();
+    kDebug() << "[TIME] Sorting of" << newItems.count() << "items:" << timer.elapsed();
+#endif
+
+    insertSortedItems(newItems);
+}
+
+void KFileItemModel::insertSortedItems(QList<ItemData*>& newItems)
+{
+    if (newItems.isEmpty()) {
+        return;
+    }
+
+#ifdef KFILEITEMMODEL_DEBUG
+    QElapsedTimer timer;
+    timer.start();
+    kDebug() << "===========================================================";
+    kDebug() << "Inserting" << newItems.count() << "items";
 #endif
 
+    if (!m_itemsToResort.isEmpty()) {
+        // Merging the new items requires that all existing items are sorted.
+        resortChangedItems();
+    }
+
+    m_groups.clear();
+
     KItemRangeList itemRanges;
     const int existingItemCount = m_itemData.count();
     const int newItemCount = newItems.count();
@@ -1077,8 +1348,12 @@ void KFileItemModel::removeItems(const KFileItemList& items, RemoveItemsBehavior
             QHash<KUrl, int>::iterator it = m_items.find(url);
             m_items.erase(it);
 
+            if (!m_itemsToResort.isEmpty()) {
+                m_itemsToResort.remove(m_itemData.at(index));
+            }
+
             if (behavior == DeleteItemData) {
-                delete m_itemData.at(index);
+                deleteItemData(m_itemData.at(index));
             }
 
             m_itemData[index] = 0;
@@ -1122,7 +1397,7 @@ void KFileItemModel::removeItems(const KFileItemList& items, RemoveItemsBehavior
     emit itemsRemoved(itemRanges);
 }
 
-QList<KFileItemModel::ItemData*> KFileItemModel::createItemDataList(const KUrl& parentUrl, const KFileItemList& items) const
+QList<KFileItemModel::ItemData*> KFileItemModel::createItemDataList(const KUrl& parentUrl, const KFileItemList& items)
 {
     if (m_sortRole == TypeRole) {
         // Try to resolve the MIME-types synchronously to prevent a reordering of
@@ -1140,7 +1415,9 @@ QList<KFileItemModel::ItemData*> KFileItemModel::createItemDataList(const KUrl&
     foreach (const KFileItem& item, items) {
         ItemData* itemData = new ItemData();
         itemData->item = item;
-        itemData->values = retrieveData(item, parentItem);
+        itemData->slot = m_roleStore.allocate();
+        m_roleStore.setValues(itemData->slot, retrieveData(item, parentItem));
+        itemData->sortKey = sortKey(item.text());
         itemData->parent = parentItem;
         itemDataList.append(itemData);
     }
@@ -1148,15 +1425,21 @@ QList<KFileItemModel::ItemData*> KFileItemModel::createItemDataList(const KUrl&
     return itemDataList;
 }
 
-int KFileItemModel::expandedParentsCount(const ItemData* data)
+void KFileItemModel::deleteItemData(ItemData* data)
 {
-    // The hash 'values' is only guaranteed to contain the key "expandedParentsCount"
+    m_roleStore.release(data->slot);
+    delete data;
+}
+
+int KFileItemModel::expandedParentsCount(const ItemData* data) const
+{
+    // The role store is only guaranteed to contain the value "expandedParentsCount"
     // if the corresponding item is expanded, and it is not a top-level item.
     const ItemData* parent = data->parent;
     if (parent) {
         if (parent->parent) {
-            Q_ASSERT(parent->values.contains("expandedParentsCount"));
-            return parent->values.value("expandedParentsCount").toInt() + 1;
+            Q_ASSERT(m_roleStore.hasExpandedParentsCount(parent->slot));
+            return m_roleStore.expandedParentsCount(parent->slot) + 1;
         } else {
             return 1;
         }
@@ -1188,36 +1471,60 @@ void KFileItemModel::emitItemsChangedAndTriggerResorting(const KItemRangeList& i
     // Trigger a resorting if necessary. Note that this can happen even if the sort
     // role has not changed at all because the file name can be used as a fallback.
     if (changedRoles.contains(sortRole()) || changedRoles.contains(roleForType(NameRole))) {
+        bool resortingTriggered = false;
+
         foreach (const KItemRange& range, itemRanges) {
             bool needsResorting = false;
 
             const int first = range.index;
             const int last = range.index + range.count - 1;
 
-            // Resorting the model is necessary if
-            // (a)  The first item in the range is "lessThan" its predecessor,
-            // (b)  the successor of the last item is "lessThan" the last item, or
-            // (c)  the internal order of the items in the range is incorrect.
-            if (first > 0
-                && lessThan(m_itemData.at(first), m_itemData.at(first - 1))) {
-                needsResorting = true;
-            } else if (last < count() - 1
-                && lessThan(m_itemData.at(last + 1), m_itemData.at(last))) {
-                needsResorting = true;
-            } else {
-                for (int index = first; index < last; ++index) {
-                    if (lessThan(m_itemData.at(index + 1), m_itemData.at(index))) {
-                        needsResorting = true;
+            // Resorting the model is necessary if the items in the range are not
+            // "lessThan"-ordered relative to each other, to the nearest preceding
+            // item and to the nearest succeeding item. Items that are already part
+            // of m_itemsToResort are skipped, because resortChangedItems() relies
+            // on the order of all other items being correct.
+            const ItemData* previous = 0;
+            for (int index = first - 1; index >= 0; --index) {
+                if (!m_itemsToResort.contains(m_itemData.at(index))) {
+                    previous = m_itemData.at(index);
+                    break;
+                }
+            }
+
+            for (int index = first; index <= last && !needsResorting; ++index) {
+                const ItemData* itemData = m_itemData.at(index);
+                if (m_itemsToResort.contains(itemData)) {
+                    continue;
+                }
+                if (previous && lessThan(itemData, previous)) {
+                    needsResorting = true;
+                }
+                previous = itemData;
+            }
+
+            if (!needsResorting && previous) {
+                for (int index = last + 1; index < count(); ++index) {
+                    const ItemData* next = m_itemData.at(index);
+                    if (!m_itemsToResort.contains(next)) {
+                        needsResorting = lessThan(next, previous);
                         break;
                     }
                 }
             }
 
             if (needsResorting) {
-                m_resortAllItemsTimer->start();
-                return;
+                for (int index = first; index <= last; ++index) {
+                    m_itemsToResort.insert(m_itemData.at(index));
+                }
+                resortingTriggered = true;
             }
         }
+
+        if (resortingTriggered) {
+            m_resortAllItemsTimer->start();
+            return;
+        }
     }
 
     if (groupedSorting() && changedRoles.contains(sortRole())) {
@@ -1297,8 +1604,9 @@ QHash<QByteArray, QVariant> KFileItemModel::retrieveData(const KFileItem& item,
     // It is important to insert only roles that are fast to retrieve. E.g.
     // KFileItem::iconName() can be very expensive if the MIME-type is unknown
     // and hence will be retrieved asynchronously by KFileItemModelRolesUpdater.
+    // The role "url" is not part of the data, as it is always taken
+    // from the KFileItem in KFileItemModel::data().
     QHash<QByteArray, QVariant> data;
-    data.insert(sharedValue("url"), item.url());
 
     const bool isDir = item.isDir();
     if (m_requestRole[IsDirRole] && isDir) {
@@ -1463,6 +1771,253 @@ private:
     const KFileItemModel* m_model;
 };
 
+namespace {
+    // Protects KFileItemModelBatchSortTask::m_finished. The mutex is not a
+    // member of the task, as the task may be deleted as soon as it is finished.
+    QMutex s_sortingBatchesMutex;
+    QWaitCondition s_sortingBatchFinished;
+}
+
+/**
+ * Sorts a batch of new items by name in a worker thread of
+ * KFileItemModelSortEngine, see KFileItemModel::appendPendingItemsToInsert().
+ *
+ * The settings that affect the order are copied, so the worker thread does not
+ * access the model. All items of a batch have the same parent, and the values
+ * that are compared are not changed while the items are not part of the model.
+ */
+class KFileItemModelBatchSortTask : public KFileItemModelSortEngine::Task
+{
+public:
+    KFileItemModelBatchSortTask(KFileItemModel* model, const QList<KFileItemModel::ItemData*>& items) :
+        m_model(model),
+        m_items(items),
+        m_sortDirsFirst(model->m_sortDirsFirst),
+        m_naturalSorting(model->m_naturalSorting),
+        m_caseSensitivity(model->m_caseSensitivity),
+        m_sortOrder(model->sortOrder()),
+        m_finished(false)
+    {
+    }
+
+    const QList<KFileItemModel::ItemData*>& items() const
+    {
+        return m_items;
+    }
+
+    bool isFinished() const
+    {
+        QMutexLocker locker(&s_sortingBatchesMutex);
+        return m_finished;
+    }
+
+    void waitForFinished()
+    {
+        QMutexLocker locker(&s_sortingBatchesMutex);
+        while (!m_finished) {
+            s_sortingBatchFinished.wait(&s_sortingBatchesMutex);
+        }
+    }
+
+    virtual void run(int worker)
+    {
+        Q_UNUSED(worker);
+
+        mergeSort(m_items.begin(), m_items.end(), LessThan(this));
+
+        // The model waits for the task before it is destructed, so it is
+        // still valid here. The task must not be accessed after m_finished
+        // has been set.
+        QMetaObject::invokeMethod(m_model, "appendSortedBatches", Qt::QueuedConnection);
+
+        QMutexLocker locker(&s_sortingBatchesMutex);
+        m_finished = true;
+        s_sortingBatchFinished.wakeAll();
+    }
+
+private:
+    class LessThan
+    {
+    public:
+        LessThan(const KFileItemModelBatchSortTask* task) :
+            m_task(task)
+        {
+        }
+
+        bool operator()(const KFileItemModel::ItemData* a, const KFileItemModel::ItemData* b) const
+        {
+            return m_task->lessThan(a, b);
+        }
+
+    private:
+        const KFileItemModelBatchSortTask* m_task;
+    };
+
+    // Equivalent to KFileItemModel::lessThan() for items with the same parent,
+    // if the items are sorted by name.
+    bool lessThan(const KFileItemModel::ItemData* a, const KFileItemModel::ItemData* b) const
+    {
+        if (m_sortDirsFirst) {
+            const bool isDirA = a->item.isDir();
+            const bool isDirB = b->item.isDir();
+            if (isDirA && !isDirB) {
+                return true;
+            } else if (!isDirA && isDirB) {
+                return false;
+            }
+        }
+
+        const int result = nameCompare(a, b);
+        return (m_sortOrder == Qt::AscendingOrder) ? result < 0 : result > 0;
+    }
+
+    // See the fallbacks of KFileItemModel::sortRoleCompare()
+    int nameCompare(const KFileItemModel::ItemData* a, const KFileItemModel::ItemData* b) const
+    {
+        const QByteArray& keyA = a->sortKey;
+        const QByteArray& keyB = b->sortKey;
+        int result = memcmp(keyA.constData(), keyB.constData(), qMin(keyA.size(), keyB.size()));
+        if (result == 0) {
+            result = keyA.size() - keyB.size();
+        }
+        if (result != 0) {
+            return result;
+        }
+
+        // KFileItem::name(true) caches the lower case name, which must not
+        // be done by a worker thread.
+        const QString nameA = a->item.name();
+        const QString nameB = b->item.name();
+        if (m_caseSensitivity == Qt::CaseInsensitive) {
+            result = stringCompare(nameA.toLower(), nameB.toLower(), Qt::CaseInsensitive);
+            if (result != 0) {
+                return result;
+            }
+        }
+        result = stringCompare(nameA, nameB, Qt::CaseSensitive);
+        if (result != 0) {
+            return result;
+        }
+
+        return QString::compare(a->item.url().url(), b->item.url().url(), Qt::CaseSensitive);
+    }
+
+    int stringCompare(const QString& a, const QString& b, Qt::CaseSensitivity caseSensitivity) const
+    {
+        return m_naturalSorting ? KStringHandler::naturalCompare(a, b, caseSensitivity)
+                                : QString::compare(a, b, caseSensitivity);
+    }
+
+private:
+    KFileItemModel* m_model;
+    QList<KFileItemModel::ItemData*> m_items;
+    bool m_sortDirsFirst;
+    bool m_naturalSorting;
+    Qt::CaseSensitivity m_caseSensitivity;
+    Qt::SortOrder m_sortOrder;
+    bool m_finished;
+};
+
+void KFileItemModel::appendPendingItemsToInsert(QList<ItemData*>& items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+
+    if (m_sortRole == NameRole) {
+        // Sorting by name is expensive, in particular if natural sorting is
+        // enabled. Sort the batch in a worker thread, so that the GUI thread
+        // only has to merge the sorted runs.
+        KFileItemModelBatchSortTask* task = new KFileItemModelBatchSortTask(this, items);
+        m_sortingBatches.append(task);
+        KFileItemModelSortEngine::instance()->start(task);
+        return;
+    }
+
+    sort(items.begin(), items.end());
+    appendSortedRun(items);
+}
+
+void KFileItemModel::appendSortedRun(const QList<ItemData*>& items)
+{
+    m_pendingItemsToInsert.append(items);
+    m_pendingRunLengths.append(items.count());
+
+    // Merge the last two runs as long as the last run is not much shorter
+    // than its predecessor. Like in a binary counter, this assures that
+    // there are only O(log(n)) runs and that each item takes part in only
+    // O(log(n)) merges.
+    int runCount = m_pendingRunLengths.count();
+    while (runCount > 1 && m_pendingRunLengths.at(runCount - 2) <= 2 * m_pendingRunLengths.at(runCount - 1)) {
+        mergeLastPendingRuns();
+        --runCount;
+    }
+}
+
+void KFileItemModel::appendSortedBatches()
+{
+    QMutableListIterator<KFileItemModelBatchSortTask*> it(m_sortingBatches);
+    while (it.hasNext()) {
+        KFileItemModelBatchSortTask* task = it.next();
+        if (task->isFinished()) {
+            appendSortedRun(task->items());
+            delete task;
+            it.remove();
+        }
+    }
+}
+
+void KFileItemModel::finishSortingBatches()
+{
+    foreach (KFileItemModelBatchSortTask* task, m_sortingBatches) {
+        task->waitForFinished();
+        appendSortedRun(task->items());
+        delete task;
+    }
+    m_sortingBatches.clear();
+}
+
+void KFileItemModel::discardSortingBatches()
+{
+    foreach (KFileItemModelBatchSortTask* task, m_sortingBatches) {
+        task->waitForFinished();
+        qDeleteAll(task->items());
+        delete task;
+    }
+    m_sortingBatches.clear();
+}
+
+void KFileItemModel::mergeLastPendingRuns()
+{
+    const int runCount = m_pendingRunLengths.count();
+    Q_ASSERT(runCount > 1);
+
+    const int lastLength = m_pendingRunLengths.at(runCount - 1);
+    const int previousLength = m_pendingRunLengths.at(runCount - 2);
+
+    const QList<ItemData*>::iterator end = m_pendingItemsToInsert.end();
+    const QList<ItemData*>::iterator pivot = end - lastLength;
+    const QList<ItemData*>::iterator begin = pivot - previousLength;
+
+    QVector<ItemData*> buffer(previousLength);
+    merge(begin, pivot, end, KFileItemModelLessThan(this), buffer.data());
+
+    m_pendingRunLengths.removeLast();
+    m_pendingRunLengths.last() = previousLength + lastLength;
+}
+
+void KFileItemModel::resortPendingItemsToInsert()
+{
+    // Batches that are being sorted might use the old sort settings
+    finishSortingBatches();
+
+    if (!m_pendingItemsToInsert.isEmpty()) {
+        sort(m_pendingItemsToInsert.begin(), m_pendingItemsToInsert.end());
+        m_pendingRunLengths.clear();
+        m_pendingRunLengths.append(m_pendingItemsToInsert.count());
+    }
+}
+
 void KFileItemModel::sort(QList<KFileItemModel::ItemData*>::iterator begin,
                           QList<KFileItemModel::ItemData*>::iterator end) const
 {
@@ -1471,8 +2026,7 @@ void KFileItemModel::sort(QList<KFileItemModel::ItemData*>::iterator begin,
     if (m_sortRole == NameRole) {
         // Sorting by name can be expensive, in particular if natural sorting is
         // enabled. Use all CPU cores to speed up the sorting process.
-        static const int numberOfThreads = QThread::idealThreadCount();
-        parallelMergeSort(begin, end, lessThan, numberOfThreads);
+        parallelMergeSort(begin, end, lessThan, KFileItemModelSortEngine::instance());
     } else {
         // Sorting by other roles is quite fast. Use only one thread to prevent
         // problems caused by non-reentrant comparison functions, see
@@ -1498,16 +2052,18 @@ int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
             // See "if (m_sortFoldersFirst || m_sortRole == SizeRole)" in KFileItemModel::lessThan():
             Q_ASSERT(itemB.isDir());
 
-            const QVariant valueA = a->values.value("size");
-            const QVariant valueB = b->values.value("size");
-            if (valueA.isNull() && valueB.isNull()) {
+            const bool hasSizeA = m_roleStore.hasSize(a->slot);
+            const bool hasSizeB = m_roleStore.hasSize(b->slot);
+            if (!hasSizeA && !hasSizeB) {
                 result = 0;
-            } else if (valueA.isNull()) {
+            } else if (!hasSizeA) {
                 result = -1;
-            } else if (valueB.isNull()) {
+            } else if (!hasSizeB) {
                 result = +1;
             } else {
-                result = valueA.toInt() - valueB.toInt();
+                const qint64 countA = m_roleStore.size(a->slot);
+                const qint64 countB = m_roleStore.size(b->slot);
+                result = (countA < countB) ? -1 : ((countA > countB) ? +1 : 0);
             }
         } else {
             // See "if (m_sortFoldersFirst || m_sortRole == SizeRole)" in KFileItemModel::lessThan():
@@ -1537,23 +2093,23 @@ int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
     }
 
     case RatingRole: {
-        result = a->values.value("rating").toInt() - b->values.value("rating").toInt();
+        result = m_roleStore.value(a->slot, "rating").toInt() - m_roleStore.value(b->slot, "rating").toInt();
         break;
     }
 
     case ImageSizeRole: {
         // Alway use a natural comparing to interpret the numbers of a string like
         // "1600 x 1200" for having a correct sorting.
-        result = KStringHandler::naturalCompare(a->values.value("imageSize").toString(),
-                                                b->values.value("imageSize").toString(),
+        result = KStringHandler::naturalCompare(m_roleStore.value(a->slot, "imageSize").toString(),
+                                                m_roleStore.value(b->slot, "imageSize").toString(),
                                                 Qt::CaseSensitive);
         break;
     }
 
     default: {
         const QByteArray role = roleForType(m_sortRole);
-        result = QString::compare(a->values.value(role).toString(),
-                                  b->values.value(role).toString());
+        result = QString::compare(m_roleStore.value(a->slot, role).toString(),
+                                  m_roleStore.value(b->slot, role).toString());
         break;
     }
 
@@ -1564,8 +2120,15 @@ int KFileItemModel::sortRoleCompare(const ItemData* a, const ItemData* b) const
         return result;
     }
 
-    // Fallback #1: Compare the text of the items
-    result = stringCompare(itemA.text(), itemB.text());
+    // Fallback #1: Compare the text of the items. The sort keys give the same
+    // result as stringCompare(itemA.text(), itemB.text()), but are much cheaper
+    // to compare.
+    const QByteArray& keyA = a->sortKey;
+    const QByteArray& keyB = b->sortKey;
+    result = memcmp(keyA.constData(), keyB.constData(), qMin(keyA.size(), keyB.size()));
+    if (result == 0) {
+        result = keyA.size() - keyB.size();
+    }
     if (result != 0) {
         return result;
     }
@@ -1605,6 +2168,142 @@ int KFileItemModel::stringCompare(const QString& a, const QString& b) const
                             : QString::compare(a, b, Qt::CaseSensitive);
 }
 
+namespace {
+    // Separates the case-insensitive part of the key from the case-sensitive
+    // part. It must be smaller than any token class.
+    const char CaseSeparator = 0x00;
+
+    // Token classes of the natural sort key, which mimic the order of
+    // KStringHandler::naturalCompare(): Texts that end earlier are sorted first,
+    // digit sequences starting with '0' are compared left aligned and are sorted
+    // before anything else. A punctuation character or space is compared with
+    // the first digit of a number by its code unit, so the characters below '0'
+    // are sorted before numbers and the others after them. Numbers and
+    // punctuation are sorted before other characters. The only difference is a
+    // text that starts with a symbol below '0' (e.g. '$' or '+') and follows a
+    // punctuation character: naturalCompare() compares it with a number by its
+    // first code unit, which is not transitive and cannot be expressed by a key.
+    const char FractionToken = 0x01;
+    const char LowPunctuationToken = 0x02;
+    const char IntegerToken = 0x03;
+    const char HighPunctuationToken = 0x04;
+    const char TextToken = 0x05;
+
+    void appendCodeUnit(QByteArray& key, ushort codeUnit)
+    {
+        key.append(static_cast<char>(codeUnit >> 8));
+        key.append(static_cast<char>(codeUnit & 0xff));
+    }
+
+    void appendCodeUnits(QByteArray& key, const QChar* begin, const QChar* end)
+    {
+        for (const QChar* it = begin; it != end; ++it) {
+            appendCodeUnit(key, it->unicode());
+        }
+    }
+
+    /**
+     * Appends the locale-dependent collation key of the text between \a begin
+     * and \a end. Like QString::localeAwareCompare(), which uses strcoll() on
+     * Unix, strxfrm() is used on the local 8-bit representation. The key is
+     * terminated by a 0 byte, which never occurs inside the key.
+     */
+    void appendCollationKey(QByteArray& key, const QChar* begin, const QChar* end)
+    {
+        const QByteArray text = QString(begin, end - begin).toLocal8Bit();
+        const size_t length = strxfrm(0, text.constData(), 0);
+        const int oldSize = key.size();
+        key.resize(oldSize + length + 1);
+        strxfrm(key.data() + oldSize, text.constData(), length + 1);
+    }
+
+    void appendNaturalKey(QByteArray& key, const QString& text)
+    {
+        const QChar* it = text.constData();
+        const QChar* end = it + text.length();
+
+        while (it != end) {
+            const QChar* begin = it;
+            if (it->isDigit()) {
+                while (it != end && it->isDigit()) {
+                    ++it;
+                }
+
+                if (*begin == QLatin1Char('0')) {
+                    // Left aligned comparison: a sequence that ends earlier is
+                    // sorted after a longer sequence with the same prefix, hence
+                    // the terminator must be larger than any digit.
+                    key.append(FractionToken);
+                    appendCodeUnits(key, begin, it);
+                    appendCodeUnit(key, 0xffff);
+                } else {
+                    // Right aligned comparison: longer numbers are larger.
+                    const quint32 digitsCount = it - begin;
+                    key.append(IntegerToken);
+                    key.append(static_cast<char>(digitsCount >> 24));
+                    key.append(static_cast<char>((digitsCount >> 16) & 0xff));
+                    key.append(static_cast<char>((digitsCount >> 8) & 0xff));
+                    key.append(static_cast<char>(digitsCount & 0xff));
+                    appendCodeUnits(key, begin, it);
+                }
+            } else if (it->isPunct() || it->isSpace()) {
+                key.append(it->unicode() < '0' ? LowPunctuationToken : HighPunctuationToken);
+                appendCodeUnit(key, it->unicode());
+                ++it;
+            } else {
+                while (it != end && !it->isDigit() && !it->isPunct() && !it->isSpace()) {
+                    ++it;
+                }
+
+                key.append(TextToken);
+                appendCollationKey(key, begin, it);
+            }
+        }
+    }
+}
+
+QByteArray KFileItemModel::sortKey(const QString& text) const
+{
+    QByteArray key;
+
+    if (m_naturalSorting) {
+        key.reserve(text.length() * 3);
+        if (m_caseSensitivity == Qt::CaseInsensitive) {
+            appendNaturalKey(key, text.toLower());
+            key.append(CaseSeparator);
+        }
+        appendNaturalKey(key, text);
+    } else {
+        // QString::compare() compares the UTF-16 code units. As no file name
+        // contains the code unit 0, the separator 0x0000 is smaller than any
+        // code unit.
+        key.reserve(text.length() * 4 + 2);
+        if (m_caseSensitivity == Qt::CaseInsensitive) {
+            const QString foldedText = text.toCaseFolded();
+            appendCodeUnits(key, foldedText.constData(), foldedText.constData() + foldedText.length());
+            appendCodeUnit(key, 0);
+        }
+        appendCodeUnits(key, text.constData(), text.constData() + text.length());
+    }
+
+    return key;
+}
+
+void KFileItemModel::updateSortKeys()
+{
+    finishSortingBatches();
+
+    foreach (ItemData* itemData, m_itemData) {
+        itemData->sortKey = sortKey(itemData->item.text());
+    }
+    foreach (ItemData* itemData, m_pendingItemsToInsert) {
+        itemData->sortKey = sortKey(itemData->item.text());
+    }
+    foreach (ItemData* itemData, m_filteredItems) {
+        itemData->sortKey = sortKey(itemData->item.text());
+    }
+}
+
 bool KFileItemModel::useMaximumUpdateInterval() const
 {
     return !m_dirLister->url().isLocalFile();
@@ -1629,7 +2328,7 @@ QList<QPair<int, QVariant> > KFileItemModel::nameRoleGroups() const
             continue;
         }
 
-        const QString name = m_itemData.at(i)->values.value("text").toString();
+        const QString name = m_roleStore.text(m_itemData.at(i)->slot);
 
         // Use the first character of the name as group indication
         QChar newFirstChar = name.at(0).toUpper();
@@ -1809,7 +2508,7 @@ QList<QPair<int, QVariant> > KFileItemModel::permissionRoleGroups() const
         }
 
         const ItemData* itemData = m_itemData.at(i);
-        const QString newPermissionsString = itemData->values.value("permissions").toString();
+        const QString newPermissionsString = m_roleStore.value(itemData->slot, "permissions").toString();
         if (newPermissionsString == permissionsString) {
             continue;
         }
@@ -1878,7 +2577,7 @@ QList<QPair<int, QVariant> > KFileItemModel::ratingRoleGroups() const
         if (isChildItem(i)) {
             continue;
         }
-        const int newGroupValue = m_itemData.at(i)->values.value("rating", 0).toInt();
+        const int newGroupValue = m_roleStore.value(m_itemData.at(i)->slot, "rating").toInt();
         if (newGroupValue != groupValue) {
             groupValue = newGroupValue;
             groups.append(QPair<int, QVariant>(i, newGroupValue));
@@ -1901,7 +2600,7 @@ QList<QPair<int, QVariant> > KFileItemModel::genericStringRoleGroups(const QByte
         if (isChildItem(i)) {
             continue;
         }
-        const QString newGroupValue = m_itemData.at(i)->values.value(role).toString();
+        const QString newGroupValue = m_roleStore.value(m_itemData.at(i)->slot, role).toString();
         if (newGroupValue != groupValue || isFirstGroupValue) {
             groupValue = newGroupValue;
             groups.append(QPair<int, QVariant>(i, newGroupValue));
@@ -1941,8 +2640,7 @@ void KFileItemModel::emitSortProgress(int resolvedCount)
     if (resolvedCount >= itemCount) {
         m_sortingProgressPercent = -1;
         if (m_resortAllItemsTimer->isActive()) {
-            m_resortAllItemsTimer->stop();
-            resortAllItems();
+            resortChangedItems();
         }
 
         emit directorySortingProgress(100);
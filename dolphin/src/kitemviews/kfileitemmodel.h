@@ -25,9 +25,11 @@
 #include <KUrl>
 #include <kitemviews/kitemmodelbase.h>
 #include <kitemviews/private/kfileitemmodelfilter.h>
+#include <kitemviews/private/kfileitemmodelrolestore.h>
 
 #include <QHash>
 
+class KFileItemModelBatchSortTask;
 class KFileItemModelDirLister;
 class QTimer;
 
@@ -81,6 +83,14 @@ public:
     virtual QHash<QByteArray, QVariant> data(int index) const;
     virtual bool setData(int index, const QHash<QByteArray, QVariant>& values);
 
+    /**
+     * Sets the values of several items like setData(), but emits only one
+     * itemsChanged() signal for all changed items. The keys of \a values
+     * are the indexes of the items.
+     * @return True if at least one value has been changed.
+     */
+    bool setItemsData(const QHash<int, QHash<QByteArray, QVariant> >& values);
+
     /**
      * Sets a separate sorting with directories first (true) or a mixed
      * sorting of files and directories (false).
@@ -99,7 +109,7 @@ public:
     bool showDirectoriesOnly() const;
 
     /** @reimp */
-    virtual QMimeData* createMimeData(const QSet<int>& indexes) const;
+    virtual QMimeData* createMimeData(const KItemSet& indexes) const;
 
     /** @reimp */
     virtual int indexForKeyboardSearch(const QString& text, int startFromIndex = 0) const;
@@ -270,6 +280,14 @@ private slots:
      */
     void resortAllItems();
 
+    /**
+     * Moves the items from m_itemsToResort to their correct positions. The
+     * positions are determined by a binary search, hence the costs depend on
+     * the number of changed items and not on the number of all items. Falls
+     * back to resortAllItems() if many items have been changed.
+     */
+    void resortChangedItems();
+
     void slotCompleted();
     void slotCanceled();
     void slotItemsAdded(const KUrl& directoryUrl, const KFileItemList& items);
@@ -281,6 +299,12 @@ private slots:
 
     void dispatchPendingItemsToInsert();
 
+    /**
+     * Appends the batches that have been sorted by worker threads
+     * to m_pendingItemsToInsert.
+     */
+    void appendSortedBatches();
+
 private:
     enum RoleType {
         // User visible roles:
@@ -299,7 +323,9 @@ private:
     struct ItemData
     {
         KFileItem item;
-        QHash<QByteArray, QVariant> values;
+        int slot; // Slot of the role values in m_roleStore
+        QByteArray sortKey; // See KFileItemModel::sortKey()
+        QString lowerCaseText; // Cached by KFileItemModel::matchesFilter(), empty if not calculated yet
         ItemData* parent;
     };
 
@@ -309,24 +335,84 @@ private:
     };
 
     void insertItems(QList<ItemData*>& items);
+
+    /**
+     * Inserts the items \a items, which must be sorted already, into the
+     * model. This requires only a linear number of comparisons.
+     */
+    void insertSortedItems(QList<ItemData*>& items);
+
     void removeItems(const KFileItemList& items, RemoveItemsBehavior behavior);
 
     /**
      * Helper method for insertItems() and removeItems(): Creates
      * a list of ItemData elements based on the given items.
      * Note that the ItemData instances are created dynamically and
-     * must be deleted by the caller.
+     * must be deleted by the caller with deleteItemData().
+     */
+    QList<ItemData*> createItemDataList(const KUrl& parentUrl, const KFileItemList& items);
+
+    /**
+     * Releases the role values of \a data in m_roleStore and deletes \a data.
      */
-    QList<ItemData*> createItemDataList(const KUrl& parentUrl, const KFileItemList& items) const;
+    void deleteItemData(ItemData* data);
 
-    static int expandedParentsCount(const ItemData* data);
+    int expandedParentsCount(const ItemData* data) const;
 
     void removeExpandedItems();
 
     /**
-     * This function is called by setData() and slotRefreshItems(). It emits
-     * the itemsChanged() signal, checks if the sort order is still correct,
-     * and starts m_resortAllItemsTimer if that is not the case.
+     * Sorts \a items and appends them as a new sorted run to
+     * m_pendingItemsToInsert. When sorting by name, the items are sorted by
+     * a worker thread of KFileItemModelSortEngine and appended later by
+     * appendSortedBatches() or finishSortingBatches().
+     */
+    void appendPendingItemsToInsert(QList<ItemData*>& items);
+
+    /**
+     * Appends the sorted items \a items as a new run to m_pendingItemsToInsert.
+     * Adjacent runs of similar length are merged immediately, so the costs for
+     * sorting the pending items are spread over the incoming batches and no
+     * huge sort is necessary in dispatchPendingItemsToInsert().
+     */
+    void appendSortedRun(const QList<ItemData*>& items);
+
+    /**
+     * Waits until the batches in m_sortingBatches have been sorted and
+     * appends them to m_pendingItemsToInsert.
+     */
+    void finishSortingBatches();
+
+    /**
+     * Waits until the batches in m_sortingBatches have been sorted and
+     * deletes their items.
+     */
+    void discardSortingBatches();
+
+    /**
+     * Merges the two last runs of m_pendingItemsToInsert.
+     */
+    void mergeLastPendingRuns();
+
+    /**
+     * Sorts m_pendingItemsToInsert again, which is necessary if
+     * the sort role, the sort order or the sort keys have changed.
+     */
+    void resortPendingItemsToInsert();
+
+    /**
+     * Stores \a values for the item with the index \a index without
+     * emitting itemsChanged().
+     * @return Roles whose values have been changed.
+     */
+    QSet<QByteArray> storeValues(int index, const QHash<QByteArray, QVariant>& values);
+
+    /**
+     * This function is called by setData(), setItemsData() and slotRefreshItems().
+     * It emits the itemsChanged() signal, checks if the sort order is still
+     * correct, and starts m_resortAllItemsTimer if that is not the case. The
+     * items that are not at their correct position anymore are remembered in
+     * m_itemsToResort.
      */
     void emitItemsChangedAndTriggerResorting(const KItemRangeList& itemRanges, const QSet<QByteArray>& changedRoles);
 
@@ -370,6 +456,24 @@ private:
 
     int stringCompare(const QString& a, const QString& b) const;
 
+    /**
+     * @return Key for the text \a text that respects the settings m_naturalSorting
+     *         and m_caseSensitivity. Comparing the keys of two texts byte by byte
+     *         gives the order of stringCompare() on the texts, except for some
+     *         corner cases of KStringHandler::naturalCompare() (e.g., punctuation
+     *         characters with a code point above '9' are always sorted before
+     *         numbers). The key is computed once when an item is added or renamed,
+     *         so that the expensive locale-aware and natural comparison is not
+     *         done for every pair of items that gets compared while sorting.
+     */
+    QByteArray sortKey(const QString& text) const;
+
+    /**
+     * Recalculates the sort keys of all items. Must be invoked if
+     * m_naturalSorting or m_caseSensitivity has been changed.
+     */
+    void updateSortKeys();
+
     bool useMaximumUpdateInterval() const;
 
     QList<QPair<int, QVariant> > nameRoleGroups() const;
@@ -402,8 +506,16 @@ private:
 
     /**
      * Applies the filters set through @ref setNameFilter and @ref setMimeTypeFilters.
+     * If the filter has been narrowed, only the shown items are checked. If it
+     * has been widened, only the items in m_filteredItems are checked.
+     */
+    void applyFilters(KFileItemModelFilter::FilterChange change);
+
+    /**
+     * @return True if the item matches m_filter. The lowercase text of the
+     *         item is cached in \a itemData.
      */
-    void applyFilters();
+    bool matchesFilter(ItemData* itemData) const;
 
     /**
      * Removes filtered items whose expanded parents have been deleted
@@ -462,6 +574,7 @@ private:
 
     QList<ItemData*> m_itemData;
     QHash<KUrl, int> m_items; // Allows O(1) access for KFileItemModel::index(const KFileItem& item)
+    KFileItemModelRoleStore m_roleStore; // Role values of all items in m_itemData, m_filteredItems, m_pendingItemsToInsert and m_sortingBatches
 
     KFileItemModelFilter m_filter;
     QHash<KFileItem, ItemData*> m_filteredItems; // Items that got hidden by KFileItemModel::setNameFilter()
@@ -470,7 +583,10 @@ private:
 
     QTimer* m_maximumUpdateIntervalTimer;
     QTimer* m_resortAllItemsTimer;
+    QSet<ItemData*> m_itemsToResort; // Items that must be moved by resortChangedItems()
     QList<ItemData*> m_pendingItemsToInsert;
+    QList<int> m_pendingRunLengths; // Lengths of the sorted runs in m_pendingItemsToInsert
+    QList<KFileItemModelBatchSortTask*> m_sortingBatches; // New items that are being sorted by worker threads
 
     // Cache for KFileItemModel::groups()
     mutable QList<QPair<int, QVariant> > m_groups;
@@ -483,6 +599,7 @@ private:
     QSet<KUrl> m_urlsToExpand;
 
     friend class KFileItemModelLessThan;       // Accesses lessThan() method
+    friend class KFileItemModelBatchSortTask;  // Accesses ItemData and the sort settings
     friend class KFileItemModelRolesUpdater;   // Accesses emitSortProgress() method
     friend class KFileItemModelTest;           // For unit testing
     friend class KFileItemModelBenchmark;      // For unit testing
@@ -492,7 +609,7 @@ private:
 
 inline bool KFileItemModel::isChildItem(int index) const
 {
-    return m_requestRole[ExpandedParentsCountRole] && m_itemData.at(index)->values.value("expandedParentsCount").toInt() > 0;
+    return m_requestRole[ExpandedParentsCountRole] && m_roleStore.expandedParentsCount(m_itemData.at(index)->slot) > 0;
 }
 
 #endif
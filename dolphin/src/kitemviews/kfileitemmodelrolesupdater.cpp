@@ -31,14 +31,16 @@
 
 #include "private/kpixmapmodifier.h"
 #include "private/kdirectorycontentscounter.h"
+#include "private/kfileitemmodelrolecache.h"
+#include "private/kpreviewcache.h"
+#include "private/kpreviewcompositor.h"
 
 #include <QApplication>
-#include <QPainter>
 #include <QPixmap>
 #include <QElapsedTimer>
 #include <QTimer>
+#include <qmath.h>
 
-#include <algorithm>
 
 #ifdef HAVE_NEPOMUK
     #include "private/knepomukrolesprovider.h"
@@ -60,6 +62,12 @@ namespace {
     // Not only the visible area, but up to ReadAheadPages before and after
     // this area will be resolved.
     const int ReadAheadPages = 5;
+
+    // While scrolling, the pages that will get visible within PrefetchTime ms
+    // are resolved ahead of time. At least one and at most MaxPrefetchPages
+    // pages are prefetched.
+    const int PrefetchTime = 1000;
+    const int MaxPrefetchPages = 10;
 }
 
 KFileItemModelRolesUpdater::KFileItemModelRolesUpdater(KFileItemModel* model, QObject* parent) :
@@ -71,23 +79,26 @@ KFileItemModelRolesUpdater::KFileItemModelRolesUpdater(KFileItemModel* model, QO
     m_previewShown(false),
     m_enlargeSmallPreviews(true),
     m_clearPreviews(false),
-    m_finishedItems(),
+    m_itemStates(),
+    m_nextSortRoleIndex(0),
     m_model(model),
     m_iconSize(),
     m_firstVisibleIndex(0),
     m_lastVisibleIndex(-1),
     m_maximumVisibleItems(50),
+    m_scrollVelocity(0),
+    m_updatedWhileScrolling(false),
     m_roles(),
     m_resolvableRoles(),
     m_enabledPlugins(),
-    m_pendingSortRoleItems(),
     m_pendingIndexes(),
     m_pendingPreviewItems(),
     m_previewJob(),
+    m_previewJobItems(),
     m_recentlyChangedItemsTimer(0),
-    m_recentlyChangedItems(),
-    m_changedItems(),
-    m_directoryContentsCounter(0)
+    m_directoryContentsCounter(0),
+    m_roleCache(0),
+    m_previewCompositor(0)
   #ifdef HAVE_NEPOMUK
   , m_nepomukResourceWatcher(0),
     m_nepomukUriItems()
@@ -95,6 +106,8 @@ KFileItemModelRolesUpdater::KFileItemModelRolesUpdater(KFileItemModel* model, QO
 {
     Q_ASSERT(model);
 
+    m_itemStates.resize(m_model->count());
+
     const KConfigGroup globalConfig(KGlobal::config(), "PreviewSettings");
     m_enabledPlugins = globalConfig.readEntry("Plugins", QStringList()
                                                          << "directorythumbnail"
@@ -129,11 +142,18 @@ KFileItemModelRolesUpdater::KFileItemModelRolesUpdater(KFileItemModel* model, QO
     m_directoryContentsCounter = new KDirectoryContentsCounter(m_model, this);
     connect(m_directoryContentsCounter, SIGNAL(result(QString,int)),
             this,                       SLOT(slotDirectoryContentsCountReceived(QString,int)));
+
+    m_roleCache = KFileItemModelRoleCache::instance();
+
+    m_previewCompositor = new KPreviewCompositor(this);
+    connect(m_previewCompositor, SIGNAL(imageReady(KFileItem,QImage,QSize)),
+            this,                SLOT(slotPreviewImageReady(KFileItem,QImage,QSize)));
 }
 
 KFileItemModelRolesUpdater::~KFileItemModelRolesUpdater()
 {
     killPreviewJob();
+    m_roleCache->scheduleSave();
 }
 
 void KFileItemModelRolesUpdater::setIconSize(const QSize& size)
@@ -145,7 +165,8 @@ void KFileItemModelRolesUpdater::setIconSize(const QSize& size)
         } else if (m_previewShown) {
             // An icon size change requires the regenerating of
             // all previews
-            m_finishedItems.clear();
+            clearCompositedPreviews();
+            m_itemStates.clearFlag(FinishedItem);
             startUpdating();
         }
     }
@@ -165,7 +186,8 @@ void KFileItemModelRolesUpdater::setVisibleIndexRange(int index, int count)
         count = 0;
     }
 
-    if (index == m_firstVisibleIndex && count == m_lastVisibleIndex - m_firstVisibleIndex + 1) {
+    const bool scrollingStopped = (m_scrollVelocity == 0) && m_updatedWhileScrolling;
+    if (index == m_firstVisibleIndex && count == m_lastVisibleIndex - m_firstVisibleIndex + 1 && !scrollingStopped) {
         // The range has not been changed
         return;
     }
@@ -173,6 +195,19 @@ void KFileItemModelRolesUpdater::setVisibleIndexRange(int index, int count)
     m_firstVisibleIndex = index;
     m_lastVisibleIndex = qMin(index + count - 1, m_model->count() - 1);
 
+    if (m_directoryContentsCounter->hasPendingRequests()) {
+        // Count the visible directories first and cancel the requests for
+        // directories that have been scrolled away.
+        QSet<QString> visibleDirs;
+        for (int i = m_firstVisibleIndex; i <= m_lastVisibleIndex; ++i) {
+            const KFileItem item = m_model->fileItem(i);
+            if (item.isDir() && item.isLocalFile()) {
+                visibleDirs.insert(item.localPath());
+            }
+        }
+        m_directoryContentsCounter->setVisibleDirectories(visibleDirs);
+    }
+
     startUpdating();
 }
 
@@ -181,6 +216,16 @@ void KFileItemModelRolesUpdater::setMaximumVisibleItems(int count)
     m_maximumVisibleItems = count;
 }
 
+void KFileItemModelRolesUpdater::setScrollVelocity(qreal velocity)
+{
+    m_scrollVelocity = velocity;
+}
+
+qreal KFileItemModelRolesUpdater::scrollVelocity() const
+{
+    return m_scrollVelocity;
+}
+
 void KFileItemModelRolesUpdater::setPreviewsShown(bool show)
 {
     if (show == m_previewShown) {
@@ -219,6 +264,8 @@ void KFileItemModelRolesUpdater::setEnabledPlugins(const QStringList& list)
 {
     if (m_enabledPlugins != list) {
         m_enabledPlugins = list;
+        // The cached previews might have been created by plugins that are disabled now.
+        KPreviewCache::instance()->clear();
         if (m_previewShown) {
             updateAllPreviews();
         }
@@ -238,15 +285,18 @@ void KFileItemModelRolesUpdater::setPaused(bool paused)
         const bool updatePreviews = (m_iconSizeChangedDuringPausing && m_previewShown) ||
                                     m_previewChangedDuringPausing;
         const bool resolveAll = updatePreviews || m_rolesChangedDuringPausing;
+        if (updatePreviews) {
+            clearCompositedPreviews();
+        }
         if (resolveAll) {
-            m_finishedItems.clear();
+            m_itemStates.clearFlag(FinishedItem);
         }
 
         m_iconSizeChangedDuringPausing = false;
         m_previewChangedDuringPausing = false;
         m_rolesChangedDuringPausing = false;
 
-        if (!m_pendingSortRoleItems.isEmpty()) {
+        if (m_itemStates.flagCount(PendingSortRoleItem) > 0) {
             m_state = ResolvingSortRole;
             resolveNextSortRole();
         } else {
@@ -318,6 +368,9 @@ QStringList KFileItemModelRolesUpdater::enabledPlugins() const
 
 void KFileItemModelRolesUpdater::slotItemsInserted(const KItemRangeList& itemRanges)
 {
+    m_itemStates.insertItems(itemRanges);
+    m_nextSortRoleIndex = 0;
+
     QElapsedTimer timer;
     timer.start();
 
@@ -330,7 +383,7 @@ void KFileItemModelRolesUpdater::slotItemsInserted(const KItemRangeList& itemRan
                 if (timer.elapsed() < MaxBlockTimeout) {
                     applySortRole(i);
                 } else {
-                    m_pendingSortRoleItems.insert(m_model->fileItem(i));
+                    m_itemStates.setFlag(i, PendingSortRoleItem);
                 }
             }
             insertedCount += range.count;
@@ -341,7 +394,7 @@ void KFileItemModelRolesUpdater::slotItemsInserted(const KItemRangeList& itemRan
         // If there are still items whose sort role is unknown, check if the
         // asynchronous determination of the sort role is already in progress,
         // and start it if that is not the case.
-        if (!m_pendingSortRoleItems.isEmpty() && m_state != ResolvingSortRole) {
+        if (m_itemStates.flagCount(PendingSortRoleItem) > 0 && m_state != ResolvingSortRole) {
             killPreviewJob();
             m_state = ResolvingSortRole;
             resolveNextSortRole();
@@ -353,7 +406,8 @@ void KFileItemModelRolesUpdater::slotItemsInserted(const KItemRangeList& itemRan
 
 void KFileItemModelRolesUpdater::slotItemsRemoved(const KItemRangeList& itemRanges)
 {
-    Q_UNUSED(itemRanges);
+    m_itemStates.removeItems(itemRanges);
+    m_nextSortRoleIndex = 0;
 
     const bool allItemsRemoved = (m_model->count() == 0);
 
@@ -388,27 +442,18 @@ void KFileItemModelRolesUpdater::slotItemsRemoved(const KItemRangeList& itemRang
     if (allItemsRemoved) {
         m_state = Idle;
 
-        m_finishedItems.clear();
-        m_pendingSortRoleItems.clear();
+        m_itemStates.clear();
         m_pendingIndexes.clear();
         m_pendingPreviewItems.clear();
-        m_recentlyChangedItems.clear();
         m_recentlyChangedItemsTimer->stop();
-        m_changedItems.clear();
+        m_previewCompositor->clear();
 
         killPreviewJob();
-    } else {
-        // Only remove the items from m_finishedItems. They will be removed
-        // from the other sets later on.
-        QSet<KFileItem>::iterator it = m_finishedItems.begin();
-        while (it != m_finishedItems.end()) {
-            if (m_model->index(*it) < 0) {
-                it = m_finishedItems.erase(it);
-            } else {
-                ++it;
-            }
-        }
 
+        // The directory has been left, make its roles available for
+        // other Dolphin instances.
+        m_roleCache->scheduleSave();
+    } else {
         // The visible items might have changed.
         startUpdating();
     }
@@ -416,8 +461,8 @@ void KFileItemModelRolesUpdater::slotItemsRemoved(const KItemRangeList& itemRang
 
 void KFileItemModelRolesUpdater::slotItemsMoved(const KItemRange& itemRange, QList<int> movedToIndexes)
 {
-    Q_UNUSED(itemRange);
-    Q_UNUSED(movedToIndexes);
+    m_itemStates.moveItems(itemRange, movedToIndexes);
+    m_nextSortRoleIndex = 0;
 
     // The visible items might have changed.
     startUpdating();
@@ -433,14 +478,12 @@ void KFileItemModelRolesUpdater::slotItemsChanged(const KItemRangeList& itemRang
     // to prevent expensive repeated updates if files are updated frequently.
     const bool itemsChangedRecently = m_recentlyChangedItemsTimer->isActive();
 
-    QSet<KFileItem>& targetSet = itemsChangedRecently ? m_recentlyChangedItems : m_changedItems;
+    const ItemState targetState = itemsChangedRecently ? RecentlyChangedItem : ChangedItem;
 
     foreach (const KItemRange& itemRange, itemRanges) {
-        int index = itemRange.index;
-        for (int count = itemRange.count; count > 0; --count) {
-            const KFileItem item = m_model->fileItem(index);
-            targetSet.insert(item);
-            ++index;
+        const int lastIndex = itemRange.index + itemRange.count - 1;
+        for (int index = itemRange.index; index <= lastIndex; ++index) {
+            m_itemStates.setFlag(index, targetState);
         }
     }
 
@@ -458,8 +501,9 @@ void KFileItemModelRolesUpdater::slotSortRoleChanged(const QByteArray& current,
     Q_UNUSED(previous);
 
     if (m_resolvableRoles.contains(current)) {
-        m_pendingSortRoleItems.clear();
-        m_finishedItems.clear();
+        m_itemStates.clearFlag(PendingSortRoleItem);
+        m_itemStates.clearFlag(FinishedItem);
+        m_nextSortRoleIndex = 0;
 
         const int count = m_model->count();
         QElapsedTimer timer;
@@ -470,13 +514,13 @@ void KFileItemModelRolesUpdater::slotSortRoleChanged(const QByteArray& current,
             if (timer.elapsed() < MaxBlockTimeout) {
                 applySortRole(index);
             } else {
-                m_pendingSortRoleItems.insert(m_model->fileItem(index));
+                m_itemStates.setFlag(index, PendingSortRoleItem);
             }
         }
 
         applySortProgressToModel();
 
-        if (!m_pendingSortRoleItems.isEmpty()) {
+        if (m_itemStates.flagCount(PendingSortRoleItem) > 0) {
             // Trigger the asynchronous determination of the sort role.
             killPreviewJob();
             m_state = ResolvingSortRole;
@@ -484,7 +528,7 @@ void KFileItemModelRolesUpdater::slotSortRoleChanged(const QByteArray& current,
         }
     } else {
         m_state = Idle;
-        m_pendingSortRoleItems.clear();
+        m_itemStates.clearFlag(PendingSortRoleItem);
         applySortProgressToModel();
     }
 }
@@ -495,77 +539,8 @@ void KFileItemModelRolesUpdater::slotGotPreview(const KFileItem& item, const QPi
         return;
     }
 
-    m_changedItems.remove(item);
-
-    const int index = m_model->index(item);
-    if (index < 0) {
-        return;
-    }
-
-    QPixmap scaledPixmap = pixmap;
-
-    const QString mimeType = item.mimetype();
-    const int slashIndex = mimeType.indexOf(QLatin1Char('/'));
-    const QString mimeTypeGroup = mimeType.left(slashIndex);
-    if (mimeTypeGroup == QLatin1String("image")) {
-        if (m_enlargeSmallPreviews) {
-            KPixmapModifier::applyFrame(scaledPixmap, m_iconSize);
-        } else {
-            // Assure that small previews don't get enlarged. Instead they
-            // should be shown centered within the frame.
-            const QSize contentSize = KPixmapModifier::sizeInsideFrame(m_iconSize);
-            const bool enlargingRequired = scaledPixmap.width()  < contentSize.width() &&
-                                           scaledPixmap.height() < contentSize.height();
-            if (enlargingRequired) {
-                QSize frameSize = scaledPixmap.size();
-                frameSize.scale(m_iconSize, Qt::KeepAspectRatio);
-
-                QPixmap largeFrame(frameSize);
-                largeFrame.fill(Qt::transparent);
-
-                KPixmapModifier::applyFrame(largeFrame, frameSize);
-
-                QPainter painter(&largeFrame);
-                painter.drawPixmap((largeFrame.width()  - scaledPixmap.width()) / 2,
-                                   (largeFrame.height() - scaledPixmap.height()) / 2,
-                                   scaledPixmap);
-                scaledPixmap = largeFrame;
-            } else {
-                // The image must be shrinked as it is too large to fit into
-                // the available icon size
-                KPixmapModifier::applyFrame(scaledPixmap, m_iconSize);
-            }
-        }
-    } else {
-        KPixmapModifier::scale(scaledPixmap, m_iconSize);
-    }
-
-    QHash<QByteArray, QVariant> data = rolesData(item);
-
-    const QStringList overlays = data["iconOverlays"].toStringList();
-    // Strangely KFileItem::overlays() returns empty string-values, so
-    // we need to check first whether an overlay must be drawn at all.
-    // It is more efficient to do it here, as KIconLoader::drawOverlays()
-    // assumes that an overlay will be drawn and has some additional
-    // setup time.
-    foreach (const QString& overlay, overlays) {
-        if (!overlay.isEmpty()) {
-            // There is at least one overlay, draw all overlays above m_pixmap
-            // and cancel the check
-            KIconLoader::global()->drawOverlays(overlays, scaledPixmap, KIconLoader::Desktop);
-            break;
-        }
-    }
-
-    data.insert("iconPixmap", scaledPixmap);
-
-    disconnect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
-               this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
-    m_model->setData(index, data);
-    connect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
-            this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
-
-    m_finishedItems.insert(item);
+    KPreviewCache::instance()->insert(item, previewJobSize(), pixmap);
+    applyPreview(item, pixmap);
 }
 
 void KFileItemModelRolesUpdater::slotPreviewFailed(const KFileItem& item)
@@ -574,10 +549,11 @@ void KFileItemModelRolesUpdater::slotPreviewFailed(const KFileItem& item)
         return;
     }
 
-    m_changedItems.remove(item);
-
     const int index = m_model->index(item);
     if (index >= 0) {
+        m_itemStates.setFlag(index, ChangedItem, false);
+        m_itemStates.setFlag(index, FinishedItem);
+
         QHash<QByteArray, QVariant> data;
         data.insert("iconPixmap", QPixmap());
 
@@ -588,13 +564,13 @@ void KFileItemModelRolesUpdater::slotPreviewFailed(const KFileItem& item)
                 this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
 
         applyResolvedRoles(item, ResolveAll);
-        m_finishedItems.insert(item);
     }
 }
 
 void KFileItemModelRolesUpdater::slotPreviewJobFinished()
 {
     m_previewJob = 0;
+    m_previewJobItems.clear();
 
     if (m_state != PreviewJobRunning) {
         return;
@@ -605,7 +581,7 @@ void KFileItemModelRolesUpdater::slotPreviewJobFinished()
     if (!m_pendingPreviewItems.isEmpty()) {
         startPreviewJob();
     } else {
-        if (!m_changedItems.isEmpty()) {
+        if (m_itemStates.flagCount(ChangedItem) > 0) {
             updateChangedItems();
         }
     }
@@ -617,24 +593,28 @@ void KFileItemModelRolesUpdater::resolveNextSortRole()
         return;
     }
 
-    QSet<KFileItem>::iterator it = m_pendingSortRoleItems.begin();
-    while (it != m_pendingSortRoleItems.end()) {
-        const KFileItem item = *it;
-        const int index = m_model->index(item);
+    int index = m_itemStates.nextIndex(PendingSortRoleItem, m_nextSortRoleIndex);
+    if (index < 0) {
+        // The search has been started behind the first pending item.
+        index = m_itemStates.nextIndex(PendingSortRoleItem);
+    }
+
+    while (index >= 0) {
+        m_itemStates.setFlag(index, PendingSortRoleItem, false);
+        m_nextSortRoleIndex = index + 1;
 
         // Continue if the sort role has already been determined for the
         // item, and the item has not been changed recently.
-        if (!m_changedItems.contains(item) && m_model->data(index).contains(m_model->sortRole())) {
-            it = m_pendingSortRoleItems.erase(it);
+        if (!m_itemStates.testFlag(index, ChangedItem) && m_model->data(index).contains(m_model->sortRole())) {
+            index = m_itemStates.nextIndex(PendingSortRoleItem, m_nextSortRoleIndex);
             continue;
         }
 
         applySortRole(index);
-        m_pendingSortRoleItems.erase(it);
         break;
     }
 
-    if (!m_pendingSortRoleItems.isEmpty()) {
+    if (m_itemStates.flagCount(PendingSortRoleItem) > 0) {
         applySortProgressToModel();
         QTimer::singleShot(0, this, SLOT(resolveNextSortRole()));
     } else {
@@ -658,15 +638,13 @@ void KFileItemModelRolesUpdater::resolveNextPendingRoles()
 
     while (!m_pendingIndexes.isEmpty()) {
         const int index = m_pendingIndexes.takeFirst();
-        const KFileItem item = m_model->fileItem(index);
-
-        if (m_finishedItems.contains(item)) {
+        if (index >= m_model->count() || m_itemStates.testFlag(index, FinishedItem)) {
             continue;
         }
 
-        applyResolvedRoles(item, ResolveAll);
-        m_finishedItems.insert(item);
-        m_changedItems.remove(item);
+        m_itemStates.setFlag(index, FinishedItem);
+        m_itemStates.setFlag(index, ChangedItem, false);
+        applyResolvedRoles(m_model->fileItem(index), ResolveAll);
         break;
     }
 
@@ -677,7 +655,7 @@ void KFileItemModelRolesUpdater::resolveNextPendingRoles()
 
         if (m_clearPreviews) {
             // Only go through the list if there are items which might still have previews.
-            if (m_finishedItems.count() != m_model->count()) {
+            if (m_itemStates.flagCount(FinishedItem) != m_model->count()) {
                 QHash<QByteArray, QVariant> data;
                 data.insert("iconPixmap", QPixmap());
 
@@ -695,7 +673,7 @@ void KFileItemModelRolesUpdater::resolveNextPendingRoles()
             m_clearPreviews = false;
         }
 
-        if (!m_changedItems.isEmpty()) {
+        if (m_itemStates.flagCount(ChangedItem) > 0) {
             updateChangedItems();
         }
     }
@@ -703,8 +681,10 @@ void KFileItemModelRolesUpdater::resolveNextPendingRoles()
 
 void KFileItemModelRolesUpdater::resolveRecentlyChangedItems()
 {
-    m_changedItems += m_recentlyChangedItems;
-    m_recentlyChangedItems.clear();
+    foreach (int index, m_itemStates.indexes(RecentlyChangedItem)) {
+        m_itemStates.setFlag(index, ChangedItem);
+    }
+    m_itemStates.clearFlag(RecentlyChangedItem);
     updateChangedItems();
 }
 
@@ -762,6 +742,7 @@ void KFileItemModelRolesUpdater::slotDirectoryContentsCountReceived(const QStrin
     if (getSizeRole || getIsExpandableRole) {
         const int index = m_model->index(KUrl(path));
         if (index >= 0) {
+            m_roleCache->setItemCount(m_model->fileItem(index), count, m_directoryContentsCounter->workerOptions());
 
             QHash<QByteArray, QVariant> data;
 
@@ -787,21 +768,29 @@ void KFileItemModelRolesUpdater::startUpdating()
         return;
     }
 
-    if (m_finishedItems.count() == m_model->count()) {
+    if (m_itemStates.flagCount(FinishedItem) == m_model->count()) {
         // All roles have been resolved already.
         m_state = Idle;
         return;
     }
 
-    // Terminate all updates that are currently active.
-    killPreviewJob();
+    // Terminate all updates that are currently active. While scrolling, the
+    // preview job is only stopped if it works on items that have been left
+    // behind. Otherwise it is creating previews for the items ahead, which
+    // are needed soon.
+    const bool scrolling = (m_scrollVelocity != 0);
+    if (!scrolling || isPreviewJobObsolete()) {
+        killPreviewJob();
+    }
     m_pendingIndexes.clear();
 
-    QElapsedTimer timer;
-    timer.start();
-
-    // Determine the icons for the visible items synchronously.
-    updateVisibleIcons();
+    // Determine the icons for the visible items synchronously. This is
+    // skipped while scrolling, as blocking would make the scrolling jerky.
+    // The views show preliminary icons until the roles have been resolved.
+    m_updatedWhileScrolling = scrolling;
+    if (!scrolling) {
+        updateVisibleIcons();
+    }
 
     // A detailed update of the items in and near the visible area
     // only makes sense if sorting is finished.
@@ -813,17 +802,26 @@ void KFileItemModelRolesUpdater::startUpdating()
     QList<int> indexes = indexesToResolve();
 
     if (m_previewShown) {
+        // Items that are handled by a preview job that is still running
+        // or by m_previewCompositor must not be requested again.
+        QSet<int> previewJobIndexes;
+        foreach (const KFileItem& item, m_previewJobItems) {
+            previewJobIndexes.insert(m_model->index(item));
+        }
+
         m_pendingPreviewItems.clear();
         m_pendingPreviewItems.reserve(indexes.count());
 
         foreach (int index, indexes) {
-            const KFileItem item = m_model->fileItem(index);
-            if (!m_finishedItems.contains(item)) {
-                m_pendingPreviewItems.append(item);
+            if (!m_itemStates.testFlag(index, FinishedItem) && !m_itemStates.testFlag(index, CompositingItem)
+                && !previewJobIndexes.contains(index)) {
+                m_pendingPreviewItems.append(m_model->fileItem(index));
             }
         }
 
-        startPreviewJob();
+        if (!m_previewJob) {
+            startPreviewJob();
+        }
     } else {
         m_pendingIndexes = indexes;
         // Trigger the asynchronous resolving of all roles.
@@ -868,40 +866,61 @@ void KFileItemModelRolesUpdater::startPreviewJob()
         return;
     }
 
-    // PreviewJob internally caches items always with the size of
-    // 128 x 128 pixels or 256 x 256 pixels. A (slow) downscaling is done
-    // by PreviewJob if a smaller size is requested. For images KFileItemModelRolesUpdater must
-    // do a downscaling anyhow because of the frame, so in this case only the provided
-    // cache sizes are requested.
-    const QSize cacheSize = (m_iconSize.width() > 128) || (m_iconSize.height() > 128)
-                             ? QSize(256, 256) : QSize(128, 128);
+    const QSize cacheSize = previewJobSize();
+    KPreviewCache* previewCache = KPreviewCache::instance();
 
     // KIO::filePreview() will request the MIME-type of all passed items, which (in the
     // worst case) might block the application for several seconds. To prevent such
     // a blocking, we only pass items with known mime type to the preview job.
+    // Items whose previews are cached already, e.g., because the directory is shown
+    // in another view, are not passed to the preview job at all.
     const int count = m_pendingPreviewItems.count();
     KFileItemList itemSubSet;
     itemSubSet.reserve(count);
 
+    // While scrolling, the preview jobs are kept small. This allows to stop
+    // creating previews for items that have been left behind quickly.
+    const int maximumJobItems = (m_scrollVelocity != 0) ? qMax(1, m_maximumVisibleItems) : count;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QPixmap cachedPixmap;
     if (m_pendingPreviewItems.first().isMimeTypeKnown()) {
         // Some mime types are known already, probably because they were
         // determined when loading the icons for the visible items. Start
         // a preview job for all items at the beginning of the list which
         // have a known mime type.
         do {
-            itemSubSet.append(m_pendingPreviewItems.takeFirst());
-        } while (!m_pendingPreviewItems.isEmpty() && m_pendingPreviewItems.first().isMimeTypeKnown());
+            const KFileItem item = m_pendingPreviewItems.takeFirst();
+            if (previewCache->find(item, cacheSize, cachedPixmap)) {
+                applyPreview(item, cachedPixmap);
+            } else {
+                itemSubSet.append(item);
+            }
+        } while (!m_pendingPreviewItems.isEmpty() && m_pendingPreviewItems.first().isMimeTypeKnown() &&
+                 itemSubSet.count() < maximumJobItems && timer.elapsed() < MaxBlockTimeout);
     } else {
         // Determine mime types for MaxBlockTimeout ms, and start a preview
         // job for the corresponding items.
-        QElapsedTimer timer;
-        timer.start();
-
         do {
             const KFileItem item = m_pendingPreviewItems.takeFirst();
-            item.determineMimeType();
-            itemSubSet.append(item);
-        } while (!m_pendingPreviewItems.isEmpty() && timer.elapsed() < MaxBlockTimeout);
+            if (previewCache->find(item, cacheSize, cachedPixmap)) {
+                applyPreview(item, cachedPixmap);
+            } else {
+                item.determineMimeType();
+                itemSubSet.append(item);
+            }
+        } while (!m_pendingPreviewItems.isEmpty() && itemSubSet.count() < maximumJobItems &&
+                 timer.elapsed() < MaxBlockTimeout);
+    }
+
+    if (itemSubSet.isEmpty()) {
+        // All previews have been taken from the cache. Continue with the
+        // remaining pending items asynchronously to keep the user interface
+        // responsive.
+        QTimer::singleShot(0, this, SLOT(slotPreviewJobFinished()));
+        return;
     }
 
     KIO::PreviewJob* job = new KIO::PreviewJob(itemSubSet, cacheSize, &m_enabledPlugins);
@@ -919,6 +938,100 @@ void KFileItemModelRolesUpdater::startPreviewJob()
             this, SLOT(slotPreviewJobFinished()));
 
     m_previewJob = job;
+    m_previewJobItems = itemSubSet;
+}
+
+QSize KFileItemModelRolesUpdater::previewJobSize() const
+{
+    // PreviewJob internally caches items always with the size of
+    // 128 x 128 pixels or 256 x 256 pixels. A (slow) downscaling is done
+    // by PreviewJob if a smaller size is requested. For images KFileItemModelRolesUpdater must
+    // do a downscaling anyhow because of the frame, so in this case only the provided
+    // cache sizes are requested.
+    return (m_iconSize.width() > 128) || (m_iconSize.height() > 128)
+           ? QSize(256, 256) : QSize(128, 128);
+}
+
+void KFileItemModelRolesUpdater::applyPreview(const KFileItem& item, const QPixmap& pixmap)
+{
+    const int index = m_model->index(item);
+    if (index < 0) {
+        return;
+    }
+
+    // The item is marked as finished as soon as the preview has been
+    // applied, see slotPreviewImageReady(). Until then CompositingItem
+    // prevents that the preview is requested again.
+    m_itemStates.setFlag(index, ChangedItem, false);
+    m_itemStates.setFlag(index, CompositingItem);
+
+    // Scaling the preview and applying the frame is done in a background
+    // thread.
+    KPreviewCompositor::Operation operation = KPreviewCompositor::Scale;
+
+    const QString mimeType = item.mimetype();
+    const int slashIndex = mimeType.indexOf(QLatin1Char('/'));
+    const QString mimeTypeGroup = mimeType.left(slashIndex);
+    if (mimeTypeGroup == QLatin1String("image")) {
+        operation = m_enlargeSmallPreviews ? KPreviewCompositor::ApplyFrame
+                                           : KPreviewCompositor::ApplyFrameWithoutEnlarging;
+    }
+
+    m_previewCompositor->addRequest(item, pixmap.toImage(), m_iconSize, operation);
+}
+
+void KFileItemModelRolesUpdater::slotPreviewImageReady(const KFileItem& item, const QImage& image, const QSize& size)
+{
+    const int index = m_model->index(item);
+    if (index < 0) {
+        return;
+    }
+
+    m_itemStates.setFlag(index, CompositingItem, false);
+
+    if (!m_previewShown || size != m_iconSize) {
+        // The previews will be created again with the new settings
+        return;
+    }
+
+    const KFileItem modelItem = m_model->fileItem(index);
+    if (modelItem.size() != item.size() ||
+        modelItem.time(KFileItem::ModificationTime) != item.time(KFileItem::ModificationTime)) {
+        // The item has been changed since the preview has been requested.
+        // A new preview is created for the changed item.
+        return;
+    }
+
+    m_itemStates.setFlag(index, FinishedItem);
+
+    QPixmap scaledPixmap = QPixmap::fromImage(image);
+
+    QHash<QByteArray, QVariant> data = rolesData(item);
+
+    // The overlays are drawn in the GUI thread, as KIconLoader may not be
+    // used in other threads. Only few items have overlays usually.
+    const QStringList overlays = data["iconOverlays"].toStringList();
+    // Strangely KFileItem::overlays() returns empty string-values, so
+    // we need to check first whether an overlay must be drawn at all.
+    // It is more efficient to do it here, as KIconLoader::drawOverlays()
+    // assumes that an overlay will be drawn and has some additional
+    // setup time.
+    foreach (const QString& overlay, overlays) {
+        if (!overlay.isEmpty()) {
+            // There is at least one overlay, draw all overlays above m_pixmap
+            // and cancel the check
+            KIconLoader::global()->drawOverlays(overlays, scaledPixmap, KIconLoader::Desktop);
+            break;
+        }
+    }
+
+    data.insert("iconPixmap", scaledPixmap);
+
+    disconnect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
+               this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
+    m_model->setData(index, data);
+    connect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
+            this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
 }
 
 void KFileItemModelRolesUpdater::updateChangedItems()
@@ -927,14 +1040,20 @@ void KFileItemModelRolesUpdater::updateChangedItems()
         return;
     }
 
-    if (m_changedItems.isEmpty()) {
+    const QList<int> changedIndexes = m_itemStates.indexes(ChangedItem);
+    if (changedIndexes.isEmpty()) {
         return;
     }
 
-    m_finishedItems -= m_changedItems;
+    foreach (int index, changedIndexes) {
+        m_itemStates.setFlag(index, FinishedItem, false);
+    }
 
     if (m_resolvableRoles.contains(m_model->sortRole())) {
-        m_pendingSortRoleItems += m_changedItems;
+        foreach (int index, changedIndexes) {
+            m_itemStates.setFlag(index, PendingSortRoleItem);
+        }
+        m_nextSortRoleIndex = 0;
 
         if (m_state != ResolvingSortRole) {
             // Stop the preview job if necessary, and trigger the
@@ -950,14 +1069,7 @@ void KFileItemModelRolesUpdater::updateChangedItems()
     QList<int> visibleChangedIndexes;
     QList<int> invisibleChangedIndexes;
 
-    foreach (const KFileItem& item, m_changedItems) {
-        const int index = m_model->index(item);
-
-        if (index < 0) {
-            m_changedItems.remove(item);
-            continue;
-        }
-
+    foreach (int index, changedIndexes) {
         if (index >= m_firstVisibleIndex && index <= m_lastVisibleIndex) {
             visibleChangedIndexes.append(index);
         } else {
@@ -965,8 +1077,6 @@ void KFileItemModelRolesUpdater::updateChangedItems()
         }
     }
 
-    std::sort(visibleChangedIndexes.begin(), visibleChangedIndexes.end());
-
     if (m_previewShown) {
         foreach (int index, visibleChangedIndexes) {
             m_pendingPreviewItems.append(m_model->fileItem(index));
@@ -995,15 +1105,31 @@ void KFileItemModelRolesUpdater::applySortRole(int index)
     QHash<QByteArray, QVariant> data;
     const KFileItem item = m_model->fileItem(index);
 
+    KFileItemModelRoleCache::Entry cachedEntry;
+    const bool isCached = !item.isMimeTypeKnown() && m_roleCache->lookup(item, cachedEntry);
+
     if (m_model->sortRole() == "type") {
-        if (!item.isMimeTypeKnown()) {
-            item.determineMimeType();
+        if (isCached && !cachedEntry.type.isEmpty()) {
+            data.insert("type", cachedEntry.type);
+        } else {
+            if (!item.isMimeTypeKnown()) {
+                item.determineMimeType();
+            }
+            m_roleCache->setIconNameAndType(item, item.iconName(), item.mimeComment());
+            data.insert("type", item.mimeComment());
         }
-
-        data.insert("type", item.mimeComment());
     } else if (m_model->sortRole() == "size" && item.isLocalFile() && item.isDir()) {
-        const QString path = item.localPath();
-        data.insert("size", m_directoryContentsCounter->countDirectoryContentsSynchronously(path));
+        const int options = m_directoryContentsCounter->workerOptions();
+        if (m_roleCache->lookup(item, cachedEntry) && cachedEntry.itemCount >= 0 && cachedEntry.itemCountOptions == options) {
+            // Keep the size up to date if the directory is changed
+            m_directoryContentsCounter->watchDirectory(item.localPath());
+            data.insert("size", cachedEntry.itemCount);
+        } else {
+            const QString path = item.localPath();
+            const int count = m_directoryContentsCounter->countDirectoryContentsSynchronously(path);
+            m_roleCache->setItemCount(item, count, options);
+            data.insert("size", count);
+        }
     } else {
         // Probably the sort role is a Nepomuk role - just determine all roles.
         data = rolesData(item);
@@ -1020,7 +1146,7 @@ void KFileItemModelRolesUpdater::applySortProgressToModel()
 {
     // Inform the model about the progress of the resolved items,
     // so that it can give an indication when the sorting has been finished.
-    const int resolvedCount = m_model->count() - m_pendingSortRoleItems.count();
+    const int resolvedCount = m_model->count() - m_itemStates.flagCount(PendingSortRoleItem);
     m_model->emitSortProgress(resolvedCount);
 }
 
@@ -1032,29 +1158,40 @@ bool KFileItemModelRolesUpdater::applyResolvedRoles(const KFileItem& item, Resol
 
     const bool resolveAll = (hint == ResolveAll);
 
+    const int index = m_model->index(item);
+    if (index < 0) {
+        return false;
+    }
+
     bool iconChanged = false;
+    QString iconName;
     if (!item.isMimeTypeKnown() || !item.isFinalIconKnown()) {
-        item.determineMimeType();
-        iconChanged = true;
-    } else {
-        const int index = m_model->index(item);
-        if (!m_model->data(index).contains("iconName")) {
+        // Determining the MIME type is expensive. Use the icon
+        // from the role cache if the file has not been changed.
+        KFileItemModelRoleCache::Entry cachedEntry;
+        if (m_roleCache->lookup(item, cachedEntry) && !cachedEntry.iconName.isEmpty()) {
+            // The MIME type of the item stays unknown in this case, so only
+            // apply the cached icon if the model does not show it already.
+            // Otherwise every resolve pass would set the same icon again.
+            iconName = cachedEntry.iconName;
+            iconChanged = (m_model->data(index).value("iconName").toString() != iconName);
+        } else {
+            item.determineMimeType();
+            m_roleCache->setIconNameAndType(item, item.iconName(), item.mimeComment());
             iconChanged = true;
         }
+    } else if (!m_model->data(index).contains("iconName")) {
+        iconChanged = true;
     }
 
     if (iconChanged || resolveAll || m_clearPreviews) {
-        const int index = m_model->index(item);
-        if (index < 0) {
-            return false;
-        }
 
         QHash<QByteArray, QVariant> data;
         if (resolveAll) {
             data = rolesData(item);
         }
 
-        data.insert("iconName", item.iconName());
+        data.insert("iconName", iconName.isEmpty() ? item.iconName() : iconName);
 
         if (m_clearPreviews) {
             data.insert("iconPixmap", QPixmap());
@@ -1062,10 +1199,10 @@ bool KFileItemModelRolesUpdater::applyResolvedRoles(const KFileItem& item, Resol
 
         disconnect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
                    this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
-        m_model->setData(index, data);
+        const bool changed = m_model->setData(index, data);
         connect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
                 this,    SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
-        return true;
+        return changed;
     }
 
     return false;
@@ -1078,19 +1215,46 @@ QHash<QByteArray, QVariant> KFileItemModelRolesUpdater::rolesData(const KFileIte
     const bool getSizeRole = m_roles.contains("size");
     const bool getIsExpandableRole = m_roles.contains("isExpandable");
 
+    KFileItemModelRoleCache::Entry cachedEntry;
+    const bool isCached = m_roleCache->lookup(item, cachedEntry);
+
     if ((getSizeRole || getIsExpandableRole) && item.isDir()) {
-        if (item.isLocalFile()) {
+        // The number of items depends e.g. on whether hidden files are counted
+        const bool isCountCached = isCached && cachedEntry.itemCount >= 0
+                                   && cachedEntry.itemCountOptions == m_directoryContentsCounter->workerOptions();
+        if (isCountCached) {
+            // The directory has not been changed since the items have been counted.
+            if (getSizeRole) {
+                data.insert("size", cachedEntry.itemCount);
+            }
+            if (getIsExpandableRole) {
+                data.insert("isExpandable", cachedEntry.itemCount > 0);
+            }
+
+            // Show the cached number first, but keep it up to date if the
+            // directory is changed while it is shown.
+            if (item.isLocalFile()) {
+                m_directoryContentsCounter->watchDirectory(item.localPath());
+            }
+        } else if (item.isLocalFile()) {
             // Tell m_directoryContentsCounter that we want to count the items
             // inside the directory. The result will be received in slotDirectoryContentsCountReceived.
             const QString path = item.localPath();
-            m_directoryContentsCounter->addDirectory(path);
+            const int index = m_model->index(item);
+            const bool isVisible = (index >= m_firstVisibleIndex && index <= m_lastVisibleIndex);
+            m_directoryContentsCounter->addDirectory(path, isVisible ? KDirectoryContentsCounter::HighPriority
+                                                                     : KDirectoryContentsCounter::LowPriority);
         } else if (getSizeRole) {
             data.insert("size", -1); // -1 indicates an unknown number of items
         }
     }
 
     if (m_roles.contains("type")) {
-        data.insert("type", item.mimeComment());
+        if (isCached && !item.isMimeTypeKnown() && !cachedEntry.type.isEmpty()) {
+            data.insert("type", cachedEntry.type);
+        } else {
+            data.insert("type", item.mimeComment());
+        }
     }
 
     data.insert("iconOverlays", item.overlays());
@@ -1132,7 +1296,8 @@ void KFileItemModelRolesUpdater::updateAllPreviews()
     if (m_state == Paused) {
         m_previewChangedDuringPausing = true;
     } else {
-        m_finishedItems.clear();
+        clearCompositedPreviews();
+        m_itemStates.clearFlag(FinishedItem);
         startUpdating();
     }
 }
@@ -1148,10 +1313,38 @@ void KFileItemModelRolesUpdater::killPreviewJob()
                    this, SLOT(slotPreviewJobFinished()));
         m_previewJob->kill();
         m_previewJob = 0;
+        m_previewJobItems.clear();
         m_pendingPreviewItems.clear();
     }
 }
 
+void KFileItemModelRolesUpdater::clearCompositedPreviews()
+{
+    m_previewCompositor->clear();
+    m_itemStates.clearFlag(CompositingItem);
+}
+
+bool KFileItemModelRolesUpdater::isPreviewJobObsolete() const
+{
+    foreach (const KFileItem& item, m_previewJobItems) {
+        const int index = m_model->index(item);
+        if (index >= 0 && !m_itemStates.testFlag(index, FinishedItem) && !isLeftBehind(index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KFileItemModelRolesUpdater::isLeftBehind(int index) const
+{
+    if (m_scrollVelocity > 0) {
+        return index < m_firstVisibleIndex;
+    } else if (m_scrollVelocity < 0) {
+        return index > m_lastVisibleIndex;
+    }
+    return false;
+}
+
 QList<int> KFileItemModelRolesUpdater::indexesToResolve() const
 {
     const int count = m_model->count();
@@ -1164,6 +1357,28 @@ QList<int> KFileItemModelRolesUpdater::indexesToResolve() const
         result.append(i);
     }
 
+    if (m_scrollVelocity != 0) {
+        // Add the items of the pages that will get visible soon, and skip
+        // the items that have been left behind.
+        const qreal prefetchPages = qAbs(m_scrollVelocity) * PrefetchTime / 1000;
+        const int pages = qBound(1, qCeil(prefetchPages), MaxPrefetchPages);
+        const int prefetchItems = qMin(pages * m_maximumVisibleItems, ResolveAllItemsLimit - result.count());
+
+        if (m_scrollVelocity > 0) {
+            const int end = qMin(m_lastVisibleIndex + prefetchItems, count - 1);
+            for (int i = m_lastVisibleIndex + 1; i <= end; ++i) {
+                result.append(i);
+            }
+        } else {
+            const int begin = qMax(0, m_firstVisibleIndex - prefetchItems);
+            for (int i = m_firstVisibleIndex - 1; i >= begin; --i) {
+                result.append(i);
+            }
+        }
+
+        return result;
+    }
+
     // We need a reasonable upper limit for number of items to resolve after
     // and before the visible range. m_maximumVisibleItems can be quite large
     // when using Compace View.
@@ -24,6 +24,7 @@
 
 #include <KFileItem>
 #include <kitemviews/kitemmodelbase.h>
+#include <kitemviews/private/kitemstatearray.h>
 
 #include <libdolphin_export.h>
 
@@ -34,7 +35,10 @@
 
 class KDirectoryContentsCounter;
 class KFileItemModel;
+class KFileItemModelRoleCache;
 class KJob;
+class KPreviewCompositor;
+class QImage;
 class QPixmap;
 class QTimer;
 
@@ -99,6 +103,11 @@ class QTimer;
  *
  * 3.   Finally, the entire process is repeated for any items that might have
  *      changed in the mean time.
+ *
+ * The icon names, MIME type comments and directory item counts of local files
+ * are stored persistently in KFileItemModelRoleCache. If a directory is opened
+ * again, these roles are taken from the cache as long as the files have not
+ * been modified.
  */
 class LIBDOLPHINPRIVATE_EXPORT KFileItemModelRolesUpdater : public QObject
 {
@@ -119,6 +128,19 @@ public:
 
     void setMaximumVisibleItems(int count);
 
+    /**
+     * Sets the velocity of the scrolling in visible pages per second. Positive
+     * values mean that the view is scrolled towards higher indexes, 0 means
+     * that the view is not scrolled.
+     *
+     * While the view is scrolled, the roles and previews for the pages ahead
+     * of the visible range are prefetched, depending on the velocity, and the
+     * work for items that have been left behind is cancelled. The view should
+     * invoke setVisibleIndexRange() after changing the velocity.
+     */
+    void setScrollVelocity(qreal velocity);
+    qreal scrollVelocity() const;
+
     /**
      * If \a show is set to true, the "iconPixmap" role will be filled with a preview
      * of the file. If \a show is false the MIME type icon will be used for the "iconPixmap"
@@ -176,11 +198,20 @@ private slots:
                              const QByteArray& previous);
 
     /**
-     * Is invoked after a preview has been received successfully.
+     * Is invoked after a preview has been received successfully. The
+     * preview is stored in the shared KPreviewCache and applied to the model.
      * @see startPreviewJob()
      */
     void slotGotPreview(const KFileItem& item, const QPixmap& pixmap);
 
+    /**
+     * Is invoked after the preview for \a item has been scaled to the
+     * icon size \a size and a frame has been applied if necessary.
+     * The preview is dropped if \a item has been changed in the meantime.
+     * @see applyPreview()
+     */
+    void slotPreviewImageReady(const KFileItem& item, const QImage& image, const QSize& size);
+
     /**
      * Is invoked after generating a preview has failed.
      * @see startPreviewJob()
@@ -196,7 +227,7 @@ private slots:
     void slotPreviewJobFinished();
 
     /**
-     * Resolves the sort role of the next item in m_pendingSortRole, applies it
+     * Resolves the sort role of the next item with the state PendingSortRoleItem, applies it
      * to the model, and invokes itself if there are any pending items left. If
      * that is not the case, \a startUpdating() is called.
      */
@@ -237,13 +268,27 @@ private:
 
     /**
      * Creates previews for the items starting from the first item in
-     * m_pendingPreviewItems.
+     * m_pendingPreviewItems. Previews that are available in the shared
+     * KPreviewCache are applied without starting a preview job.
      * @see slotGotPreview()
      * @see slotPreviewFailed()
      * @see slotPreviewJobFinished()
      */
     void startPreviewJob();
 
+    /**
+     * @return Size of the previews that are requested by startPreviewJob().
+     */
+    QSize previewJobSize() const;
+
+    /**
+     * Passes the preview \a pixmap to m_previewCompositor, which scales it
+     * to the icon size and applies a frame for images. The preview is set
+     * as icon of \a item and the item is marked as finished by
+     * slotPreviewImageReady().
+     */
+    void applyPreview(const KFileItem& item, const QPixmap& pixmap);
+
     /**
      * Ensures that icons, previews, and other roles are determined for any
      * items that have been changed.
@@ -277,6 +322,23 @@ private:
 
     void killPreviewJob();
 
+    /**
+     * Discards the previews that are processed by m_previewCompositor.
+     */
+    void clearCompositedPreviews();
+
+    /**
+     * @return True if all items of the running preview job that have no
+     *         preview yet have been left behind by scrolling.
+     */
+    bool isPreviewJobObsolete() const;
+
+    /**
+     * @return True if the item with the index \a index has been
+     *         left behind by scrolling.
+     */
+    bool isLeftBehind(int index) const;
+
     QList<int> indexesToResolve() const;
 
 private:
@@ -288,6 +350,23 @@ private:
         PreviewJobRunning
     };
 
+    // Flags for m_itemStates.
+    enum ItemState {
+        // The item has been handled already, which prevents that
+        // previews and other expensive roles are determined again.
+        FinishedItem = 0x01,
+        // The sort role still has to be determined for the item.
+        PendingSortRoleItem = 0x02,
+        // The item has been changed while m_recentlyChangedItemsTimer
+        // was active.
+        RecentlyChangedItem = 0x04,
+        // The item has been changed, but not repeatedly recently.
+        ChangedItem = 0x08,
+        // The preview of the item is processed by m_previewCompositor.
+        // FinishedItem is set as soon as the preview has been applied.
+        CompositingItem = 0x10
+    };
+
     State m_state;
 
     // Property changes during pausing must be remembered to be able
@@ -307,22 +386,29 @@ private:
     // during the roles-updater has been paused by setPaused().
     bool m_clearPreviews;
 
-    // Remembers which items have been handled already, to prevent that
-    // previews and other expensive roles are determined again.
-    QSet<KFileItem> m_finishedItems;
+    // Contains an ItemState for each item of the model. The states
+    // are shifted when items are inserted, removed or moved.
+    KItemStateArray m_itemStates;
+
+    // Index from which resolveNextSortRole() continues searching for items
+    // with the state PendingSortRoleItem.
+    int m_nextSortRoleIndex;
 
     KFileItemModel* m_model;
     QSize m_iconSize;
     int m_firstVisibleIndex;
     int m_lastVisibleIndex;
     int m_maximumVisibleItems;
+    qreal m_scrollVelocity;
+
+    // True if the last update has been done while scrolling. In this case
+    // the synchronous update of the visible icons has been skipped.
+    bool m_updatedWhileScrolling;
+
     QSet<QByteArray> m_roles;
     QSet<QByteArray> m_resolvableRoles;
     QStringList m_enabledPlugins;
 
-    // Items for which the sort role still has to be determined.
-    QSet<KFileItem> m_pendingSortRoleItems;
-
     // Indexes of items which still have to be handled by
     // resolveNextPendingRoles().
     QList<int> m_pendingIndexes;
@@ -333,18 +419,19 @@ private:
 
     KJob* m_previewJob;
 
+    // Items that have been passed to m_previewJob.
+    KFileItemList m_previewJobItems;
+
     // When downloading or copying large files, the slot slotItemsChanged()
     // will be called periodically within a quite short delay. To prevent
     // a high CPU-load by generating e.g. previews for each notification, the update
     // will be postponed until no file change has been done within a longer period
     // of time.
     QTimer* m_recentlyChangedItemsTimer;
-    QSet<KFileItem> m_recentlyChangedItems;
-
-    // Items which have not been changed repeatedly recently.
-    QSet<KFileItem> m_changedItems;
 
     KDirectoryContentsCounter* m_directoryContentsCounter;
+    KFileItemModelRoleCache* m_roleCache;
+    KPreviewCompositor* m_previewCompositor;
 
 #ifdef HAVE_NEPOMUK
     Nepomuk2::ResourceWatcher* m_nepomukResourceWatcher;
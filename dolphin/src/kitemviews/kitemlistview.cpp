@@ -32,6 +32,7 @@
 #include "private/kitemlistheaderwidget.h"
 #include "private/kitemlistrubberband.h"
 #include "private/kitemlistsizehintresolver.h"
+#include "private/kitemlisttextheightresolver.h"
 #include "private/kitemlistviewlayouter.h"
 #include "private/kitemlistviewanimation.h"
 
@@ -123,6 +124,9 @@ KItemListView::KItemListView(QGraphicsWidget* parent) :
     m_layoutTimer->setSingleShot(true);
     connect(m_layoutTimer, SIGNAL(timeout()), this, SLOT(slotLayoutTimerFinished()));
 
+    connect(KItemListTextHeightResolver::instance(), SIGNAL(textHeightsResolved(const QObject*,int,int)),
+            this, SLOT(slotTextHeightsResolved(const QObject*,int,int)));
+
     m_rubberBand = new KItemListRubberBand(this);
     connect(m_rubberBand, SIGNAL(activationChanged(bool)), this, SLOT(slotRubberBandActivationChanged(bool)));
 
@@ -406,6 +410,17 @@ qreal KItemListView::verticalPageStep() const
 
 int KItemListView::itemAt(const QPointF& pos) const
 {
+    // The layouter finds the item in O(log n). The widgets still need to be
+    // checked, as they might not cover the whole item rectangle and might
+    // be moved by an animation.
+    if (m_model) {
+        const int index = m_layouter->itemAt(pos);
+        const KItemListWidget* candidate = m_visibleItems.value(index);
+        if (candidate && candidate->contains(candidate->mapFromItem(this, pos))) {
+            return index;
+        }
+    }
+
     QHashIterator<int, KItemListWidget*> it(m_visibleItems);
     while (it.hasNext()) {
         it.next();
@@ -609,12 +624,12 @@ KItemListHeader* KItemListView::header() const
     return m_header;
 }
 
-QPixmap KItemListView::createDragPixmap(const QSet<int>& indexes) const
+QPixmap KItemListView::createDragPixmap(const KItemSet& indexes) const
 {
     QPixmap pixmap;
 
     if (indexes.count() == 1) {
-        KItemListWidget* item = m_visibleItems.value(indexes.toList().first());
+        KItemListWidget* item = m_visibleItems.value(indexes.first());
         QGraphicsView* graphicsView = scene()->views()[0];
         if (item && graphicsView) {
             pixmap = item->createDragPixmap(0, graphicsView);
@@ -962,7 +977,9 @@ void KItemListView::slotItemsInserted(const KItemRangeList& itemRanges)
         beginTransaction();
     }
 
-    m_layouter->markAsDirty();
+    if (!itemRanges.isEmpty()) {
+        m_layouter->markAsDirtyFrom(itemRanges.first().index);
+    }
 
     m_sizeHintResolver->itemsInserted(itemRanges);
 
@@ -1067,7 +1084,9 @@ void KItemListView::slotItemsRemoved(const KItemRangeList& itemRanges)
         beginTransaction();
     }
 
-    m_layouter->markAsDirty();
+    if (!itemRanges.isEmpty()) {
+        m_layouter->markAsDirtyFrom(itemRanges.first().index);
+    }
 
     m_sizeHintResolver->itemsRemoved(itemRanges);
 
@@ -1172,7 +1191,7 @@ void KItemListView::slotItemsRemoved(const KItemRangeList& itemRanges)
 void KItemListView::slotItemsMoved(const KItemRange& itemRange, const QList<int>& movedToIndexes)
 {
     m_sizeHintResolver->itemsMoved(itemRange, movedToIndexes);
-    m_layouter->markAsDirty();
+    m_layouter->markAsDirtyFrom(itemRange.index);
 
     if (m_controller) {
         m_controller->selectionManager()->itemsMoved(itemRange, movedToIndexes);
@@ -1205,9 +1224,14 @@ void KItemListView::slotItemsChanged(const KItemRangeList& itemRanges,
         const int index = itemRange.index;
         const int count = itemRange.count;
 
+        if (m_grouped && roles.contains(m_model->sortRole())) {
+            // The group headers might have been changed
+            m_layouter->markAsDirtyFrom(index);
+        }
+
         if (updateSizeHints) {
             m_sizeHintResolver->itemsChanged(index, count, roles);
-            m_layouter->markAsDirty();
+            m_layouter->markSizeHintsAsDirty(index, count);
 
             if (!m_layoutTimer->isActive()) {
                 m_layoutTimer->start();
@@ -1305,7 +1329,7 @@ void KItemListView::slotCurrentChanged(int current, int previous)
     QAccessible::updateAccessibility(this, current+1, QAccessible::Focus);
 }
 
-void KItemListView::slotSelectionChanged(const QSet<int>& current, const QSet<int>& previous)
+void KItemListView::slotSelectionChanged(const KItemSet& current, const KItemSet& previous)
 {
     Q_UNUSED(previous);
 
@@ -1361,6 +1385,30 @@ void KItemListView::slotLayoutTimerFinished()
     doLayout(Animation);
 }
 
+void KItemListView::slotTextHeightsResolved(const QObject* requester, int firstIndex, int lastIndex)
+{
+    if (requester != this || !m_model || firstIndex < 0) {
+        return;
+    }
+
+    // The indexes might be outdated if the model has been changed in the
+    // meantime. This is no problem, as the layout of all items behind a
+    // changed item is updated anyway.
+    lastIndex = qMin(lastIndex, m_model->count() - 1);
+    if (firstIndex > lastIndex) {
+        return;
+    }
+
+    // The size hints that are based on estimated text heights are not
+    // cached, so updating the row heights of the resolved items requests
+    // those size hints again. The relayout is delayed to handle many
+    // results at once.
+    m_layouter->markSizeHintsAsDirty(firstIndex, lastIndex - firstIndex + 1);
+    if (!m_layoutTimer->isActive()) {
+        m_layoutTimer->start();
+    }
+}
+
 void KItemListView::slotRubberBandPosChanged()
 {
     update();
@@ -1502,7 +1550,7 @@ void KItemListView::setController(KItemListController* controller)
         if (previous) {
             KItemListSelectionManager* selectionManager = previous->selectionManager();
             disconnect(selectionManager, SIGNAL(currentChanged(int,int)), this, SLOT(slotCurrentChanged(int,int)));
-            disconnect(selectionManager, SIGNAL(selectionChanged(QSet<int>,QSet<int>)), this, SLOT(slotSelectionChanged(QSet<int>,QSet<int>)));
+            disconnect(selectionManager, SIGNAL(selectionChanged(KItemSet,KItemSet)), this, SLOT(slotSelectionChanged(KItemSet,KItemSet)));
         }
 
         m_controller = controller;
@@ -1510,7 +1558,7 @@ void KItemListView::setController(KItemListController* controller)
         if (controller) {
             KItemListSelectionManager* selectionManager = controller->selectionManager();
             connect(selectionManager, SIGNAL(currentChanged(int,int)), this, SLOT(slotCurrentChanged(int,int)));
-            connect(selectionManager, SIGNAL(selectionChanged(QSet<int>,QSet<int>)), this, SLOT(slotSelectionChanged(QSet<int>,QSet<int>)));
+            connect(selectionManager, SIGNAL(selectionChanged(KItemSet,KItemSet)), this, SLOT(slotSelectionChanged(KItemSet,KItemSet)));
         }
 
         onControllerChanged(controller, previous);
@@ -0,0 +1,406 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kitemset.h"
+
+#include <algorithm>
+
+KItemSet::KItemSet() :
+    m_itemRanges(),
+    m_count(0)
+{
+}
+
+void KItemSet::clear()
+{
+    m_itemRanges.clear();
+    m_count = 0;
+}
+
+bool KItemSet::contains(int index) const
+{
+    const int rangeIndex = firstRangeEndingAfter(index);
+    return rangeIndex < m_itemRanges.count() && m_itemRanges.at(rangeIndex).index <= index;
+}
+
+int KItemSet::first() const
+{
+    Q_ASSERT(!isEmpty());
+    return m_itemRanges.first().index;
+}
+
+int KItemSet::last() const
+{
+    Q_ASSERT(!isEmpty());
+    const KItemRange& range = m_itemRanges.last();
+    return range.index + range.count - 1;
+}
+
+void KItemSet::insert(int index)
+{
+    insertRange(index, 1);
+}
+
+void KItemSet::remove(int index)
+{
+    removeRange(index, 1);
+}
+
+void KItemSet::insertRange(int index, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    int begin = index;
+    int end = index + count;
+
+    const int first = firstRangeEndingAfter(begin);
+    int last = first;
+    while (last < m_itemRanges.count() && m_itemRanges.at(last).index < end) {
+        const KItemRange& range = m_itemRanges.at(last);
+        begin = qMin(begin, range.index);
+        end = qMax(end, range.index + range.count);
+        ++last;
+    }
+
+    replaceRanges(first, last, QVector<KItemRange>() << KItemRange(begin, end - begin));
+}
+
+void KItemSet::removeRange(int index, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const int begin = index;
+    const int end = index + count;
+
+    const int first = firstRangeEndingAfter(begin);
+    int last = first;
+    QVector<KItemRange> replacement;
+    while (last < m_itemRanges.count() && m_itemRanges.at(last).index < end) {
+        const KItemRange& range = m_itemRanges.at(last);
+        const int rangeEnd = range.index + range.count;
+        if (range.index < begin) {
+            replacement.append(KItemRange(range.index, begin - range.index));
+        }
+        if (rangeEnd > end) {
+            replacement.append(KItemRange(end, rangeEnd - end));
+        }
+        ++last;
+    }
+
+    if (last > first) {
+        replaceRanges(first, last, replacement);
+    }
+}
+
+void KItemSet::toggleRange(int index, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const int begin = index;
+    const int end = index + count;
+
+    // The gaps between the ranges inside [begin, end) are inserted, and the
+    // parts of the ranges outside [begin, end) are kept.
+    const int first = firstRangeEndingAfter(begin);
+    int last = first;
+    int gapBegin = begin;
+    QVector<KItemRange> replacement;
+    while (last < m_itemRanges.count() && m_itemRanges.at(last).index < end) {
+        const KItemRange& range = m_itemRanges.at(last);
+        const int rangeEnd = range.index + range.count;
+        if (range.index < begin) {
+            replacement.append(KItemRange(range.index, begin - range.index));
+        } else if (range.index > gapBegin) {
+            replacement.append(KItemRange(gapBegin, range.index - gapBegin));
+        }
+        if (rangeEnd > end) {
+            replacement.append(KItemRange(end, rangeEnd - end));
+        }
+        gapBegin = rangeEnd;
+        ++last;
+    }
+
+    if (gapBegin < end) {
+        replacement.append(KItemRange(gapBegin, end - gapBegin));
+    }
+
+    replaceRanges(first, last, replacement);
+}
+
+void KItemSet::itemsInserted(const KItemRangeList& itemRanges)
+{
+    if (m_itemRanges.isEmpty() || itemRanges.isEmpty()) {
+        return;
+    }
+
+    QVector<KItemRange> result;
+    result.reserve(m_itemRanges.count() + itemRanges.count());
+
+    int insertedCount = 0;
+    int i = 0;
+    foreach (const KItemRange& range, m_itemRanges) {
+        int index = range.index;
+        int remaining = range.count;
+
+        // Items that are inserted at or before the start of the
+        // range move the whole range.
+        while (i < itemRanges.count() && itemRanges.at(i).index <= index) {
+            insertedCount += itemRanges.at(i).count;
+            ++i;
+        }
+
+        // Items that are inserted inside the range split it.
+        while (i < itemRanges.count() && itemRanges.at(i).index < index + remaining) {
+            const int partCount = itemRanges.at(i).index - index;
+            result.append(KItemRange(index + insertedCount, partCount));
+            index += partCount;
+            remaining -= partCount;
+            insertedCount += itemRanges.at(i).count;
+            ++i;
+        }
+
+        result.append(KItemRange(index + insertedCount, remaining));
+    }
+
+    m_itemRanges = result;
+}
+
+void KItemSet::itemsRemoved(const KItemRangeList& itemRanges)
+{
+    if (m_itemRanges.isEmpty() || itemRanges.isEmpty()) {
+        return;
+    }
+
+    QVector<KItemRange> result;
+    result.reserve(m_itemRanges.count());
+
+    int removedCount = 0;
+    int i = 0;
+    foreach (const KItemRange& range, m_itemRanges) {
+        int index = range.index;
+        const int end = range.index + range.count;
+        while (index < end) {
+            // Skip the removed ranges that end before the current index.
+            while (i < itemRanges.count() && itemRanges.at(i).index + itemRanges.at(i).count <= index) {
+                removedCount += itemRanges.at(i).count;
+                ++i;
+            }
+
+            if (i < itemRanges.count() && itemRanges.at(i).index <= index) {
+                // The current index has been removed.
+                index = itemRanges.at(i).index + itemRanges.at(i).count;
+                continue;
+            }
+
+            const int partEnd = (i < itemRanges.count()) ? qMin(end, itemRanges.at(i).index) : end;
+            appendRange(result, KItemRange(index - removedCount, partEnd - index));
+            index = partEnd;
+        }
+    }
+
+    m_itemRanges = result;
+    m_count = countIndexes(m_itemRanges);
+}
+
+void KItemSet::itemsMoved(const KItemRange& itemRange, const QList<int>& movedToIndexes)
+{
+    if (m_itemRanges.isEmpty() || itemRange.count <= 0) {
+        return;
+    }
+
+    const int begin = itemRange.index;
+    const int end = itemRange.index + itemRange.count;
+
+    QList<int> newIndexes;
+    const int first = firstRangeEndingAfter(begin);
+    for (int rangeIndex = first; rangeIndex < m_itemRanges.count(); ++rangeIndex) {
+        const KItemRange& range = m_itemRanges.at(rangeIndex);
+        if (range.index >= end) {
+            break;
+        }
+
+        const int from = qMax(begin, range.index);
+        const int to = qMin(end, range.index + range.count);
+        for (int index = from; index < to; ++index) {
+            newIndexes.append(movedToIndexes.at(index - begin));
+        }
+    }
+
+    if (newIndexes.isEmpty()) {
+        return;
+    }
+
+    std::sort(newIndexes.begin(), newIndexes.end());
+
+    removeRange(begin, itemRange.count);
+    foreach (const KItemRange& range, KItemRangeList::fromSortedContainer(newIndexes)) {
+        insertRange(range.index, range.count);
+    }
+}
+
+KItemSet KItemSet::operator+(const KItemSet& other) const
+{
+    KItemSet result;
+    result.m_itemRanges.reserve(m_itemRanges.count() + other.m_itemRanges.count());
+
+    QVector<KItemRange>::const_iterator it = m_itemRanges.constBegin();
+    QVector<KItemRange>::const_iterator otherIt = other.m_itemRanges.constBegin();
+    while (it != m_itemRanges.constEnd() || otherIt != other.m_itemRanges.constEnd()) {
+        // Take the range that starts first and merge it with the
+        // last range of the result if they overlap.
+        KItemRange range;
+        if (otherIt == other.m_itemRanges.constEnd()
+            || (it != m_itemRanges.constEnd() && it->index < otherIt->index)) {
+            range = *it++;
+        } else {
+            range = *otherIt++;
+        }
+
+        if (!result.m_itemRanges.isEmpty()) {
+            KItemRange& lastRange = result.m_itemRanges.last();
+            const int lastEnd = lastRange.index + lastRange.count;
+            if (range.index <= lastEnd) {
+                lastRange.count = qMax(lastEnd, range.index + range.count) - lastRange.index;
+                continue;
+            }
+        }
+        result.m_itemRanges.append(range);
+    }
+
+    result.m_count = countIndexes(result.m_itemRanges);
+    return result;
+}
+
+KItemSet KItemSet::operator-(const KItemSet& other) const
+{
+    KItemSet result;
+    result.m_itemRanges.reserve(m_itemRanges.count() + other.m_itemRanges.count());
+
+    QVector<KItemRange>::const_iterator otherIt = other.m_itemRanges.constBegin();
+    foreach (const KItemRange& range, m_itemRanges) {
+        int index = range.index;
+        const int end = range.index + range.count;
+
+        // Skip the ranges of other that end before this range.
+        while (otherIt != other.m_itemRanges.constEnd() && otherIt->index + otherIt->count <= index) {
+            ++otherIt;
+        }
+
+        QVector<KItemRange>::const_iterator removedIt = otherIt;
+        while (index < end) {
+            if (removedIt == other.m_itemRanges.constEnd() || removedIt->index >= end) {
+                result.m_itemRanges.append(KItemRange(index, end - index));
+                break;
+            }
+
+            if (removedIt->index > index) {
+                result.m_itemRanges.append(KItemRange(index, removedIt->index - index));
+            }
+            index = removedIt->index + removedIt->count;
+            ++removedIt;
+        }
+    }
+
+    result.m_count = countIndexes(result.m_itemRanges);
+    return result;
+}
+
+KItemSet KItemSet::operator^(const KItemSet& other) const
+{
+    return (*this - other) + (other - *this);
+}
+
+int KItemSet::firstRangeEndingAfter(int index) const
+{
+    int low = 0;
+    int high = m_itemRanges.count();
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const KItemRange& range = m_itemRanges.at(middle);
+        if (range.index + range.count <= index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void KItemSet::replaceRanges(int first, int last, const QVector<KItemRange>& replacement)
+{
+    // Include the neighbors of the replaced ranges, because they
+    // might be adjacent to the new ranges.
+    QVector<KItemRange> ranges;
+    ranges.reserve(replacement.count() + 2);
+    if (first > 0) {
+        --first;
+        appendRange(ranges, m_itemRanges.at(first));
+    }
+    foreach (const KItemRange& range, replacement) {
+        appendRange(ranges, range);
+    }
+    if (last < m_itemRanges.count()) {
+        appendRange(ranges, m_itemRanges.at(last));
+        ++last;
+    }
+
+    for (int i = first; i < last; ++i) {
+        m_count -= m_itemRanges.at(i).count;
+    }
+    m_count += countIndexes(ranges);
+
+    const int replacedCount = last - first;
+    if (ranges.count() > replacedCount) {
+        m_itemRanges.insert(first, ranges.count() - replacedCount, KItemRange());
+    } else if (ranges.count() < replacedCount) {
+        m_itemRanges.remove(first, replacedCount - ranges.count());
+    }
+    std::copy(ranges.constBegin(), ranges.constEnd(), m_itemRanges.begin() + first);
+}
+
+void KItemSet::appendRange(QVector<KItemRange>& ranges, const KItemRange& range)
+{
+    if (range.count <= 0) {
+        return;
+    }
+
+    if (!ranges.isEmpty()) {
+        KItemRange& lastRange = ranges.last();
+        if (lastRange.index + lastRange.count == range.index) {
+            lastRange.count += range.count;
+            return;
+        }
+    }
+    ranges.append(range);
+}
+
+int KItemSet::countIndexes(const QVector<KItemRange>& ranges)
+{
+    int count = 0;
+    foreach (const KItemRange& range, ranges) {
+        count += range.count;
+    }
+    return count;
+}
@@ -0,0 +1,278 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KITEMSET_H
+#define KITEMSET_H
+
+#include <libdolphin_export.h>
+
+#include <kitemviews/kitemrange.h>
+
+#include <QMetaType>
+#include <QVector>
+
+/**
+ * @brief Set of item indexes that is stored as a list of ranges.
+ *
+ * The indexes are stored as a sorted list of disjoint KItemRange intervals.
+ * Adjacent intervals are always merged, so selecting all items of a model,
+ * inverting a selection that consists of a few ranges or selecting a
+ * range of items only requires a few intervals, independent of the
+ * number of items.
+ *
+ * Checking whether an index is contained requires a binary search over the
+ * ranges. Adapting the indexes after the model has been changed, see
+ * itemsInserted(), itemsRemoved() and itemsMoved(), requires a time that is
+ * proportional to the number of ranges (and the number of moved items).
+ *
+ * The indexes are iterated in ascending order.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KItemSet
+{
+
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator();
+
+        int operator*() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+
+    private:
+        const_iterator(const QVector<KItemRange>* ranges, int rangeIndex);
+
+        const QVector<KItemRange>* m_ranges;
+        int m_rangeIndex;
+        int m_index;
+
+        friend class KItemSet;
+    };
+
+    KItemSet();
+
+    /**
+     * @return Number of indexes in the set.
+     */
+    int count() const;
+    bool isEmpty() const;
+    void clear();
+
+    bool contains(int index) const;
+
+    /**
+     * @return Smallest and largest index of the set. The set must not be empty.
+     */
+    int first() const;
+    int last() const;
+
+    void insert(int index);
+    void remove(int index);
+
+    void insertRange(int index, int count);
+    void removeRange(int index, int count);
+
+    /**
+     * Inserts all indexes of the range that are not contained
+     * in the set and removes all indexes that are contained.
+     */
+    void toggleRange(int index, int count);
+
+    /**
+     * @return Sorted, disjoint and non-adjacent ranges of the set.
+     */
+    const QVector<KItemRange>& ranges() const;
+
+    /**
+     * Adapts the indexes after items have been inserted into the model.
+     * Like in KItemModelBase::itemsInserted(), the indexes of \a itemRanges
+     * refer to the model before the insertion.
+     */
+    void itemsInserted(const KItemRangeList& itemRanges);
+
+    /**
+     * Removes the indexes of the removed items and adapts the indexes of
+     * the other items, see KItemModelBase::itemsRemoved().
+     */
+    void itemsRemoved(const KItemRangeList& itemRanges);
+
+    /**
+     * Moves the indexes of \a itemRange to \a movedToIndexes,
+     * see KItemModelBase::itemsMoved().
+     */
+    void itemsMoved(const KItemRange& itemRange, const QList<int>& movedToIndexes);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator constBegin() const;
+    const_iterator constEnd() const;
+
+    KItemSet& operator<<(int index);
+
+    /**
+     * @return Union of both sets.
+     */
+    KItemSet operator+(const KItemSet& other) const;
+
+    /**
+     * @return Indexes that are contained in this set, but not in \a other.
+     */
+    KItemSet operator-(const KItemSet& other) const;
+
+    /**
+     * @return Indexes that are contained in exactly one of both sets.
+     */
+    KItemSet operator^(const KItemSet& other) const;
+
+    bool operator==(const KItemSet& other) const;
+    bool operator!=(const KItemSet& other) const;
+
+private:
+    /**
+     * @return Index of the first range that ends after \a index, i.e.,
+     *         that contains \a index or starts after \a index. The number
+     *         of ranges is returned if there is no such range.
+     */
+    int firstRangeEndingAfter(int index) const;
+
+    /**
+     * Replaces the ranges [first, last) by \a replacement and merges the
+     * new ranges with adjacent ranges. The ranges of \a replacement must
+     * be sorted and must fit into the gap between the remaining ranges.
+     */
+    void replaceRanges(int first, int last, const QVector<KItemRange>& replacement);
+
+    /**
+     * Appends \a range to \a ranges. If \a range starts directly after
+     * the last range, the last range is extended instead.
+     */
+    static void appendRange(QVector<KItemRange>& ranges, const KItemRange& range);
+
+    static int countIndexes(const QVector<KItemRange>& ranges);
+
+private:
+    QVector<KItemRange> m_itemRanges;
+    int m_count;
+};
+
+Q_DECLARE_METATYPE(KItemSet)
+
+inline KItemSet::const_iterator::const_iterator() :
+    m_ranges(0),
+    m_rangeIndex(0),
+    m_index(0)
+{
+}
+
+inline KItemSet::const_iterator::const_iterator(const QVector<KItemRange>* ranges, int rangeIndex) :
+    m_ranges(ranges),
+    m_rangeIndex(rangeIndex),
+    m_index(rangeIndex < ranges->count() ? ranges->at(rangeIndex).index : 0)
+{
+}
+
+inline int KItemSet::const_iterator::operator*() const
+{
+    return m_index;
+}
+
+inline KItemSet::const_iterator& KItemSet::const_iterator::operator++()
+{
+    const KItemRange& range = m_ranges->at(m_rangeIndex);
+    ++m_index;
+    if (m_index >= range.index + range.count) {
+        ++m_rangeIndex;
+        m_index = (m_rangeIndex < m_ranges->count()) ? m_ranges->at(m_rangeIndex).index : 0;
+    }
+    return *this;
+}
+
+inline KItemSet::const_iterator KItemSet::const_iterator::operator++(int)
+{
+    const const_iterator result = *this;
+    ++(*this);
+    return result;
+}
+
+inline bool KItemSet::const_iterator::operator==(const const_iterator& other) const
+{
+    return m_rangeIndex == other.m_rangeIndex && m_index == other.m_index;
+}
+
+inline bool KItemSet::const_iterator::operator!=(const const_iterator& other) const
+{
+    return !(*this == other);
+}
+
+inline int KItemSet::count() const
+{
+    return m_count;
+}
+
+inline bool KItemSet::isEmpty() const
+{
+    return m_count == 0;
+}
+
+inline const QVector<KItemRange>& KItemSet::ranges() const
+{
+    return m_itemRanges;
+}
+
+inline KItemSet::const_iterator KItemSet::begin() const
+{
+    return const_iterator(&m_itemRanges, 0);
+}
+
+inline KItemSet::const_iterator KItemSet::end() const
+{
+    return const_iterator(&m_itemRanges, m_itemRanges.count());
+}
+
+inline KItemSet::const_iterator KItemSet::constBegin() const
+{
+    return begin();
+}
+
+inline KItemSet::const_iterator KItemSet::constEnd() const
+{
+    return end();
+}
+
+inline KItemSet& KItemSet::operator<<(int index)
+{
+    insert(index);
+    return *this;
+}
+
+inline bool KItemSet::operator==(const KItemSet& other) const
+{
+    return m_count == other.m_count && m_itemRanges == other.m_itemRanges;
+}
+
+inline bool KItemSet::operator!=(const KItemSet& other) const
+{
+    return !(*this == other);
+}
+
+#endif
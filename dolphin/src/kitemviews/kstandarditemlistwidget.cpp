@@ -32,6 +32,7 @@
 
 #include "private/kfileitemclipboard.h"
 #include "private/kitemlistroleeditor.h"
+#include "private/kitemlisttextheightresolver.h"
 #include "private/kpixmapmodifier.h"
 
 #include <QFontMetricsF>
@@ -46,6 +47,12 @@
 
 // #define KSTANDARDITEMLISTWIDGET_DEBUG
 
+namespace {
+    // Number of different blended pixmaps that are shown during the
+    // hover animation, see KStandardItemListWidget::paint()
+    const int HoverOpacitySteps = 16;
+}
+
 KStandardItemListWidgetInformant::KStandardItemListWidgetInformant() :
     KItemListWidgetInformant()
 {
@@ -66,27 +73,17 @@ QSizeF KStandardItemListWidgetInformant::itemSizeHint(int index, const KItemList
 
         const qreal itemWidth = view->itemSize().width();
         const qreal maxWidth = itemWidth - 2 * option.padding;
-        QTextLine line;
-
-        // Calculate the number of lines required for wrapping the name
-        QTextOption textOption(Qt::AlignHCenter);
-        textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        const qreal maxTextHeight = option.maxTextSize.height();
 
-        qreal textHeight = 0;
-        QTextLayout layout(text, option.font);
-        layout.setTextOption(textOption);
-        layout.beginLayout();
-        while ((line = layout.createLine()).isValid()) {
-            line.setLineWidth(maxWidth);
-            line.naturalTextWidth();
-            textHeight += line.height();
-        }
-        layout.endLayout();
+        // Calculate the height that is required for wrapping the name. The text
+        // is laid out asynchronously, and an estimated height is used until the
+        // exact height is known (see KItemListTextHeightResolver).
+        qreal textHeight = KItemListTextHeightResolver::instance()->textHeight(text, option.font, maxWidth, maxTextHeight,
+                                                                               0, view, index);
 
         // Add one line for each additional information
         textHeight += additionalRolesCount * option.fontMetrics.lineSpacing();
 
-        const qreal maxTextHeight = option.maxTextSize.height();
         if (maxTextHeight > 0 && textHeight > maxTextHeight) {
             textHeight = maxTextHeight;
         }
@@ -191,6 +188,9 @@ KStandardItemListWidget::KStandardItemListWidget(KItemListWidgetInformant* infor
     m_scaledPixmapSize(),
     m_iconRect(),
     m_hoverPixmap(),
+    m_pixmapImage(),
+    m_hoverImage(),
+    m_blendedPixmaps(),
     m_textInfo(),
     m_textRect(),
     m_sortedVisibleRoles(),
@@ -267,39 +267,35 @@ void KStandardItemListWidget::paint(QPainter* painter, const QStyleOptionGraphic
              * m_pixmap, even if the opacities are adjusted. For details see
              * https://git.reviewboard.kde.org/r/109614/
              */
-            // Paint pixmap1 so that pixmap1 = m_pixmap * (1.0 - hoverOpacity())
-            QPixmap pixmap1(m_pixmap.size());
-            pixmap1.fill(Qt::transparent);
-            {
-                QPainter p(&pixmap1);
-                p.setOpacity(1.0 - hoverOpacity());
-                p.drawPixmap(0, 0, m_pixmap);
-            }
-
-            // Paint pixmap2 so that pixmap2 = m_hoverPixmap * hoverOpacity()
-            QPixmap pixmap2(pixmap1.size());
-            pixmap2.fill(Qt::transparent);
-            {
-                QPainter p(&pixmap2);
-                p.setOpacity(hoverOpacity());
-                p.drawPixmap(0, 0, m_hoverPixmap);
-            }
-
-            // Paint pixmap2 on pixmap1 using CompositionMode_Plus
-            // Now pixmap1 = pixmap2 + m_pixmap * (1.0 - hoverOpacity())
-            //             = m_hoverPixmap * hoverOpacity() + m_pixmap * (1.0 - hoverOpacity())
-            {
-                QPainter p(&pixmap1);
-                p.setCompositionMode(QPainter::CompositionMode_Plus);
-                p.drawPixmap(0, 0, pixmap2);
+            if (m_hoverPixmap.cacheKey() == m_pixmap.cacheKey()) {
+                // No icon effect is active for hovered items
+                drawPixmap(painter, m_pixmap);
+            } else {
+                // The opacity is rounded to HoverOpacitySteps steps, and the
+                // blended pixmap of each step is created only once during
+                // the hover animation.
+                const int step = qRound(hoverOpacity() * HoverOpacitySteps);
+                if (m_blendedPixmaps.isEmpty()) {
+                    m_blendedPixmaps.resize(HoverOpacitySteps + 1);
+                }
+
+                QPixmap& blendedPixmap = m_blendedPixmaps[qBound(0, step, HoverOpacitySteps)];
+                if (blendedPixmap.isNull()) {
+                    if (m_pixmapImage.isNull()) {
+                        m_pixmapImage = m_pixmap.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+                        m_hoverImage = m_hoverPixmap.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+                    }
+                    const qreal factor = qreal(step) / HoverOpacitySteps;
+                    blendedPixmap = QPixmap::fromImage(KPixmapModifier::blend(m_pixmapImage, m_hoverImage, factor));
+                }
+                drawPixmap(painter, blendedPixmap);
             }
-
-            // Finally paint pixmap1 on the widget
-            drawPixmap(painter, pixmap1);
         } else {
+            clearBlendedPixmaps();
             drawPixmap(painter, m_hoverPixmap);
         }
     } else {
+        clearBlendedPixmaps();
         drawPixmap(painter, m_pixmap);
     }
 
@@ -923,6 +919,14 @@ void KStandardItemListWidget::updatePixmapCache()
         // No hover animation is ongoing. Clear m_hoverPixmap to save memory.
         m_hoverPixmap = QPixmap();
     }
+    clearBlendedPixmaps();
+}
+
+void KStandardItemListWidget::clearBlendedPixmaps()
+{
+    m_pixmapImage = QImage();
+    m_hoverImage = QImage();
+    m_blendedPixmaps.clear();
 }
 
 void KStandardItemListWidget::updateTextsCache()
@@ -24,9 +24,11 @@
 
 #include <kitemviews/kitemlistwidget.h>
 
+#include <QImage>
 #include <QPixmap>
 #include <QPointF>
 #include <QStaticText>
+#include <QVector>
 
 class KItemListRoleEditor;
 class KItemListStyleOption;
@@ -177,6 +179,12 @@ private:
     void updateExpansionArea();
     void updatePixmapCache();
 
+    /**
+     * Releases the images and pixmaps that are only needed
+     * while the hover animation is running.
+     */
+    void clearBlendedPixmaps();
+
     void updateTextsCache();
     void updateIconsLayoutTextCache();
     void updateCompactLayoutTextCache();
@@ -229,6 +237,9 @@ private:
 
     QRectF m_iconRect;          // Cache for KItemListWidget::iconRect()
     QPixmap m_hoverPixmap;      // Cache for modified m_pixmap when hovering the item
+    QImage m_pixmapImage;       // Caches for blending m_pixmap and m_hoverPixmap
+    QImage m_hoverImage;        // during the hover animation
+    QVector<QPixmap> m_blendedPixmaps; // Blended pixmap for each opacity step of the hover animation
 
     struct TextInfo
     {
@@ -24,81 +24,212 @@
 #include <kitemviews/kfileitemmodel.h>
 
 #include <KDirWatch>
+#include <KGlobal>
+
+#include <QMutex>
+#include <QRunnable>
 #include <QThread>
+#include <QThreadPool>
+
+namespace {
+    // Counting is mostly limited by the latency of the file system, so
+    // using more workers than cores is useful for network file systems.
+    int defaultWorkerCount()
+    {
+        return qBound(2, QThread::idealThreadCount(), 4);
+    }
+}
+
+class KDirectoryContentsCounterThreadPoolSingleton
+{
+public:
+    KDirectoryContentsCounterThreadPoolSingleton()
+    {
+        instance.setMaxThreadCount(defaultWorkerCount());
+    }
+
+    QThreadPool instance;
+};
+K_GLOBAL_STATIC(KDirectoryContentsCounterThreadPoolSingleton, s_threadPool)
+
+/**
+ * Allows the tasks that are running in the thread pool to pass their
+ * results to the counter. The counter is reset when the counter is
+ * deleted, so the results of tasks that are still running get dropped.
+ */
+struct KDirectoryContentsCounterLink
+{
+    KDirectoryContentsCounterLink(KDirectoryContentsCounter* counter) :
+        mutex(),
+        counter(counter)
+    {
+    }
+
+    QMutex mutex;
+    KDirectoryContentsCounter* counter;
+};
+
+class KDirectoryContentsCounterTask : public QRunnable
+{
+public:
+    KDirectoryContentsCounterTask(const QSharedPointer<KDirectoryContentsCounterLink>& link,
+                                  const QString& path,
+                                  KDirectoryContentsCounterWorker::Options options) :
+        QRunnable(),
+        m_link(link),
+        m_path(path),
+        m_options(options)
+    {
+    }
+
+    virtual void run()
+    {
+        const int count = KDirectoryContentsCounterWorker::subItemsCount(m_path, m_options);
+
+        QMutexLocker locker(&m_link->mutex);
+        if (m_link->counter) {
+            QMetaObject::invokeMethod(m_link->counter, "slotResult", Qt::QueuedConnection,
+                                      Q_ARG(QString, m_path),
+                                      Q_ARG(int, count));
+        }
+    }
+
+private:
+    QSharedPointer<KDirectoryContentsCounterLink> m_link;
+    QString m_path;
+    KDirectoryContentsCounterWorker::Options m_options;
+};
 
 KDirectoryContentsCounter::KDirectoryContentsCounter(KFileItemModel* model, QObject* parent) :
     QObject(parent),
     m_model(model),
-    m_queue(),
-    m_workerThread(0),
-    m_worker(0),
-    m_workerIsBusy(false),
+    m_highPriorityQueue(),
+    m_lowPriorityQueue(),
+    m_queuedDirs(),
+    m_cancelledDirs(),
+    m_maximumWorkerCount(defaultWorkerCount()),
+    m_runningTaskCount(0),
+    m_link(new KDirectoryContentsCounterLink(this)),
     m_dirWatcher(0),
     m_watchedDirs()
 {
     connect(m_model, SIGNAL(itemsRemoved(KItemRangeList)),
             this,    SLOT(slotItemsRemoved()));
 
-    m_workerThread = new QThread(this);
-    m_worker = new KDirectoryContentsCounterWorker();
-    m_worker->moveToThread(m_workerThread);
-
-    connect(this,     SIGNAL(requestDirectoryContentsCount(QString,KDirectoryContentsCounterWorker::Options)),
-            m_worker, SLOT(countDirectoryContents(QString,KDirectoryContentsCounterWorker::Options)));
-    connect(m_worker, SIGNAL(result(QString,int)),
-            this,     SLOT(slotResult(QString,int)));
-
-    m_workerThread->start();
-
     m_dirWatcher = new KDirWatch(this);
     connect(m_dirWatcher, SIGNAL(dirty(QString)), this, SLOT(slotDirWatchDirty(QString)));
 }
 
 KDirectoryContentsCounter::~KDirectoryContentsCounter()
 {
-    m_workerThread->quit();
-    m_workerThread->wait();
+    // Results that are posted already are discarded by the QObject destructor
+    QMutexLocker locker(&m_link->mutex);
+    m_link->counter = 0;
+}
 
-    delete m_worker;
+void KDirectoryContentsCounter::setMaximumWorkerCount(int count)
+{
+    m_maximumWorkerCount = qMax(1, count);
+    startWorkers();
 }
 
-void KDirectoryContentsCounter::addDirectory(const QString& path)
+int KDirectoryContentsCounter::maximumWorkerCount() const
 {
-    startWorker(path);
+    return m_maximumWorkerCount;
 }
 
-int KDirectoryContentsCounter::countDirectoryContentsSynchronously(const QString& path)
+void KDirectoryContentsCounter::addDirectory(const QString& path, Priority priority)
 {
-    if (!m_dirWatcher->contains(path)) {
-        m_dirWatcher->addDir(path);
-        m_watchedDirs.insert(path);
+    m_cancelledDirs.remove(path);
+
+    if (m_queuedDirs.contains(path)) {
+        if (priority == HighPriority && m_lowPriorityQueue.removeOne(path)) {
+            m_highPriorityQueue.append(path);
+        }
+        return;
     }
 
-    KDirectoryContentsCounterWorker::Options options;
+    m_queuedDirs.insert(path);
+    if (priority == HighPriority) {
+        m_highPriorityQueue.append(path);
+    } else {
+        m_lowPriorityQueue.append(path);
+    }
 
-    if (m_model->showHiddenFiles()) {
-        options |= KDirectoryContentsCounterWorker::CountHiddenFiles;
+    startWorkers();
+}
+
+void KDirectoryContentsCounter::setVisibleDirectories(const QSet<QString>& paths)
+{
+    if (m_queuedDirs.isEmpty() && m_cancelledDirs.isEmpty()) {
+        return;
     }
 
-    if (m_model->showDirectoriesOnly()) {
-        options |= KDirectoryContentsCounterWorker::CountDirectoriesOnly;
+    // The high priority requests have been visible before. Counting them
+    // does not make sense anymore if they have been scrolled away.
+    QList<QString> highPriorityQueue;
+    foreach (const QString& path, m_highPriorityQueue) {
+        if (paths.contains(path)) {
+            highPriorityQueue.append(path);
+        } else {
+            m_queuedDirs.remove(path);
+            m_cancelledDirs.insert(path);
+        }
     }
 
-    return KDirectoryContentsCounterWorker::subItemsCount(path, options);
+    QList<QString> lowPriorityQueue;
+    foreach (const QString& path, m_lowPriorityQueue) {
+        if (paths.contains(path)) {
+            highPriorityQueue.append(path);
+        } else {
+            lowPriorityQueue.append(path);
+        }
+    }
+
+    // Request the cancelled directories again that are visible again
+    QMutableSetIterator<QString> it(m_cancelledDirs);
+    while (it.hasNext()) {
+        const QString& path = it.next();
+        if (paths.contains(path)) {
+            highPriorityQueue.append(path);
+            m_queuedDirs.insert(path);
+            it.remove();
+        }
+    }
+
+    m_highPriorityQueue = highPriorityQueue;
+    m_lowPriorityQueue = lowPriorityQueue;
+
+    startWorkers();
 }
 
-void KDirectoryContentsCounter::slotResult(const QString& path, int count)
+bool KDirectoryContentsCounter::hasPendingRequests() const
 {
-    m_workerIsBusy = false;
+    return !m_queuedDirs.isEmpty() || !m_cancelledDirs.isEmpty();
+}
+
+int KDirectoryContentsCounter::countDirectoryContentsSynchronously(const QString& path)
+{
+    watchDirectory(path);
+
+    return KDirectoryContentsCounterWorker::subItemsCount(path, workerOptions());
+}
 
+void KDirectoryContentsCounter::watchDirectory(const QString& path)
+{
     if (!m_dirWatcher->contains(path)) {
         m_dirWatcher->addDir(path);
         m_watchedDirs.insert(path);
     }
+}
 
-    if (!m_queue.isEmpty()) {
-        startWorker(m_queue.dequeue());
-    }
+void KDirectoryContentsCounter::slotResult(const QString& path, int count)
+{
+    --m_runningTaskCount;
+
+    watchDirectory(path);
+
+    startWorkers();
 
     emit result(path, count);
 }
@@ -114,7 +245,7 @@ void KDirectoryContentsCounter::slotDirWatchDirty(const QString& path)
             return;
         }
 
-        startWorker(path);
+        addDirectory(path);
     }
 }
 
@@ -122,6 +253,32 @@ void KDirectoryContentsCounter::slotItemsRemoved()
 {
     const bool allItemsRemoved = (m_model->count() == 0);
 
+    if (allItemsRemoved) {
+        m_highPriorityQueue.clear();
+        m_lowPriorityQueue.clear();
+        m_queuedDirs.clear();
+        m_cancelledDirs.clear();
+    } else {
+        // Cancel the requests for removed items
+        QMutableSetIterator<QString> it(m_queuedDirs);
+        while (it.hasNext()) {
+            const QString& path = it.next();
+            if (m_model->index(KUrl(path)) < 0) {
+                if (!m_highPriorityQueue.removeOne(path)) {
+                    m_lowPriorityQueue.removeOne(path);
+                }
+                it.remove();
+            }
+        }
+
+        QMutableSetIterator<QString> cancelledIt(m_cancelledDirs);
+        while (cancelledIt.hasNext()) {
+            if (m_model->index(KUrl(cancelledIt.next())) < 0) {
+                cancelledIt.remove();
+            }
+        }
+    }
+
     if (!m_watchedDirs.isEmpty()) {
         // Don't let KDirWatch watch for removed items
         if (allItemsRemoved) {
@@ -129,7 +286,6 @@ void KDirectoryContentsCounter::slotItemsRemoved()
                 m_dirWatcher->removeDir(path);
             }
             m_watchedDirs.clear();
-            m_queue.clear();
         } else {
             QMutableSetIterator<QString> it(m_watchedDirs);
             while (it.hasNext()) {
@@ -143,22 +299,35 @@ void KDirectoryContentsCounter::slotItemsRemoved()
     }
 }
 
-void KDirectoryContentsCounter::startWorker(const QString& path)
+KDirectoryContentsCounterWorker::Options KDirectoryContentsCounter::workerOptions() const
 {
-    if (m_workerIsBusy) {
-        m_queue.enqueue(path);
-    } else {
-        KDirectoryContentsCounterWorker::Options options;
+    KDirectoryContentsCounterWorker::Options options;
 
-        if (m_model->showHiddenFiles()) {
-            options |= KDirectoryContentsCounterWorker::CountHiddenFiles;
-        }
+    if (m_model->showHiddenFiles()) {
+        options |= KDirectoryContentsCounterWorker::CountHiddenFiles;
+    }
 
-        if (m_model->showDirectoriesOnly()) {
-            options |= KDirectoryContentsCounterWorker::CountDirectoriesOnly;
-        }
+    if (m_model->showDirectoriesOnly()) {
+        options |= KDirectoryContentsCounterWorker::CountDirectoriesOnly;
+    }
+
+    return options;
+}
+
+void KDirectoryContentsCounter::startWorkers()
+{
+    if (m_queuedDirs.isEmpty()) {
+        return;
+    }
+
+    const KDirectoryContentsCounterWorker::Options options = workerOptions();
+
+    while (!m_queuedDirs.isEmpty() && m_runningTaskCount < m_maximumWorkerCount) {
+        const QString path = m_highPriorityQueue.isEmpty() ? m_lowPriorityQueue.takeFirst()
+                                                           : m_highPriorityQueue.takeFirst();
+        m_queuedDirs.remove(path);
 
-        emit requestDirectoryContentsCount(path, options);
-        m_workerIsBusy = true;
+        ++m_runningTaskCount;
+        s_threadPool->instance.start(new KDirectoryContentsCounterTask(m_link, path, options));
     }
 }
@@ -23,30 +23,77 @@
 
 #include "kdirectorycontentscounterworker.h"
 
+#include <libdolphin_export.h>
+
+#include <QList>
 #include <QSet>
-#include <QQueue>
+#include <QSharedPointer>
 
 class KDirWatch;
 class KFileItemModel;
 class QString;
-
-class KDirectoryContentsCounter : public QObject
+struct KDirectoryContentsCounterLink;
+
+/**
+ * @brief Counts the items inside directories asynchronously.
+ *
+ * The counting is done by a thread pool that is shared by all counters,
+ * so several directories are counted in parallel. This prevents that the
+ * results arrive at the speed of one round trip per directory on network
+ * file systems. Requests for directories with a high priority, e.g., the
+ * visible directories, are handled before all other requests.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KDirectoryContentsCounter : public QObject
 {
     Q_OBJECT
 
 public:
+    enum Priority {
+        LowPriority,
+        HighPriority
+    };
+
     explicit KDirectoryContentsCounter(KFileItemModel* model, QObject* parent = 0);
     ~KDirectoryContentsCounter();
 
+    /**
+     * Sets the maximum number of directories of this counter that are
+     * counted in parallel. The number of threads of the shared thread pool
+     * is not changed. Reducing the number does not stop directories that
+     * are counted already, but no new requests are started beyond the
+     * new maximum.
+     */
+    void setMaximumWorkerCount(int count);
+    int maximumWorkerCount() const;
+
     /**
      * Requests the number of items inside the directory \a path. The actual
      * counting is done asynchronously, and the result is announced via the
-     * signal \a result.
+     * signal \a result. Requests with the priority HighPriority are handled
+     * before all requests with the priority LowPriority.
      *
      * The directory \a path is watched for changes, and the signal is emitted
      * again if a change occurs.
      */
-    void addDirectory(const QString& path);
+    void addDirectory(const QString& path, Priority priority = LowPriority);
+
+    /**
+     * Assigns the priority HighPriority to the pending requests for the
+     * visible directories \a paths. This allows to count the visible
+     * directories first.
+     *
+     * Pending requests with the priority HighPriority for directories that
+     * are not part of \a paths anymore, e.g., because they have been scrolled
+     * away, are cancelled. They are requested again as soon as the
+     * directories are part of \a paths again.
+     */
+    void setVisibleDirectories(const QSet<QString>& paths);
+
+    /**
+     * @return True if there are requests that have not been started yet
+     *         or that have been cancelled by setVisibleDirectories().
+     */
+    bool hasPendingRequests() const;
 
     /**
      * In contrast to \a addDirectory, this function counts the items inside
@@ -57,34 +104,52 @@ public:
      */
     int countDirectoryContentsSynchronously(const QString& path);
 
+    /**
+     * Watches the directory \a path for changes without counting its items,
+     * which is useful if the number of items is known already. The signal
+     * \a result is emitted if a change occurs.
+     */
+    void watchDirectory(const QString& path);
+
+    /**
+     * @return Options that are used for counting the items with the
+     *         current settings of the model.
+     */
+    KDirectoryContentsCounterWorker::Options workerOptions() const;
+
 signals:
     /**
      * Signals that the directory \a path contains \a count items.
      */
     void result(const QString& path, int count);
 
-    void requestDirectoryContentsCount(const QString& path, KDirectoryContentsCounterWorker::Options options);
-
 private slots:
     void slotResult(const QString& path, int count);
     void slotDirWatchDirty(const QString& path);
     void slotItemsRemoved();
 
 private:
-    void startWorker(const QString& path);
+    /**
+     * Passes pending requests to the shared thread pool as long as
+     * the maximum worker count has not been reached.
+     */
+    void startWorkers();
 
 private:
     KFileItemModel* m_model;
 
-    QQueue<QString> m_queue;
+    QList<QString> m_highPriorityQueue;
+    QList<QString> m_lowPriorityQueue;
+    QSet<QString> m_queuedDirs;
+    QSet<QString> m_cancelledDirs;
 
-    QThread* m_workerThread;
-    KDirectoryContentsCounterWorker* m_worker;
-    bool m_workerIsBusy;
+    int m_maximumWorkerCount;
+    int m_runningTaskCount;
+    QSharedPointer<KDirectoryContentsCounterLink> m_link;
 
     KDirWatch* m_dirWatcher;
     QSet<QString> m_watchedDirs;    // Required as sadly KDirWatch does not offer a getter method
                                     // to get all watched directories.
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -28,6 +28,90 @@
     #include <QFile>
 #endif
 
+#ifdef Q_OS_LINUX
+    #include <fcntl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#ifndef Q_WS_WIN
+namespace {
+    /**
+     * @return True if the directory entry with the name \a name and the
+     *         type \a type (as in struct dirent::d_type) must be counted.
+     */
+    inline bool isCountedEntry(const char* name, unsigned char type,
+                               bool countHiddenFiles, bool countDirectoriesOnly)
+    {
+        if (name[0] == '.') {
+            if (name[1] == '\0' || !countHiddenFiles) {
+                // Skip "." or hidden files
+                return false;
+            }
+            if (name[1] == '.' && name[2] == '\0') {
+                // Skip ".."
+                return false;
+            }
+        }
+
+        // If only directories are counted, consider an unknown file type and links also
+        // as directory instead of trying to do an expensive stat()
+        // (see bugs 292642 and 299997).
+        return !countDirectoriesOnly ||
+               type == DT_DIR ||
+               type == DT_LNK ||
+               type == DT_UNKNOWN;
+    }
+
+#ifdef Q_OS_LINUX
+    // Layout of the records that are returned by the getdents64 system call.
+    struct LinuxDirent64
+    {
+        quint64 d_ino;
+        qint64 d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    /**
+     * Counts the directory entries with getdents64. In contrast to readdir(),
+     * which fetches only a few entries per system call, a large buffer is
+     * passed to the kernel. This reduces the number of round trips on
+     * network file systems considerably.
+     *
+     * @return The number of items or -1 if the directory cannot be opened.
+     */
+    int countWithGetdents(const QByteArray& path, bool countHiddenFiles, bool countDirectoriesOnly)
+    {
+        const int fd = ::open(path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+
+        // 64 KiB, aligned for LinuxDirent64
+        quint64 buffer[8192];
+
+        int count = 0;
+        long readBytes;
+        while ((readBytes = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0) {
+            const char* data = reinterpret_cast<const char*>(buffer);
+            for (long offset = 0; offset < readBytes;) {
+                const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(data + offset);
+                if (isCountedEntry(entry->d_name, entry->d_type, countHiddenFiles, countDirectoriesOnly)) {
+                    ++count;
+                }
+                offset += entry->d_reclen;
+            }
+        }
+
+        ::close(fd);
+        return (readBytes < 0) ? -1 : count;
+    }
+#endif
+}
+#endif
+
 KDirectoryContentsCounterWorker::KDirectoryContentsCounterWorker(QObject* parent) :
     QObject(parent)
 {
@@ -51,6 +135,8 @@ int KDirectoryContentsCounterWorker::subItemsCount(const QString& path, Options
         filters |= QDir::AllEntries;
     }
     return dir.entryList(filters).count();
+#elif defined(Q_OS_LINUX)
+    return countWithGetdents(QFile::encodeName(path), countHiddenFiles, countDirectoriesOnly);
 #else
     // Taken from kdelibs/kio/kio/kdirmodel.cpp
     // Copyright (C) 2006 David Faure <faure@kde.org>
@@ -61,25 +147,7 @@ int KDirectoryContentsCounterWorker::subItemsCount(const QString& path, Options
         count = 0;
         struct dirent *dirEntry = 0;
         while ((dirEntry = ::readdir(dir))) {
-            if (dirEntry->d_name[0] == '.') {
-                if (dirEntry->d_name[1] == '\0' || !countHiddenFiles) {
-                    // Skip "." or hidden files
-                    continue;
-                }
-                if (dirEntry->d_name[1] == '.' && dirEntry->d_name[2] == '\0') {
-                    // Skip ".."
-                    continue;
-                }
-            }
-
-            // If only directories are counted, consider an unknown file type and links also
-            // as directory instead of trying to do an expensive stat()
-            // (see bugs 292642 and 299997).
-            const bool countEntry = !countDirectoriesOnly ||
-                                    dirEntry->d_type == DT_DIR ||
-                                    dirEntry->d_type == DT_LNK ||
-                                    dirEntry->d_type == DT_UNKNOWN;
-            if (countEntry) {
+            if (isCountedEntry(dirEntry->d_name, dirEntry->d_type, countHiddenFiles, countDirectoriesOnly)) {
                 ++count;
             }
         }
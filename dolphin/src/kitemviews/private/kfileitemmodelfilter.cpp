@@ -38,8 +38,11 @@ KFileItemModelFilter::~KFileItemModelFilter()
     m_regExp = 0;
 }
 
-void KFileItemModelFilter::setPattern(const QString& filter)
+KFileItemModelFilter::FilterChange KFileItemModelFilter::setPattern(const QString& filter)
 {
+    const bool usedRegExp = m_useRegExp;
+    const QString previousLowerCasePattern = m_lowerCasePattern;
+
     m_pattern = filter;
     m_lowerCasePattern = filter.toLower();
 
@@ -55,6 +58,20 @@ void KFileItemModelFilter::setPattern(const QString& filter)
         }
         m_regExp->setPattern(filter);
     }
+
+    if (previousLowerCasePattern.isEmpty()) {
+        return NarrowingChange;
+    } else if (m_lowerCasePattern.isEmpty()) {
+        return WideningChange;
+    } else if (usedRegExp || m_useRegExp) {
+        return ArbitraryChange;
+    } else if (m_lowerCasePattern.contains(previousLowerCasePattern)) {
+        // Each name that contains the new pattern also contains the previous one
+        return NarrowingChange;
+    } else if (previousLowerCasePattern.contains(m_lowerCasePattern)) {
+        return WideningChange;
+    }
+    return ArbitraryChange;
 }
 
 QString KFileItemModelFilter::pattern() const
@@ -62,9 +79,23 @@ QString KFileItemModelFilter::pattern() const
     return m_pattern;
 }
 
-void KFileItemModelFilter::setMimeTypes(const QStringList& types)
+KFileItemModelFilter::FilterChange KFileItemModelFilter::setMimeTypes(const QStringList& types)
 {
+    const QSet<QString> previousMimeTypeSet = m_mimeTypeSet;
+
     m_mimeTypes = types;
+    m_mimeTypeSet = types.toSet();
+
+    if (previousMimeTypeSet.isEmpty()) {
+        return NarrowingChange;
+    } else if (m_mimeTypeSet.isEmpty()) {
+        return WideningChange;
+    } else if (previousMimeTypeSet.contains(m_mimeTypeSet)) {
+        return NarrowingChange;
+    } else if (m_mimeTypeSet.contains(previousMimeTypeSet)) {
+        return WideningChange;
+    }
+    return ArbitraryChange;
 }
 
 QStringList KFileItemModelFilter::mimeTypes() const
@@ -79,6 +110,11 @@ bool KFileItemModelFilter::hasSetFilters() const
 
 
 bool KFileItemModelFilter::matches(const KFileItem& item) const
+{
+    return matches(item, QString());
+}
+
+bool KFileItemModelFilter::matches(const KFileItem& item, const QString& lowerCaseText) const
 {
     const bool hasPatternFilter = !m_pattern.isEmpty();
     const bool hasMimeTypesFilter = !m_mimeTypes.isEmpty();
@@ -90,33 +126,29 @@ bool KFileItemModelFilter::matches(const KFileItem& item) const
 
     // If both filters are set, return true when both filters are matched
     if (hasPatternFilter && hasMimeTypesFilter) {
-        return (matchesPattern(item) && matchesType(item));
+        return (matchesPattern(item, lowerCaseText) && matchesType(item));
     }
 
     // If only one filter is set, return true when that filter is matched
     if (hasPatternFilter) {
-        return matchesPattern(item);
+        return matchesPattern(item, lowerCaseText);
     }
 
     return matchesType(item);
 }
 
-bool KFileItemModelFilter::matchesPattern(const KFileItem& item) const
+bool KFileItemModelFilter::matchesPattern(const KFileItem& item, const QString& lowerCaseText) const
 {
     if (m_useRegExp) {
         return m_regExp->exactMatch(item.text());
-    } else {
+    } else if (lowerCaseText.isEmpty()) {
         return item.text().toLower().contains(m_lowerCasePattern);
+    } else {
+        return lowerCaseText.contains(m_lowerCasePattern);
     }
 }
 
 bool KFileItemModelFilter::matchesType(const KFileItem& item) const
 {
-    foreach (const QString& mimeType, m_mimeTypes) {
-        if (item.mimetype() == mimeType) {
-            return true;
-        }
-    }
-
-    return m_mimeTypes.isEmpty();
+    return m_mimeTypeSet.isEmpty() || m_mimeTypeSet.contains(item.mimetype());
 }
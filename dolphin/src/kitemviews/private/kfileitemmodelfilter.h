@@ -22,6 +22,7 @@
 #define KFILEITEMMODELFILTER_H
 
 #include <libdolphin_export.h>
+#include <QSet>
 #include <QStringList>
 
 class KFileItem;
@@ -34,11 +35,23 @@ class QRegExp;
  * Currently the filter is only checked for the KFileItem::text()
  * property of the KFileItem, but this might get extended in
  * future.
+ *
+ * The setters return how the set of matching items is affected by the
+ * change. This allows KFileItemModel to refine the filtering incrementally:
+ * If the user appends a character to the pattern, only the items that matched
+ * before need to be checked again. If a character is removed, only the items
+ * that did not match before need to be checked again.
  */
 class LIBDOLPHINPRIVATE_EXPORT KFileItemModelFilter
 {
 
 public:
+    enum FilterChange {
+        NarrowingChange,    // No item that did not match before matches now
+        WideningChange,     // No item that matched before does not match now
+        ArbitraryChange
+    };
+
     KFileItemModelFilter();
     virtual ~KFileItemModelFilter();
 
@@ -48,14 +61,14 @@ public:
      * defines a sub-string. As soon as the pattern contains at least
      * a '*', '?' or '[' the pattern represents a regular expression.
      */
-    void setPattern(const QString& pattern);
+    FilterChange setPattern(const QString& pattern);
     QString pattern() const;
 
     /**
      * Set the list of mimetypes that are used for comparison with the
      * item in KFileItemModelFilter::matchesMimeType.
      */
-    void setMimeTypes(const QStringList& types);
+    FilterChange setMimeTypes(const QStringList& types);
     QStringList mimeTypes() const;
 
     /**
@@ -69,11 +82,18 @@ public:
      */
     bool matches(const KFileItem& item) const;
 
+    /**
+     * Like matches(const KFileItem&), but the lowercase version of the
+     * item text is provided by the caller, who can cache it. If \a lowerCaseText
+     * is empty, it is calculated if required.
+     */
+    bool matches(const KFileItem& item, const QString& lowerCaseText) const;
+
 private:
     /**
      * @return True if item matches pattern set by @ref setPattern.
      */
-    bool matchesPattern(const KFileItem& item) const;
+    bool matchesPattern(const KFileItem& item, const QString& lowerCaseText) const;
 
     /**
      * @return True if item matches mimetypes set by @ref setMimeTypes.
@@ -87,6 +107,7 @@ private:
                                 // faster comparison in matches().
     QString m_pattern;          // Property set by setPattern().
     QStringList m_mimeTypes;    // Property set by setMimeTypes()
+    QSet<QString> m_mimeTypeSet; // Set of m_mimeTypes for a fast lookup
 };
 #endif
 
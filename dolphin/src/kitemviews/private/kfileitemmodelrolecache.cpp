@@ -0,0 +1,576 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kfileitemmodelrolecache.h"
+
+#include <KFileItem>
+#include <KGlobal>
+#include <KLocale>
+#include <KSaveFile>
+#include <KStandardDirs>
+#include <kio/udsentry.h>
+
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QTimer>
+
+#include <cstring>
+
+namespace {
+    // "DRC1" in the native byte order. Files that have been written on
+    // machines with another byte order are ignored.
+    const quint32 Magic = 0x31435244;
+    const quint32 Version = 2;
+
+    // Upper limit for the number of entries in the cache file.
+    const int MaxEntries = 200000;
+
+    // Minimum time in milliseconds between writing the cache file
+    // in the background.
+    const int SaveInterval = 30000;
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 recordCount;
+        quint32 stringCount;
+    };
+}
+
+class KFileItemModelRoleCacheSingleton
+{
+public:
+    KFileItemModelRoleCacheSingleton() :
+        instance(KStandardDirs::locateLocal("cache", "dolphin/rolecache"))
+    {
+        if (qApp) {
+            // Changes that have not been written by a background save
+            // yet must not get lost.
+            QObject::connect(qApp, SIGNAL(aboutToQuit()), &instance, SLOT(save()));
+        }
+    }
+
+    KFileItemModelRoleCache instance;
+};
+K_GLOBAL_STATIC(KFileItemModelRoleCacheSingleton, s_roleCache)
+
+class KFileItemModelRoleCacheSaveTask : public QRunnable
+{
+public:
+    KFileItemModelRoleCacheSaveTask(KFileItemModelRoleCache* cache, int saveId) :
+        m_cache(cache),
+        m_saveId(saveId),
+        m_fileName(cache->m_fileName),
+        m_language(cache->m_language),
+        m_values(cache->m_savingValues)
+    {
+    }
+
+    virtual void run()
+    {
+        const bool success = KFileItemModelRoleCache::writeFile(m_fileName, m_language, m_values);
+        QMetaObject::invokeMethod(m_cache, "slotBackgroundSaveFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, m_saveId), Q_ARG(bool, success));
+    }
+
+private:
+    KFileItemModelRoleCache* m_cache;
+    const int m_saveId;
+    const QString m_fileName;
+    const QString m_language;
+    const QHash<KFileItemModelRoleCache::Key, KFileItemModelRoleCache::Value> m_values;
+};
+
+
+
+uint qHash(const KFileItemModelRoleCache::Key& key)
+{
+    return qHash(key.inode) ^ qHash(key.device);
+}
+
+KFileItemModelRoleCache::KFileItemModelRoleCache(const QString& fileName, QObject* parent) :
+    QObject(parent),
+    m_fileName(fileName),
+    m_language(KGlobal::locale()->language()),
+    m_file(),
+    m_records(0),
+    m_recordCount(0),
+    m_strings(),
+    m_changedValues(),
+    m_saveTimer(0),
+    m_savePool(),
+    m_saveId(0),
+    m_saving(false),
+    m_savingValues()
+{
+    m_savePool.setMaxThreadCount(1);
+    load();
+}
+
+KFileItemModelRoleCache::KFileItemModelRoleCache(const QString& fileName, const QString& language) :
+    QObject(0),
+    m_fileName(fileName),
+    m_language(language),
+    m_file(),
+    m_records(0),
+    m_recordCount(0),
+    m_strings(),
+    m_changedValues(),
+    m_saveTimer(0),
+    m_savePool(),
+    m_saveId(0),
+    m_saving(false),
+    m_savingValues()
+{
+    load();
+}
+
+KFileItemModelRoleCache::~KFileItemModelRoleCache()
+{
+    m_savePool.waitForDone();
+    unload();
+}
+
+KFileItemModelRoleCache* KFileItemModelRoleCache::instance()
+{
+    return &s_roleCache->instance;
+}
+
+bool KFileItemModelRoleCache::lookup(const KFileItem& item, Entry& entry) const
+{
+    Key key;
+    qint64 modificationTime;
+    qint64 size;
+    if (!keyForItem(item, key, modificationTime, size)) {
+        return false;
+    }
+
+    QHash<Key, Value>::const_iterator it = m_changedValues.constFind(key);
+    if (it != m_changedValues.constEnd()) {
+        if (it->modificationTime != modificationTime || it->size != size) {
+            return false;
+        }
+        entry = it->entry;
+        return true;
+    }
+
+    const int index = findRecord(key);
+    if (index < 0) {
+        return false;
+    }
+
+    const Record r = record(index);
+    if (r.modificationTime != modificationTime || r.size != size) {
+        // The file has been changed since the entry has been stored.
+        return false;
+    }
+
+    entry = valueForRecord(r).entry;
+    return true;
+}
+
+void KFileItemModelRoleCache::setIconNameAndType(const KFileItem& item, const QString& iconName, const QString& type)
+{
+    Entry entry;
+    if (lookup(item, entry) && entry.iconName == iconName && entry.type == type) {
+        return;
+    }
+
+    Value* value = writableValue(item);
+    if (value) {
+        value->entry.iconName = iconName;
+        value->entry.type = type;
+    }
+}
+
+void KFileItemModelRoleCache::setItemCount(const KFileItem& item, int count, int options)
+{
+    Entry entry;
+    if (lookup(item, entry) && entry.itemCount == count && entry.itemCountOptions == options) {
+        return;
+    }
+
+    Value* value = writableValue(item);
+    if (value) {
+        value->entry.itemCount = count;
+        value->entry.itemCountOptions = options;
+    }
+}
+
+void KFileItemModelRoleCache::scheduleSave()
+{
+    if (m_changedValues.isEmpty()) {
+        return;
+    }
+
+    if (!m_saveTimer) {
+        m_saveTimer = new QTimer(this);
+        m_saveTimer->setSingleShot(true);
+        m_saveTimer->setInterval(SaveInterval);
+        connect(m_saveTimer, SIGNAL(timeout()), this, SLOT(startBackgroundSave()));
+    }
+
+    if (!m_saving && !m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+bool KFileItemModelRoleCache::save()
+{
+    // Wait for a running background save, its result is superseded
+    // by writing all changed values.
+    m_savePool.waitForDone();
+    m_saving = false;
+    m_savingValues.clear();
+    ++m_saveId;
+    if (m_saveTimer) {
+        m_saveTimer->stop();
+    }
+
+    if (m_changedValues.isEmpty()) {
+        return true;
+    }
+
+    // The old file must not be mapped while it is replaced.
+    unload();
+
+    const bool success = writeFile(m_fileName, m_language, m_changedValues);
+    if (success) {
+        m_changedValues.clear();
+    }
+
+    load();
+    return success;
+}
+
+void KFileItemModelRoleCache::startBackgroundSave()
+{
+    if (m_saving || m_changedValues.isEmpty()) {
+        return;
+    }
+
+    // The mapped file stays valid while it is written, as KSaveFile
+    // replaces the file by renaming the new one.
+    m_saving = true;
+    m_savingValues = m_changedValues;
+    ++m_saveId;
+    m_savePool.start(new KFileItemModelRoleCacheSaveTask(this, m_saveId));
+}
+
+void KFileItemModelRoleCache::slotBackgroundSaveFinished(int saveId, bool success)
+{
+    if (!m_saving || saveId != m_saveId) {
+        return;
+    }
+
+    m_saving = false;
+    if (success) {
+        // Map the new file and forget the values that have been written. Values
+        // that have been changed while the file was written are kept.
+        load();
+
+        QHashIterator<Key, Value> it(m_savingValues);
+        while (it.hasNext()) {
+            it.next();
+            QHash<Key, Value>::iterator changedIt = m_changedValues.find(it.key());
+            if (changedIt != m_changedValues.end() && changedIt.value() == it.value()) {
+                m_changedValues.erase(changedIt);
+            }
+        }
+    }
+    m_savingValues.clear();
+
+    scheduleSave();
+}
+
+int KFileItemModelRoleCache::count() const
+{
+    int result = m_recordCount;
+    QHashIterator<Key, Value> it(m_changedValues);
+    while (it.hasNext()) {
+        it.next();
+        if (findRecord(it.key()) < 0) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+bool KFileItemModelRoleCache::writeFile(const QString& fileName, const QString& language, const QHash<Key, Value>& changedValues)
+{
+    QMap<Key, Value> values;
+    {
+        const KFileItemModelRoleCache reader(fileName, language);
+        values = reader.mergedValues(changedValues);
+    }
+
+    // Build the string table. The first string is the language.
+    QVector<QString> strings;
+    QHash<QString, quint32> stringIds;
+    strings.append(language);
+
+    QVector<Record> records;
+    records.reserve(values.count());
+
+    QMapIterator<Key, Value> it(values);
+    while (it.hasNext()) {
+        it.next();
+        const Value& value = it.value();
+
+        Record r;
+        std::memset(&r, 0, sizeof(Record));
+        r.device = it.key().device;
+        r.inode = it.key().inode;
+        r.modificationTime = value.modificationTime;
+        r.size = value.size;
+        r.itemCount = value.entry.itemCount;
+        r.itemCountOptions = value.entry.itemCountOptions;
+
+        const QString* texts[] = { &value.entry.iconName, &value.entry.type };
+        quint32* ids[] = { &r.iconNameId, &r.typeId };
+        for (int i = 0; i < 2; ++i) {
+            if (texts[i]->isEmpty()) {
+                continue;
+            }
+            quint32 id = stringIds.value(*texts[i]);
+            if (id == 0) {
+                strings.append(*texts[i]);
+                id = strings.count() - 1;
+                stringIds.insert(*texts[i], id);
+            }
+            *ids[i] = id;
+        }
+
+        records.append(r);
+    }
+
+    QByteArray data;
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.recordCount = records.count();
+    header.stringCount = strings.count();
+    data.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char*>(records.constData()), records.count() * sizeof(Record));
+    foreach (const QString& string, strings) {
+        const quint32 length = string.length();
+        data.append(reinterpret_cast<const char*>(&length), sizeof(quint32));
+        data.append(reinterpret_cast<const char*>(string.constData()), length * sizeof(QChar));
+    }
+
+    KSaveFile file(fileName);
+    return file.open() && file.write(data) == data.size() && file.finalize();
+}
+
+QMap<KFileItemModelRoleCache::Key, KFileItemModelRoleCache::Value> KFileItemModelRoleCache::mergedValues(const QHash<Key, Value>& changedValues) const
+{
+    // Merge the entries of the cache file and the changed entries. If there are
+    // too many entries, the changed ones are preferred, because they have
+    // been used recently.
+    QMap<Key, Value> values;
+    QHashIterator<Key, Value> changedIt(changedValues);
+    while (changedIt.hasNext()) {
+        changedIt.next();
+        values.insert(changedIt.key(), changedIt.value());
+    }
+
+    for (int i = 0; i < m_recordCount && values.count() < MaxEntries; ++i) {
+        const Record r = record(i);
+        Key key;
+        key.device = r.device;
+        key.inode = r.inode;
+        if (!values.contains(key)) {
+            values.insert(key, valueForRecord(r));
+        }
+    }
+
+    return values;
+}
+
+bool KFileItemModelRoleCache::keyForItem(const KFileItem& item, Key& key, qint64& modificationTime, qint64& size)
+{
+    if (item.isNull() || !item.isLocalFile()) {
+        return false;
+    }
+
+    const KIO::UDSEntry entry = item.entry();
+    key.inode = entry.numberValue(KIO::UDSEntry::UDS_INODE, 0);
+    if (key.inode == 0) {
+        return false;
+    }
+
+    key.device = entry.numberValue(KIO::UDSEntry::UDS_DEVICE_ID, 0);
+    modificationTime = entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME, -1);
+    size = item.size();
+    return true;
+}
+
+void KFileItemModelRoleCache::load()
+{
+    unload();
+
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < static_cast<qint64>(sizeof(Header))) {
+        m_file.close();
+        return;
+    }
+
+    const uchar* data = m_file.map(0, fileSize);
+    if (!data) {
+        m_file.close();
+        return;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    const qint64 recordsEnd = sizeof(Header) + qint64(header.recordCount) * sizeof(Record);
+    bool valid = (header.magic == Magic && header.version == Version && recordsEnd <= fileSize);
+
+    // Read the string table.
+    QVector<QString> strings;
+    qint64 offset = recordsEnd;
+    for (quint32 i = 0; valid && i < header.stringCount; ++i) {
+        quint32 length;
+        if (offset + static_cast<qint64>(sizeof(quint32)) > fileSize) {
+            valid = false;
+            break;
+        }
+        std::memcpy(&length, data + offset, sizeof(quint32));
+        offset += sizeof(quint32);
+
+        if (offset + qint64(length) * sizeof(QChar) > fileSize) {
+            valid = false;
+            break;
+        }
+        QString string(length, Qt::Uninitialized);
+        std::memcpy(string.data(), data + offset, length * sizeof(QChar));
+        offset += length * sizeof(QChar);
+        strings.append(string);
+    }
+
+    if (valid && (strings.isEmpty() || strings.first() != m_language)) {
+        valid = false;
+    }
+
+    if (!valid) {
+        m_file.unmap(const_cast<uchar*>(data));
+        m_file.close();
+        return;
+    }
+
+    m_records = data + sizeof(Header);
+    m_recordCount = header.recordCount;
+    m_strings = strings;
+}
+
+void KFileItemModelRoleCache::unload()
+{
+    if (m_records) {
+        m_file.unmap(const_cast<uchar*>(m_records - sizeof(Header)));
+        m_records = 0;
+    }
+    m_file.close();
+    m_recordCount = 0;
+    m_strings.clear();
+}
+
+int KFileItemModelRoleCache::findRecord(const Key& key) const
+{
+    int low = 0;
+    int high = m_recordCount;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const Record r = record(middle);
+
+        Key middleKey;
+        middleKey.device = r.device;
+        middleKey.inode = r.inode;
+
+        if (middleKey < key) {
+            low = middle + 1;
+        } else if (key < middleKey) {
+            high = middle;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+KFileItemModelRoleCache::Record KFileItemModelRoleCache::record(int index) const
+{
+    // The records are copied to prevent unaligned access to the mapped memory.
+    Record r;
+    std::memcpy(&r, m_records + index * sizeof(Record), sizeof(Record));
+    return r;
+}
+
+KFileItemModelRoleCache::Value KFileItemModelRoleCache::valueForRecord(const Record& record) const
+{
+    Value value;
+    value.modificationTime = record.modificationTime;
+    value.size = record.size;
+    value.entry.itemCount = record.itemCount;
+    value.entry.itemCountOptions = record.itemCountOptions;
+    if (record.iconNameId > 0 && record.iconNameId < quint32(m_strings.count())) {
+        value.entry.iconName = m_strings.at(record.iconNameId);
+    }
+    if (record.typeId > 0 && record.typeId < quint32(m_strings.count())) {
+        value.entry.type = m_strings.at(record.typeId);
+    }
+    return value;
+}
+
+KFileItemModelRoleCache::Value* KFileItemModelRoleCache::writableValue(const KFileItem& item)
+{
+    Key key;
+    qint64 modificationTime;
+    qint64 size;
+    if (!keyForItem(item, key, modificationTime, size)) {
+        return 0;
+    }
+
+    QHash<Key, Value>::iterator it = m_changedValues.find(key);
+    if (it == m_changedValues.end()) {
+        Value value;
+        const int index = findRecord(key);
+        if (index >= 0) {
+            value = valueForRecord(record(index));
+        }
+        it = m_changedValues.insert(key, value);
+    }
+
+    if (it->modificationTime != modificationTime || it->size != size) {
+        // Values for an older version of the file must not be kept.
+        it->modificationTime = modificationTime;
+        it->size = size;
+        it->entry = Entry();
+    }
+
+    return &it.value();
+}
+
+#include "kfileitemmodelrolecache.moc"
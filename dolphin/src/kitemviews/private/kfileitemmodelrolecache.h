@@ -0,0 +1,236 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KFILEITEMMODELROLECACHE_H
+#define KFILEITEMMODELROLECACHE_H
+
+#include <libdolphin_export.h>
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+class KFileItem;
+class QTimer;
+
+/**
+ * @brief Persistent cache for roles that are expensive to resolve.
+ *
+ * KFileItemModelRolesUpdater stores the icon name, the MIME type comment
+ * ("type") and the number of items of a directory ("size") in this cache.
+ * When a directory is opened again, the roles can be taken from the cache
+ * without determining the MIME types or counting the directory contents.
+ *
+ * The entries are identified by the device and the inode of the file. An
+ * entry is only valid as long as the modification time and the size of
+ * the file are unchanged, so modified files are resolved again. Only local
+ * files are cached.
+ *
+ * The cache file is memory-mapped and contains the entries sorted by the
+ * device and inode, so looking up an entry requires a binary search only.
+ * New entries are kept in memory until save() or scheduleSave() is invoked.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KFileItemModelRoleCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+        Entry() : iconName(), type(), itemCount(-1), itemCountOptions(0) {}
+
+        QString iconName;
+        QString type;
+        int itemCount; // -1 if the number of items is unknown
+        int itemCountOptions; // See KDirectoryContentsCounterWorker::Options
+
+        bool operator==(const Entry& other) const
+        {
+            return itemCount == other.itemCount && itemCountOptions == other.itemCountOptions
+                   && iconName == other.iconName && type == other.type;
+        }
+    };
+
+    /**
+     * @param fileName Path of the cache file. The file is created
+     *                 by save() if it does not exist yet. Changes are
+     *                 only written if save() or scheduleSave() is invoked.
+     */
+    explicit KFileItemModelRoleCache(const QString& fileName, QObject* parent = 0);
+    virtual ~KFileItemModelRoleCache();
+
+    /**
+     * @return Cache that is shared by all KFileItemModelRolesUpdater instances.
+     */
+    static KFileItemModelRoleCache* instance();
+
+    /**
+     * Fills \a entry with the cached roles of \a item.
+     * @return True if a valid entry is available for \a item.
+     */
+    bool lookup(const KFileItem& item, Entry& entry) const;
+
+    void setIconNameAndType(const KFileItem& item, const QString& iconName, const QString& type);
+
+    /**
+     * Stores the number of items \a count of the directory \a item, which has
+     * been counted with the options \a options. The options are part of the
+     * entry, as the number depends e.g. on whether hidden files are counted.
+     */
+    void setItemCount(const KFileItem& item, int count, int options);
+
+    /**
+     * Writes the changed entries to the cache file in a background thread.
+     * The file is written at most once every 30 seconds, so the method
+     * may be invoked as often as needed. Nothing is done if no entry has
+     * been changed.
+     */
+    void scheduleSave();
+
+    /**
+     * @return Number of entries in the cache file and in memory.
+     */
+    int count() const;
+
+public slots:
+    /**
+     * Writes all changed entries to the cache file and waits until this has
+     * been done. At most MaxEntries entries are kept, the entries that have
+     * been added recently are preferred.
+     */
+    bool save();
+
+private slots:
+    void startBackgroundSave();
+    void slotBackgroundSaveFinished(int saveId, bool success);
+
+private:
+    struct Key
+    {
+        quint64 device;
+        quint64 inode;
+
+        bool operator==(const Key& other) const
+        {
+            return device == other.device && inode == other.inode;
+        }
+
+        bool operator<(const Key& other) const
+        {
+            return device < other.device || (device == other.device && inode < other.inode);
+        }
+    };
+
+    /**
+     * Layout of an entry inside the cache file. The strings are
+     * stored as 1-based indexes into the string table.
+     */
+    struct Record
+    {
+        quint64 device;
+        quint64 inode;
+        qint64 modificationTime;
+        qint64 size;
+        qint32 itemCount;
+        quint32 iconNameId;
+        quint32 typeId;
+        quint32 itemCountOptions;
+    };
+
+    struct Value
+    {
+        Value() : modificationTime(-1), size(-1), entry() {}
+
+        bool operator==(const Value& other) const
+        {
+            return modificationTime == other.modificationTime && size == other.size && entry == other.entry;
+        }
+
+        qint64 modificationTime;
+        qint64 size;
+        Entry entry;
+    };
+
+    friend uint qHash(const Key& key);
+    friend class KFileItemModelRoleCacheSaveTask;
+
+    /**
+     * Creates a cache that is only used for reading the file \a fileName.
+     * Does not access KGlobal, so it may be used by a worker thread.
+     */
+    KFileItemModelRoleCache(const QString& fileName, const QString& language);
+
+    /**
+     * Writes the entries of the file \a fileName merged with \a changedValues
+     * to the file. May be invoked by a worker thread.
+     */
+    static bool writeFile(const QString& fileName, const QString& language, const QHash<Key, Value>& changedValues);
+
+    /**
+     * @return Entries of the mapped file merged with \a changedValues.
+     */
+    QMap<Key, Value> mergedValues(const QHash<Key, Value>& changedValues) const;
+
+    /**
+     * @return True if \a item is a local file with a known device and inode.
+     */
+    static bool keyForItem(const KFileItem& item, Key& key, qint64& modificationTime, qint64& size);
+
+    /**
+     * Maps the cache file into the memory and reads the string table.
+     */
+    void load();
+    void unload();
+
+    /**
+     * @return Index of the record with the key \a key in the mapped
+     *         file or -1 if there is no such record.
+     */
+    int findRecord(const Key& key) const;
+    Record record(int index) const;
+    Value valueForRecord(const Record& record) const;
+
+    /**
+     * @return Value for \a item that can be modified. The value is
+     *         initialized from the mapped file if possible.
+     */
+    Value* writableValue(const KFileItem& item);
+
+private:
+    QString m_fileName;
+    QString m_language; // The MIME type comments are translated
+    QFile m_file;
+    const uchar* m_records;
+    int m_recordCount;
+    QVector<QString> m_strings;
+
+    QHash<Key, Value> m_changedValues;
+
+    QTimer* m_saveTimer;
+    QThreadPool m_savePool;
+    int m_saveId; // Identifies the running background save
+    bool m_saving;
+    QHash<Key, Value> m_savingValues; // Values of m_changedValues that are being written
+};
+
+#endif
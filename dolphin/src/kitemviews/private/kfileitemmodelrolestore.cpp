@@ -0,0 +1,537 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kfileitemmodelrolestore.h"
+
+#include <kio/global.h>
+
+#include <QDateTime>
+
+namespace {
+    // Marks an invalid QDateTime in the column m_date.
+    const qint64 InvalidDate = Q_INT64_C(-9223372036854775807) - 1;
+}
+
+KFileItemModelRoleStore::KFileItemModelRoleStore() :
+    m_slotCount(0),
+    m_freeSlots(),
+    m_flags(),
+    m_text(),
+    m_size(),
+    m_date(),
+    m_expandedParentsCount(),
+    m_otherValues(),
+    m_strings(),
+    m_stringRefCounts(),
+    m_freeStringIds(),
+    m_stringIds()
+{
+}
+
+KFileItemModelRoleStore::~KFileItemModelRoleStore()
+{
+}
+
+int KFileItemModelRoleStore::allocate()
+{
+    if (!m_freeSlots.isEmpty()) {
+        const int slot = m_freeSlots.last();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+
+    // Only the flags and the other values are resized for each new slot. The
+    // typed columns grow on demand when a value is set (see ensureSize()), so
+    // that roles which are not used do not need any memory.
+    const int slot = m_slotCount;
+    ++m_slotCount;
+    m_flags.append(0);
+    m_otherValues.append(QHash<QByteArray, QVariant>());
+    return slot;
+}
+
+void KFileItemModelRoleStore::release(int slot)
+{
+    Q_ASSERT(slot >= 0 && slot < m_slotCount);
+
+    for (int column = TextColumn; column < ColumnCount; ++column) {
+        removeTypedValue(slot, static_cast<Column>(column));
+    }
+    m_otherValues[slot] = QHash<QByteArray, QVariant>();
+    m_flags[slot] = 0;
+
+    m_freeSlots.append(slot);
+    if (m_freeSlots.count() == m_slotCount) {
+        // No slot is in use anymore.
+        clear();
+    }
+}
+
+void KFileItemModelRoleStore::clear()
+{
+    m_slotCount = 0;
+    m_freeSlots.clear();
+    m_flags.clear();
+    m_text.clear();
+    m_size.clear();
+    m_date.clear();
+    m_expandedParentsCount.clear();
+    for (int i = 0; i < StringColumnCount; ++i) {
+        m_stringColumns[i].clear();
+    }
+    for (int i = 0; i < InternedColumnCount; ++i) {
+        m_internedColumns[i].clear();
+    }
+    m_otherValues.clear();
+    m_strings.clear();
+    m_stringRefCounts.clear();
+    m_freeStringIds.clear();
+    m_stringIds.clear();
+}
+
+QVariant KFileItemModelRoleStore::value(int slot, const QByteArray& role) const
+{
+    const quint16 flags = m_flags.at(slot);
+    const Column column = columnForRole(role);
+
+    switch (column) {
+    case TextColumn:
+        if (flags & HasText) {
+            return m_text.at(slot);
+        }
+        break;
+
+    case SizeColumn:
+        if (flags & HasSize) {
+            // For directories, KFileItemModelRolesUpdater stores the number
+            // of items as int, for files KIO::filesize_t is used.
+            if (flags & SizeIsInt) {
+                return static_cast<int>(m_size.at(slot));
+            }
+            return static_cast<KIO::filesize_t>(m_size.at(slot));
+        }
+        break;
+
+    case DateColumn:
+        if (flags & HasDate) {
+            const qint64 msecs = m_date.at(slot);
+            if (msecs == InvalidDate) {
+                return QDateTime();
+            }
+            const QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(msecs);
+            return (flags & DateIsUtc) ? dateTime.toUTC() : dateTime;
+        }
+        break;
+
+    case ExpandedParentsCountColumn:
+        if (flags & HasExpandedParentsCount) {
+            return m_expandedParentsCount.at(slot);
+        }
+        break;
+
+    case IsDirColumn:
+        if (flags & HasIsDir) {
+            return bool(flags & IsDir);
+        }
+        break;
+
+    case IsLinkColumn:
+        if (flags & HasIsLink) {
+            return bool(flags & IsLink);
+        }
+        break;
+
+    case IsExpandedColumn:
+        if (flags & HasIsExpanded) {
+            return bool(flags & IsExpanded);
+        }
+        break;
+
+    case IsExpandableColumn:
+        if (flags & HasIsExpandable) {
+            return bool(flags & IsExpandable);
+        }
+        break;
+
+    case PathColumn:
+    case DestinationColumn: {
+        const QVector<QString>& strings = m_stringColumns[column - FirstStringColumn];
+        if (slot < strings.count() && !strings.at(slot).isNull()) {
+            return strings.at(slot);
+        }
+        break;
+    }
+
+    case NoColumn:
+        break;
+
+    default: {
+        const QVector<int>& ids = m_internedColumns[column - FirstInternedColumn];
+        if (slot < ids.count() && ids.at(slot) > 0) {
+            return m_strings.at(ids.at(slot) - 1);
+        }
+        break;
+    }
+    }
+
+    // Values that do not fit into their typed column are
+    // stored as other values, too.
+    return m_otherValues.at(slot).value(role);
+}
+
+void KFileItemModelRoleStore::setValue(int slot, const QByteArray& role, const QVariant& value)
+{
+    Q_ASSERT(slot >= 0 && slot < m_slotCount);
+
+    const Column column = columnForRole(role);
+    if (column != NoColumn) {
+        removeTypedValue(slot, column);
+    }
+    m_otherValues[slot].remove(role);
+
+    if (!value.isValid()) {
+        return;
+    }
+
+    bool stored = false;
+    switch (column) {
+    case TextColumn:
+        if (value.type() == QVariant::String) {
+            ensureSize(m_text, slot);
+            m_text[slot] = value.toString();
+            m_flags[slot] |= HasText;
+            stored = true;
+        }
+        break;
+
+    case SizeColumn:
+        if (value.type() == QVariant::Int || value.type() == QVariant::ULongLong) {
+            ensureSize(m_size, slot);
+            if (value.type() == QVariant::Int) {
+                m_size[slot] = value.toInt();
+                m_flags[slot] |= HasSize | SizeIsInt;
+            } else {
+                m_size[slot] = static_cast<qint64>(value.toULongLong());
+                m_flags[slot] |= HasSize;
+            }
+            stored = true;
+        }
+        break;
+
+    case DateColumn:
+        if (value.type() == QVariant::DateTime) {
+            const QDateTime dateTime = value.toDateTime();
+            if (!dateTime.isValid()) {
+                ensureSize(m_date, slot);
+                m_date[slot] = InvalidDate;
+                m_flags[slot] |= HasDate;
+                stored = true;
+            } else if (dateTime.timeSpec() != Qt::OffsetFromUTC) {
+                ensureSize(m_date, slot);
+                m_date[slot] = dateTime.toMSecsSinceEpoch();
+                m_flags[slot] |= HasDate;
+                if (dateTime.timeSpec() == Qt::UTC) {
+                    m_flags[slot] |= DateIsUtc;
+                }
+                stored = true;
+            }
+        }
+        break;
+
+    case ExpandedParentsCountColumn:
+        if (value.type() == QVariant::Int) {
+            ensureSize(m_expandedParentsCount, slot);
+            m_expandedParentsCount[slot] = value.toInt();
+            m_flags[slot] |= HasExpandedParentsCount;
+            stored = true;
+        }
+        break;
+
+    case IsDirColumn:
+        if (value.type() == QVariant::Bool) {
+            setBool(slot, HasIsDir, IsDir, value.toBool());
+            stored = true;
+        }
+        break;
+
+    case IsLinkColumn:
+        if (value.type() == QVariant::Bool) {
+            setBool(slot, HasIsLink, IsLink, value.toBool());
+            stored = true;
+        }
+        break;
+
+    case IsExpandedColumn:
+        if (value.type() == QVariant::Bool) {
+            setBool(slot, HasIsExpanded, IsExpanded, value.toBool());
+            stored = true;
+        }
+        break;
+
+    case IsExpandableColumn:
+        if (value.type() == QVariant::Bool) {
+            setBool(slot, HasIsExpandable, IsExpandable, value.toBool());
+            stored = true;
+        }
+        break;
+
+    case PathColumn:
+    case DestinationColumn:
+        // A null string marks a missing value, so null strings
+        // are stored as other values.
+        if (value.type() == QVariant::String && !value.toString().isNull()) {
+            QVector<QString>& strings = m_stringColumns[column - FirstStringColumn];
+            ensureSize(strings, slot);
+            strings[slot] = value.toString();
+            stored = true;
+        }
+        break;
+
+    case NoColumn:
+        break;
+
+    default:
+        if (value.type() == QVariant::String) {
+            QVector<int>& ids = m_internedColumns[column - FirstInternedColumn];
+            ensureSize(ids, slot);
+            ids[slot] = internString(value.toString());
+            stored = true;
+        }
+        break;
+    }
+
+    if (!stored) {
+        m_otherValues[slot].insert(role, value);
+    }
+}
+
+void KFileItemModelRoleStore::setValues(int slot, const QHash<QByteArray, QVariant>& values)
+{
+    Q_ASSERT(slot >= 0 && slot < m_slotCount);
+
+    for (int column = TextColumn; column < ColumnCount; ++column) {
+        removeTypedValue(slot, static_cast<Column>(column));
+    }
+    m_otherValues[slot] = QHash<QByteArray, QVariant>();
+
+    QHashIterator<QByteArray, QVariant> it(values);
+    while (it.hasNext()) {
+        it.next();
+        setValue(slot, it.key(), it.value());
+    }
+}
+
+QHash<QByteArray, QVariant> KFileItemModelRoleStore::values(int slot) const
+{
+    QHash<QByteArray, QVariant> result = m_otherValues.at(slot);
+
+    const quint16 flags = m_flags.at(slot);
+    if (flags != 0) {
+        for (int column = TextColumn; column < FirstStringColumn; ++column) {
+            const QByteArray& role = roleForColumn(static_cast<Column>(column));
+            const QVariant columnValue = value(slot, role);
+            if (columnValue.isValid()) {
+                result.insert(role, columnValue);
+            }
+        }
+    }
+
+    for (int i = 0; i < StringColumnCount; ++i) {
+        const QVector<QString>& strings = m_stringColumns[i];
+        if (slot < strings.count() && !strings.at(slot).isNull()) {
+            result.insert(roleForColumn(static_cast<Column>(FirstStringColumn + i)), strings.at(slot));
+        }
+    }
+
+    for (int i = 0; i < InternedColumnCount; ++i) {
+        const QVector<int>& ids = m_internedColumns[i];
+        if (slot < ids.count() && ids.at(slot) > 0) {
+            result.insert(roleForColumn(static_cast<Column>(FirstInternedColumn + i)), m_strings.at(ids.at(slot) - 1));
+        }
+    }
+
+    return result;
+}
+
+qint64 KFileItemModelRoleStore::memoryUsage() const
+{
+    qint64 bytes = sizeof(KFileItemModelRoleStore);
+    bytes += m_freeSlots.capacity() * sizeof(int);
+    bytes += m_flags.capacity() * sizeof(quint16);
+    bytes += m_text.capacity() * sizeof(QString);
+    bytes += m_size.capacity() * sizeof(qint64);
+    bytes += m_date.capacity() * sizeof(qint64);
+    bytes += m_expandedParentsCount.capacity() * sizeof(int);
+    for (int i = 0; i < StringColumnCount; ++i) {
+        bytes += m_stringColumns[i].capacity() * sizeof(QString);
+    }
+    for (int i = 0; i < InternedColumnCount; ++i) {
+        bytes += m_internedColumns[i].capacity() * sizeof(int);
+    }
+
+    bytes += m_otherValues.capacity() * sizeof(QHash<QByteArray, QVariant>);
+    foreach (const QHash<QByteArray, QVariant>& otherValues, m_otherValues) {
+        if (!otherValues.isEmpty()) {
+            bytes += sizeof(QHashData)
+                     + otherValues.capacity() * sizeof(void*)
+                     + otherValues.count() * sizeof(QHashNode<QByteArray, QVariant>);
+        }
+    }
+
+    bytes += m_strings.capacity() * sizeof(QString);
+    bytes += m_stringRefCounts.capacity() * sizeof(int);
+    bytes += m_freeStringIds.capacity() * sizeof(int);
+    bytes += sizeof(QHashData)
+             + m_stringIds.capacity() * sizeof(void*)
+             + m_stringIds.count() * sizeof(QHashNode<QString, int>);
+
+    return bytes;
+}
+
+KFileItemModelRoleStore::Column KFileItemModelRoleStore::columnForRole(const QByteArray& role)
+{
+    static QHash<QByteArray, Column> columns;
+    if (columns.isEmpty()) {
+        for (int column = TextColumn; column < ColumnCount; ++column) {
+            columns.insert(roleForColumn(static_cast<Column>(column)), static_cast<Column>(column));
+        }
+    }
+
+    return columns.value(role, NoColumn);
+}
+
+const QByteArray& KFileItemModelRoleStore::roleForColumn(Column column)
+{
+    // Take care to keep the order in sync with the enum Column.
+    static const QByteArray roles[ColumnCount] = {
+        QByteArray(),
+        QByteArray("text"),
+        QByteArray("size"),
+        QByteArray("date"),
+        QByteArray("expandedParentsCount"),
+        QByteArray("isDir"),
+        QByteArray("isLink"),
+        QByteArray("isExpanded"),
+        QByteArray("isExpandable"),
+        QByteArray("path"),
+        QByteArray("destination"),
+        QByteArray("iconName"),
+        QByteArray("type"),
+        QByteArray("permissions"),
+        QByteArray("owner"),
+        QByteArray("group")
+    };
+
+    return roles[column];
+}
+
+void KFileItemModelRoleStore::setBool(int slot, quint16 hasFlag, quint16 valueFlag, bool value)
+{
+    quint16& flags = m_flags[slot];
+    flags |= hasFlag;
+    if (value) {
+        flags |= valueFlag;
+    } else {
+        flags &= ~valueFlag;
+    }
+}
+
+void KFileItemModelRoleStore::removeTypedValue(int slot, Column column)
+{
+    quint16& flags = m_flags[slot];
+
+    switch (column) {
+    case TextColumn:
+        if (flags & HasText) {
+            m_text[slot] = QString();
+            flags &= ~HasText;
+        }
+        break;
+    case SizeColumn:              flags &= ~(HasSize | SizeIsInt); break;
+    case DateColumn:              flags &= ~(HasDate | DateIsUtc); break;
+    case ExpandedParentsCountColumn: flags &= ~HasExpandedParentsCount; break;
+    case IsDirColumn:             flags &= ~(HasIsDir | IsDir); break;
+    case IsLinkColumn:            flags &= ~(HasIsLink | IsLink); break;
+    case IsExpandedColumn:        flags &= ~(HasIsExpanded | IsExpanded); break;
+    case IsExpandableColumn:      flags &= ~(HasIsExpandable | IsExpandable); break;
+    case PathColumn:
+    case DestinationColumn: {
+        QVector<QString>& strings = m_stringColumns[column - FirstStringColumn];
+        if (slot < strings.count()) {
+            strings[slot] = QString();
+        }
+        break;
+    }
+    case NoColumn:
+        break;
+    default: {
+        QVector<int>& ids = m_internedColumns[column - FirstInternedColumn];
+        if (slot < ids.count() && ids.at(slot) > 0) {
+            releaseString(ids.at(slot));
+            ids[slot] = 0;
+        }
+        break;
+    }
+    }
+}
+
+int KFileItemModelRoleStore::internString(const QString& string)
+{
+    const QHash<QString, int>::const_iterator it = m_stringIds.constFind(string);
+    if (it != m_stringIds.constEnd()) {
+        ++m_stringRefCounts[it.value() - 1];
+        return it.value();
+    }
+
+    int id;
+    if (m_freeStringIds.isEmpty()) {
+        m_strings.append(string);
+        m_stringRefCounts.append(1);
+        id = m_strings.count();
+    } else {
+        id = m_freeStringIds.last();
+        m_freeStringIds.pop_back();
+        m_strings[id - 1] = string;
+        m_stringRefCounts[id - 1] = 1;
+    }
+    m_stringIds.insert(string, id);
+    return id;
+}
+
+void KFileItemModelRoleStore::releaseString(int id)
+{
+    Q_ASSERT(id > 0 && id <= m_strings.count());
+    Q_ASSERT(m_stringRefCounts.at(id - 1) > 0);
+
+    if (--m_stringRefCounts[id - 1] == 0) {
+        m_stringIds.remove(m_strings.at(id - 1));
+        m_strings[id - 1] = QString();
+        m_freeStringIds.append(id);
+    }
+}
+
+template<typename T>
+void KFileItemModelRoleStore::ensureSize(QVector<T>& column, int slot)
+{
+    if (slot >= column.count()) {
+        // QVector grows its capacity exponentially, so setting values
+        // for consecutive slots does not result in repeated reallocations.
+        column.resize(slot + 1);
+    }
+}
@@ -0,0 +1,249 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KFILEITEMMODELROLESTORE_H
+#define KFILEITEMMODELROLESTORE_H
+
+#include <libdolphin_export.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Stores the role values of all items of a KFileItemModel.
+ *
+ * Instead of keeping a QHash<QByteArray, QVariant> for each item, the
+ * values of the roles that are used by almost every item are stored in
+ * one typed column per role (structure of arrays):
+ * - "text" as QString,
+ * - "size" and "date" as qint64,
+ * - "expandedParentsCount" as int,
+ * - "isDir", "isLink", "isExpanded" and "isExpandable" as bits of a
+ *   per-item flag word,
+ * - "path" and "destination", which differ for almost every item, as QString,
+ * - roles with only a few distinct values like "type" or "iconName" as
+ *   indexes into a table of interned strings. The interned strings are
+ *   reference counted, so strings that are not used anymore get freed.
+ *
+ * All other roles (e.g. "iconPixmap" or "rating") are stored in a per-item
+ * hash that is only allocated if the item actually has such a role.
+ *
+ * Each item is identified by a slot that is returned by allocate(). Slots
+ * are stable, i.e., sorting the items does not require to move any values.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KFileItemModelRoleStore
+{
+
+public:
+    KFileItemModelRoleStore();
+    ~KFileItemModelRoleStore();
+
+    /**
+     * @return A new empty slot. Slots that have been released
+     *         with release() are reused.
+     */
+    int allocate();
+
+    /**
+     * Removes all values of the slot \a slot and marks it as free.
+     */
+    void release(int slot);
+
+    /**
+     * Releases all slots and frees the memory of all columns.
+     */
+    void clear();
+
+    /**
+     * @return Value of the role \a role for the slot \a slot. An
+     *         invalid QVariant is returned if no value is set.
+     */
+    QVariant value(int slot, const QByteArray& role) const;
+
+    /**
+     * Sets the value of the role \a role for the slot \a slot. Passing
+     * an invalid QVariant removes the value.
+     */
+    void setValue(int slot, const QByteArray& role, const QVariant& value);
+
+    /**
+     * Replaces all values of the slot \a slot by \a values.
+     */
+    void setValues(int slot, const QHash<QByteArray, QVariant>& values);
+
+    /**
+     * @return All values of the slot \a slot. The hash is assembled on demand.
+     */
+    QHash<QByteArray, QVariant> values(int slot) const;
+
+    // Fast typed accessors that are used when sorting and grouping.
+    QString text(int slot) const;
+    bool hasSize(int slot) const;
+    qint64 size(int slot) const;
+    bool isDir(int slot) const;
+    bool isExpanded(int slot) const;
+    bool isExpandable(int slot) const;
+    bool hasExpandedParentsCount(int slot) const;
+    int expandedParentsCount(int slot) const;
+
+    /**
+     * @return Approximate number of bytes that are used by the columns. The
+     *         heap memory of implicitly shared values (e.g. the characters of
+     *         strings which are shared with the KFileItems) is not counted.
+     */
+    qint64 memoryUsage() const;
+
+private:
+    enum Column {
+        NoColumn,
+        TextColumn,
+        SizeColumn,
+        DateColumn,
+        ExpandedParentsCountColumn,
+        IsDirColumn,
+        IsLinkColumn,
+        IsExpandedColumn,
+        IsExpandableColumn,
+        // String columns
+        PathColumn,
+        DestinationColumn,
+        // Interned string columns, must be the last entries.
+        IconNameColumn,
+        TypeColumn,
+        PermissionsColumn,
+        OwnerColumn,
+        GroupColumn,
+        ColumnCount
+    };
+
+    enum Flag {
+        HasText = 0x0001,
+        HasSize = 0x0002,
+        SizeIsInt = 0x0004,
+        HasDate = 0x0008,
+        DateIsUtc = 0x0010,
+        HasExpandedParentsCount = 0x0020,
+        HasIsDir = 0x0040,
+        IsDir = 0x0080,
+        HasIsLink = 0x0100,
+        IsLink = 0x0200,
+        HasIsExpanded = 0x0400,
+        IsExpanded = 0x0800,
+        HasIsExpandable = 0x1000,
+        IsExpandable = 0x2000
+    };
+
+    static const int FirstStringColumn = PathColumn;
+    static const int StringColumnCount = IconNameColumn - PathColumn;
+    static const int FirstInternedColumn = IconNameColumn;
+    static const int InternedColumnCount = ColumnCount - IconNameColumn;
+
+    static Column columnForRole(const QByteArray& role);
+    static const QByteArray& roleForColumn(Column column);
+
+    /**
+     * Stores the boolean \a value into the flags of \a slot. \a hasFlag marks
+     * that a value is present, \a valueFlag contains the value itself.
+     */
+    void setBool(int slot, quint16 hasFlag, quint16 valueFlag, bool value);
+
+    /**
+     * Removes the value of \a column from the typed columns of the slot \a slot.
+     */
+    void removeTypedValue(int slot, Column column);
+
+    /**
+     * @return Index + 1 of the interned string \a string. The string is
+     *         added to m_strings if it is not interned yet. The reference
+     *         count of the string is increased.
+     */
+    int internString(const QString& string);
+
+    /**
+     * Decreases the reference count of the interned string with the
+     * id \a id. The string is freed if it is not used anymore.
+     */
+    void releaseString(int id);
+
+    template<typename T>
+    static void ensureSize(QVector<T>& column, int slot);
+
+private:
+    int m_slotCount;
+    QVector<int> m_freeSlots;
+
+    QVector<quint16> m_flags;
+    QVector<QString> m_text;
+    QVector<qint64> m_size;
+    QVector<qint64> m_date;
+    QVector<int> m_expandedParentsCount;
+    QVector<QString> m_stringColumns[StringColumnCount];
+    QVector<int> m_internedColumns[InternedColumnCount];
+    QVector<QHash<QByteArray, QVariant> > m_otherValues;
+
+    QVector<QString> m_strings;
+    QVector<int> m_stringRefCounts;
+    QVector<int> m_freeStringIds;
+    QHash<QString, int> m_stringIds;
+};
+
+inline QString KFileItemModelRoleStore::text(int slot) const
+{
+    return (m_flags.at(slot) & HasText) ? m_text.at(slot) : QString();
+}
+
+inline bool KFileItemModelRoleStore::hasSize(int slot) const
+{
+    return m_flags.at(slot) & HasSize;
+}
+
+inline qint64 KFileItemModelRoleStore::size(int slot) const
+{
+    return (m_flags.at(slot) & HasSize) ? m_size.at(slot) : 0;
+}
+
+inline bool KFileItemModelRoleStore::isDir(int slot) const
+{
+    return m_flags.at(slot) & IsDir;
+}
+
+inline bool KFileItemModelRoleStore::isExpanded(int slot) const
+{
+    return m_flags.at(slot) & IsExpanded;
+}
+
+inline bool KFileItemModelRoleStore::isExpandable(int slot) const
+{
+    return m_flags.at(slot) & IsExpandable;
+}
+
+inline bool KFileItemModelRoleStore::hasExpandedParentsCount(int slot) const
+{
+    return m_flags.at(slot) & HasExpandedParentsCount;
+}
+
+inline int KFileItemModelRoleStore::expandedParentsCount(int slot) const
+{
+    return (m_flags.at(slot) & HasExpandedParentsCount) ? m_expandedParentsCount.at(slot) : 0;
+}
+
+#endif
@@ -22,14 +22,67 @@
 #ifndef KFILEITEMMODELSORTALGORITHM_H
 #define KFILEITEMMODELSORTALGORITHM_H
 
+#include "kfileitemmodelsortengine.h"
+
 #include <QtCore>
 
 #include <algorithm>
+#include <iterator>
+
+/**
+ * Merges the sorted item ranges between \a begin and \a pivot and
+ * between \a pivot and \a end into a single sorted range between
+ * \a begin and \a end. The items between \a begin and \a pivot are
+ * copied to \a buffer first, such that the merge requires only a linear
+ * number of comparisons and moves.
+ */
+
+template <typename RandomAccessIterator, typename LessThan>
+static void merge(RandomAccessIterator begin,
+                  RandomAccessIterator pivot,
+                  RandomAccessIterator end,
+                  LessThan lessThan,
+                  typename std::iterator_traits<RandomAccessIterator>::value_type* buffer)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type ValueType;
+
+    if (begin == pivot || pivot == end) {
+        return;
+    }
+
+    if (!lessThan(*pivot, *(pivot - 1))) {
+        // The ranges are in the correct order already.
+        return;
+    }
+
+    ValueType* left = buffer;
+    ValueType* const leftEnd = std::copy(begin, pivot, buffer);
+    RandomAccessIterator right = pivot;
+    RandomAccessIterator out = begin;
+
+    // Prefer the left item if both are equal to keep the sorting stable.
+    while (left != leftEnd && right != end) {
+        if (lessThan(*right, *left)) {
+            *out = *right;
+            ++right;
+        } else {
+            *out = *left;
+            ++left;
+        }
+        ++out;
+    }
+
+    // The remaining right items are at their final positions already.
+    std::copy(left, leftEnd, out);
+}
 
 /**
  * Sorts the items using the merge sort algorithm is used to assure a
  * worst-case of O(n * log(n)) and to keep the number of comparisons low.
  *
+ * The items are merged with the help of \a buffer, which must provide space
+ * for at least (end - begin) / 2 items.
+ *
  * The implementation is based on qStableSortHelper() from qalgorithms.h
  * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
  */
@@ -37,7 +90,8 @@
 template <typename RandomAccessIterator, typename LessThan>
 static void mergeSort(RandomAccessIterator begin,
                       RandomAccessIterator end,
-                      LessThan lessThan)
+                      LessThan lessThan,
+                      typename std::iterator_traits<RandomAccessIterator>::value_type* buffer)
 {
     // The implementation is based on qStableSortHelper() from qalgorithms.h
     // Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
@@ -48,96 +102,148 @@ static void mergeSort(RandomAccessIterator begin,
     }
 
     const RandomAccessIterator middle = begin + span / 2;
-    mergeSort(begin, middle, lessThan);
-    mergeSort(middle, end, lessThan);
-    merge(begin, middle, end, lessThan);
+    mergeSort(begin, middle, lessThan, buffer);
+    mergeSort(middle, end, lessThan, buffer);
+    merge(begin, middle, end, lessThan, buffer);
 }
 
 /**
- * Uses up to \a numberOfThreads threads to sort the items between
- * \a begin and \a end. Only item ranges longer than
- * \a parallelMergeSortingThreshold are split to be sorted by two different
- * threads.
- *
- * The comparison function \a lessThan must be reentrant.
+ * Sorts the items between \a begin and \a end in the current thread.
  */
 
 template <typename RandomAccessIterator, typename LessThan>
-static void parallelMergeSort(RandomAccessIterator begin,
-                              RandomAccessIterator end,
-                              LessThan lessThan,
-                              int numberOfThreads,
-                              int parallelMergeSortingThreshold = 100)
+static void mergeSort(RandomAccessIterator begin,
+                      RandomAccessIterator end,
+                      LessThan lessThan)
 {
-    const int span = end - begin;
-
-    if (numberOfThreads > 1 && span > parallelMergeSortingThreshold) {
-        const int newNumberOfThreads = numberOfThreads / 2;
-        const RandomAccessIterator middle = begin + span / 2;
-
-        QFuture<void> future = QtConcurrent::run(parallelMergeSort<RandomAccessIterator, LessThan>, begin, middle, lessThan, newNumberOfThreads, parallelMergeSortingThreshold);
-        parallelMergeSort(middle, end, lessThan, newNumberOfThreads, parallelMergeSortingThreshold);
-
-        future.waitForFinished();
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type ValueType;
 
-        merge(begin, middle, end, lessThan);
-    } else {
-        mergeSort(begin, end, lessThan);
+    const int span = end - begin;
+    if (span < 2) {
+        return;
     }
+
+    QVector<ValueType> buffer(span / 2);
+    mergeSort(begin, end, lessThan, buffer.data());
 }
 
 /**
- * Merges the sorted item ranges between \a begin and \a pivot and
- * between \a pivot and \a end into a single sorted range between
- * \a begin and \a end.
+ * @brief Task of parallelMergeSort() that sorts one item range.
  *
- * The implementation is based on qMerge() from qalgorithms.h
- * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ * Ranges that are not longer than KFileItemModelSortEngine::grainSize() are
+ * sorted with mergeSort(). Longer ranges are split into two halves, which are
+ * sorted by two child tasks. The task does not wait for its children: the
+ * child that finishes last merges both halves and thereby finishes the
+ * parent task.
+ *
+ * Each task uses the part of the scratch buffer that corresponds to its item
+ * range, so tasks that run in parallel never write to the same memory.
  */
 
 template <typename RandomAccessIterator, typename LessThan>
-static void merge(RandomAccessIterator begin,
-                  RandomAccessIterator pivot,
-                  RandomAccessIterator end,
-                  LessThan lessThan)
+class KFileItemModelMergeSortTask : public KFileItemModelSortEngine::Task
 {
-    // The implementation is based on qMerge() from qalgorithms.h
-    // Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies).
+public:
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type ValueType;
+
+    KFileItemModelMergeSortTask(KFileItemModelSortEngine* engine,
+                                RandomAccessIterator begin,
+                                RandomAccessIterator end,
+                                ValueType* buffer,
+                                LessThan lessThan,
+                                KFileItemModelMergeSortTask* parent = 0) :
+        m_engine(engine),
+        m_begin(begin),
+        m_end(end),
+        m_buffer(buffer),
+        m_lessThan(lessThan),
+        m_parent(parent),
+        m_left(0),
+        m_right(0),
+        m_pendingChildren(0)
+    {
+    }
 
-    const int len1 = pivot - begin;
-    const int len2 = end - pivot;
+    virtual ~KFileItemModelMergeSortTask()
+    {
+        delete m_left;
+        delete m_right;
+    }
 
-    if (len1 == 0 || len2 == 0) {
-        return;
+    virtual void run(int worker)
+    {
+        const int span = m_end - m_begin;
+        if (span <= m_engine->grainSize()) {
+            mergeSort(m_begin, m_end, m_lessThan, m_buffer);
+            finish();
+            return;
+        }
+
+        const int leftSpan = span / 2;
+        const RandomAccessIterator middle = m_begin + leftSpan;
+        m_left = new KFileItemModelMergeSortTask(m_engine, m_begin, middle, m_buffer, m_lessThan, this);
+        m_right = new KFileItemModelMergeSortTask(m_engine, middle, m_end, m_buffer + leftSpan, m_lessThan, this);
+        m_pendingChildren = 2;
+
+        m_engine->spawn(worker, m_right);
+        m_engine->spawn(worker, m_left);
     }
 
-    if (len1 + len2 == 2) {
-        if (lessThan(*(begin + 1), *(begin))) {
-            qSwap(*begin, *(begin + 1));
+private:
+    /**
+     * Is invoked if the item range of this task has been sorted.
+     * Finishes the parent task if its other child is finished already.
+     */
+    void finish()
+    {
+        if (m_parent && !m_parent->m_pendingChildren.deref()) {
+            m_parent->mergeChildren();
         }
-        return;
     }
 
-    RandomAccessIterator firstCut;
-    RandomAccessIterator secondCut;
-    int len2Half;
-    if (len1 > len2) {
-        const int len1Half = len1 / 2;
-        firstCut = begin + len1Half;
-        secondCut = std::lower_bound(pivot, end, *firstCut, lessThan);
-        len2Half = secondCut - pivot;
-    } else {
-        len2Half = len2 / 2;
-        secondCut = pivot + len2Half;
-        firstCut = std::upper_bound(begin, pivot, *secondCut, lessThan);
+    void mergeChildren()
+    {
+        merge(m_begin, m_left->m_end, m_end, m_lessThan, m_buffer);
+        finish();
     }
 
-    std::rotate(firstCut, pivot, secondCut);
+private:
+    KFileItemModelSortEngine* m_engine;
+    RandomAccessIterator m_begin;
+    RandomAccessIterator m_end;
+    ValueType* m_buffer;
+    LessThan m_lessThan;
+    KFileItemModelMergeSortTask* m_parent;
+    KFileItemModelMergeSortTask* m_left;
+    KFileItemModelMergeSortTask* m_right;
+    QAtomicInt m_pendingChildren;
+};
+
+/**
+ * Uses the threads of \a engine to sort the items between \a begin and
+ * \a end. Only item ranges longer than KFileItemModelSortEngine::grainSize()
+ * are split to be sorted by different threads.
+ *
+ * The comparison function \a lessThan must be reentrant.
+ */
+
+template <typename RandomAccessIterator, typename LessThan>
+static void parallelMergeSort(RandomAccessIterator begin,
+                              RandomAccessIterator end,
+                              LessThan lessThan,
+                              KFileItemModelSortEngine* engine)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type ValueType;
+
+    const int span = end - begin;
+    if (engine->threadCount() < 2 || span <= engine->grainSize()) {
+        mergeSort(begin, end, lessThan);
+        return;
+    }
 
-    RandomAccessIterator newPivot = firstCut + len2Half;
-    merge(begin, firstCut, newPivot, lessThan);
-    merge(newPivot, secondCut, end, lessThan);
+    QVector<ValueType> buffer(span);
+    KFileItemModelMergeSortTask<RandomAccessIterator, LessThan> task(engine, begin, end, buffer.data(), lessThan);
+    engine->execute(&task);
 }
 
 #endif
-
@@ -0,0 +1,244 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kfileitemmodelsortengine.h"
+
+#include <KGlobal>
+
+#include <QThread>
+
+class KFileItemModelSortWorker : public QThread
+{
+public:
+    KFileItemModelSortWorker(KFileItemModelSortEngine* engine, int worker) :
+        QThread(),
+        m_engine(engine),
+        m_worker(worker)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        m_engine->workerLoop(m_worker);
+    }
+
+private:
+    KFileItemModelSortEngine* m_engine;
+    int m_worker;
+};
+
+class KFileItemModelSortEngineSingleton
+{
+public:
+    KFileItemModelSortEngineSingleton() :
+        instance(QThread::idealThreadCount())
+    {
+    }
+
+    KFileItemModelSortEngine instance;
+};
+K_GLOBAL_STATIC(KFileItemModelSortEngineSingleton, s_sortEngine)
+
+
+
+KFileItemModelSortEngine::KFileItemModelSortEngine(int threadCount) :
+    m_grainSize(1000),
+    m_queues(),
+    m_workers(),
+    m_queuedTasks(0),
+    m_pendingTasks(0),
+    m_executeMutex(),
+    m_sleepMutex(),
+    m_taskAvailable(),
+    m_executeProgress(),
+    m_shutdown(false)
+{
+    threadCount = qMax(1, threadCount);
+
+    m_queues.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        m_queues.append(new TaskQueue());
+    }
+
+    // Worker 0 is the thread that invokes execute().
+    for (int i = 1; i < threadCount; ++i) {
+        KFileItemModelSortWorker* worker = new KFileItemModelSortWorker(this, i);
+        m_workers.append(worker);
+        worker->start();
+    }
+}
+
+KFileItemModelSortEngine::~KFileItemModelSortEngine()
+{
+    m_sleepMutex.lock();
+    m_shutdown = true;
+    m_taskAvailable.wakeAll();
+    m_sleepMutex.unlock();
+
+    foreach (KFileItemModelSortWorker* worker, m_workers) {
+        worker->wait();
+    }
+    qDeleteAll(m_workers);
+    qDeleteAll(m_queues);
+}
+
+KFileItemModelSortEngine* KFileItemModelSortEngine::instance()
+{
+    return &s_sortEngine->instance;
+}
+
+int KFileItemModelSortEngine::threadCount() const
+{
+    return m_queues.count();
+}
+
+void KFileItemModelSortEngine::setGrainSize(int grainSize)
+{
+    m_grainSize = qMax(2, grainSize);
+}
+
+int KFileItemModelSortEngine::grainSize() const
+{
+    return m_grainSize;
+}
+
+void KFileItemModelSortEngine::execute(Task* task)
+{
+    // Only one group of tasks is executed at a time. Otherwise the check
+    // for pending tasks below would wait for tasks of another caller.
+    QMutexLocker executeLocker(&m_executeMutex);
+
+    spawn(0, task);
+
+    // Participate as worker 0 until all tasks have been finished. Waiting
+    // for the other workers is only necessary if no task can be stolen.
+    forever {
+        Task* nextTask = takeTask(0);
+        if (nextTask) {
+            runTask(0, nextTask);
+            continue;
+        }
+
+        QMutexLocker sleepLocker(&m_sleepMutex);
+        if (m_pendingTasks <= 0) {
+            return;
+        }
+        if (m_queuedTasks <= 0) {
+            // Woken up by spawn() if a task can be stolen again or by
+            // runTask() if the last task has been finished.
+            m_executeProgress.wait(&m_sleepMutex);
+        }
+    }
+}
+
+void KFileItemModelSortEngine::start(Task* task)
+{
+    if (m_workers.isEmpty()) {
+        task->run(0);
+    } else {
+        spawn(1, task);
+    }
+}
+
+void KFileItemModelSortEngine::spawn(int worker, Task* task)
+{
+    m_pendingTasks.ref();
+
+    TaskQueue* queue = m_queues.at(worker);
+    queue->mutex.lock();
+    queue->tasks.append(task);
+    queue->mutex.unlock();
+
+    m_queuedTasks.ref();
+
+    if (!m_workers.isEmpty()) {
+        // The increment of m_queuedTasks is done before locking m_sleepMutex.
+        // This guarantees that a worker either notices the new task before
+        // going to sleep or is woken up here.
+        QMutexLocker sleepLocker(&m_sleepMutex);
+        m_taskAvailable.wakeOne();
+        m_executeProgress.wakeOne();
+    }
+}
+
+KFileItemModelSortEngine::Task* KFileItemModelSortEngine::takeTask(int worker)
+{
+    if (m_queuedTasks <= 0) {
+        return 0;
+    }
+
+    // Take the most recently spawned task from the own queue...
+    TaskQueue* ownQueue = m_queues.at(worker);
+    ownQueue->mutex.lock();
+    if (!ownQueue->tasks.isEmpty()) {
+        Task* task = ownQueue->tasks.takeLast();
+        ownQueue->mutex.unlock();
+        m_queuedTasks.deref();
+        return task;
+    }
+    ownQueue->mutex.unlock();
+
+    // ... or steal the oldest task from another worker.
+    const int queueCount = m_queues.count();
+    for (int i = 1; i < queueCount; ++i) {
+        TaskQueue* queue = m_queues.at((worker + i) % queueCount);
+        queue->mutex.lock();
+        if (!queue->tasks.isEmpty()) {
+            Task* task = queue->tasks.takeFirst();
+            queue->mutex.unlock();
+            m_queuedTasks.deref();
+            return task;
+        }
+        queue->mutex.unlock();
+    }
+
+    return 0;
+}
+
+void KFileItemModelSortEngine::runTask(int worker, Task* task)
+{
+    task->run(worker);
+
+    // Tasks that have been spawned by 'task' have already increased
+    // m_pendingTasks, so it only reaches 0 if everything has been done.
+    if (!m_pendingTasks.deref()) {
+        QMutexLocker sleepLocker(&m_sleepMutex);
+        m_executeProgress.wakeOne();
+    }
+}
+
+void KFileItemModelSortEngine::workerLoop(int worker)
+{
+    forever {
+        Task* task = takeTask(worker);
+        if (task) {
+            runTask(worker, task);
+            continue;
+        }
+
+        QMutexLocker sleepLocker(&m_sleepMutex);
+        if (m_shutdown) {
+            return;
+        }
+        if (m_queuedTasks <= 0) {
+            m_taskAvailable.wait(&m_sleepMutex);
+        }
+    }
+}
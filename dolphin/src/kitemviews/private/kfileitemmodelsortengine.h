@@ -0,0 +1,147 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KFILEITEMMODELSORTENGINE_H
+#define KFILEITEMMODELSORTENGINE_H
+
+#include <libdolphin_export.h>
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+class KFileItemModelSortWorker;
+
+/**
+ * @brief Work-stealing task pool that is used by parallelMergeSort().
+ *
+ * Each worker owns a double-ended queue of tasks. A worker takes the most
+ * recently spawned task from its own queue. If its queue is empty, it steals
+ * the oldest task from the queue of another worker. Old tasks represent large
+ * item ranges, so a steal usually provides enough work for a long time.
+ *
+ * Tasks never wait for other tasks. A task that depends on the results of
+ * other tasks must be continued by the task that finishes last (see
+ * KFileItemModelMergeSortTask in kfileitemmodelsortalgorithm.h).
+ *
+ * The thread that calls execute() acts as worker 0, all other workers are
+ * dedicated threads that sleep while no tasks are available.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KFileItemModelSortEngine
+{
+
+public:
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+
+        /**
+         * Is invoked by the worker \a worker. Tasks that are spawned
+         * by run() should be passed to spawn() together with \a worker.
+         */
+        virtual void run(int worker) = 0;
+    };
+
+    /**
+     * Creates an engine that uses up to \a threadCount threads,
+     * including the thread that invokes execute().
+     */
+    explicit KFileItemModelSortEngine(int threadCount);
+    ~KFileItemModelSortEngine();
+
+    /**
+     * @return Engine that uses QThread::idealThreadCount() threads.
+     */
+    static KFileItemModelSortEngine* instance();
+
+    int threadCount() const;
+
+    /**
+     * Sets the number of items up to which a range is sorted by a single task
+     * without being split further. Smaller values result in a better load
+     * balancing, larger values reduce the overhead for the task management.
+     */
+    void setGrainSize(int grainSize);
+    int grainSize() const;
+
+    /**
+     * Runs \a task and all tasks that are spawned by it, and returns after all
+     * of them have been finished. The calling thread runs tasks as well and
+     * sleeps while all remaining tasks are being run by other workers. The
+     * engine does not take ownership of tasks.
+     */
+    void execute(Task* task);
+
+    /**
+     * Passes \a task to the worker threads and returns immediately. The task
+     * must not spawn other tasks and must inform its owner itself when it has
+     * been finished. If the engine has no worker threads, \a task is run
+     * before returning. Note that execute() also waits for tasks that have been
+     * started by this method.
+     */
+    void start(Task* task);
+
+    /**
+     * Adds \a task to the queue of the worker \a worker. May only be called by
+     * Task::run() and by execute().
+     */
+    void spawn(int worker, Task* task);
+
+private:
+    struct TaskQueue
+    {
+        QMutex mutex;
+        QList<Task*> tasks;
+    };
+
+    /**
+     * @return Task from the queue of \a worker or stolen from another
+     *         worker. 0 is returned if all queues are empty.
+     */
+    Task* takeTask(int worker);
+
+    void runTask(int worker, Task* task);
+
+    /**
+     * Main loop of the dedicated worker threads.
+     */
+    void workerLoop(int worker);
+
+private:
+    int m_grainSize;
+    QVector<TaskQueue*> m_queues;
+    QList<KFileItemModelSortWorker*> m_workers;
+
+    QAtomicInt m_queuedTasks;
+    QAtomicInt m_pendingTasks;
+
+    QMutex m_executeMutex;
+
+    QMutex m_sleepMutex;
+    QWaitCondition m_taskAvailable;
+    QWaitCondition m_executeProgress;
+    bool m_shutdown;
+
+    friend class KFileItemModelSortWorker;
+};
+
+#endif
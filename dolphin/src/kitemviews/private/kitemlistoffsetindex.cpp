@@ -0,0 +1,122 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kitemlistoffsetindex.h"
+
+namespace {
+    inline int lowBit(int i)
+    {
+        return i & -i;
+    }
+}
+
+KItemListOffsetIndex::KItemListOffsetIndex() :
+    m_values(),
+    m_tree(1, 0)
+{
+}
+
+void KItemListOffsetIndex::clear()
+{
+    m_values.clear();
+    m_tree.resize(1);
+}
+
+void KItemListOffsetIndex::append(qreal value)
+{
+    // The new node covers the values (i - lowbit(i), i], where i is the
+    // 1-based index of the new value.
+    const int i = m_values.count() + 1;
+    m_values.append(value);
+    m_tree.append(value + prefixSum(i - 1) - prefixSum(i - lowBit(i)));
+}
+
+void KItemListOffsetIndex::truncate(int count)
+{
+    // The nodes 1..count only cover values with an index < count, so they
+    // remain valid.
+    if (count < m_values.count()) {
+        m_values.resize(count);
+        m_tree.resize(count + 1);
+    }
+}
+
+void KItemListOffsetIndex::setValue(int index, qreal value)
+{
+    const qreal difference = value - m_values.at(index);
+    if (difference == 0) {
+        return;
+    }
+
+    m_values[index] = value;
+    const int treeCount = m_tree.count();
+    for (int i = index + 1; i < treeCount; i += lowBit(i)) {
+        m_tree[i] += difference;
+    }
+}
+
+qreal KItemListOffsetIndex::prefixSum(int index) const
+{
+    qreal sum = 0;
+    for (int i = index; i > 0; i -= lowBit(i)) {
+        sum += m_tree.at(i);
+    }
+    return sum;
+}
+
+int KItemListOffsetIndex::lastIndexBefore(qreal offset) const
+{
+    return qMin(leadingCount(offset, false), count()) - 1;
+}
+
+int KItemListOffsetIndex::lastIndexAtOrBefore(qreal offset) const
+{
+    return qMin(leadingCount(offset, true), count()) - 1;
+}
+
+int KItemListOffsetIndex::leadingCount(qreal offset, bool inclusive) const
+{
+    // prefixSum(0) is 0, so no prefix sum can match if the offset is too small.
+    if (inclusive ? (offset < 0) : (offset <= 0)) {
+        return 0;
+    }
+
+    const int n = m_values.count();
+    int step = 1;
+    while (step * 2 <= n) {
+        step *= 2;
+    }
+
+    // Find the largest k with a sum of the first k values below the offset.
+    // As all values are non-negative, prefixSum(i) matches for all i <= k.
+    int k = 0;
+    qreal sum = 0;
+    for (; step > 0; step /= 2) {
+        const int next = k + step;
+        if (next <= n) {
+            const qreal nextSum = sum + m_tree.at(next);
+            if (inclusive ? (nextSum <= offset) : (nextSum < offset)) {
+                k = next;
+                sum = nextSum;
+            }
+        }
+    }
+
+    return k + 1;
+}
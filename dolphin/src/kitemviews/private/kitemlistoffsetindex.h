@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KITEMLISTOFFSETINDEX_H
+#define KITEMLISTOFFSETINDEX_H
+
+#include <libdolphin_export.h>
+
+#include <QVector>
+
+/**
+ * @brief Stores a sequence of non-negative values and their prefix sums.
+ *
+ * KItemListViewLayouter uses the index to store the heights of the rows.
+ * The position of a row and the row at a certain offset can be determined
+ * in O(log n), and changing the height of a row only requires O(log n)
+ * operations, because the values are stored in a binary indexed tree
+ * (Fenwick tree).
+ */
+class LIBDOLPHINPRIVATE_EXPORT KItemListOffsetIndex
+{
+
+public:
+    KItemListOffsetIndex();
+
+    void clear();
+    int count() const;
+
+    /**
+     * Appends the value \a value in O(log n).
+     */
+    void append(qreal value);
+
+    /**
+     * Removes all values starting at \a count in O(1).
+     */
+    void truncate(int count);
+
+    void setValue(int index, qreal value);
+    qreal value(int index) const;
+
+    /**
+     * @return Sum of the values with an index smaller than \a index.
+     *         The sum of all values is returned for \a index == count().
+     */
+    qreal prefixSum(int index) const;
+
+    /**
+     * @return Largest index i with prefixSum(i) < \a offset, or -1 if
+     *         there is no such index.
+     */
+    int lastIndexBefore(qreal offset) const;
+
+    /**
+     * @return Largest index i with prefixSum(i) <= \a offset, or -1 if
+     *         there is no such index.
+     */
+    int lastIndexAtOrBefore(qreal offset) const;
+
+private:
+    /**
+     * @return Number of leading values whose sum is smaller than (or equal
+     *         to, if \a inclusive is true) \a offset.
+     */
+    int leadingCount(qreal offset, bool inclusive) const;
+
+private:
+    QVector<qreal> m_values;
+    QVector<qreal> m_tree; // 1-based; m_tree[i] is the sum of the values (i - lowbit(i), i]
+};
+
+inline int KItemListOffsetIndex::count() const
+{
+    return m_values.count();
+}
+
+inline qreal KItemListOffsetIndex::value(int index) const
+{
+    return m_values.at(index);
+}
+
+#endif
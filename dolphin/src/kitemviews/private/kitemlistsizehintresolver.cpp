@@ -19,6 +19,8 @@
 
 #include "kitemlistsizehintresolver.h"
 
+#include "kitemlisttextheightresolver.h"
+
 #include <kitemviews/kitemlistview.h>
 
 KItemListSizeHintResolver::KItemListSizeHintResolver(const KItemListView* itemListView) :
@@ -35,8 +37,16 @@ QSizeF KItemListSizeHintResolver::sizeHint(int index) const
 {
     QSizeF size = m_sizeHintCache.at(index);
     if (size.isEmpty()) {
+        const KItemListTextHeightResolver* textHeightResolver = KItemListTextHeightResolver::instance();
+        const quint64 estimatedCount = textHeightResolver->estimatedCount();
+
         size = m_itemListView->itemSizeHint(index);
-        m_sizeHintCache[index] = size;
+
+        // If the size hint is based on estimated text heights, it is not cached.
+        // The view requests it again when the exact text heights are known.
+        if (textHeightResolver->estimatedCount() == estimatedCount) {
+            m_sizeHintCache[index] = size;
+        }
     }
     return size;
 }
@@ -0,0 +1,265 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kitemlisttextheightresolver.h"
+
+#include <KGlobal>
+
+#include <QFontDatabase>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QTextLayout>
+#include <QTextLine>
+#include <QTimer>
+
+#include <cmath>
+
+namespace {
+    // Number of texts that are laid out by one task
+    const int RequestsPerTask = 64;
+
+    // Maximum number of cached heights
+    const int MaxCacheSize = 100000;
+}
+
+K_GLOBAL_STATIC(KItemListTextHeightResolver, s_textHeightResolver)
+
+uint qHash(const KItemListTextHeightResolver::Key& key)
+{
+    return qHash(key.text) ^ qHash(key.font) ^ qHash(static_cast<int>(key.width * 4));
+}
+
+class KItemListTextHeightTask : public QRunnable
+{
+public:
+    KItemListTextHeightTask(KItemListTextHeightResolver* resolver,
+                            const QList<KItemListTextHeightResolver::Request>& requests) :
+        QRunnable(),
+        m_resolver(resolver),
+        m_requests(requests)
+    {
+    }
+
+    virtual void run()
+    {
+        QList<KItemListTextHeightResolver::Result> results;
+        results.reserve(m_requests.count());
+        foreach (const KItemListTextHeightResolver::Request& request, m_requests) {
+            KItemListTextHeightResolver::Result result;
+            result.key = request.key;
+            result.height = KItemListTextHeightResolver::calculateTextHeight(request.key.text, request.font,
+                                                                             request.key.width, request.key.maxHeight);
+            results.append(result);
+        }
+        m_resolver->addResults(results);
+    }
+
+private:
+    KItemListTextHeightResolver* m_resolver;
+    QList<KItemListTextHeightResolver::Request> m_requests;
+};
+
+KItemListTextHeightResolver::KItemListTextHeightResolver(QObject* parent) :
+    QObject(parent),
+    m_threaded(QFontDatabase::supportsThreadedFontRendering()),
+    m_estimatedCount(0),
+    m_cache(MaxCacheSize),
+    m_pendingKeys(),
+    m_queuedRequests(),
+    m_threadPool(),
+    m_resultsMutex(),
+    m_results(),
+    m_estimationFont(),
+    m_estimationFontMetrics(m_estimationFont)
+{
+}
+
+KItemListTextHeightResolver::~KItemListTextHeightResolver()
+{
+    m_threadPool.waitForDone();
+}
+
+KItemListTextHeightResolver* KItemListTextHeightResolver::instance()
+{
+    return s_textHeightResolver;
+}
+
+qreal KItemListTextHeightResolver::textHeight(const QString& text, const QFont& font, qreal width, qreal maxHeight, bool* isEstimated,
+                                              const QObject* requester, int index)
+{
+    if (isEstimated) {
+        *isEstimated = false;
+    }
+
+    Key key;
+    key.text = text;
+    key.font = font.key();
+    key.width = width;
+    key.maxHeight = maxHeight;
+
+    const qreal* cachedHeight = m_cache.object(key);
+    if (cachedHeight) {
+        return *cachedHeight;
+    }
+
+    if (!m_threaded) {
+        const qreal height = calculateTextHeight(text, font, width, maxHeight);
+        m_cache.insert(key, new qreal(height));
+        return height;
+    }
+
+    Waiter waiter;
+    waiter.requester = requester;
+    waiter.index = index;
+
+    QHash<Key, QList<Waiter> >::iterator pendingIt = m_pendingKeys.find(key);
+    if (pendingIt != m_pendingKeys.end()) {
+        pendingIt->append(waiter);
+    } else {
+        m_pendingKeys.insert(key, QList<Waiter>() << waiter);
+
+        Request request;
+        request.key = key;
+        request.font = font;
+        m_queuedRequests.append(request);
+
+        if (m_queuedRequests.count() == 1) {
+            // The requests are usually made for many items in a row, so
+            // they are collected and passed to the thread pool in batches.
+            QTimer::singleShot(0, this, SLOT(startPendingTasks()));
+        } else if (m_queuedRequests.count() >= RequestsPerTask) {
+            startPendingTasks();
+        }
+    }
+
+    if (isEstimated) {
+        *isEstimated = true;
+    }
+    ++m_estimatedCount;
+    return estimatedTextHeight(text, font, width, maxHeight);
+}
+
+qreal KItemListTextHeightResolver::calculateTextHeight(const QString& text, const QFont& font, qreal width, qreal maxHeight)
+{
+    QTextOption textOption(Qt::AlignHCenter);
+    textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+
+    qreal textHeight = 0;
+    QTextLine line;
+    QTextLayout layout(text, font);
+    layout.setTextOption(textOption);
+    layout.beginLayout();
+    while ((line = layout.createLine()).isValid()) {
+        line.setLineWidth(width);
+        line.naturalTextWidth();
+        textHeight += line.height();
+        if (maxHeight > 0 && textHeight > maxHeight) {
+            break;
+        }
+    }
+    layout.endLayout();
+
+    return textHeight;
+}
+
+void KItemListTextHeightResolver::startPendingTasks()
+{
+    while (!m_queuedRequests.isEmpty()) {
+        const QList<Request> requests = m_queuedRequests.mid(0, RequestsPerTask);
+        m_queuedRequests = m_queuedRequests.mid(requests.count());
+        m_threadPool.start(new KItemListTextHeightTask(this, requests));
+    }
+}
+
+void KItemListTextHeightResolver::slotResultsAvailable()
+{
+    QList<Result> results;
+    {
+        QMutexLocker locker(&m_resultsMutex);
+        results.swap(m_results);
+    }
+
+    if (results.isEmpty()) {
+        // The results have been handled by a previous invocation already.
+        return;
+    }
+
+    // Each requester is notified once about the range of its indexes
+    // whose heights have been resolved.
+    QHash<const QObject*, QPair<int, int> > resolvedRanges;
+    foreach (const Result& result, results) {
+        foreach (const Waiter& waiter, m_pendingKeys.take(result.key)) {
+            QHash<const QObject*, QPair<int, int> >::iterator it = resolvedRanges.find(waiter.requester);
+            if (it == resolvedRanges.end()) {
+                resolvedRanges.insert(waiter.requester, qMakePair(waiter.index, waiter.index));
+            } else if (waiter.index >= 0) {
+                if (it->first < 0 || waiter.index < it->first) {
+                    it->first = waiter.index;
+                }
+                it->second = qMax(it->second, waiter.index);
+            }
+        }
+        m_cache.insert(result.key, new qreal(result.height));
+    }
+
+    QHashIterator<const QObject*, QPair<int, int> > it(resolvedRanges);
+    while (it.hasNext()) {
+        it.next();
+        emit textHeightsResolved(it.key(), it.value().first, it.value().second);
+    }
+}
+
+qreal KItemListTextHeightResolver::estimatedTextHeight(const QString& text, const QFont& font, qreal width, qreal maxHeight)
+{
+    if (font != m_estimationFont) {
+        m_estimationFont = font;
+        m_estimationFontMetrics = QFontMetricsF(font);
+    }
+
+    // Assume that the text is wrapped anywhere, which is usually a good
+    // approximation of the number of lines for file names.
+    const qreal textWidth = m_estimationFontMetrics.width(text);
+    const int lineCount = (width > 0) ? qMax(1, static_cast<int>(std::ceil(textWidth / width))) : 1;
+
+    qreal height = lineCount * m_estimationFontMetrics.height();
+    if (maxHeight > 0 && height > maxHeight) {
+        // calculateTextHeight() stops after the first line that exceeds
+        // the maximum height.
+        height = std::ceil(maxHeight / m_estimationFontMetrics.height()) * m_estimationFontMetrics.height();
+    }
+    return height;
+}
+
+void KItemListTextHeightResolver::addResults(const QList<Result>& results)
+{
+    bool notify;
+    {
+        QMutexLocker locker(&m_resultsMutex);
+        notify = m_results.isEmpty();
+        m_results += results;
+    }
+
+    if (notify) {
+        // Results that arrive before the slot is invoked are handled by
+        // the same invocation.
+        QMetaObject::invokeMethod(this, "slotResultsAvailable", Qt::QueuedConnection);
+    }
+}
+
+#include "kitemlisttextheightresolver.moc"
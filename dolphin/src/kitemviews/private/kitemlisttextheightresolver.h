@@ -0,0 +1,167 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KITEMLISTTEXTHEIGHTRESOLVER_H
+#define KITEMLISTTEXTHEIGHTRESOLVER_H
+
+#include <libdolphin_export.h>
+
+#include <QCache>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+
+class KItemListTextHeightTask;
+
+/**
+ * @brief Calculates the height of word-wrapped texts in background threads.
+ *
+ * Laying out the names of the items with QTextLayout is expensive. If
+ * the size hints of all items in the icons view must be calculated, e.g.,
+ * because the zoom level has been changed, this would block the user
+ * interface for a long time in large directories.
+ *
+ * textHeight() returns the exact height if it has been calculated already.
+ * Otherwise an estimated height is returned, and the text is laid out
+ * in a thread pool. The signal textHeightsResolved() is emitted for each
+ * requester when new exact heights are available. The results are cached
+ * with the text, the font, the width and the maximum height as key.
+ *
+ * If the platform does not support laying out text outside the GUI thread
+ * (see QFontDatabase::supportsThreadedFontRendering()), the heights are
+ * calculated synchronously.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KItemListTextHeightResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    KItemListTextHeightResolver(QObject* parent = 0);
+    virtual ~KItemListTextHeightResolver();
+
+    static KItemListTextHeightResolver* instance();
+
+    /**
+     * @return Height of \a text if it is wrapped at word boundaries (or
+     *         anywhere, if required) with the line width \a width. If
+     *         \a maxHeight is > 0, the layout is stopped as soon as the
+     *         height exceeds \a maxHeight. If the exact height is not
+     *         known yet, an estimated height is returned and
+     *         \a isEstimated is set to true. In this case
+     *         textHeightsResolved() is emitted with \a requester and
+     *         \a index as soon as the exact height is known.
+     */
+    qreal textHeight(const QString& text, const QFont& font, qreal width, qreal maxHeight, bool* isEstimated = 0,
+                     const QObject* requester = 0, int index = -1);
+
+    /**
+     * @return Number of estimated heights that have been returned by
+     *         textHeight() since the resolver has been created. This
+     *         allows callers to detect whether a calculation that uses
+     *         textHeight() indirectly is based on estimated heights.
+     */
+    quint64 estimatedCount() const;
+
+    /**
+     * Lays out \a text in the current thread, see textHeight().
+     */
+    static qreal calculateTextHeight(const QString& text, const QFont& font, qreal width, qreal maxHeight);
+
+signals:
+    /**
+     * Is emitted if exact heights are available for texts whose height
+     * has been estimated for \a requester. \a firstIndex and \a lastIndex
+     * are the smallest and the largest index that have been passed to
+     * textHeight() for these texts, or -1 if no index has been passed.
+     */
+    void textHeightsResolved(const QObject* requester, int firstIndex, int lastIndex);
+
+private slots:
+    void startPendingTasks();
+    void slotResultsAvailable();
+
+private:
+    struct Key
+    {
+        QString text;
+        QString font;
+        qreal width;
+        qreal maxHeight;
+
+        bool operator==(const Key& other) const
+        {
+            return width == other.width && maxHeight == other.maxHeight &&
+                   text == other.text && font == other.font;
+        }
+    };
+
+    struct Request
+    {
+        Key key;
+        QFont font;
+    };
+
+    struct Result
+    {
+        Key key;
+        qreal height;
+    };
+
+    struct Waiter
+    {
+        const QObject* requester;
+        int index;
+    };
+
+    friend uint qHash(const Key& key);
+    friend class KItemListTextHeightTask;
+
+    qreal estimatedTextHeight(const QString& text, const QFont& font, qreal width, qreal maxHeight);
+
+    /**
+     * Is invoked by KItemListTextHeightTask in a worker thread.
+     */
+    void addResults(const QList<Result>& results);
+
+private:
+    bool m_threaded;
+    quint64 m_estimatedCount;
+
+    QCache<Key, qreal> m_cache;
+    QHash<Key, QList<Waiter> > m_pendingKeys; // Requesters waiting for the height of a key
+    QList<Request> m_queuedRequests;
+    QThreadPool m_threadPool;
+
+    QMutex m_resultsMutex;
+    QList<Result> m_results;
+
+    QFont m_estimationFont;
+    QFontMetricsF m_estimationFontMetrics;
+};
+
+inline quint64 KItemListTextHeightResolver::estimatedCount() const
+{
+    return m_estimatedCount;
+}
+
+#endif
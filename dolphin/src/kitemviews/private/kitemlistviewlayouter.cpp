@@ -30,6 +30,9 @@ KItemListViewLayouter::KItemListViewLayouter(QObject* parent) :
     QObject(parent),
     m_dirty(true),
     m_visibleIndexesDirty(true),
+    m_firstDirtyIndex(-1),
+    m_firstSizeHintDirtyIndex(-1),
+    m_lastSizeHintDirtyIndex(-1),
     m_scrollOrientation(Qt::Vertical),
     m_size(),
     m_itemSize(128, 128),
@@ -46,10 +49,15 @@ KItemListViewLayouter::KItemListViewLayouter(QObject* parent) :
     m_columnWidth(0),
     m_xPosInc(0),
     m_columnCount(0),
+    m_logicalItemSize(),
+    m_logicalItemMargin(),
+    m_grouped(false),
     m_groupItemIndexes(),
     m_groupHeaderHeight(0),
     m_groupHeaderMargin(0),
-    m_itemInfos()
+    m_itemInfos(),
+    m_rowInfos(),
+    m_rowOffsets()
 {
 }
 
@@ -242,7 +250,7 @@ QRectF KItemListViewLayouter::itemRect(int index) const
     if (m_scrollOrientation == Qt::Horizontal) {
         // Rotate the logical direction which is always vertical by 90°
         // to get the physical horizontal direction
-        const QRectF& b = m_itemInfos[index].rect;
+        const QRectF b = logicalItemRect(index);
         QRectF bounds(b.y(), b.x(), b.height(), b.width());
         QPointF pos = bounds.topLeft();
         pos.rx() -= m_scrollOffset;
@@ -250,11 +258,41 @@ QRectF KItemListViewLayouter::itemRect(int index) const
         return bounds;
     }
 
-    QRectF bounds = m_itemInfos[index].rect;
+    QRectF bounds = logicalItemRect(index);
     bounds.moveTo(bounds.topLeft() - QPointF(m_itemOffset, m_scrollOffset));
     return bounds;
 }
 
+int KItemListViewLayouter::itemAt(const QPointF& pos) const
+{
+    const_cast<KItemListViewLayouter*>(this)->doLayout();
+    if (m_rowInfos.isEmpty()) {
+        return -1;
+    }
+
+    // Map the position to the logical (vertical) layout, see itemRect()
+    QPointF logicalPos;
+    if (m_scrollOrientation == Qt::Horizontal) {
+        logicalPos = QPointF(pos.y(), pos.x() + m_scrollOffset);
+    } else {
+        logicalPos = QPointF(pos.x() + m_itemOffset, pos.y() + m_scrollOffset);
+    }
+
+    const int row = rowAt(logicalPos.y(), true);
+    if (row < 0) {
+        return -1;
+    }
+
+    const qreal columnX = logicalItemRect(m_rowInfos[row].firstIndex).x();
+    const int column = static_cast<int>((logicalPos.x() - columnX + m_columnWidth) / m_columnWidth) - 1;
+    const int index = m_rowInfos[row].firstIndex + column;
+    if (column < 0 || index >= rowEndIndex(row)) {
+        return -1;
+    }
+
+    return logicalItemRect(index).contains(logicalPos) ? index : -1;
+}
+
 QRectF KItemListViewLayouter::groupHeaderRect(int index) const
 {
     const_cast<KItemListViewLayouter*>(this)->doLayout();
@@ -279,16 +317,16 @@ QRectF KItemListViewLayouter::groupHeaderRect(int index) const
         // Qt::Horizontal and m_itemRects is accessed directly,
         // the logical height represents the visual width.
         qreal width = minimumGroupHeaderWidth();
-        const qreal y = m_itemInfos[index].rect.y();
+        const int row = m_itemInfos[index].row;
         const int maxIndex = m_itemInfos.count() - 1;
         while (index <= maxIndex) {
-            QRectF bounds = m_itemInfos[index].rect;
-            if (bounds.y() != y) {
+            const ItemInfo& itemInfo = m_itemInfos[index];
+            if (itemInfo.row != row) {
                 break;
             }
 
-            if (bounds.height() > width) {
-                width = bounds.height();
+            if (itemInfo.height > width) {
+                width = itemInfo.height;
             }
 
             ++index;
@@ -348,17 +386,41 @@ void KItemListViewLayouter::markAsDirty()
     m_dirty = true;
 }
 
+void KItemListViewLayouter::markAsDirtyFrom(int index)
+{
+    index = qMax(0, index);
+    if (m_firstDirtyIndex < 0 || index < m_firstDirtyIndex) {
+        m_firstDirtyIndex = index;
+    }
+}
+
+void KItemListViewLayouter::markSizeHintsAsDirty(int index, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const int lastIndex = index + count - 1;
+    if (m_firstSizeHintDirtyIndex < 0) {
+        m_firstSizeHintDirtyIndex = index;
+        m_lastSizeHintDirtyIndex = lastIndex;
+    } else {
+        m_firstSizeHintDirtyIndex = qMin(m_firstSizeHintDirtyIndex, index);
+        m_lastSizeHintDirtyIndex = qMax(m_lastSizeHintDirtyIndex, lastIndex);
+    }
+}
+
 
 #ifndef QT_NO_DEBUG
     bool KItemListViewLayouter::isDirty()
     {
-        return m_dirty;
+        return m_dirty || m_firstDirtyIndex >= 0 || m_firstSizeHintDirtyIndex >= 0;
     }
 #endif
 
 void KItemListViewLayouter::doLayout()
 {
-    if (m_dirty) {
+    if (m_dirty || m_firstDirtyIndex >= 0 || m_firstSizeHintDirtyIndex >= 0) {
 #ifdef KITEMLISTVIEWLAYOUTER_DEBUG
         QElapsedTimer timer;
         timer.start();
@@ -387,6 +449,8 @@ void KItemListViewLayouter::doLayout()
             }
         }
 
+        const int previousColumnCount = m_columnCount;
+
         m_columnWidth = itemSize.width() + itemMargin.width();
         const qreal widthForColumns = size.width() - itemMargin.width();
         m_columnCount = qMax(1, int(widthForColumns / m_columnWidth));
@@ -403,110 +467,32 @@ void KItemListViewLayouter::doLayout()
             }
         }
 
-        int rowCount = itemCount / m_columnCount;
-        if (itemCount % m_columnCount != 0) {
-            ++rowCount;
+        // The x-positions of the items are calculated from the columns in
+        // logicalItemRect(), so the rows before the first changed item can
+        // be kept as long as the number of columns and the grouping are unchanged.
+        int firstIndex = 0;
+        if (!m_dirty && m_columnCount == previousColumnCount && grouped == m_grouped) {
+            firstIndex = (m_firstDirtyIndex >= 0) ? m_firstDirtyIndex : itemCount;
         }
 
-        m_itemInfos.resize(itemCount);
-
-        qreal y = m_headerHeight + itemMargin.height();
-        int row = 0;
-
-        int index = 0;
-        while (index < itemCount) {
-            qreal x = m_xPosInc;
-            qreal maxItemHeight = itemSize.height();
-
-            if (grouped) {
-                if (horizontalScrolling) {
-                    // All group headers will always be aligned on the top and not
-                    // flipped like the other properties
-                    x += m_groupHeaderHeight;
-                }
-
-                if (m_groupItemIndexes.contains(index)) {
-                    // The item is the first item of a group.
-                    // Increase the y-position to provide space
-                    // for the group header.
-                    if (index > 0) {
-                        // Only add a margin if there has been added another
-                        // group already before
-                        y += m_groupHeaderMargin;
-                    } else if (!horizontalScrolling) {
-                        // The first group header should be aligned on top
-                        y -= itemMargin.height();
-                    }
-
-                    if (!horizontalScrolling) {
-                        y += m_groupHeaderHeight;
-                    }
-                }
-            }
-
-            int column = 0;
-            while (index < itemCount && column < m_columnCount) {
-                qreal requiredItemHeight = itemSize.height();
-                if (m_sizeHintResolver) {
-                    const QSizeF sizeHint = m_sizeHintResolver->sizeHint(index);
-                    const qreal sizeHintHeight = horizontalScrolling ? sizeHint.width() : sizeHint.height();
-                    if (sizeHintHeight > requiredItemHeight) {
-                        requiredItemHeight = sizeHintHeight;
-                    }
-                }
-
-                ItemInfo& itemInfo = m_itemInfos[index];
-                itemInfo.rect = QRectF(x, y, itemSize.width(), requiredItemHeight);
-                itemInfo.column = column;
-                itemInfo.row = row;
-
-                if (grouped && horizontalScrolling) {
-                    // When grouping is enabled in the horizontal mode, the header alignment
-                    // looks like this:
-                    //   Header-1 Header-2 Header-3
-                    //   Item 1   Item 4   Item 7
-                    //   Item 2   Item 5   Item 8
-                    //   Item 3   Item 6   Item 9
-                    // In this case 'requiredItemHeight' represents the column-width. We don't
-                    // check the content of the header in the layouter to determine the required
-                    // width, hence assure that at least a minimal width of 15 characters is given
-                    // (in average a character requires the halve width of the font height).
-                    //
-                    // TODO: Let the group headers provide a minimum width and respect this width here
-                    const qreal headerWidth = minimumGroupHeaderWidth();
-                    if (requiredItemHeight < headerWidth) {
-                        requiredItemHeight = headerWidth;
-                    }
-                }
-
-                maxItemHeight = qMax(maxItemHeight, requiredItemHeight);
-                x += m_columnWidth;
-                ++index;
-                ++column;
-
-                if (grouped && m_groupItemIndexes.contains(index)) {
-                    // The item represents the first index of a group
-                    // and must aligned in the first column
-                    break;
-                }
-            }
+        m_logicalItemSize = itemSize;
+        m_logicalItemMargin = itemMargin;
+        m_grouped = grouped;
 
-            y += maxItemHeight + itemMargin.height();
-            ++row;
+        if (firstIndex > 0 && m_firstSizeHintDirtyIndex >= 0) {
+            // Items at or behind firstIndex are laid out again anyway.
+            updateRowHeights(m_firstSizeHintDirtyIndex, qMin(m_lastSizeHintDirtyIndex, firstIndex - 1));
         }
+        layoutItems(firstIndex);
 
-        if (itemCount > 0) {
+        if (!m_rowInfos.isEmpty()) {
             // Calculate the maximum y-range of the last row for m_maximumScrollOffset
-            m_maximumScrollOffset = m_itemInfos.last().rect.bottom();
-            const qreal rowY = m_itemInfos.last().rect.y();
-
-            int index = m_itemInfos.count() - 2;
-            while (index >= 0 && m_itemInfos[index].rect.bottom() >= rowY) {
-                m_maximumScrollOffset = qMax(m_maximumScrollOffset, m_itemInfos[index].rect.bottom());
-                --index;
+            const int lastRow = m_rowInfos.count() - 1;
+            qreal maxItemHeight = 0;
+            for (int index = m_rowInfos[lastRow].firstIndex; index < itemCount; ++index) {
+                maxItemHeight = qMax(maxItemHeight, m_itemInfos[index].height);
             }
-
-            m_maximumScrollOffset += itemMargin.height();
+            m_maximumScrollOffset = rowTop(lastRow) + maxItemHeight + itemMargin.height();
 
             m_maximumItemOffset = m_columnCount * m_columnWidth;
         } else {
@@ -515,9 +501,12 @@ void KItemListViewLayouter::doLayout()
         }
 
 #ifdef KITEMLISTVIEWLAYOUTER_DEBUG
-        kDebug() << "[TIME] doLayout() for " << m_model->count() << "items:" << timer.elapsed();
+        kDebug() << "[TIME] doLayout() for " << m_model->count() << "items, starting at" << firstIndex << ":" << timer.elapsed();
 #endif
         m_dirty = false;
+        m_firstDirtyIndex = -1;
+        m_firstSizeHintDirtyIndex = -1;
+        m_lastSizeHintDirtyIndex = -1;
     }
 
     updateVisibleIndexes();
@@ -538,35 +527,10 @@ void KItemListViewLayouter::updateVisibleIndexes()
         return;
     }
 
-    const int maxIndex = m_model->count() - 1;
-
-    // Calculate the first visible index that is fully visible
-    int min = 0;
-    int max = maxIndex;
-    int mid = 0;
-    do {
-        mid = (min + max) / 2;
-        if (m_itemInfos[mid].rect.top() < m_scrollOffset) {
-            min = mid + 1;
-        } else {
-            max = mid - 1;
-        }
-    } while (min <= max);
-
-    if (mid > 0) {
-        // Include the row before the first fully visible index, as it might
-        // be partly visible
-        if (m_itemInfos[mid].rect.top() >= m_scrollOffset) {
-            --mid;
-            Q_ASSERT(m_itemInfos[mid].rect.top() < m_scrollOffset);
-        }
-
-        const qreal rowTop = m_itemInfos[mid].rect.top();
-        while (mid > 0 && m_itemInfos[mid - 1].rect.top() == rowTop) {
-            --mid;
-        }
-    }
-    m_firstVisibleIndex = mid;
+    // The first visible row is the last row that starts above the scroll
+    // offset, as it might be partly visible
+    const int firstRow = rowAt(m_scrollOffset, false);
+    m_firstVisibleIndex = (firstRow > 0) ? m_rowInfos[firstRow].firstIndex : 0;
 
     // Calculate the last visible index that is (at least partly) visible
     const int visibleHeight = (m_scrollOrientation == Qt::Horizontal) ? m_size.width() : m_size.height();
@@ -575,21 +539,8 @@ void KItemListViewLayouter::updateVisibleIndexes()
         bottom += m_groupHeaderHeight;
     }
 
-    min = m_firstVisibleIndex;
-    max = maxIndex;
-    do {
-        mid = (min + max) / 2;
-        if (m_itemInfos[mid].rect.y() <= bottom) {
-            min = mid + 1;
-        } else {
-            max = mid - 1;
-        }
-    } while (min <= max);
-
-    while (mid > 0 && m_itemInfos[mid].rect.y() > bottom) {
-        --mid;
-    }
-    m_lastVisibleIndex = mid;
+    const int lastRow = rowAt(bottom, true);
+    m_lastVisibleIndex = (lastRow >= 0) ? rowEndIndex(lastRow) - 1 : 0;
 
     m_visibleIndexesDirty = false;
 }
@@ -620,4 +571,190 @@ qreal KItemListViewLayouter::minimumGroupHeaderWidth() const
     return 100;
 }
 
+void KItemListViewLayouter::layoutItems(int index)
+{
+    const int itemCount = m_model->count();
+    index = qMin(index, qMin(itemCount, m_itemInfos.count()));
+    if (index >= itemCount && itemCount == m_itemInfos.count()) {
+        // No item has been changed
+        return;
+    }
+
+    // Continue with the row of the item before the first changed item,
+    // as the changed items might be part of this row.
+    int row = 0;
+    if (index > 0) {
+        row = m_itemInfos[index - 1].row;
+        index = m_rowInfos[row].firstIndex;
+    }
+
+    m_itemInfos.resize(itemCount);
+    m_rowInfos.resize(row);
+    m_rowOffsets.truncate(row);
+
+    const bool horizontalScrolling = (m_scrollOrientation == Qt::Horizontal);
+    const qreal itemMarginHeight = m_logicalItemMargin.height();
+
+    qreal y = rowTop(row);
+    while (index < itemCount) {
+        const qreal rowY = y;
+        const int firstIndex = index;
+        qreal maxItemHeight = m_logicalItemSize.height();
+
+        if (m_grouped && m_groupItemIndexes.contains(index)) {
+            // The item is the first item of a group.
+            // Increase the y-position to provide space
+            // for the group header.
+            if (index > 0) {
+                // Only add a margin if there has been added another
+                // group already before
+                y += m_groupHeaderMargin;
+            } else if (!horizontalScrolling) {
+                // The first group header should be aligned on top
+                y -= itemMarginHeight;
+            }
+
+            if (!horizontalScrolling) {
+                y += m_groupHeaderHeight;
+            }
+        }
+
+        int column = 0;
+        while (index < itemCount && column < m_columnCount) {
+            ItemInfo& itemInfo = m_itemInfos[index];
+            itemInfo.height = requiredItemHeight(index);
+            itemInfo.column = column;
+            itemInfo.row = row;
+
+            maxItemHeight = qMax(maxItemHeight, requiredRowHeight(index));
+            ++index;
+            ++column;
+
+            if (m_grouped && m_groupItemIndexes.contains(index)) {
+                // The item represents the first index of a group
+                // and must aligned in the first column
+                break;
+            }
+        }
+
+        RowInfo rowInfo;
+        rowInfo.firstIndex = firstIndex;
+        rowInfo.headerOffset = y - rowY;
+        rowInfo.height = maxItemHeight;
+        m_rowInfos.append(rowInfo);
+        m_rowOffsets.append(rowInfo.headerOffset + rowInfo.height + itemMarginHeight);
+
+        y += maxItemHeight + itemMarginHeight;
+        ++row;
+    }
+}
+
+void KItemListViewLayouter::updateRowHeights(int firstIndex, int lastIndex)
+{
+    lastIndex = qMin(lastIndex, m_itemInfos.count() - 1);
+    if (firstIndex > lastIndex) {
+        return;
+    }
+
+    const int firstRow = m_itemInfos[firstIndex].row;
+    const int lastRow = m_itemInfos[lastIndex].row;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        RowInfo& rowInfo = m_rowInfos[row];
+
+        qreal maxItemHeight = m_logicalItemSize.height();
+        const int endIndex = rowEndIndex(row);
+        for (int index = rowInfo.firstIndex; index < endIndex; ++index) {
+            m_itemInfos[index].height = requiredItemHeight(index);
+            maxItemHeight = qMax(maxItemHeight, requiredRowHeight(index));
+        }
+
+        if (maxItemHeight != rowInfo.height) {
+            rowInfo.height = maxItemHeight;
+            m_rowOffsets.setValue(row, rowInfo.headerOffset + rowInfo.height + m_logicalItemMargin.height());
+        }
+    }
+}
+
+qreal KItemListViewLayouter::requiredItemHeight(int index) const
+{
+    qreal requiredHeight = m_logicalItemSize.height();
+    if (m_sizeHintResolver) {
+        const QSizeF sizeHint = m_sizeHintResolver->sizeHint(index);
+        const qreal sizeHintHeight = (m_scrollOrientation == Qt::Horizontal) ? sizeHint.width() : sizeHint.height();
+        if (sizeHintHeight > requiredHeight) {
+            requiredHeight = sizeHintHeight;
+        }
+    }
+    return requiredHeight;
+}
+
+qreal KItemListViewLayouter::requiredRowHeight(int index) const
+{
+    const qreal requiredHeight = m_itemInfos[index].height;
+    if (m_grouped && m_scrollOrientation == Qt::Horizontal) {
+        // When grouping is enabled in the horizontal mode, the header alignment
+        // looks like this:
+        //   Header-1 Header-2 Header-3
+        //   Item 1   Item 4   Item 7
+        //   Item 2   Item 5   Item 8
+        //   Item 3   Item 6   Item 9
+        // In this case 'requiredHeight' represents the column-width. We don't
+        // check the content of the header in the layouter to determine the required
+        // width, hence assure that at least a minimal width of 15 characters is given
+        // (in average a character requires the halve width of the font height).
+        //
+        // TODO: Let the group headers provide a minimum width and respect this width here
+        return qMax(requiredHeight, minimumGroupHeaderWidth());
+    }
+    return requiredHeight;
+}
+
+qreal KItemListViewLayouter::rowTop(int row) const
+{
+    const qreal y = m_headerHeight + m_logicalItemMargin.height() + m_rowOffsets.prefixSum(row);
+    return (row < m_rowInfos.count()) ? y + m_rowInfos[row].headerOffset : y;
+}
+
+int KItemListViewLayouter::rowAt(qreal y, bool inclusive) const
+{
+    const qreal offset = y - m_headerHeight - m_logicalItemMargin.height();
+    int row = inclusive ? m_rowOffsets.lastIndexAtOrBefore(offset)
+                        : m_rowOffsets.lastIndexBefore(offset);
+
+    // The top of the row is below the prefix sum by the space for the
+    // group header, so the previous row might be the correct one. Only the
+    // first row might start above the prefix sum (see layoutItems()).
+    if (row > 0) {
+        const qreal top = rowTop(row);
+        if (inclusive ? (top > y) : (top >= y)) {
+            --row;
+        }
+    } else if (row < 0 && !m_rowInfos.isEmpty()) {
+        const qreal top = rowTop(0);
+        if (inclusive ? (top <= y) : (top < y)) {
+            row = 0;
+        }
+    }
+    return row;
+}
+
+int KItemListViewLayouter::rowEndIndex(int row) const
+{
+    return (row + 1 < m_rowInfos.count()) ? m_rowInfos[row + 1].firstIndex : m_itemInfos.count();
+}
+
+QRectF KItemListViewLayouter::logicalItemRect(int index) const
+{
+    const ItemInfo& itemInfo = m_itemInfos[index];
+
+    qreal x = m_xPosInc + itemInfo.column * m_columnWidth;
+    if (m_grouped && m_scrollOrientation == Qt::Horizontal) {
+        // All group headers will always be aligned on the top and not
+        // flipped like the other properties
+        x += m_groupHeaderHeight;
+    }
+
+    return QRectF(x, rowTop(itemInfo.row), m_logicalItemSize.width(), itemInfo.height);
+}
+
 #include "kitemlistviewlayouter.moc"
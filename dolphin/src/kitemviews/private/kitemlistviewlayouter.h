@@ -22,6 +22,8 @@
 
 #include <libdolphin_export.h>
 
+#include "kitemlistoffsetindex.h"
+
 #include <QObject>
 #include <QRectF>
 #include <QSet>
@@ -44,6 +46,11 @@ class KItemListSizeHintResolver;
  * marking the layouter as dirty (see markAsDirty()). This means that
  * changing properties of the layouter is not expensive, only the
  * first read of a property can get expensive.
+ *
+ * The heights of the rows are stored in a KItemListOffsetIndex. Finding
+ * the visible items and the item at a position are O(log n) operations,
+ * and changes of the items only require to layout the affected rows
+ * again (see markAsDirtyFrom() and markSizeHintsAsDirty()).
  */
 class LIBDOLPHINPRIVATE_EXPORT KItemListViewLayouter : public QObject
 {
@@ -126,6 +133,12 @@ public:
      */
     QRectF itemRect(int index) const;
 
+    /**
+     * @return Index of the item whose rectangle (see itemRect()) contains
+     *         the position \a pos, or -1 if there is no such item.
+     */
+    int itemAt(const QPointF& pos) const;
+
     /**
      * @return Rectangle of the group header for the item with the
      *         index \a index. Note that the layouter does not check
@@ -165,6 +178,20 @@ public:
      */
     void markAsDirty();
 
+    /**
+     * Marks the layout of the items starting at the index \a index as dirty,
+     * e.g., because items have been inserted, removed or moved. The rows
+     * before the row of the item \a index - 1 are kept.
+     */
+    void markAsDirtyFrom(int index);
+
+    /**
+     * Marks the size hints of the \a count items starting at the index
+     * \a index as dirty. Only the heights of the rows that contain the
+     * items are updated.
+     */
+    void markSizeHintsAsDirty(int index, int count);
+
     inline int columnCount() const
     {
         return m_columnCount;
@@ -184,6 +211,48 @@ private:
     void updateVisibleIndexes();
     bool createGroupHeaders();
 
+    /**
+     * Lays out the items starting at the index \a index. The rows before
+     * the row of the item \a index - 1 are kept.
+     */
+    void layoutItems(int index);
+
+    /**
+     * Updates the heights of the rows that contain the items
+     * \a firstIndex to \a lastIndex.
+     */
+    void updateRowHeights(int firstIndex, int lastIndex);
+
+    /**
+     * @return Height of the rectangle of the item \a index in the
+     *         logical (vertical) layout.
+     */
+    qreal requiredItemHeight(int index) const;
+
+    /**
+     * @return Height that the item \a index requires in its row. In contrast
+     *         to requiredItemHeight(), the width of the group headers is
+     *         respected in the horizontal alignment mode.
+     */
+    qreal requiredRowHeight(int index) const;
+
+    /**
+     * @return Top of the row \a row in the logical (vertical) layout.
+     */
+    qreal rowTop(int row) const;
+
+    /**
+     * @return Row in the logical (vertical) layout that contains the
+     *         position \a y, i.e., the last row with a top that is
+     *         smaller than (or equal to, if \a inclusive is true) \a y.
+     *         If there is no such row, -1 is returned.
+     */
+    int rowAt(qreal y, bool inclusive) const;
+
+    int rowEndIndex(int row) const;
+
+    QRectF logicalItemRect(int index) const;
+
     /**
      * @return Minimum width of group headers when grouping is enabled in the horizontal
      *         alignment mode. The header alignment is done like this:
@@ -198,6 +267,13 @@ private:
     bool m_dirty;
     bool m_visibleIndexesDirty;
 
+    // Indexes of the items that must be laid out again if m_dirty is false,
+    // see markAsDirtyFrom() and markSizeHintsAsDirty(). -1 means that
+    // no such items exist.
+    int m_firstDirtyIndex;
+    int m_firstSizeHintDirtyIndex;
+    int m_lastSizeHintDirtyIndex;
+
     Qt::Orientation m_scrollOrientation;
     QSizeF m_size;
 
@@ -220,6 +296,11 @@ private:
     qreal m_xPosInc;
     int m_columnCount;
 
+    // Item size and margin of the logical (vertical) layout
+    QSizeF m_logicalItemSize;
+    QSizeF m_logicalItemMargin;
+    bool m_grouped;
+
     // Stores all item indexes that are the first item of a group.
     // Assures fast access for KItemListViewLayouter::isFirstGroupItem().
     QSet<int> m_groupItemIndexes;
@@ -227,12 +308,22 @@ private:
     qreal m_groupHeaderMargin;
 
     struct ItemInfo {
-        QRectF rect;
+        qreal height;
         int column;
         int row;
     };
     QVector<ItemInfo> m_itemInfos;
 
+    struct RowInfo {
+        int firstIndex;
+        qreal headerOffset; // Space for the group header above the row
+        qreal height;
+    };
+    QVector<RowInfo> m_rowInfos;
+
+    // Stores headerOffset + height + margin for each row
+    KItemListOffsetIndex m_rowOffsets;
+
     friend class KItemListControllerTest;
 };
 
@@ -0,0 +1,197 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kitemstatearray.h"
+
+#include <cstring>
+
+KItemStateArray::KItemStateArray() :
+    m_states()
+{
+    std::memset(m_flagCounts, 0, sizeof(m_flagCounts));
+}
+
+void KItemStateArray::clear()
+{
+    m_states.clear();
+    std::memset(m_flagCounts, 0, sizeof(m_flagCounts));
+}
+
+void KItemStateArray::resize(int count)
+{
+    for (int i = count; i < m_states.count(); ++i) {
+        addToCounts(m_states.at(i), -1);
+    }
+
+    const int oldCount = m_states.count();
+    m_states.resize(count);
+    for (int i = oldCount; i < count; ++i) {
+        m_states[i] = 0;
+    }
+}
+
+void KItemStateArray::setFlag(int index, quint8 flag, bool enabled)
+{
+    if (index < 0 || index >= m_states.count()) {
+        return;
+    }
+
+    quint8& state = m_states[index];
+    if (bool(state & flag) != enabled) {
+        state ^= flag;
+        m_flagCounts[bitPosition(flag)] += enabled ? 1 : -1;
+    }
+}
+
+void KItemStateArray::clearFlag(quint8 flag)
+{
+    const int position = bitPosition(flag);
+    if (m_flagCounts[position] == 0) {
+        return;
+    }
+
+    const quint8 mask = ~flag;
+    quint8* states = m_states.data();
+    const int count = m_states.count();
+    for (int i = 0; i < count; ++i) {
+        states[i] &= mask;
+    }
+    m_flagCounts[position] = 0;
+}
+
+int KItemStateArray::flagCount(quint8 flag) const
+{
+    return m_flagCounts[bitPosition(flag)];
+}
+
+int KItemStateArray::nextIndex(quint8 flag, int from) const
+{
+    if (m_flagCounts[bitPosition(flag)] == 0) {
+        return -1;
+    }
+
+    const quint8* states = m_states.constData();
+    const int count = m_states.count();
+    for (int i = qMax(0, from); i < count; ++i) {
+        if (states[i] & flag) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QList<int> KItemStateArray::indexes(quint8 flag) const
+{
+    QList<int> result;
+    result.reserve(flagCount(flag));
+    for (int index = nextIndex(flag); index >= 0; index = nextIndex(flag, index + 1)) {
+        result.append(index);
+    }
+    return result;
+}
+
+void KItemStateArray::insertItems(const KItemRangeList& itemRanges)
+{
+    int insertedCount = 0;
+    foreach (const KItemRange& range, itemRanges) {
+        insertedCount += range.count;
+    }
+    if (insertedCount == 0) {
+        return;
+    }
+
+    const int oldCount = m_states.count();
+    const int newCount = oldCount + insertedCount;
+    m_states.resize(newCount);
+    quint8* states = m_states.data();
+
+    // Move the existing states backwards, starting with the last range, such
+    // that each state is moved only once.
+    int target = newCount;
+    int source = oldCount;
+    for (int i = itemRanges.count() - 1; i >= 0; --i) {
+        const KItemRange& range = itemRanges.at(i);
+        const int movedCount = source - range.index;
+        target -= movedCount;
+        source -= movedCount;
+        std::memmove(states + target, states + source, movedCount);
+
+        target -= range.count;
+        std::memset(states + target, 0, range.count);
+    }
+}
+
+void KItemStateArray::removeItems(const KItemRangeList& itemRanges)
+{
+    if (itemRanges.isEmpty()) {
+        return;
+    }
+
+    quint8* states = m_states.data();
+    const int oldCount = m_states.count();
+
+    int target = itemRanges.first().index;
+    for (int i = 0; i < itemRanges.count(); ++i) {
+        const KItemRange& range = itemRanges.at(i);
+        for (int index = range.index; index < range.index + range.count; ++index) {
+            addToCounts(states[index], -1);
+        }
+
+        const int source = range.index + range.count;
+        const int nextRangeIndex = (i + 1 < itemRanges.count()) ? itemRanges.at(i + 1).index : oldCount;
+        const int movedCount = nextRangeIndex - source;
+        std::memmove(states + target, states + source, movedCount);
+        target += movedCount;
+    }
+
+    m_states.resize(target);
+}
+
+void KItemStateArray::moveItems(const KItemRange& itemRange, const QList<int>& movedToIndexes)
+{
+    if (itemRange.count <= 0) {
+        return;
+    }
+
+    const QVector<quint8> oldStates = m_states.mid(itemRange.index, itemRange.count);
+    quint8* states = m_states.data();
+    for (int i = 0; i < itemRange.count; ++i) {
+        states[movedToIndexes.at(i)] = oldStates.at(i);
+    }
+}
+
+int KItemStateArray::bitPosition(quint8 flag)
+{
+    Q_ASSERT(flag != 0 && (flag & (flag - 1)) == 0);
+    int position = 0;
+    while (!(flag & 1)) {
+        flag >>= 1;
+        ++position;
+    }
+    return position;
+}
+
+void KItemStateArray::addToCounts(quint8 state, int difference)
+{
+    for (int position = 0; state != 0; ++position, state >>= 1) {
+        if (state & 1) {
+            m_flagCounts[position] += difference;
+        }
+    }
+}
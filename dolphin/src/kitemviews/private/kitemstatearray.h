@@ -0,0 +1,124 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KITEMSTATEARRAY_H
+#define KITEMSTATEARRAY_H
+
+#include <libdolphin_export.h>
+
+#include <kitemviews/kitemrange.h>
+
+#include <QList>
+#include <QVector>
+
+/**
+ * @brief Stores up to 8 boolean flags for each item of a model.
+ *
+ * The flags are stored in one byte per item, and the array is kept in sync
+ * with the model by passing the ranges of the signals itemsInserted(),
+ * itemsRemoved() and itemsMoved() to insertItems(), removeItems() and
+ * moveItems(). Checking a flag only requires an array access, and the number
+ * of items that have a certain flag is always available.
+ *
+ * Accessing an index outside the array is allowed: no flags are set
+ * for such indexes.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KItemStateArray
+{
+
+public:
+    KItemStateArray();
+
+    /**
+     * Removes all items.
+     */
+    void clear();
+
+    /**
+     * Adds or removes items at the end such that the array contains \a count
+     * items. Added items have no flags.
+     */
+    void resize(int count);
+    int count() const;
+
+    /**
+     * @param flag Must contain exactly one bit.
+     */
+    bool testFlag(int index, quint8 flag) const;
+    void setFlag(int index, quint8 flag, bool enabled = true);
+
+    /**
+     * Clears \a flag for all items.
+     */
+    void clearFlag(quint8 flag);
+
+    /**
+     * @return Number of items that have \a flag set.
+     */
+    int flagCount(quint8 flag) const;
+
+    /**
+     * @return First index that is equal to or larger than \a from and
+     *         has \a flag set. -1 is returned if there is no such index.
+     */
+    int nextIndex(quint8 flag, int from = 0) const;
+
+    /**
+     * @return Indexes of all items that have \a flag set.
+     */
+    QList<int> indexes(quint8 flag) const;
+
+    /**
+     * Inserts items without flags. Like in KItemModelBase::itemsInserted(),
+     * the indexes of \a itemRanges refer to the array before the insertion.
+     */
+    void insertItems(const KItemRangeList& itemRanges);
+
+    /**
+     * Removes the items \a itemRanges, see KItemModelBase::itemsRemoved().
+     */
+    void removeItems(const KItemRangeList& itemRanges);
+
+    /**
+     * Moves the items in \a itemRange to the indexes \a movedToIndexes,
+     * see KItemModelBase::itemsMoved().
+     */
+    void moveItems(const KItemRange& itemRange, const QList<int>& movedToIndexes);
+
+private:
+    static int bitPosition(quint8 flag);
+
+    void addToCounts(quint8 state, int difference);
+
+private:
+    QVector<quint8> m_states;
+    int m_flagCounts[8];
+};
+
+inline bool KItemStateArray::testFlag(int index, quint8 flag) const
+{
+    return index >= 0 && index < m_states.count() && (m_states.at(index) & flag);
+}
+
+inline int KItemStateArray::count() const
+{
+    return m_states.count();
+}
+
+#endif
@@ -40,6 +40,7 @@
 #include <QSize>
 
 #include <KDebug>
+#include <KGlobal>
 
 #include <config-X11.h> // for HAVE_XRENDER
 #if defined(Q_WS_X11) && defined(HAVE_XRENDER)
@@ -288,43 +289,53 @@ namespace {
 
             shadowBlur(image, 3, Qt::black);
 
-            QPixmap pixmap = QPixmap::fromImage(image);
-            m_tiles[TopLeftCorner]     = pixmap.copy(0, 0, 8, 8);
-            m_tiles[TopSide]           = pixmap.copy(8, 0, 8, 8);
-            m_tiles[TopRightCorner]    = pixmap.copy(16, 0, 8, 8);
-            m_tiles[LeftSide]          = pixmap.copy(0, 8, 8, 8);
-            m_tiles[RightSide]         = pixmap.copy(16, 8, 8, 8);
-            m_tiles[BottomLeftCorner]  = pixmap.copy(0, 16, 8, 8);
-            m_tiles[BottomSide]        = pixmap.copy(8, 16, 8, 8);
-            m_tiles[BottomRightCorner] = pixmap.copy(16, 16, 8, 8);
+            // The tiles are kept as images, so that frames can
+            // also be painted outside the GUI thread.
+            m_tiles[TopLeftCorner]     = image.copy(0, 0, 8, 8);
+            m_tiles[TopSide]           = image.copy(8, 0, 8, 8);
+            m_tiles[TopRightCorner]    = image.copy(16, 0, 8, 8);
+            m_tiles[LeftSide]          = image.copy(0, 8, 8, 8);
+            m_tiles[RightSide]         = image.copy(16, 8, 8, 8);
+            m_tiles[BottomLeftCorner]  = image.copy(0, 16, 8, 8);
+            m_tiles[BottomSide]        = image.copy(8, 16, 8, 8);
+            m_tiles[BottomRightCorner] = image.copy(16, 16, 8, 8);
         }
 
         void paint(QPainter* p, const QRect& r)
         {
-            p->drawPixmap(r.topLeft(), m_tiles[TopLeftCorner]);
+            p->drawImage(r.topLeft(), m_tiles[TopLeftCorner]);
             if (r.width() - 16 > 0) {
-                p->drawTiledPixmap(r.x() + 8, r.y(), r.width() - 16, 8, m_tiles[TopSide]);
+                drawTiled(p, QRect(r.x() + 8, r.y(), r.width() - 16, 8), m_tiles[TopSide]);
             }
-            p->drawPixmap(r.right() - 8 + 1, r.y(), m_tiles[TopRightCorner]);
+            p->drawImage(r.right() - 8 + 1, r.y(), m_tiles[TopRightCorner]);
             if (r.height() - 16 > 0) {
-                p->drawTiledPixmap(r.x(), r.y() + 8, 8, r.height() - 16,  m_tiles[LeftSide]);
-                p->drawTiledPixmap(r.right() - 8 + 1, r.y() + 8, 8, r.height() - 16, m_tiles[RightSide]);
+                drawTiled(p, QRect(r.x(), r.y() + 8, 8, r.height() - 16), m_tiles[LeftSide]);
+                drawTiled(p, QRect(r.right() - 8 + 1, r.y() + 8, 8, r.height() - 16), m_tiles[RightSide]);
             }
-            p->drawPixmap(r.x(), r.bottom() - 8 + 1, m_tiles[BottomLeftCorner]);
+            p->drawImage(r.x(), r.bottom() - 8 + 1, m_tiles[BottomLeftCorner]);
             if (r.width() - 16 > 0) {
-                p->drawTiledPixmap(r.x() + 8, r.bottom() - 8 + 1, r.width() - 16, 8, m_tiles[BottomSide]);
+                drawTiled(p, QRect(r.x() + 8, r.bottom() - 8 + 1, r.width() - 16, 8), m_tiles[BottomSide]);
             }
-            p->drawPixmap(r.right() - 8 + 1, r.bottom() - 8 + 1, m_tiles[BottomRightCorner]);
+            p->drawImage(r.right() - 8 + 1, r.bottom() - 8 + 1, m_tiles[BottomRightCorner]);
 
             const QRect contentRect = r.adjusted(LeftMargin + 1, TopMargin + 1,
                                                  -(RightMargin + 1), -(BottomMargin + 1));
             p->fillRect(contentRect, Qt::transparent);
         }
 
-        QPixmap m_tiles[NumTiles];
+        QImage m_tiles[NumTiles];
+
+    private:
+        static void drawTiled(QPainter* p, const QRect& rect, const QImage& tile)
+        {
+            p->setBrushOrigin(rect.topLeft());
+            p->fillRect(rect, QBrush(tile));
+        }
     };
 }
 
+K_GLOBAL_STATIC(TileSet, s_tileSet)
+
 void KPixmapModifier::scale(QPixmap& pixmap, const QSize& scaledSize)
 {
     if (scaledSize.isEmpty()) {
@@ -371,30 +382,78 @@ void KPixmapModifier::scale(QPixmap& pixmap, const QSize& scaledSize)
 
 void KPixmapModifier::applyFrame(QPixmap& icon, const QSize& scaledSize)
 {
-    static TileSet tileSet;
+    QImage image = icon.toImage();
+    applyFrame(image, scaledSize);
+    icon = QPixmap::fromImage(image);
+}
 
+QSize KPixmapModifier::sizeInsideFrame(const QSize& frameSize)
+{
+    return QSize(frameSize.width() - TileSet::LeftMargin - TileSet::RightMargin,
+                 frameSize.height() - TileSet::TopMargin - TileSet::BottomMargin);
+}
+
+
+void KPixmapModifier::scale(QImage& image, const QSize& scaledSize)
+{
+    if (scaledSize.isEmpty()) {
+        image = QImage();
+        return;
+    }
+
+    image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied)
+                 .scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+void KPixmapModifier::applyFrame(QImage& icon, const QSize& scaledSize)
+{
     // Resize the icon to the maximum size minus the space required for the frame
     const QSize size(scaledSize.width() - TileSet::LeftMargin - TileSet::RightMargin,
                      scaledSize.height() - TileSet::TopMargin - TileSet::BottomMargin);
     scale(icon, size);
 
-    QPixmap framedIcon(icon.size().width() + TileSet::LeftMargin + TileSet::RightMargin,
-                       icon.size().height() + TileSet::TopMargin + TileSet::BottomMargin);
-    framedIcon.fill(Qt::transparent);
+    QImage framedIcon(icon.width() + TileSet::LeftMargin + TileSet::RightMargin,
+                      icon.height() + TileSet::TopMargin + TileSet::BottomMargin,
+                      QImage::Format_ARGB32_Premultiplied);
+    framedIcon.fill(0);
 
     QPainter painter;
     painter.begin(&framedIcon);
     painter.setCompositionMode(QPainter::CompositionMode_Source);
-    tileSet.paint(&painter, framedIcon.rect());
+    s_tileSet->paint(&painter, framedIcon.rect());
     painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    painter.drawPixmap(TileSet::LeftMargin, TileSet::TopMargin, icon);
+    painter.drawImage(TileSet::LeftMargin, TileSet::TopMargin, icon);
+    painter.end();
 
     icon = framedIcon;
 }
 
-QSize KPixmapModifier::sizeInsideFrame(const QSize& frameSize)
+QImage KPixmapModifier::blend(const QImage& image1, const QImage& image2, qreal factor)
 {
-    return QSize(frameSize.width() - TileSet::LeftMargin - TileSet::RightMargin,
-                 frameSize.height() - TileSet::TopMargin - TileSet::BottomMargin);
-}
+    if (image1.size() != image2.size()) {
+        return (factor < 0.5) ? image1 : image2;
+    }
 
+    QImage result = image1.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage image = image2.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    const quint32 factor2 = qBound(0, qRound(factor * 256), 256);
+    const quint32 factor1 = 256 - factor2;
+
+    // Interpolating the premultiplied channels results in a valid premultiplied
+    // pixel. Two channels are interpolated at once with one multiplication each.
+    const int width = result.width();
+    for (int y = 0; y < result.height(); ++y) {
+        quint32* pixels1 = reinterpret_cast<quint32*>(result.scanLine(y));
+        const quint32* pixels2 = reinterpret_cast<const quint32*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x) {
+            const quint32 pixel1 = pixels1[x];
+            const quint32 pixel2 = pixels2[x];
+            const quint32 redBlue = (((pixel1 & 0x00ff00ff) * factor1 + (pixel2 & 0x00ff00ff) * factor2) >> 8) & 0x00ff00ff;
+            const quint32 alphaGreen = (((pixel1 >> 8) & 0x00ff00ff) * factor1 + ((pixel2 >> 8) & 0x00ff00ff) * factor2) & 0xff00ff00;
+            pixels1[x] = redBlue | alphaGreen;
+        }
+    }
+
+    return result;
+}
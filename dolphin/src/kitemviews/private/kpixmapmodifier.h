@@ -22,6 +22,9 @@
 
 #include <libdolphin_export.h>
 
+#include <QtGlobal>
+
+class QImage;
 class QPixmap;
 class QSize;
 
@@ -31,6 +34,20 @@ public:
     static void scale(QPixmap& pixmap, const QSize& scaledSize);
     static void applyFrame(QPixmap& icon, const QSize& scaledSize);
     static QSize sizeInsideFrame(const QSize& frameSize);
+
+    /**
+     * The QImage variants return images in the format QImage::Format_ARGB32_Premultiplied.
+     * Contrary to the QPixmap variants, they may be used outside the GUI thread.
+     */
+    static void scale(QImage& image, const QSize& scaledSize);
+    static void applyFrame(QImage& icon, const QSize& scaledSize);
+
+    /**
+     * @return Linear interpolation image1 * (1 - factor) + image2 * factor.
+     *         Both images must have the same size, otherwise the image that
+     *         is closer to the result is returned.
+     */
+    static QImage blend(const QImage& image1, const QImage& image2, qreal factor);
 };
 
 #endif
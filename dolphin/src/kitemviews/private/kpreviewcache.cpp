@@ -0,0 +1,158 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kpreviewcache.h"
+
+#include "kpixmapmodifier.h"
+
+#include <KFileItem>
+#include <KGlobal>
+#include <kio/udsentry.h>
+
+#include <QSize>
+
+namespace {
+    // Smallest and largest bucket of previews that is used for downscaling
+    const int MinimumBucket = 128;
+    const int MaximumBucket = 1024;
+}
+
+class KPreviewCacheSingleton
+{
+public:
+    KPreviewCache instance;
+};
+K_GLOBAL_STATIC(KPreviewCacheSingleton, s_previewCache)
+
+
+uint qHash(const KPreviewCache::Key& key)
+{
+    return qHash(key.url) ^ qHash(key.modificationTime) ^ key.bucket;
+}
+
+KPreviewCache::KPreviewCache(int maximumSize) :
+    m_cache(maximumSize),
+    m_hitCount(0),
+    m_scaledHitCount(0),
+    m_missCount(0)
+{
+}
+
+KPreviewCache::~KPreviewCache()
+{
+}
+
+KPreviewCache* KPreviewCache::instance()
+{
+    return &s_previewCache->instance;
+}
+
+bool KPreviewCache::find(const KFileItem& item, const QSize& size, QPixmap& pixmap)
+{
+    const int bucket = bucketForSize(size);
+    const Key key = keyForItem(item, bucket);
+
+    const QPixmap* cachedPixmap = m_cache.object(key);
+    if (cachedPixmap) {
+        pixmap = *cachedPixmap;
+        scaleToSize(pixmap, size);
+        ++m_hitCount;
+        return true;
+    }
+
+    // Downscaling a larger preview is much cheaper than generating a new one.
+    Key largerKey = key;
+    for (largerKey.bucket = bucket * 2; largerKey.bucket <= MaximumBucket; largerKey.bucket *= 2) {
+        cachedPixmap = m_cache.object(largerKey);
+        if (cachedPixmap) {
+            pixmap = *cachedPixmap;
+            scaleToSize(pixmap, QSize(bucket, bucket));
+            insertPixmap(key, pixmap);
+            scaleToSize(pixmap, size);
+
+            ++m_hitCount;
+            ++m_scaledHitCount;
+            return true;
+        }
+    }
+
+    ++m_missCount;
+    return false;
+}
+
+void KPreviewCache::insert(const KFileItem& item, const QSize& size, const QPixmap& pixmap)
+{
+    if (pixmap.isNull()) {
+        return;
+    }
+
+    insertPixmap(keyForItem(item, bucketForSize(size)), pixmap);
+}
+
+void KPreviewCache::clear()
+{
+    m_cache.clear();
+}
+
+void KPreviewCache::setMaximumSize(int maximumSize)
+{
+    m_cache.setMaxCost(maximumSize);
+}
+
+int KPreviewCache::maximumSize() const
+{
+    return m_cache.maxCost();
+}
+
+int KPreviewCache::size() const
+{
+    return m_cache.totalCost();
+}
+
+int KPreviewCache::bucketForSize(const QSize& size)
+{
+    const int requestedSize = qMax(size.width(), size.height());
+    int bucket = MinimumBucket;
+    while (bucket < requestedSize) {
+        bucket *= 2;
+    }
+    return bucket;
+}
+
+void KPreviewCache::scaleToSize(QPixmap& pixmap, const QSize& size)
+{
+    if (pixmap.width() > size.width() || pixmap.height() > size.height()) {
+        KPixmapModifier::scale(pixmap, size);
+    }
+}
+
+KPreviewCache::Key KPreviewCache::keyForItem(const KFileItem& item, int bucket)
+{
+    Key key;
+    key.url = item.url().url();
+    key.modificationTime = item.entry().numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME, -1);
+    key.bucket = bucket;
+    return key;
+}
+
+void KPreviewCache::insertPixmap(const Key& key, const QPixmap& pixmap)
+{
+    const int cost = pixmap.width() * pixmap.height() * 4;
+    m_cache.insert(key, new QPixmap(pixmap), cost);
+}
@@ -0,0 +1,164 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KPREVIEWCACHE_H
+#define KPREVIEWCACHE_H
+
+#include <libdolphin_export.h>
+
+#include <QCache>
+#include <QPixmap>
+#include <QString>
+
+class KFileItem;
+class QSize;
+
+/**
+ * @brief Process-wide memory cache for the previews of files.
+ *
+ * The previews are requested by KFileItemModelRolesUpdater for each view,
+ * by the tooltips and by the Information Panel. All of them share this
+ * cache, so a preview that has been generated for one of them can be
+ * reused by the others, e.g. if a directory is opened in a split view or
+ * in another tab, or if the zoom level is changed.
+ *
+ * The previews are cached with the URL, the modification time and a size
+ * bucket as key. The size bucket is the smallest power of two that is
+ * equal to or larger than the requested size (at least 128), so previews
+ * for similar sizes share one entry. If no preview is cached for the
+ * bucket of the requested size, a preview of a larger bucket is
+ * downscaled. The returned previews are downscaled to the requested size.
+ *
+ * The memory that is used by the cached pixmaps is limited by
+ * maximumSize(). The least recently used previews are removed first.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KPreviewCache
+{
+
+public:
+    /**
+     * @param maximumSize Maximum memory in bytes that may be used by the pixmaps.
+     */
+    explicit KPreviewCache(int maximumSize = 64 * 1024 * 1024);
+    ~KPreviewCache();
+
+    /**
+     * @return Cache that is shared by all views and panels.
+     */
+    static KPreviewCache* instance();
+
+    /**
+     * Sets \a pixmap to the cached preview of \a item that fits into \a size.
+     * @return True if a preview is available.
+     */
+    bool find(const KFileItem& item, const QSize& size, QPixmap& pixmap);
+
+    /**
+     * Inserts the preview \a pixmap that has been generated
+     * for \a item with the requested size \a size.
+     */
+    void insert(const KFileItem& item, const QSize& size, const QPixmap& pixmap);
+
+    /**
+     * Removes all previews, e.g. because the enabled preview plugins have been changed.
+     */
+    void clear();
+
+    void setMaximumSize(int maximumSize);
+    int maximumSize() const;
+
+    /**
+     * @return Memory in bytes that is used by the cached pixmaps.
+     */
+    int size() const;
+
+    /**
+     * @return Number of calls of find() that have returned a preview,
+     *         including the previews that have been downscaled.
+     */
+    quint64 hitCount() const;
+
+    /**
+     * @return Number of calls of find() that have returned a
+     *         preview by downscaling a preview of a larger bucket.
+     */
+    quint64 scaledHitCount() const;
+
+    /**
+     * @return Number of calls of find() that have not returned a preview.
+     */
+    quint64 missCount() const;
+
+private:
+    struct Key
+    {
+        QString url;
+        qint64 modificationTime;
+        int bucket;
+
+        bool operator==(const Key& other) const
+        {
+            return bucket == other.bucket && modificationTime == other.modificationTime && url == other.url;
+        }
+    };
+
+    friend uint qHash(const Key& key);
+
+    /**
+     * @return Size bucket for previews that must fit into \a size.
+     */
+    static int bucketForSize(const QSize& size);
+
+    static Key keyForItem(const KFileItem& item, int bucket);
+
+    /**
+     * Downscales \a pixmap if it does not fit into \a size.
+     */
+    static void scaleToSize(QPixmap& pixmap, const QSize& size);
+
+    /**
+     * Inserts \a pixmap with the key \a key. The cost of the
+     * entry is the size of the pixmap in bytes.
+     */
+    void insertPixmap(const Key& key, const QPixmap& pixmap);
+
+private:
+    QCache<Key, QPixmap> m_cache;
+
+    quint64 m_hitCount;
+    quint64 m_scaledHitCount;
+    quint64 m_missCount;
+};
+
+inline quint64 KPreviewCache::hitCount() const
+{
+    return m_hitCount;
+}
+
+inline quint64 KPreviewCache::scaledHitCount() const
+{
+    return m_scaledHitCount;
+}
+
+inline quint64 KPreviewCache::missCount() const
+{
+    return m_missCount;
+}
+
+#endif
@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "kpreviewcompositor.h"
+
+#include "kpixmapmodifier.h"
+
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+
+class KPreviewCompositorTask : public QRunnable
+{
+public:
+    KPreviewCompositorTask(KPreviewCompositor* compositor, const KPreviewCompositor::Request& request) :
+        QRunnable(),
+        m_compositor(compositor),
+        m_request(request)
+    {
+    }
+
+    virtual void run()
+    {
+        if (m_request.generation != m_compositor->m_generation) {
+            // The request has been discarded by KPreviewCompositor::clear()
+            return;
+        }
+
+        m_request.image = KPreviewCompositor::process(m_request.image, m_request.size, m_request.operation);
+        m_compositor->addResult(m_request);
+    }
+
+private:
+    KPreviewCompositor* m_compositor;
+    KPreviewCompositor::Request m_request;
+};
+
+KPreviewCompositor::KPreviewCompositor(QObject* parent) :
+    QObject(parent),
+    m_generation(0),
+    m_threadPool(),
+    m_lastRequestId(0),
+    m_latestRequestIds(),
+    m_resultsMutex(),
+    m_results()
+{
+}
+
+KPreviewCompositor::~KPreviewCompositor()
+{
+    clear();
+    m_threadPool.waitForDone();
+}
+
+void KPreviewCompositor::addRequest(const KFileItem& item, const QImage& image, const QSize& size, Operation operation)
+{
+    Request request;
+    request.item = item;
+    request.image = image;
+    request.size = size;
+    request.operation = operation;
+    request.generation = m_generation;
+    request.id = ++m_lastRequestId;
+    m_latestRequestIds.insert(item.url(), request.id);
+    m_threadPool.start(new KPreviewCompositorTask(this, request));
+}
+
+void KPreviewCompositor::clear()
+{
+    m_generation.ref();
+    m_latestRequestIds.clear();
+
+    QMutexLocker locker(&m_resultsMutex);
+    m_results.clear();
+}
+
+QImage KPreviewCompositor::process(const QImage& image, const QSize& size, Operation operation)
+{
+    QImage result = image;
+
+    switch (operation) {
+    case Scale:
+        KPixmapModifier::scale(result, size);
+        break;
+
+    case ApplyFrame:
+        KPixmapModifier::applyFrame(result, size);
+        break;
+
+    case ApplyFrameWithoutEnlarging: {
+        const QSize contentSize = KPixmapModifier::sizeInsideFrame(size);
+        const bool enlargingRequired = result.width()  < contentSize.width() &&
+                                       result.height() < contentSize.height();
+        if (enlargingRequired) {
+            // Show the image centered within a frame that has the size
+            // of an enlarged image.
+            QSize frameSize = result.size();
+            frameSize.scale(size, Qt::KeepAspectRatio);
+
+            QImage largeFrame(frameSize, QImage::Format_ARGB32_Premultiplied);
+            largeFrame.fill(0);
+            KPixmapModifier::applyFrame(largeFrame, frameSize);
+
+            QPainter painter(&largeFrame);
+            painter.drawImage((largeFrame.width()  - result.width()) / 2,
+                              (largeFrame.height() - result.height()) / 2,
+                              result);
+            painter.end();
+            result = largeFrame;
+        } else {
+            // The image must be shrinked as it is too large to fit into
+            // the available icon size
+            KPixmapModifier::applyFrame(result, size);
+        }
+        break;
+    }
+
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+
+    return result;
+}
+
+void KPreviewCompositor::slotResultsAvailable()
+{
+    QList<Request> results;
+    {
+        QMutexLocker locker(&m_resultsMutex);
+        results.swap(m_results);
+    }
+
+    foreach (const Request& result, results) {
+        if (result.generation != m_generation) {
+            continue;
+        }
+
+        // Results of outdated requests might be finished after the result
+        // of the latest request for the same item and must not replace it.
+        QHash<KUrl, int>::iterator it = m_latestRequestIds.find(result.item.url());
+        if (it == m_latestRequestIds.end() || it.value() != result.id) {
+            continue;
+        }
+        m_latestRequestIds.erase(it);
+
+        emit imageReady(result.item, result.image, result.size);
+    }
+}
+
+void KPreviewCompositor::addResult(const Request& result)
+{
+    bool notify;
+    {
+        QMutexLocker locker(&m_resultsMutex);
+        notify = m_results.isEmpty();
+        m_results.append(result);
+    }
+
+    if (notify) {
+        // Results that arrive before the slot is invoked are handled by
+        // the same invocation.
+        QMetaObject::invokeMethod(this, "slotResultsAvailable", Qt::QueuedConnection);
+    }
+}
+
+#include "kpreviewcompositor.moc"
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef KPREVIEWCOMPOSITOR_H
+#define KPREVIEWCOMPOSITOR_H
+
+#include <libdolphin_export.h>
+
+#include <KFileItem>
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <QThreadPool>
+
+class KPreviewCompositorTask;
+
+/**
+ * @brief Scales previews and applies frames in background threads.
+ *
+ * KFileItemModelRolesUpdater receives the previews as pixmaps from
+ * KIO::PreviewJob. Scaling them to the icon size and applying a frame
+ * requires several full-size paint operations per preview, which would
+ * block the GUI thread if many previews arrive at once.
+ *
+ * The previews are processed as premultiplied ARGB images by a thread pool.
+ * The signal imageReady() is emitted in the GUI thread with the final image,
+ * so the GUI thread only has to convert it to a pixmap.
+ *
+ * The requests are processed in parallel, so their results may be finished
+ * in a different order. If several requests have been added for the same
+ * item, only the result of the latest request is emitted.
+ */
+class LIBDOLPHINPRIVATE_EXPORT KPreviewCompositor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Operation {
+        /** Scales the image to fit into the requested size. */
+        Scale,
+        /** Scales the image and applies a frame, see KPixmapModifier::applyFrame(). */
+        ApplyFrame,
+        /**
+         * Like ApplyFrame, but images that are smaller than the requested
+         * size are not enlarged and shown centered within the frame instead.
+         */
+        ApplyFrameWithoutEnlarging
+    };
+
+    explicit KPreviewCompositor(QObject* parent = 0);
+    virtual ~KPreviewCompositor();
+
+    /**
+     * Processes \a image for \a item. The signal imageReady() is
+     * emitted as soon as the image has been processed, unless another
+     * request for the URL of \a item is added in the meantime.
+     */
+    void addRequest(const KFileItem& item, const QImage& image, const QSize& size, Operation operation);
+
+    /**
+     * Discards all requests that have not been finished yet.
+     * imageReady() is not emitted for them.
+     */
+    void clear();
+
+    /**
+     * Applies \a operation to \a image in the current thread.
+     */
+    static QImage process(const QImage& image, const QSize& size, Operation operation);
+
+signals:
+    /**
+     * Is emitted if the image \a image for \a item is ready. \a size
+     * is the size that has been passed to addRequest().
+     */
+    void imageReady(const KFileItem& item, const QImage& image, const QSize& size);
+
+private slots:
+    void slotResultsAvailable();
+
+private:
+    struct Request
+    {
+        KFileItem item;
+        QImage image;
+        QSize size;
+        Operation operation;
+        int generation;
+        int id;
+    };
+
+    friend class KPreviewCompositorTask;
+
+    /**
+     * Is invoked by KPreviewCompositorTask in a worker thread.
+     */
+    void addResult(const Request& result);
+
+private:
+    // Is increased by clear(). Requests of older generations are skipped.
+    QAtomicInt m_generation;
+
+    QThreadPool m_threadPool;
+
+    // ID of the latest request for each URL. Is only used in the GUI thread.
+    int m_lastRequestId;
+    QHash<KUrl, int> m_latestRequestIds;
+
+    QMutex m_resultsMutex;
+    QList<Request> m_results;
+};
+
+#endif
@@ -47,7 +47,7 @@ InformationPanel::~InformationPanel()
 {
 }
 
-void InformationPanel::setSelection(const KFileItemList& selection)
+void InformationPanel::setSelection(const DolphinSelectionSnapshot& selection)
 {
     m_selection = selection;
     m_fileItem = KFileItem();
@@ -110,7 +110,7 @@ bool InformationPanel::urlChanged()
     }
 
     cancelRequest();
-    m_selection.clear();
+    m_selection = DolphinSelectionSnapshot();
 
     if (!isEqualToShownUrl(url())) {
         m_shownUrl = url();
@@ -168,7 +168,7 @@ void InformationPanel::showItemInfo()
 
     if (m_fileItem.isNull() && (m_selection.count() > 1)) {
         // The information for a selection of items should be shown
-        m_content->showItems(m_selection);
+        m_content->showItems(m_selection.items());
     } else {
         // The information for exactly one item should be shown
         KFileItem item;
@@ -215,7 +215,7 @@ void InformationPanel::reset()
 
         // The current URL is still invalid. Reset
         // the content to show the directory URL.
-        m_selection.clear();
+        m_selection = DolphinSelectionSnapshot();
         m_shownUrl = url();
         m_fileItem = KFileItem();
         showItemInfo();
@@ -228,14 +228,8 @@ void InformationPanel::slotFileRenamed(const QString& source, const QString& des
         m_shownUrl = KUrl(dest);
         m_fileItem = KFileItem(KFileItem::Unknown, KFileItem::Unknown, m_shownUrl);
 
-        if ((m_selection.count() == 1) && (m_selection[0].url() == KUrl(source))) {
-            m_selection[0] = m_fileItem;
-            // Implementation note: Updating the selection is only required if exactly one
-            // item is selected, as the name of the item is shown. If this should change
-            // in future: Before parsing the whole selection take care to test possible
-            // performance bottlenecks when renaming several hundreds of files.
-        }
-
+        // The selection need not be updated: DolphinSelectionSnapshot follows
+        // the changes of the model, so the renamed item is picked up automatically.
         showItemInfo();
     }
 }
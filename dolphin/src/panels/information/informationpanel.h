@@ -21,6 +21,7 @@
 #define INFORMATIONPANEL_H
 
 #include <panels/panel.h>
+#include <views/dolphinselectionsnapshot.h>
 
 class InformationPanelContent;
 namespace KIO
@@ -47,7 +48,7 @@ public slots:
      * This is invoked to inform the panel that the user has selected a new
      * set of items.
      */
-    void setSelection(const KFileItemList& selection);
+    void setSelection(const DolphinSelectionSnapshot& selection);
 
     /**
      * Does a delayed request of information for the item \a item.
@@ -149,7 +150,7 @@ private:
     KUrl m_invalidUrlCandidate;
 
     KFileItem m_fileItem; // file item for m_shownUrl if available (otherwise null)
-    KFileItemList m_selection;
+    DolphinSelectionSnapshot m_selection;
 
     KIO::Job* m_folderStatJob;
 
@@ -37,6 +37,7 @@
 #include <nepomuk2/filemetadatawidget.h>
 #endif
 
+#include <kitemviews/private/kpreviewcache.h>
 #include <panels/places/placesitem.h>
 #include <panels/places/placesitemmodel.h>
 
@@ -177,26 +178,32 @@ void InformationPanelContent::showItem(const KFileItem& item)
             // try to get a preview pixmap from the item...
             m_pendingPreview = true;
 
-            // Mark the currently shown preview as outdated. This is done
-            // with a small delay to prevent a flickering when the next preview
-            // can be shown within a short timeframe. This timer is not started
-            // for directories, as directory previews might fail and return the
-            // same icon.
-            if (!item.isDir()) {
-                m_outdatedPreviewTimer->start();
+            const QSize previewSize(m_preview->width(), m_preview->height());
+            QPixmap cachedPixmap;
+            if (KPreviewCache::instance()->find(item, previewSize, cachedPixmap)) {
+                showPreview(item, cachedPixmap);
+            } else {
+                // Mark the currently shown preview as outdated. This is done
+                // with a small delay to prevent a flickering when the next preview
+                // can be shown within a short timeframe. This timer is not started
+                // for directories, as directory previews might fail and return the
+                // same icon.
+                if (!item.isDir()) {
+                    m_outdatedPreviewTimer->start();
+                }
+
+                KIO::PreviewJob* job = new KIO::PreviewJob(KFileItemList() << item, previewSize);
+                job->setScaleType(KIO::PreviewJob::Unscaled);
+                job->setIgnoreMaximumSize(item.isLocalFile());
+                if (job->ui()) {
+                    job->ui()->setWindow(this);
+                }
+
+                connect(job, SIGNAL(gotPreview(KFileItem,QPixmap)),
+                        this, SLOT(showPreview(KFileItem,QPixmap)));
+                connect(job, SIGNAL(failed(KFileItem)),
+                        this, SLOT(showIcon(KFileItem)));
             }
-
-            KIO::PreviewJob* job = new KIO::PreviewJob(KFileItemList() << item, QSize(m_preview->width(), m_preview->height()));
-            job->setScaleType(KIO::PreviewJob::Unscaled);
-            job->setIgnoreMaximumSize(item.isLocalFile());
-            if (job->ui()) {
-                job->ui()->setWindow(this);
-            }
-
-            connect(job, SIGNAL(gotPreview(KFileItem,QPixmap)),
-                    this, SLOT(showPreview(KFileItem,QPixmap)));
-            connect(job, SIGNAL(failed(KFileItem)),
-                    this, SLOT(showIcon(KFileItem)));
         }
     }
 
@@ -326,8 +333,9 @@ void InformationPanelContent::showPreview(const KFileItem& item,
                                           const QPixmap& pixmap)
 {
     m_outdatedPreviewTimer->stop();
-    Q_UNUSED(item);
     if (m_pendingPreview) {
+        KPreviewCache::instance()->insert(item, m_preview->size(), pixmap);
+
         QPixmap p = pixmap;
         KIconLoader::global()->drawOverlays(item.overlays(), p, KIconLoader::Desktop);
         m_preview->setPixmap(p);
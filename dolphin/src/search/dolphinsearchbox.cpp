@@ -22,6 +22,7 @@
 #include "dolphin_searchsettings.h"
 #include "dolphinfacetswidget.h"
 #include "dolphinsearchinformation.h"
+#include "filenameindexupdater.h"
 
 #include <KIcon>
 #include <KLineEdit>
@@ -136,6 +137,8 @@ KUrl DolphinSearchBox::urlForSearching() const
         url.addQueryItem("search", m_searchInput->text());
         if (m_contentButton->isChecked()) {
             url.addQueryItem("checkContent", "yes");
+        } else if (SearchSettings::useFileNameIndex()) {
+            url.addQueryItem("useIndex", "yes");
         }
 
         QString encodedUrl;
@@ -307,6 +310,8 @@ void DolphinSearchBox::loadSettings()
     }
 
     m_facetsWidget->setVisible(SearchSettings::showFacetsWidget());
+
+    FileNameIndexUpdater::instance()->setEnabled(SearchSettings::useFileNameIndex());
 }
 
 void DolphinSearchBox::saveSettings()
@@ -0,0 +1,642 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "filenameindex.h"
+
+#include "filenamesearchengine.h"
+
+#include <KSaveFile>
+
+#include <QHash>
+
+#include <dirent.h>
+#include <cstring>
+
+namespace {
+    // "DFI1" in the native byte order. Files that have been written on
+    // machines with another byte order are ignored.
+    const quint32 Magic = 0x31494644;
+    const quint32 Version = 2;
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 recordCount;
+        quint32 namesSize;
+        quint32 rootPathSize;
+    };
+
+    struct DirectoryEntry
+    {
+        QByteArray name;
+        bool isDirectory;
+    };
+
+    /**
+     * Reads the entries of the directory \a path, except of ".", ".."
+     * and hidden entries. Symbolic links are not treated as directories,
+     * so the index cannot contain loops.
+     */
+    bool readDirectory(const QByteArray& path, QList<DirectoryEntry>& entries)
+    {
+        if (path == "/proc" || path == "/sys") {
+            // Don't try to index the virtual file systems of Linux
+            return false;
+        }
+
+        DIR* dir = ::opendir(path.constData());
+        if (!dir) {
+            return false;
+        }
+
+        const QByteArray prefix = path.endsWith('/') ? path : path + '/';
+        struct dirent* dirEntry = 0;
+        while ((dirEntry = ::readdir(dir))) {
+            if (dirEntry->d_name[0] == '.') {
+                // Skip ".", ".." and hidden files like KDirLister does per default
+                continue;
+            }
+
+            DirectoryEntry entry;
+            entry.name = dirEntry->d_name;
+            if (entry.name.contains('\n')) {
+                // The names are separated by newlines inside the index
+                continue;
+            }
+
+            unsigned char type = dirEntry->d_type;
+            if (type == DT_UNKNOWN) {
+                KDE_struct_stat statBuffer;
+                if (KDE_lstat((prefix + entry.name).constData(), &statBuffer) == 0 && S_ISDIR(statBuffer.st_mode)) {
+                    type = DT_DIR;
+                }
+            }
+            entry.isDirectory = (type == DT_DIR);
+            entries.append(entry);
+        }
+
+        ::closedir(dir);
+        return true;
+    }
+
+    inline QByteArray childPath(const QByteArray& path, const QByteArray& name)
+    {
+        return path.endsWith('/') ? path + name : path + '/' + name;
+    }
+
+    inline QByteArray parentPath(const QByteArray& path)
+    {
+        return path.left(qMax(1, path.lastIndexOf('/')));
+    }
+
+    inline QByteArray normalizedPath(const QByteArray& path)
+    {
+        QByteArray result = path;
+        while (result.length() > 1 && result.endsWith('/')) {
+            result.chop(1);
+        }
+        return result;
+    }
+}
+
+FileNameIndex::Builder::Builder() :
+    m_records(),
+    m_names()
+{
+}
+
+quint32 FileNameIndex::Builder::addEntry(quint32 parent, const QByteArray& name, bool isDirectory)
+{
+    Record r;
+    r.parent = parent;
+    r.subtreeEnd = m_records.count() + 1;
+    r.nameOffset = m_names.size();
+    r.flags = isDirectory ? IsDirectory : 0;
+    m_records.append(r);
+
+    m_names.append(name);
+    m_names.append('\n');
+
+    return m_records.count() - 1;
+}
+
+int FileNameIndex::Builder::count() const
+{
+    return m_records.count();
+}
+
+void FileNameIndex::Builder::finish()
+{
+    // As the records are stored in pre-order, all ancestors of a record
+    // are on the stack when the record is reached.
+    QVector<quint32> openRecords;
+    const quint32 count = m_records.count();
+    for (quint32 i = 0; i < count; ++i) {
+        const quint32 parent = m_records.at(i).parent;
+        while (!openRecords.isEmpty() && openRecords.last() != parent) {
+            m_records[openRecords.last()].subtreeEnd = i;
+            openRecords.pop_back();
+        }
+        Q_ASSERT(parent == NoParent || !openRecords.isEmpty());
+        openRecords.append(i);
+    }
+
+    while (!openRecords.isEmpty()) {
+        m_records[openRecords.last()].subtreeEnd = count;
+        openRecords.pop_back();
+    }
+
+    // Watch all directories up to the largest depth for which the number
+    // of directories does not exceed MaxWatchedDirectories. The parent of
+    // a record is always stored before the record.
+    QVector<int> depths(count);
+    QVector<int> directoriesPerDepth;
+    for (quint32 i = 0; i < count; ++i) {
+        const quint32 parent = m_records.at(i).parent;
+        const int depth = (parent == NoParent) ? 0 : depths.at(parent) + 1;
+        depths[i] = depth;
+        if (m_records.at(i).flags & IsDirectory) {
+            if (directoriesPerDepth.count() <= depth) {
+                directoriesPerDepth.resize(depth + 1);
+            }
+            ++directoriesPerDepth[depth];
+        }
+    }
+
+    int maxWatchedDepth = -1;
+    int watchedCount = 1; // The root directory is always watched
+    while (maxWatchedDepth + 1 < directoriesPerDepth.count() &&
+           watchedCount + directoriesPerDepth.at(maxWatchedDepth + 1) <= MaxWatchedDirectories) {
+        ++maxWatchedDepth;
+        watchedCount += directoriesPerDepth.at(maxWatchedDepth);
+    }
+
+    for (quint32 i = 0; i < count; ++i) {
+        Record& r = m_records[i];
+        if ((r.flags & IsDirectory) && depths.at(i) <= maxWatchedDepth) {
+            r.flags |= IsWatched;
+        } else {
+            r.flags &= ~IsWatched;
+        }
+    }
+}
+
+
+FileNameIndex::FileNameIndex(const QString& fileName) :
+    m_fileName(fileName),
+    m_file(),
+    m_data(0),
+    m_records(0),
+    m_names(0),
+    m_recordCount(0),
+    m_namesSize(0),
+    m_rootPath()
+{
+    load();
+}
+
+FileNameIndex::~FileNameIndex()
+{
+    unload();
+}
+
+bool FileNameIndex::isValid() const
+{
+    return m_data != 0;
+}
+
+QByteArray FileNameIndex::rootPath() const
+{
+    return m_rootPath;
+}
+
+int FileNameIndex::count() const
+{
+    return m_recordCount;
+}
+
+QList<QByteArray> FileNameIndex::watchedDirectories() const
+{
+    QList<QByteArray> directories;
+    if (!m_data) {
+        return directories;
+    }
+
+    directories.append(m_rootPath);
+
+    // The watched directories are the topmost directories, so the
+    // subtrees of unwatched directories can be skipped.
+    int i = 0;
+    while (i < m_recordCount) {
+        const Record r = record(i);
+        if ((r.flags & IsDirectory) && !(r.flags & IsWatched)) {
+            i = qMax<int>(r.subtreeEnd, i + 1);
+        } else {
+            if (r.flags & IsWatched) {
+                directories.append(path(i));
+            }
+            ++i;
+        }
+    }
+    return directories;
+}
+
+bool FileNameIndex::search(const QByteArray& directory, const FileNameSearchMatcher& matcher,
+                           QList<QByteArray>& paths) const
+{
+    if (!m_data) {
+        return false;
+    }
+
+    int first = 0;
+    int last = m_recordCount;
+    const QByteArray directoryPath = normalizedPath(directory);
+    if (directoryPath != m_rootPath) {
+        const int index = findRecord(directoryPath);
+        if (index < 0) {
+            return false;
+        }
+        first = index + 1;
+        last = record(index).subtreeEnd;
+    }
+
+    if (first >= last) {
+        return true;
+    }
+
+    // The names of the items below the directory are stored contiguously
+    const char* begin = m_names + record(first).nameOffset;
+    const char* end = m_names + ((last < m_recordCount) ? record(last).nameOffset : m_namesSize);
+
+    const char* pos = begin;
+    while (pos < end) {
+        const char* line = matcher.findMatchingLine(pos, end);
+        if (!line) {
+            break;
+        }
+
+        const int index = findRecordByNameOffset(line - m_names, first, last);
+        if (index >= 0) {
+            paths.append(path(index));
+        }
+
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            break;
+        }
+        pos = lineEnd + 1;
+    }
+
+    return true;
+}
+
+bool FileNameIndex::build(const QByteArray& rootPath)
+{
+    const QByteArray path = normalizedPath(rootPath);
+
+    Builder builder;
+    if (!scanDirectory(path, NoParent, builder)) {
+        return false;
+    }
+    return save(path, builder);
+}
+
+bool FileNameIndex::update(const QList<QByteArray>& directories)
+{
+    if (!m_data) {
+        return false;
+    }
+
+    const QByteArray prefix = m_rootPath.endsWith('/') ? m_rootPath : m_rootPath + '/';
+
+    // The changed directories are read again. All their ancestors are
+    // remembered, as only the records below these directories need to
+    // be checked.
+    QSet<QByteArray> dirtyDirectories;
+    QSet<QByteArray> changedParents;
+    foreach (const QByteArray& changedDirectory, directories) {
+        QByteArray directory = normalizedPath(changedDirectory);
+        if (directory != m_rootPath && !directory.startsWith(prefix)) {
+            continue;
+        }
+        if (directory.mid(prefix.length() - 1).contains("/.")) {
+            // Hidden directories are not indexed
+            continue;
+        }
+
+        // Directories that have been added or removed are
+        // handled by reading their parent directory again.
+        KDE_struct_stat statBuffer;
+        while (directory != m_rootPath) {
+            const int index = findRecord(directory);
+            if (index >= 0 && (record(index).flags & IsDirectory) &&
+                KDE_lstat(directory.constData(), &statBuffer) == 0 && S_ISDIR(statBuffer.st_mode)) {
+                break;
+            }
+            directory = parentPath(directory);
+        }
+
+        dirtyDirectories.insert(directory);
+        while (directory != m_rootPath) {
+            directory = parentPath(directory);
+            changedParents.insert(directory);
+        }
+    }
+
+    if (dirtyDirectories.isEmpty()) {
+        return true;
+    }
+
+    const QByteArray rootPath = m_rootPath;
+    Builder builder;
+    updateDirectory(rootPath, -1, NoParent, dirtyDirectories, changedParents, builder);
+    return save(rootPath, builder);
+}
+
+bool FileNameIndex::save(const QByteArray& rootPath, Builder& builder)
+{
+    builder.finish();
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.recordCount = builder.m_records.count();
+    header.namesSize = builder.m_names.size();
+    header.rootPathSize = rootPath.size();
+
+    // The old file must not be mapped while it is replaced.
+    unload();
+
+    const qint64 recordsSize = qint64(header.recordCount) * sizeof(Record);
+    KSaveFile file(m_fileName);
+    const bool success = file.open() &&
+                         file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header) &&
+                         file.write(reinterpret_cast<const char*>(builder.m_records.constData()), recordsSize) == recordsSize &&
+                         file.write(builder.m_names) == builder.m_names.size() &&
+                         file.write(rootPath) == rootPath.size() &&
+                         file.finalize();
+
+    load();
+    return success;
+}
+
+void FileNameIndex::load()
+{
+    unload();
+
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < static_cast<qint64>(sizeof(Header))) {
+        m_file.close();
+        return;
+    }
+
+    const uchar* data = m_file.map(0, fileSize);
+    if (!data) {
+        m_file.close();
+        return;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    const qint64 recordsEnd = sizeof(Header) + qint64(header.recordCount) * sizeof(Record);
+    const qint64 namesEnd = recordsEnd + header.namesSize;
+    const bool valid = header.magic == Magic &&
+                       header.version == Version &&
+                       header.recordCount < NoParent &&
+                       header.rootPathSize > 0 &&
+                       namesEnd + header.rootPathSize <= fileSize;
+    if (!valid) {
+        m_file.unmap(const_cast<uchar*>(data));
+        m_file.close();
+        return;
+    }
+
+    m_data = data;
+    m_records = data + sizeof(Header);
+    m_names = reinterpret_cast<const char*>(data + recordsEnd);
+    m_recordCount = header.recordCount;
+    m_namesSize = header.namesSize;
+    m_rootPath = QByteArray(reinterpret_cast<const char*>(data + namesEnd), header.rootPathSize);
+}
+
+void FileNameIndex::unload()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = 0;
+    }
+    m_file.close();
+    m_records = 0;
+    m_names = 0;
+    m_recordCount = 0;
+    m_namesSize = 0;
+    m_rootPath.clear();
+}
+
+FileNameIndex::Record FileNameIndex::record(int index) const
+{
+    // The records are copied to prevent unaligned access to the mapped memory.
+    Record r;
+    std::memcpy(&r, m_records + index * sizeof(Record), sizeof(Record));
+    return r;
+}
+
+QByteArray FileNameIndex::name(int index) const
+{
+    const quint32 offset = record(index).nameOffset;
+    if (offset >= m_namesSize) {
+        return QByteArray();
+    }
+
+    const char* begin = m_names + offset;
+    const char* end = static_cast<const char*>(memchr(begin, '\n', m_namesSize - offset));
+    return QByteArray(begin, end ? end - begin : m_namesSize - offset);
+}
+
+QByteArray FileNameIndex::path(int index) const
+{
+    QList<QByteArray> names;
+    quint32 i = index;
+    while (i != NoParent) {
+        names.prepend(name(i));
+        const quint32 parent = record(i).parent;
+        if (parent != NoParent && parent >= i) {
+            // The parent of a record is always stored before the record
+            break;
+        }
+        i = parent;
+    }
+
+    QByteArray result = m_rootPath;
+    foreach (const QByteArray& name, names) {
+        result = childPath(result, name);
+    }
+    return result;
+}
+
+int FileNameIndex::findRecord(const QByteArray& path) const
+{
+    const QByteArray prefix = m_rootPath.endsWith('/') ? m_rootPath : m_rootPath + '/';
+    if (!path.startsWith(prefix)) {
+        return -1;
+    }
+
+    int index = -1;
+    int first = 0;
+    int last = m_recordCount;
+    const QList<QByteArray> components = path.mid(prefix.length()).split('/');
+    foreach (const QByteArray& component, components) {
+        if (component.isEmpty()) {
+            continue;
+        }
+
+        // Only the children of the current directory are compared
+        index = -1;
+        int i = first;
+        while (i < last) {
+            if (name(i) == component) {
+                index = i;
+                break;
+            }
+            const int next = record(i).subtreeEnd;
+            if (next <= i) {
+                return -1;
+            }
+            i = next;
+        }
+
+        if (index < 0) {
+            return -1;
+        }
+        first = index + 1;
+        last = qMin<int>(record(index).subtreeEnd, m_recordCount);
+    }
+
+    return index;
+}
+
+int FileNameIndex::findRecordByNameOffset(quint32 nameOffset, int first, int last) const
+{
+    int low = first;
+    int high = last;
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        const quint32 middleOffset = record(middle).nameOffset;
+        if (middleOffset < nameOffset) {
+            low = middle + 1;
+        } else if (nameOffset < middleOffset) {
+            high = middle;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+void FileNameIndex::updateDirectory(const QByteArray& path, int index, quint32 parent,
+                                    const QSet<QByteArray>& dirtyDirectories,
+                                    const QSet<QByteArray>& changedParents,
+                                    Builder& builder) const
+{
+    const int first = index + 1;
+    const int last = (index < 0) ? m_recordCount : qMin<int>(record(index).subtreeEnd, m_recordCount);
+
+    if (dirtyDirectories.contains(path)) {
+        QHash<QByteArray, int> oldChildren;
+        for (int i = first; i < last; i = qMax<int>(record(i).subtreeEnd, i + 1)) {
+            oldChildren.insert(name(i), i);
+        }
+
+        QList<DirectoryEntry> entries;
+        readDirectory(path, entries);
+        foreach (const DirectoryEntry& entry, entries) {
+            const quint32 entryIndex = builder.addEntry(parent, entry.name, entry.isDirectory);
+            if (!entry.isDirectory) {
+                continue;
+            }
+
+            // Only new directories are read, the contents of existing
+            // directories are taken from the index.
+            const int oldIndex = oldChildren.value(entry.name, -1);
+            if (oldIndex >= 0 && (record(oldIndex).flags & IsDirectory)) {
+                updateDirectory(childPath(path, entry.name), oldIndex, entryIndex,
+                                dirtyDirectories, changedParents, builder);
+            } else {
+                scanDirectory(childPath(path, entry.name), entryIndex, builder);
+            }
+        }
+        return;
+    }
+
+    for (int i = first; i < last; i = qMax<int>(record(i).subtreeEnd, i + 1)) {
+        if (record(i).flags & IsDirectory) {
+            const QByteArray directory = childPath(path, name(i));
+            if (dirtyDirectories.contains(directory) || changedParents.contains(directory)) {
+                const quint32 entryIndex = builder.addEntry(parent, name(i), true);
+                updateDirectory(directory, i, entryIndex, dirtyDirectories, changedParents, builder);
+                continue;
+            }
+        }
+        copySubtree(i, parent, builder);
+    }
+}
+
+void FileNameIndex::copySubtree(int index, quint32 parent, Builder& builder) const
+{
+    // The records and names below an item are stored contiguously, so they
+    // can be copied as a whole. Only the parent indexes and the name offsets
+    // must be shifted.
+    const Record first = record(index);
+    const int last = qMin<int>(first.subtreeEnd, m_recordCount);
+    const quint32 namesBegin = first.nameOffset;
+    const quint32 namesEnd = (last < m_recordCount) ? record(last).nameOffset : m_namesSize;
+
+    const quint32 indexShift = builder.m_records.count() - index;
+    const quint32 nameOffsetShift = builder.m_names.size() - namesBegin;
+    for (int i = index; i < last; ++i) {
+        Record r = record(i);
+        r.parent = (i == index) ? parent : r.parent + indexShift;
+        r.nameOffset += nameOffsetShift;
+        builder.m_records.append(r);
+    }
+    builder.m_names.append(m_names + namesBegin, namesEnd - namesBegin);
+}
+
+bool FileNameIndex::scanDirectory(const QByteArray& path, quint32 parent, Builder& builder)
+{
+    QList<DirectoryEntry> entries;
+    if (!readDirectory(path, entries)) {
+        return false;
+    }
+
+    foreach (const DirectoryEntry& entry, entries) {
+        const quint32 index = builder.addEntry(parent, entry.name, entry.isDirectory);
+        if (entry.isDirectory) {
+            scanDirectory(childPath(path, entry.name), index, builder);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,225 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef FILENAMEINDEX_H
+#define FILENAMEINDEX_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+class FileNameSearchMatcher;
+
+/**
+ * @brief Persistent index of the names of all items below a local directory.
+ *
+ * The index allows FileNameSearchProtocol to search the names of a whole
+ * directory tree without reading the directories. The index file is
+ * memory-mapped and consists of a record for each item and a table that
+ * contains the names of all items separated by newlines:
+ *
+ * - The records are stored in pre-order, so the items below a directory
+ *   form a contiguous range of records. Each record contains the index
+ *   of its parent and the end of its range.
+ * - The names are stored in the same order as the records. Searching
+ *   the items below a directory only requires to scan one contiguous part
+ *   of the name table with FileNameSearchMatcher. The records of the
+ *   matching names are found by a binary search.
+ *
+ * Hidden items are not indexed. The index might be outdated, so the
+ * results of search() must be confirmed, e.g. by FileNameSearchEngine::createResult().
+ *
+ * Only the directories up to a certain depth are watched for changes by
+ * FileNameIndexUpdater, so that the number of watches is limited. These
+ * directories are marked with the flag IsWatched. The items below the other
+ * directories are found by search() as well, but they are only updated
+ * for changes done by KIO and by the periodic rebuild of the index.
+ */
+class FileNameIndex
+{
+
+public:
+    /**
+     * Layout of an entry inside the index file.
+     */
+    struct Record
+    {
+        quint32 parent;     // NoParent for the items inside the root directory
+        quint32 subtreeEnd; // Index of the first record that is not below this item
+        quint32 nameOffset; // Offset of the name inside the name table
+        quint32 flags;
+    };
+
+    enum RecordFlag
+    {
+        IsDirectory = 0x1,
+        IsWatched = 0x2 // The directory is watched for changes by FileNameIndexUpdater
+    };
+
+    static const quint32 NoParent = 0xffffffff;
+
+    /**
+     * Maximum number of directories that are watched for changes,
+     * including the root directory. Each watched directory requires
+     * an inotify watch, whose number is limited.
+     */
+    static const int MaxWatchedDirectories = 2000;
+
+    /**
+     * @brief Collects the entries for a new index.
+     *
+     * The entries must be added in pre-order: The items below a directory
+     * must be added directly after the directory.
+     */
+    class Builder
+    {
+    public:
+        Builder();
+
+        /**
+         * @return Index of the added entry.
+         */
+        quint32 addEntry(quint32 parent, const QByteArray& name, bool isDirectory);
+        int count() const;
+
+    private:
+        /**
+         * Sets Record::subtreeEnd and the flag IsWatched for all records.
+         */
+        void finish();
+
+        QVector<Record> m_records;
+        QByteArray m_names;
+
+        friend class FileNameIndex;
+    };
+
+    /**
+     * @param fileName Path of the index file. The file is created
+     *                 by build() or save() if it does not exist yet.
+     */
+    explicit FileNameIndex(const QString& fileName);
+    ~FileNameIndex();
+
+    /**
+     * @return True if the index file could be loaded.
+     */
+    bool isValid() const;
+
+    /**
+     * @return Local path of the indexed directory.
+     */
+    QByteArray rootPath() const;
+
+    /**
+     * @return Number of indexed items.
+     */
+    int count() const;
+
+    /**
+     * @return Local paths of the root directory and of all directories
+     *         that have the flag IsWatched.
+     */
+    QList<QByteArray> watchedDirectories() const;
+
+    /**
+     * Adds the paths of all items below \a directory whose names match
+     * with \a matcher to \a paths.
+     *
+     * @return False if \a directory is not part of the index.
+     */
+    bool search(const QByteArray& directory, const FileNameSearchMatcher& matcher,
+                QList<QByteArray>& paths) const;
+
+    /**
+     * Indexes all items below the local directory \a rootPath.
+     */
+    bool build(const QByteArray& rootPath);
+
+    /**
+     * Reads the contents of the changed directories \a directories again.
+     * The sub directories are only read if they are new, the existing
+     * records are taken for all other items.
+     */
+    bool update(const QList<QByteArray>& directories);
+
+    /**
+     * Writes the entries of \a builder as index for \a rootPath.
+     */
+    bool save(const QByteArray& rootPath, Builder& builder);
+
+private:
+    void load();
+    void unload();
+
+    Record record(int index) const;
+    QByteArray name(int index) const;
+    QByteArray path(int index) const;
+
+    /**
+     * @return Index of the record for \a path or -1 if \a path is
+     *         not indexed. For the root directory -1 is returned too.
+     */
+    int findRecord(const QByteArray& path) const;
+
+    /**
+     * @return Index of the record between \a first and \a last
+     *         whose name starts at \a nameOffset.
+     */
+    int findRecordByNameOffset(quint32 nameOffset, int first, int last) const;
+
+    /**
+     * Adds the children of the indexed directory \a path to \a builder.
+     * The records of unchanged directories are copied, directories that
+     * are part of \a dirtyDirectories are read again.
+     *
+     * @param index  Index of the record for \a path, -1 for the root directory.
+     * @param parent Index of the entry for \a path inside \a builder.
+     */
+    void updateDirectory(const QByteArray& path, int index, quint32 parent,
+                         const QSet<QByteArray>& dirtyDirectories,
+                         const QSet<QByteArray>& changedParents,
+                         Builder& builder) const;
+
+    /**
+     * Copies the record \a index and all records below it to \a builder.
+     */
+    void copySubtree(int index, quint32 parent, Builder& builder) const;
+
+    /**
+     * Adds all items below the local directory \a path to \a builder.
+     * @return False if \a path could not be read.
+     */
+    static bool scanDirectory(const QByteArray& path, quint32 parent, Builder& builder);
+
+private:
+    QString m_fileName;
+    QFile m_file;
+    const uchar* m_data;
+    const uchar* m_records;
+    const char* m_names;
+    int m_recordCount;
+    quint32 m_namesSize;
+    QByteArray m_rootPath;
+};
+
+#endif
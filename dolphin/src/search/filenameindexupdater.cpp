@@ -0,0 +1,288 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "filenameindexupdater.h"
+
+#include "filenameindex.h"
+
+#include <KDirNotify>
+#include <KDirWatch>
+#include <KGlobal>
+#include <KStandardDirs>
+#include <KUrl>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+    // Delay in milliseconds until the changed directories are read again
+    const int UpdateDelay = 5000;
+
+    // Interval in milliseconds for rebuilding the whole index while Dolphin is running
+    const int RebuildInterval = 24 * 60 * 60 * 1000;
+
+    // Changes are not tracked while Dolphin is not running, so an index that
+    // is older than this number of seconds is rebuilt when Dolphin is started.
+    const int MaximumStartupAge = 60 * 60;
+}
+
+class FileNameIndexUpdateThread : public QThread
+{
+public:
+    FileNameIndexUpdateThread(const QByteArray& rootPath, const QList<QByteArray>& directories,
+                              bool rebuild, QObject* parent) :
+        QThread(parent),
+        m_fileName(FileNameIndexUpdater::indexFileName()),
+        m_rootPath(rootPath),
+        m_directories(directories),
+        m_rebuild(rebuild)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        FileNameIndex index(m_fileName);
+        if (m_rebuild || !index.isValid() || index.rootPath() != m_rootPath) {
+            index.build(m_rootPath);
+        } else {
+            index.update(m_directories);
+        }
+    }
+
+private:
+    QString m_fileName;
+    QByteArray m_rootPath;
+    QList<QByteArray> m_directories;
+    bool m_rebuild;
+};
+
+class FileNameIndexUpdaterSingleton
+{
+public:
+    FileNameIndexUpdater instance;
+};
+K_GLOBAL_STATIC(FileNameIndexUpdaterSingleton, s_fileNameIndexUpdater)
+
+
+FileNameIndexUpdater* FileNameIndexUpdater::instance()
+{
+    return &s_fileNameIndexUpdater->instance;
+}
+
+FileNameIndexUpdater::FileNameIndexUpdater() :
+    QObject(0),
+    m_enabled(false),
+    m_rebuildRequired(false),
+    m_rootPath(QFile::encodeName(QDir::homePath())),
+    m_dirtyDirectories(),
+    m_dirWatcher(0),
+    m_watchedDirs(),
+    m_updateTimer(0),
+    m_rebuildTimer(0),
+    m_thread(0)
+{
+    m_dirWatcher = new KDirWatch(this);
+    connect(m_dirWatcher, SIGNAL(dirty(QString)), this, SLOT(slotDirWatchDirty(QString)));
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(UpdateDelay);
+    m_updateTimer->setSingleShot(true);
+    connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(startUpdate()));
+
+    m_rebuildTimer = new QTimer(this);
+    m_rebuildTimer->setInterval(RebuildInterval);
+    connect(m_rebuildTimer, SIGNAL(timeout()), this, SLOT(scheduleRebuild()));
+
+    org::kde::KDirNotify* dirNotify = new org::kde::KDirNotify(QString(), QString(),
+                                                               QDBusConnection::sessionBus(), this);
+    connect(dirNotify, SIGNAL(FilesAdded(QString)), SLOT(slotFilesAdded(QString)));
+    connect(dirNotify, SIGNAL(FilesRemoved(QStringList)), SLOT(slotFilesRemoved(QStringList)));
+    connect(dirNotify, SIGNAL(FileRenamed(QString,QString)), SLOT(slotFileRenamed(QString,QString)));
+}
+
+FileNameIndexUpdater::~FileNameIndexUpdater()
+{
+    if (m_thread) {
+        m_thread->wait();
+    }
+}
+
+void FileNameIndexUpdater::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+
+    m_enabled = enabled;
+    if (enabled) {
+        const FileNameIndex index(indexFileName());
+        const QDateTime lastModified = QFileInfo(indexFileName()).lastModified();
+        if (!index.isValid() || index.rootPath() != m_rootPath ||
+            lastModified.secsTo(QDateTime::currentDateTime()) > MaximumStartupAge) {
+            scheduleRebuild();
+        }
+        m_rebuildTimer->start();
+        updateWatchedDirectories();
+    } else {
+        m_updateTimer->stop();
+        m_rebuildTimer->stop();
+        m_rebuildRequired = false;
+        m_dirtyDirectories.clear();
+        foreach (const QString& dir, m_watchedDirs) {
+            m_dirWatcher->removeDir(dir);
+        }
+        m_watchedDirs.clear();
+    }
+}
+
+bool FileNameIndexUpdater::isEnabled() const
+{
+    return m_enabled;
+}
+
+QString FileNameIndexUpdater::indexFileName()
+{
+    return KStandardDirs::locateLocal("cache", "dolphin/filenameindex");
+}
+
+void FileNameIndexUpdater::slotFilesAdded(const QString& directory)
+{
+    const KUrl url(directory);
+    if (url.isLocalFile()) {
+        markDirty(url.toLocalFile(KUrl::RemoveTrailingSlash));
+    }
+}
+
+void FileNameIndexUpdater::slotFilesRemoved(const QStringList& files)
+{
+    foreach (const QString& file, files) {
+        markParentDirty(file);
+    }
+}
+
+void FileNameIndexUpdater::slotFileRenamed(const QString& source, const QString& destination)
+{
+    markParentDirty(source);
+    markParentDirty(destination);
+}
+
+void FileNameIndexUpdater::slotDirWatchDirty(const QString& path)
+{
+    markDirty(path);
+}
+
+void FileNameIndexUpdater::scheduleRebuild()
+{
+    m_rebuildRequired = true;
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void FileNameIndexUpdater::startUpdate()
+{
+    if (!m_enabled || m_thread) {
+        // If an update is running already, the next update is
+        // started by slotUpdateFinished().
+        return;
+    }
+
+    if (!m_rebuildRequired && m_dirtyDirectories.isEmpty()) {
+        return;
+    }
+
+    m_thread = new FileNameIndexUpdateThread(m_rootPath, m_dirtyDirectories.toList(), m_rebuildRequired, this);
+    connect(m_thread, SIGNAL(finished()), this, SLOT(slotUpdateFinished()));
+    m_dirtyDirectories.clear();
+    m_rebuildRequired = false;
+    m_thread->start(QThread::LowestPriority);
+}
+
+void FileNameIndexUpdater::slotUpdateFinished()
+{
+    m_thread->deleteLater();
+    m_thread = 0;
+
+    if (!m_enabled) {
+        return;
+    }
+
+    // Directories might have been added to or removed from the index
+    updateWatchedDirectories();
+
+    if ((m_rebuildRequired || !m_dirtyDirectories.isEmpty()) && !m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void FileNameIndexUpdater::markDirty(const QString& path)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    const QByteArray directory = QFile::encodeName(path);
+    if (directory == m_rootPath || directory.startsWith(m_rootPath + '/')) {
+        m_dirtyDirectories.insert(directory);
+        if (!m_updateTimer->isActive()) {
+            m_updateTimer->start();
+        }
+    }
+}
+
+void FileNameIndexUpdater::markParentDirty(const QString& url)
+{
+    const KUrl itemUrl(url);
+    if (itemUrl.isLocalFile()) {
+        markDirty(QFileInfo(itemUrl.toLocalFile(KUrl::RemoveTrailingSlash)).absolutePath());
+    }
+}
+
+void FileNameIndexUpdater::updateWatchedDirectories()
+{
+    // The index decides which directories are watched, so that the number
+    // of watches is limited.
+    QSet<QString> dirs;
+    dirs.insert(QFile::decodeName(m_rootPath));
+
+    const FileNameIndex index(indexFileName());
+    if (index.isValid() && index.rootPath() == m_rootPath) {
+        foreach (const QByteArray& dir, index.watchedDirectories()) {
+            dirs.insert(QFile::decodeName(dir));
+        }
+    }
+
+    foreach (const QString& dir, m_watchedDirs) {
+        if (!dirs.contains(dir)) {
+            m_dirWatcher->removeDir(dir);
+        }
+    }
+    foreach (const QString& dir, dirs) {
+        if (!m_watchedDirs.contains(dir)) {
+            m_dirWatcher->addDir(dir);
+        }
+    }
+    m_watchedDirs = dirs;
+}
+
+#include "filenameindexupdater.moc"
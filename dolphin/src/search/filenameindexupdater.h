@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef FILENAMEINDEXUPDATER_H
+#define FILENAMEINDEXUPDATER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class FileNameIndexUpdateThread;
+class KDirWatch;
+class QTimer;
+
+/**
+ * @brief Keeps the FileNameIndex of the home directory up to date.
+ *
+ * The index is used by the "filenamesearch" protocol if the option
+ * UseFileNameIndex of the search settings is enabled. Changes are detected
+ * by watching the directories that are marked with FileNameIndex::IsWatched
+ * with KDirWatch, and by the notifications of KDirNotify that are emitted for
+ * all changes done by KIO. The changed directories are collected for a
+ * few seconds and read again by a thread.
+ *
+ * The number of inotify watches is limited, so only the directories up to
+ * a certain depth are watched. Changes below the other directories are only
+ * noticed if they are done by KIO. Therefore the index is rebuilt completely
+ * once a day, and the results of the index are confirmed by the protocol.
+ */
+class FileNameIndexUpdater : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FileNameIndexUpdater* instance();
+    virtual ~FileNameIndexUpdater();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+     * @return Path of the index file.
+     */
+    static QString indexFileName();
+
+private slots:
+    void slotFilesAdded(const QString& directory);
+    void slotFilesRemoved(const QStringList& files);
+    void slotFileRenamed(const QString& source, const QString& destination);
+    void slotDirWatchDirty(const QString& path);
+
+    /**
+     * Requires a complete rebuild of the index.
+     */
+    void scheduleRebuild();
+
+    void startUpdate();
+    void slotUpdateFinished();
+
+private:
+    FileNameIndexUpdater();
+
+    /**
+     * Remembers that the contents of the local directory \a path have been changed.
+     */
+    void markDirty(const QString& path);
+
+    /**
+     * Marks the parent directory of the URL \a url as dirty.
+     */
+    void markParentDirty(const QString& url);
+
+    /**
+     * Watches the root directory and all directories that are marked
+     * with FileNameIndex::IsWatched in the current index.
+     */
+    void updateWatchedDirectories();
+
+private:
+    bool m_enabled;
+    bool m_rebuildRequired;
+    QByteArray m_rootPath;
+    QSet<QByteArray> m_dirtyDirectories;
+
+    KDirWatch* m_dirWatcher;
+    QSet<QString> m_watchedDirs;
+
+    QTimer* m_updateTimer;
+    QTimer* m_rebuildTimer;
+    FileNameIndexUpdateThread* m_thread;
+
+    friend class FileNameIndexUpdaterSingleton;
+};
+
+#endif
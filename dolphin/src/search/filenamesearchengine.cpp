@@ -0,0 +1,435 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+
+#include "filenamesearchengine.h"
+
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+
+#include <dirent.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+    // Number of bytes at the beginning of a file that are checked for null
+    // bytes to detect binary files (see KMimeType::isBufferBinaryData()).
+    const int BinaryCheckSize = 1024;
+
+    // Number of results that are collected by a task before they are passed
+    // to FileNameSearchEngine::takeResults().
+    const int ResultBatchSize = 100;
+
+    inline char toLowerAscii(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    inline char toUpperAscii(char c)
+    {
+        return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+    }
+}
+
+class FileNameSearchTask : public QRunnable
+{
+public:
+    FileNameSearchTask(FileNameSearchEngine* engine, const QByteArray& path) :
+        QRunnable(),
+        m_engine(engine),
+        m_path(path)
+    {
+    }
+
+    virtual void run()
+    {
+        m_engine->searchDirectory(m_path);
+        m_engine->finishTask();
+    }
+
+private:
+    FileNameSearchEngine* m_engine;
+    QByteArray m_path;
+};
+
+
+FileNameSearchMatcher::FileNameSearchMatcher(const QString& pattern) :
+    m_literal(literalPart(pattern)),
+    m_literalOnly(false),
+    m_regExp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard)
+{
+    m_literalOnly = (m_literal.length() == pattern.length());
+
+    const int length = m_literal.length();
+    for (int i = 0; i < 256; ++i) {
+        m_skipTable[i] = length;
+    }
+    for (int i = 0; i < length - 1; ++i) {
+        const char c = m_literal.at(i);
+        m_skipTable[static_cast<uchar>(c)] = length - 1 - i;
+        m_skipTable[static_cast<uchar>(toUpperAscii(c))] = length - 1 - i;
+    }
+}
+
+bool FileNameSearchMatcher::contains(const char* begin, const char* end) const
+{
+    return findMatchingLine(begin, end) != 0;
+}
+
+bool FileNameSearchMatcher::contains(const QByteArray& text) const
+{
+    return contains(text.constData(), text.constData() + text.length());
+}
+
+const char* FileNameSearchMatcher::findMatchingLine(const char* begin, const char* end) const
+{
+    const char* lineBegin = begin;
+    do {
+        const char* candidate = findLiteral(lineBegin, end);
+        if (!candidate) {
+            return 0;
+        }
+
+        const char* start = candidate;
+        while (start > lineBegin && start[-1] != '\n') {
+            --start;
+        }
+        if (m_literalOnly) {
+            return start;
+        }
+
+        // Check the line that contains the candidate with the regular expression
+        const char* lineEnd = static_cast<const char*>(memchr(candidate, '\n', end - candidate));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char* textEnd = lineEnd;
+        if (textEnd > start && textEnd[-1] == '\r') {
+            --textEnd;
+        }
+
+        const QString line = QString::fromLocal8Bit(start, textEnd - start);
+        if (line.contains(m_regExp)) {
+            return start;
+        }
+
+        lineBegin = lineEnd + 1;
+    } while (lineBegin < end);
+
+    return 0;
+}
+
+QByteArray FileNameSearchMatcher::literalPart(const QString& pattern)
+{
+    QByteArray longestPart;
+    QByteArray part;
+
+    const int length = pattern.length();
+    for (int i = 0; i < length; ++i) {
+        const QChar c = pattern.at(i);
+        const bool isLiteral = c.unicode() < 128 &&
+                               c != QLatin1Char('*') &&
+                               c != QLatin1Char('?') &&
+                               c != QLatin1Char('[') &&
+                               c != QLatin1Char('\\');
+        if (isLiteral) {
+            part.append(toLowerAscii(c.toLatin1()));
+            continue;
+        }
+
+        if (part.length() > longestPart.length()) {
+            longestPart = part;
+        }
+        part.clear();
+
+        if (c == QLatin1Char('[')) {
+            // Skip the character set
+            const int closingBracket = pattern.indexOf(QLatin1Char(']'), i + 2);
+            if (closingBracket < 0) {
+                break;
+            }
+            i = closingBracket;
+        }
+    }
+
+    return (part.length() > longestPart.length()) ? part : longestPart;
+}
+
+const char* FileNameSearchMatcher::findLiteral(const char* begin, const char* end) const
+{
+    const int length = m_literal.length();
+    if (length == 0) {
+        return begin;
+    }
+
+    const char* literal = m_literal.constData();
+    const char* pos = begin;
+    while (end - pos >= length) {
+        int i = length - 1;
+        while (i >= 0 && toLowerAscii(pos[i]) == literal[i]) {
+            --i;
+        }
+        if (i < 0) {
+            return pos;
+        }
+        pos += m_skipTable[static_cast<uchar>(pos[length - 1])];
+    }
+
+    return 0;
+}
+
+
+FileNameSearchEngine::FileNameSearchEngine(const QString& pattern, bool checkContent) :
+    m_matcher(pattern),
+    m_checkContent(checkContent && !pattern.isEmpty()),
+    m_canceled(0),
+    m_threadPool(),
+    m_visitedDirsMutex(),
+    m_visitedDirs(),
+    m_resultsMutex(),
+    m_resultsAvailable(),
+    m_pendingTasks(0),
+    m_results()
+{
+    // The threads are waiting for the disk most of the time,
+    // so more threads than processor cores are used.
+    m_threadPool.setMaxThreadCount(2 * qMax(1, QThread::idealThreadCount()));
+}
+
+FileNameSearchEngine::~FileNameSearchEngine()
+{
+    cancel();
+    m_threadPool.waitForDone();
+}
+
+void FileNameSearchEngine::start(const QByteArray& path)
+{
+    addTask(path);
+}
+
+void FileNameSearchEngine::cancel()
+{
+    m_canceled.fetchAndStoreOrdered(1);
+}
+
+bool FileNameSearchEngine::takeResults(QList<Result>& results, unsigned long timeout)
+{
+    QMutexLocker locker(&m_resultsMutex);
+    if (m_results.isEmpty() && m_pendingTasks > 0) {
+        m_resultsAvailable.wait(&m_resultsMutex, timeout);
+    }
+
+    const bool hasResults = !m_results.isEmpty();
+    results.append(m_results);
+    m_results.clear();
+
+    return hasResults || m_pendingTasks > 0;
+}
+
+bool FileNameSearchEngine::readDirectory(const QByteArray& path, QList<DirectoryEntry>& entries)
+{
+    DIR* dir = ::opendir(path.constData());
+    if (!dir) {
+        return false;
+    }
+
+    // Assure that no directory is searched twice, e.g. because of
+    // symbolic links that point to a parent directory.
+    KDE_struct_stat dirStat;
+    if (KDE_fstat(dirfd(dir), &dirStat) == 0) {
+        QMutexLocker locker(&m_visitedDirsMutex);
+        const QPair<quint64, quint64> id(dirStat.st_dev, dirStat.st_ino);
+        if (m_visitedDirs.contains(id)) {
+            ::closedir(dir);
+            return false;
+        }
+        m_visitedDirs.insert(id);
+    }
+
+    struct dirent* dirEntry = 0;
+    while ((dirEntry = ::readdir(dir))) {
+        if (dirEntry->d_name[0] == '.') {
+            // Skip ".", ".." and hidden files like KDirLister does per default
+            continue;
+        }
+        DirectoryEntry entry;
+        entry.name = dirEntry->d_name;
+        entry.type = dirEntry->d_type;
+        entries.append(entry);
+    }
+
+    ::closedir(dir);
+    return true;
+}
+
+void FileNameSearchEngine::searchDirectory(const QByteArray& path)
+{
+    if (m_canceled || path == "/proc" || path == "/sys") {
+        // Don't try to iterate the virtual file systems of Linux
+        return;
+    }
+
+    QList<DirectoryEntry> entries;
+    if (!readDirectory(path, entries)) {
+        return;
+    }
+
+    // QRegExp may not be used by several threads at the same time
+    const FileNameSearchMatcher matcher = m_matcher;
+
+    const QByteArray prefix = path.endsWith('/') ? path : path + '/';
+    QList<Result> results;
+
+    foreach (const DirectoryEntry& entry, entries) {
+        if (m_canceled) {
+            break;
+        }
+
+        const QByteArray childPath = prefix + entry.name;
+
+        // The type of symbolic links is determined by their target
+        unsigned char type = entry.type;
+        KDE_struct_stat statBuffer;
+        bool hasStat = false;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            hasStat = (KDE_stat(childPath.constData(), &statBuffer) == 0);
+            if (hasStat) {
+                if (S_ISDIR(statBuffer.st_mode)) {
+                    type = DT_DIR;
+                } else if (S_ISREG(statBuffer.st_mode)) {
+                    type = DT_REG;
+                }
+            }
+        }
+
+        bool matches = matcher.contains(entry.name);
+        if (!matches && m_checkContent && type == DT_REG) {
+            if (!hasStat) {
+                hasStat = (KDE_stat(childPath.constData(), &statBuffer) == 0);
+            }
+            matches = hasStat && contentContainsPattern(childPath, statBuffer.st_size, matcher);
+        }
+
+        if (matches) {
+            Result result;
+            if (createResult(childPath, result)) {
+                results.append(result);
+                if (results.count() >= ResultBatchSize) {
+                    addResults(results);
+                    results.clear();
+                }
+            }
+        }
+
+        if (type == DT_DIR) {
+            addTask(childPath);
+        }
+    }
+
+    addResults(results);
+}
+
+bool FileNameSearchEngine::contentContainsPattern(const QByteArray& path, qint64 size,
+                                                  const FileNameSearchMatcher& matcher) const
+{
+    if (size <= 0) {
+        return false;
+    }
+
+    QFile file(QFile::decodeName(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const uchar* data = file.map(0, size);
+    if (!data) {
+        return false;
+    }
+
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + size;
+
+    // Only text files are checked
+    bool contains = false;
+    if (!memchr(begin, '\0', qMin(size, qint64(BinaryCheckSize)))) {
+        contains = matcher.contains(begin, end);
+    }
+
+    file.unmap(const_cast<uchar*>(data));
+    return contains;
+}
+
+bool FileNameSearchEngine::createResult(const QByteArray& path, Result& result)
+{
+    if (KDE_lstat(path.constData(), &result.statBuffer) != 0) {
+        return false;
+    }
+
+    result.path = path;
+    if (S_ISLNK(result.statBuffer.st_mode)) {
+        char linkDest[4096];
+        const ssize_t length = ::readlink(path.constData(), linkDest, sizeof(linkDest));
+        if (length > 0) {
+            result.linkDest = QByteArray(linkDest, length);
+        }
+
+        // Like the file KIO slave, provide the information about the
+        // target if the link is not broken.
+        KDE_struct_stat targetStat;
+        if (KDE_stat(path.constData(), &targetStat) == 0) {
+            result.statBuffer = targetStat;
+        }
+    }
+
+    return true;
+}
+
+void FileNameSearchEngine::addTask(const QByteArray& path)
+{
+    if (m_canceled) {
+        return;
+    }
+
+    QMutexLocker locker(&m_resultsMutex);
+    ++m_pendingTasks;
+    locker.unlock();
+
+    m_threadPool.start(new FileNameSearchTask(this, path));
+}
+
+void FileNameSearchEngine::finishTask()
+{
+    QMutexLocker locker(&m_resultsMutex);
+    --m_pendingTasks;
+    if (m_pendingTasks == 0) {
+        m_resultsAvailable.wakeAll();
+    }
+}
+
+void FileNameSearchEngine::addResults(const QList<Result>& results)
+{
+    if (results.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_resultsMutex);
+    m_results.append(results);
+    m_resultsAvailable.wakeAll();
+}
@@ -0,0 +1,203 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+
+#ifndef FILENAMESEARCHENGINE_H
+#define FILENAMESEARCHENGINE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QRegExp>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <kde_file.h>
+
+/**
+ * @brief Checks whether names or file contents match a wildcard pattern.
+ *
+ * The pattern uses the syntax of QRegExp::Wildcard and is compared case
+ * insensitively. Like QString::contains(), a match may start at any
+ * position of a line.
+ *
+ * The longest ASCII part of the pattern that contains no wildcards is
+ * searched with a case insensitive Boyer-Moore-Horspool search directly
+ * in the undecoded data. Only lines that contain this part are decoded and
+ * checked with QRegExp. If the pattern consists of ASCII characters without
+ * wildcards, no decoding is required at all.
+ *
+ * Instances are not thread-safe, each thread must use its own copy.
+ */
+class FileNameSearchMatcher
+{
+
+public:
+    explicit FileNameSearchMatcher(const QString& pattern = QString());
+
+    /**
+     * @return True if one of the lines between \a begin and \a end
+     *         matches with the pattern.
+     */
+    bool contains(const char* begin, const char* end) const;
+    bool contains(const QByteArray& text) const;
+
+    /**
+     * @return Start of the first line between \a begin and \a end that
+     *         matches with the pattern or 0 if no line matches.
+     */
+    const char* findMatchingLine(const char* begin, const char* end) const;
+
+private:
+    /**
+     * @return The longest part of \a pattern that contains only ASCII
+     *         characters and no wildcards.
+     */
+    static QByteArray literalPart(const QString& pattern);
+
+    /**
+     * @return Start of the first occurrence of m_literal between \a begin
+     *         and \a end or 0 if m_literal does not occur.
+     */
+    const char* findLiteral(const char* begin, const char* end) const;
+
+private:
+    QByteArray m_literal; // Lowercase
+    bool m_literalOnly;   // True if the pattern is equal to m_literal
+    int m_skipTable[256];
+    QRegExp m_regExp;
+};
+
+/**
+ * @brief Searches local directories recursively for files whose names or
+ *        contents match a pattern.
+ *
+ * The directories are read by a pool of threads. Each directory is read by
+ * one task, which spawns tasks for the sub directories, so the work is
+ * distributed over all threads even for deep directory trees. Hidden files
+ * and directories are skipped like in the listings of KDirLister, and each
+ * directory is searched only once even if it is reachable by several
+ * symbolic links.
+ *
+ * The results can be fetched by takeResults() while the search is running.
+ */
+class FileNameSearchEngine
+{
+
+public:
+    struct Result
+    {
+        QByteArray path;
+        QByteArray linkDest; // Empty if the item is no symbolic link
+        KDE_struct_stat statBuffer; // Information about the link target for symbolic links
+    };
+
+    /**
+     * @param pattern      Pattern in the syntax of QRegExp::Wildcard. An empty
+     *                     pattern matches with all items.
+     * @param checkContent If true, the contents of text files are
+     *                     compared with the pattern too.
+     */
+    FileNameSearchEngine(const QString& pattern, bool checkContent);
+
+    /**
+     * Cancels the search and waits until all threads are idle.
+     */
+    ~FileNameSearchEngine();
+
+    /**
+     * Starts searching the local directory \a path.
+     */
+    void start(const QByteArray& path);
+
+    /**
+     * Stops the search as soon as possible. Results that have been
+     * found already can still be fetched.
+     */
+    void cancel();
+
+    /**
+     * Moves the results that have been found since the last invocation
+     * to \a results. Blocks until results are available, the search has
+     * been finished or \a timeout milliseconds have been passed.
+     *
+     * @return False if the search has been finished and all
+     *         results have been taken.
+     */
+    bool takeResults(QList<Result>& results, unsigned long timeout);
+
+    /**
+     * Fills \a result with the information about \a path.
+     * @return False if the information is not available.
+     */
+    static bool createResult(const QByteArray& path, Result& result);
+
+private:
+    struct DirectoryEntry
+    {
+        QByteArray name;
+        unsigned char type; // As in struct dirent::d_type
+    };
+
+    /**
+     * Reads the entries of the directory \a path, except of ".", ".."
+     * and hidden entries.
+     *
+     * @return False if the directory could not be read or has
+     *         been read already.
+     */
+    bool readDirectory(const QByteArray& path, QList<DirectoryEntry>& entries);
+
+    /**
+     * Is invoked by the tasks of m_threadPool. Passes the matching items
+     * to addResults() and adds a task for each sub directory.
+     */
+    void searchDirectory(const QByteArray& path);
+
+    /**
+     * @return True if the file \a path is a text file that contains the pattern.
+     */
+    bool contentContainsPattern(const QByteArray& path, qint64 size, const FileNameSearchMatcher& matcher) const;
+
+    void addTask(const QByteArray& path);
+    void finishTask();
+    void addResults(const QList<Result>& results);
+
+private:
+    FileNameSearchMatcher m_matcher;
+    bool m_checkContent;
+    QAtomicInt m_canceled;
+
+    QThreadPool m_threadPool;
+
+    QMutex m_visitedDirsMutex;
+    QSet<QPair<quint64, quint64> > m_visitedDirs; // Device and inode of the visited directories
+
+    QMutex m_resultsMutex; // Protects m_pendingTasks and m_results
+    QWaitCondition m_resultsAvailable;
+    int m_pendingTasks;
+    QList<Result> m_results;
+
+    friend class FileNameSearchTask;
+};
+
+#endif
@@ -19,12 +19,16 @@
 
 #include "filenamesearchprotocol.h"
 
+#include "filenameindex.h"
+
 #include <KComponentData>
 #include <KDirLister>
 #include <KFileItem>
 #include <KIO/NetAccess>
 #include <KIO/Job>
 #include <KUrl>
+#include <KStandardDirs>
+#include <KUser>
 #include <ktemporaryfile.h>
 
 #include <QCoreApplication>
@@ -35,7 +39,9 @@ FileNameSearchProtocol::FileNameSearchProtocol( const QByteArray &pool, const QB
     SlaveBase("search", pool, app),
     m_checkContent(false),
     m_regExp(0),
-    m_iteratedDirs()
+    m_iteratedDirs(),
+    m_userNames(),
+    m_groupNames()
 {
 }
 
@@ -59,13 +65,67 @@ void FileNameSearchProtocol::listDir(const KUrl& url)
         m_checkContent = true;
     }
 
-    const QString urlString = url.queryItem("url");
-    searchDirectory(KUrl(urlString));
+    const KUrl directory(url.queryItem("url"));
+    if (directory.isLocalFile()) {
+        const QString path = directory.toLocalFile(KUrl::RemoveTrailingSlash);
+        const bool useIndex = !m_checkContent && url.queryItem("useIndex") == QLatin1String("yes");
+        if (!useIndex || !searchIndex(path, search)) {
+            searchLocalDirectory(path, search);
+        }
+    } else {
+        searchDirectory(directory);
+    }
 
     cleanup();
     finished();
 }
 
+void FileNameSearchProtocol::searchLocalDirectory(const QString& path, const QString& pattern)
+{
+    FileNameSearchEngine engine(pattern, m_checkContent);
+    engine.start(QFile::encodeName(path.isEmpty() ? QLatin1String("/") : path));
+
+    QList<FileNameSearchEngine::Result> results;
+    while (engine.takeResults(results, 100)) {
+        if (wasKilled()) {
+            engine.cancel();
+            break;
+        }
+
+        if (!results.isEmpty()) {
+            foreach (const FileNameSearchEngine::Result& result, results) {
+                listEntry(createEntry(result), false);
+            }
+            listEntry(KIO::UDSEntry(), true);
+            results.clear();
+        }
+    }
+}
+
+bool FileNameSearchProtocol::searchIndex(const QString& path, const QString& pattern)
+{
+    const FileNameIndex index(KStandardDirs::locateLocal("cache", "dolphin/filenameindex"));
+
+    QList<QByteArray> paths;
+    const QByteArray directory = QFile::encodeName(path.isEmpty() ? QLatin1String("/") : path);
+    if (!index.search(directory, FileNameSearchMatcher(pattern), paths)) {
+        return false;
+    }
+
+    // The index might be outdated, so only items that still exist are listed
+    FileNameSearchEngine::Result result;
+    foreach (const QByteArray& itemPath, paths) {
+        if (wasKilled()) {
+            break;
+        }
+        if (FileNameSearchEngine::createResult(itemPath, result)) {
+            listEntry(createEntry(result), false);
+        }
+    }
+    listEntry(KIO::UDSEntry(), true);
+    return true;
+}
+
 void FileNameSearchProtocol::searchDirectory(const KUrl& directory)
 {
     if (directory.path() == QLatin1String("/proc")) {
@@ -167,6 +227,43 @@ bool FileNameSearchProtocol::contentContainsPattern(const KUrl& fileName) const
      return false;
 }
 
+KIO::UDSEntry FileNameSearchProtocol::createEntry(const FileNameSearchEngine::Result& result)
+{
+    const KDE_struct_stat& statBuffer = result.statBuffer;
+    const QString path = QFile::decodeName(result.path);
+
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, path.mid(path.lastIndexOf(QLatin1Char('/')) + 1));
+    entry.insert(KIO::UDSEntry::UDS_URL, KUrl(path).url());
+    entry.insert(KIO::UDSEntry::UDS_LOCAL_PATH, path);
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, statBuffer.st_mode & S_IFMT);
+    entry.insert(KIO::UDSEntry::UDS_ACCESS, statBuffer.st_mode & 07777);
+    entry.insert(KIO::UDSEntry::UDS_SIZE, statBuffer.st_size);
+    entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, statBuffer.st_mtime);
+    entry.insert(KIO::UDSEntry::UDS_ACCESS_TIME, statBuffer.st_atime);
+    entry.insert(KIO::UDSEntry::UDS_DEVICE_ID, statBuffer.st_dev);
+    entry.insert(KIO::UDSEntry::UDS_INODE, statBuffer.st_ino);
+    if (!result.linkDest.isEmpty()) {
+        entry.insert(KIO::UDSEntry::UDS_LINK_DEST, QFile::decodeName(result.linkDest));
+    }
+
+    // Resolving the names of users and groups is expensive, so the
+    // names are cached.
+    QHash<uid_t, QString>::const_iterator userIt = m_userNames.constFind(statBuffer.st_uid);
+    if (userIt == m_userNames.constEnd()) {
+        userIt = m_userNames.insert(statBuffer.st_uid, KUser(statBuffer.st_uid).loginName());
+    }
+    entry.insert(KIO::UDSEntry::UDS_USER, userIt.value());
+
+    QHash<gid_t, QString>::const_iterator groupIt = m_groupNames.constFind(statBuffer.st_gid);
+    if (groupIt == m_groupNames.constEnd()) {
+        groupIt = m_groupNames.insert(statBuffer.st_gid, KUserGroup(statBuffer.st_gid).name());
+    }
+    entry.insert(KIO::UDSEntry::UDS_GROUP, groupIt.value());
+
+    return entry;
+}
+
 void FileNameSearchProtocol::cleanup()
 {
     delete m_regExp;
@@ -20,8 +20,12 @@
 #ifndef FILENAMESEARCHPROTOCOL_H
 #define FILENAMESEARCHPROTOCOL_H
 
+#include "filenamesearchengine.h"
+
 #include <kio/slavebase.h>
 
+#include <QHash>
+
 class KFileItem;
 class KUrl;
 class QRegExp;
@@ -33,6 +37,12 @@ class QRegExp;
  * The directory where the searching is started is defined in the "url" query
  * item. If the query item "checkContent" is set to "yes", all files with
  * a text MIME type will be checked for the content.
+ *
+ * Local directories are searched by FileNameSearchEngine, which reads
+ * the directories and files with several threads.
+ * If the query item "useIndex" is set to "yes", the names are looked up
+ * in the FileNameIndex that is maintained by Dolphin, as long as the
+ * directory is part of the index and the contents need not be checked.
  */
 class FileNameSearchProtocol : public KIO::SlaveBase {
 public:
@@ -42,8 +52,25 @@ public:
     virtual void listDir(const KUrl& url);
 
 private:
+    /**
+     * Searches the local directory \a path with FileNameSearchEngine
+     * and lists the results as soon as they are available.
+     */
+    void searchLocalDirectory(const QString& path, const QString& pattern);
+
+    /**
+     * Lists the items below the local directory \a path whose names match
+     * \a pattern by looking them up in the FileNameIndex. Only the items
+     * that still exist are listed.
+     *
+     * @return False if \a path is not part of the index.
+     */
+    bool searchIndex(const QString& path, const QString& pattern);
+
     void searchDirectory(const KUrl& directory);
 
+    KIO::UDSEntry createEntry(const FileNameSearchEngine::Result& result);
+
     /**
      * @return True, if the pattern m_searchPattern is part of
      *         the file \a fileName.
@@ -55,6 +82,9 @@ private:
     bool m_checkContent;
     QRegExp* m_regExp;
     QSet<QString> m_iteratedDirs;
+
+    QHash<uid_t, QString> m_userNames;
+    QHash<gid_t, QString> m_groupNames;
 };
 
 #endif
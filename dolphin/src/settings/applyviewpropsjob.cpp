@@ -22,6 +22,7 @@
 
 #include "applyviewpropsjob.h"
 #include <views/viewproperties.h>
+#include <views/viewpropertiesstore.h>
 
 ApplyViewPropsJob::ApplyViewPropsJob(const KUrl& dir,
                                      const ViewProperties& viewProps) :
@@ -37,6 +38,10 @@ ApplyViewPropsJob::ApplyViewPropsJob(const KUrl& dir,
     m_viewProps->setSortRole(viewProps.sortRole());
     m_viewProps->setSortOrder(viewProps.sortOrder());
 
+    // The cached properties of all directories are written at once
+    // when the job is deleted.
+    ViewPropertiesStore::instance()->beginBatch();
+
     KIO::ListJob* listJob = KIO::listRecursive(dir, KIO::HideProgressInfo);
     connect(listJob, SIGNAL(entries(KIO::Job*,KIO::UDSEntryList)),
             SLOT(slotEntries(KIO::Job*,KIO::UDSEntryList)));
@@ -47,6 +52,8 @@ ApplyViewPropsJob::~ApplyViewPropsJob()
 {
     delete m_viewProps;  // the properties are written by the destructor
     m_viewProps = 0;
+
+    ViewPropertiesStore::instance()->endBatch();
 }
 
 void ApplyViewPropsJob::slotEntries(KIO::Job*, const KIO::UDSEntryList& list)
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "search/filenameindex.h"
+#include "search/filenamesearchengine.h"
+
+#include <KTempDir>
+
+#include <QFileInfo>
+
+namespace {
+    // The synthetic tree contains DirectoryCount directories below the
+    // root, and each directory contains FilesPerDirectory files, so the
+    // index contains 1000000 items.
+    const int DirectoryCount = 1000;
+    const int FilesPerDirectory = 999;
+};
+
+class FileNameIndexBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void save();
+
+    void search_data();
+    void search();
+
+private:
+    /**
+     * Fills \a builder with the synthetic tree.
+     */
+    static void createTree(FileNameIndex::Builder& builder);
+
+    KTempDir* m_tempDir;
+    QString m_indexFileName;
+};
+
+void FileNameIndexBenchmark::initTestCase()
+{
+    m_tempDir = new KTempDir();
+    m_indexFileName = m_tempDir->name() + "filenameindex";
+
+    FileNameIndex::Builder builder;
+    createTree(builder);
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(index.save("/home/user", builder));
+    QCOMPARE(index.count(), DirectoryCount * (FilesPerDirectory + 1));
+}
+
+void FileNameIndexBenchmark::cleanupTestCase()
+{
+    delete m_tempDir;
+    m_tempDir = 0;
+}
+
+void FileNameIndexBenchmark::save()
+{
+    FileNameIndex::Builder builder;
+    createTree(builder);
+
+    FileNameIndex index(m_tempDir->name() + "savedindex");
+    QBENCHMARK_ONCE {
+        index.save("/home/user", builder);
+    }
+
+    qDebug() << "Index file size:" << QFileInfo(m_tempDir->name() + "savedindex").size() << "bytes";
+}
+
+void FileNameIndexBenchmark::search_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QByteArray>("directory");
+    QTest::addColumn<int>("expectedCount");
+
+    QTest::newRow("Single item") << "Report-123-456" << QByteArray("/home/user") << 1;
+    QTest::newRow("No match") << "nothing" << QByteArray("/home/user") << 0;
+    QTest::newRow("Literal") << "report-123-" << QByteArray("/home/user") << FilesPerDirectory;
+    QTest::newRow("Wildcard") << "*-12?.png" << QByteArray("/home/user") << DirectoryCount * 3;
+    QTest::newRow("Sub directory") << "*.txt" << QByteArray("/home/user/Folder 500") << FilesPerDirectory / 3;
+}
+
+void FileNameIndexBenchmark::search()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QByteArray, directory);
+    QFETCH(int, expectedCount);
+
+    const FileNameIndex index(m_indexFileName);
+    const FileNameSearchMatcher matcher(pattern);
+    QList<QByteArray> paths;
+
+    QBENCHMARK {
+        paths.clear();
+        index.search(directory, matcher, paths);
+    }
+
+    QCOMPARE(paths.count(), expectedCount);
+}
+
+void FileNameIndexBenchmark::createTree(FileNameIndex::Builder& builder)
+{
+    const char* extensions[] = { ".txt", ".png", ".pdf" };
+    for (int i = 0; i < DirectoryCount; ++i) {
+        const quint32 dir = builder.addEntry(FileNameIndex::NoParent, "Folder " + QByteArray::number(i), true);
+        for (int j = 0; j < FilesPerDirectory; ++j) {
+            const QByteArray name = "Report-" + QByteArray::number(i) + '-' + QByteArray::number(j) + extensions[j % 3];
+            builder.addEntry(dir, name, false);
+        }
+    }
+}
+
+QTEST_KDEMAIN(FileNameIndexBenchmark, NoGUI)
+
+#include "filenameindexbenchmark.moc"
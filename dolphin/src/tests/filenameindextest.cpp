@@ -0,0 +1,241 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "search/filenameindex.h"
+#include "search/filenamesearchengine.h"
+
+#include "testdir.h"
+
+#include <KTempDir>
+
+#include <QDir>
+#include <QFile>
+
+class FileNameIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testBuild();
+    void testSearchSubDirectory();
+    void testUpdate();
+    void testUpdateRemovedDirectory();
+    void testBuilder();
+    void testWatchedDirectories();
+
+private:
+    /**
+     * @return Sorted paths of the items below \a directory that match
+     *         \a pattern, relative to m_testDir.
+     */
+    QStringList search(const FileNameIndex& index, const QString& pattern,
+                       const QString& directory = QString()) const;
+
+    QByteArray rootPath() const;
+
+    TestDir* m_testDir;
+    KTempDir* m_indexDir;
+    QString m_indexFileName;
+};
+
+void FileNameIndexTest::init()
+{
+    m_testDir = new TestDir();
+    m_testDir->createFiles(QStringList() << "a.txt" << "b.txt" << "c.png"
+                                         << "sub/d.txt" << "sub/sub/e.TXT"
+                                         << ".hidden.txt" << ".hiddenDir/f.txt");
+    m_testDir->createDir("sub.txt");
+
+    m_indexDir = new KTempDir();
+    m_indexFileName = m_indexDir->name() + "filenameindex";
+}
+
+void FileNameIndexTest::cleanup()
+{
+    delete m_testDir;
+    m_testDir = 0;
+    delete m_indexDir;
+    m_indexDir = 0;
+}
+
+void FileNameIndexTest::testBuild()
+{
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(!index.isValid());
+
+    QVERIFY(index.build(rootPath()));
+    QVERIFY(index.isValid());
+    QCOMPARE(index.rootPath(), rootPath());
+    QCOMPARE(index.count(), 8);
+
+    // The results must be equal to the results of FileNameSearchEngine
+    QCOMPARE(search(index, "*.txt"), QStringList() << "a.txt" << "b.txt" << "sub.txt" << "sub/d.txt" << "sub/sub/e.TXT");
+    QCOMPARE(search(index, "sub"), QStringList() << "sub" << "sub.txt" << "sub/sub");
+    QCOMPARE(search(index, "nothing"), QStringList());
+
+    // The index must be available for other instances
+    const FileNameIndex loadedIndex(m_indexFileName);
+    QVERIFY(loadedIndex.isValid());
+    QCOMPARE(loadedIndex.count(), 8);
+    QCOMPARE(search(loadedIndex, QString()).count(), 8);
+}
+
+void FileNameIndexTest::testSearchSubDirectory()
+{
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(index.build(rootPath()));
+
+    QCOMPARE(search(index, "*.txt", "sub"), QStringList() << "sub/d.txt" << "sub/sub/e.TXT");
+    QCOMPARE(search(index, "*.txt", "sub/"), QStringList() << "sub/d.txt" << "sub/sub/e.TXT");
+    QCOMPARE(search(index, QString(), "sub/sub"), QStringList() << "sub/sub/e.TXT");
+    QCOMPARE(search(index, QString(), "sub.txt"), QStringList());
+
+    // Directories outside of the index and hidden directories are not part of the index
+    QList<QByteArray> paths;
+    QVERIFY(!index.search(QFile::encodeName(QDir::rootPath()), FileNameSearchMatcher(), paths));
+    QVERIFY(!index.search(rootPath() + "/.hiddenDir", FileNameSearchMatcher(), paths));
+    QVERIFY(!index.search(rootPath() + "/a.txt/x", FileNameSearchMatcher(), paths));
+    QVERIFY(paths.isEmpty());
+}
+
+void FileNameIndexTest::testUpdate()
+{
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(index.build(rootPath()));
+
+    m_testDir->createFiles(QStringList() << "sub/g.txt" << "new/h.txt" << "new/new/i.txt");
+    m_testDir->removeFile("a.txt");
+    QVERIFY(index.update(QList<QByteArray>() << rootPath() + "/sub/" << rootPath()));
+
+    QCOMPARE(search(index, "*.txt"), QStringList() << "b.txt" << "new/h.txt" << "new/new/i.txt"
+                                                   << "sub.txt" << "sub/d.txt" << "sub/g.txt" << "sub/sub/e.TXT");
+    QCOMPARE(search(index, "*", "sub"), QStringList() << "sub/d.txt" << "sub/g.txt" << "sub/sub" << "sub/sub/e.TXT");
+
+    // Directories that are not part of the index are ignored
+    QVERIFY(index.update(QList<QByteArray>() << "/nonexistent" << rootPath() + "/.hiddenDir"));
+    QCOMPARE(index.count(), 12);
+}
+
+void FileNameIndexTest::testUpdateRemovedDirectory()
+{
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(index.build(rootPath()));
+
+    // A removed directory must result in reading its parent again
+    m_testDir->removeFile("sub/sub/e.TXT");
+    QVERIFY(QDir(m_testDir->name()).rmdir("sub/sub"));
+    QVERIFY(index.update(QList<QByteArray>() << rootPath() + "/sub/sub"));
+
+    QCOMPARE(search(index, "*", "sub"), QStringList() << "sub/d.txt");
+    QCOMPARE(index.count(), 6);
+}
+
+void FileNameIndexTest::testBuilder()
+{
+    FileNameIndex::Builder builder;
+    const quint32 dir = builder.addEntry(FileNameIndex::NoParent, "dir", true);
+    const quint32 subDir = builder.addEntry(dir, "subdir", true);
+    builder.addEntry(subDir, "a.txt", false);
+    builder.addEntry(dir, "b.txt", false);
+    builder.addEntry(FileNameIndex::NoParent, "c.txt", false);
+    QCOMPARE(builder.count(), 5);
+
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(index.save("/root", builder));
+    QCOMPARE(index.rootPath(), QByteArray("/root"));
+
+    QList<QByteArray> paths;
+    QVERIFY(index.search("/root/dir", FileNameSearchMatcher("*.txt"), paths));
+    QCOMPARE(paths, QList<QByteArray>() << "/root/dir/subdir/a.txt" << "/root/dir/b.txt");
+
+    paths.clear();
+    QVERIFY(index.search("/root", FileNameSearchMatcher("c"), paths));
+    QCOMPARE(paths, QList<QByteArray>() << "/root/c.txt");
+
+    QCOMPARE(index.watchedDirectories(), QList<QByteArray>() << "/root" << "/root/dir" << "/root/dir/subdir");
+}
+
+void FileNameIndexTest::testWatchedDirectories()
+{
+    // The directories "/root/dir<n>" fit into the limit of watched
+    // directories, but their sub directories don't.
+    FileNameIndex::Builder builder;
+    const int dirCount = FileNameIndex::MaxWatchedDirectories / 2;
+    for (int i = 0; i < dirCount; ++i) {
+        const quint32 dir = builder.addEntry(FileNameIndex::NoParent, "dir" + QByteArray::number(i), true);
+        const quint32 subDir = builder.addEntry(dir, "subdir", true);
+        builder.addEntry(subDir, "a.txt", false);
+        builder.addEntry(dir, "b.txt", false);
+    }
+
+    FileNameIndex index(m_indexFileName);
+    QVERIFY(index.save("/root", builder));
+
+    const QList<QByteArray> watchedDirectories = index.watchedDirectories();
+    QCOMPARE(watchedDirectories.count(), dirCount + 1);
+    QCOMPARE(watchedDirectories.first(), QByteArray("/root"));
+    QCOMPARE(watchedDirectories.last(), "/root/dir" + QByteArray::number(dirCount - 1));
+
+    // The items below unwatched directories are found as well
+    QList<QByteArray> paths;
+    QVERIFY(index.search("/root/dir0", FileNameSearchMatcher("*.txt"), paths));
+    QCOMPARE(paths, QList<QByteArray>() << "/root/dir0/subdir/a.txt" << "/root/dir0/b.txt");
+
+    paths.clear();
+    QVERIFY(index.search("/root", FileNameSearchMatcher("a.txt"), paths));
+    QCOMPARE(paths.count(), dirCount);
+
+    paths.clear();
+    QVERIFY(index.search("/root/dir0/subdir", FileNameSearchMatcher(), paths));
+    QCOMPARE(paths, QList<QByteArray>() << "/root/dir0/subdir/a.txt");
+}
+
+QStringList FileNameIndexTest::search(const FileNameIndex& index, const QString& pattern,
+                                      const QString& directory) const
+{
+    QList<QByteArray> results;
+    const QByteArray path = directory.isEmpty() ? rootPath() : rootPath() + '/' + QFile::encodeName(directory);
+    if (!index.search(path, FileNameSearchMatcher(pattern), results)) {
+        return QStringList();
+    }
+
+    const int prefixLength = rootPath().length() + 1;
+    QStringList paths;
+    foreach (const QByteArray& result, results) {
+        paths.append(QFile::decodeName(result.mid(prefixLength)));
+    }
+    paths.sort();
+    return paths;
+}
+
+QByteArray FileNameIndexTest::rootPath() const
+{
+    QByteArray path = QFile::encodeName(m_testDir->name());
+    path.chop(1); // Remove the trailing slash
+    return path;
+}
+
+QTEST_KDEMAIN(FileNameIndexTest, NoGUI)
+
+#include "filenameindextest.moc"
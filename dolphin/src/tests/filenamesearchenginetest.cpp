@@ -0,0 +1,149 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+
+#include <qtest_kde.h>
+
+#include "search/filenamesearchengine.h"
+
+#include "testdir.h"
+
+#include <QFile>
+
+class FileNameSearchEngineTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testMatcher_data();
+    void testMatcher();
+    void testSearchNames();
+    void testSearchContent();
+    void testSymbolicLinkLoop();
+
+private:
+    /**
+     * @return Sorted paths of the results relative to m_testDir.
+     */
+    QStringList search(const QString& pattern, bool checkContent) const;
+
+    TestDir* m_testDir;
+};
+
+void FileNameSearchEngineTest::init()
+{
+    m_testDir = new TestDir();
+}
+
+void FileNameSearchEngineTest::cleanup()
+{
+    delete m_testDir;
+    m_testDir = 0;
+}
+
+void FileNameSearchEngineTest::testMatcher_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<bool>("expectedResult");
+
+    QTest::newRow("Empty pattern") << QString() << QByteArray("abc") << true;
+    QTest::newRow("Substring") << "bc" << QByteArray("abcd") << true;
+    QTest::newRow("Case insensitive") << "BcD" << QByteArray("abCd") << true;
+    QTest::newRow("No match") << "bd" << QByteArray("abcd") << false;
+    QTest::newRow("Pattern longer than text") << "abcde" << QByteArray("abcd") << false;
+    QTest::newRow("Second line") << "line" << QByteArray("first\nsecond line") << true;
+    QTest::newRow("Wildcard") << "a*d" << QByteArray("xabcdx") << true;
+    QTest::newRow("Wildcard with case") << "A?C" << QByteArray("abc") << true;
+    QTest::newRow("Wildcard on other line") << "a*d" << QByteArray("xa\nd") << false;
+    QTest::newRow("Wildcard after candidate") << "b*z" << QByteArray("b\nbz") << true;
+    QTest::newRow("Character set") << "[xb]c" << QByteArray("abc") << true;
+}
+
+void FileNameSearchEngineTest::testMatcher()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QByteArray, text);
+    QFETCH(bool, expectedResult);
+
+    const FileNameSearchMatcher matcher(pattern);
+    QCOMPARE(matcher.contains(text), expectedResult);
+}
+
+void FileNameSearchEngineTest::testSearchNames()
+{
+    m_testDir->createFiles(QStringList() << "a.txt" << "b.txt" << "c.png"
+                                         << "sub/d.txt" << "sub/sub/e.TXT"
+                                         << ".hidden.txt" << ".hiddenDir/f.txt");
+    m_testDir->createDir("sub.txt");
+
+    QCOMPARE(search("*.txt", false), QStringList() << "a.txt" << "b.txt" << "sub.txt" << "sub/d.txt" << "sub/sub/e.TXT");
+    QCOMPARE(search("sub", false), QStringList() << "sub" << "sub.txt" << "sub/sub");
+    QCOMPARE(search(QString(), false).count(), 8);
+}
+
+void FileNameSearchEngineTest::testSearchContent()
+{
+    m_testDir->createFile("a.txt", "first line\nsecond Line with Pattern\n");
+    m_testDir->createFile("b.txt", "no match");
+    m_testDir->createFile("pattern.txt", "no match");
+    m_testDir->createFile("sub/c.txt", "PATTERN");
+    m_testDir->createFile("d.bin", QByteArray("pattern\0binary", 14));
+
+    QCOMPARE(search("pattern", false), QStringList() << "pattern.txt");
+    QCOMPARE(search("pattern", true), QStringList() << "a.txt" << "pattern.txt" << "sub/c.txt");
+    QCOMPARE(search("with*pattern", true), QStringList() << "a.txt");
+}
+
+void FileNameSearchEngineTest::testSymbolicLinkLoop()
+{
+    m_testDir->createFile("sub/a.txt");
+
+    const QString subDir = m_testDir->name() + "sub";
+    QVERIFY(QFile::link(subDir, subDir + "/loop"));
+
+    // The directory "sub" must only be searched once
+    const QStringList results = search("a.txt", false);
+    QCOMPARE(results.count(), 1);
+}
+
+QStringList FileNameSearchEngineTest::search(const QString& pattern, bool checkContent) const
+{
+    FileNameSearchEngine engine(pattern, checkContent);
+    engine.start(QFile::encodeName(m_testDir->name()));
+
+    QList<FileNameSearchEngine::Result> results;
+    while (engine.takeResults(results, 1000)) {
+    }
+
+    const int prefixLength = QFile::encodeName(m_testDir->name()).length();
+    QStringList paths;
+    foreach (const FileNameSearchEngine::Result& result, results) {
+        paths.append(QFile::decodeName(result.path.mid(prefixLength)));
+    }
+    paths.sort();
+    return paths;
+}
+
+QTEST_KDEMAIN(FileNameSearchEngineTest, NoGUI)
+
+#include "filenamesearchenginetest.moc"
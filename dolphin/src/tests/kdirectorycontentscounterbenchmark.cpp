@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/kfileitemmodel.h"
+#include "kitemviews/private/kdirectorycontentscounter.h"
+
+#include "testdir.h"
+
+#include <QDir>
+#include <QSignalSpy>
+
+namespace {
+    const int DirectoryCount = 10000;
+};
+
+class KDirectoryContentsCounterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void countDirectories_data();
+    void countDirectories();
+
+private:
+    TestDir* m_testDir;
+    QStringList m_paths;
+};
+
+void KDirectoryContentsCounterBenchmark::initTestCase()
+{
+    // Create a tree with DirectoryCount directories, which contain between
+    // 0 and 3 files each.
+    m_testDir = new TestDir();
+    const QDir dir(m_testDir->name());
+    for (int i = 0; i < DirectoryCount; ++i) {
+        const QString name = QString("dir%1").arg(i);
+        QVERIFY(dir.mkdir(name));
+
+        const QString path = dir.absoluteFilePath(name);
+        for (int j = 0; j < i % 4; ++j) {
+            m_testDir->createFile(path + QString("/file%1").arg(j));
+        }
+        m_paths.append(path);
+    }
+}
+
+void KDirectoryContentsCounterBenchmark::cleanupTestCase()
+{
+    delete m_testDir;
+    m_testDir = 0;
+    m_paths.clear();
+}
+
+void KDirectoryContentsCounterBenchmark::countDirectories_data()
+{
+    QTest::addColumn<int>("workerCount");
+
+    QTest::newRow("1 worker") << 1;
+    QTest::newRow("2 workers") << 2;
+    QTest::newRow("4 workers") << 4;
+    QTest::newRow("8 workers") << 8;
+}
+
+void KDirectoryContentsCounterBenchmark::countDirectories()
+{
+    QFETCH(int, workerCount);
+
+    KFileItemModel model;
+    KDirectoryContentsCounter counter(&model);
+    counter.setMaximumWorkerCount(workerCount);
+    QCOMPARE(counter.maximumWorkerCount(), workerCount);
+
+    QSignalSpy spy(&counter, SIGNAL(result(QString,int)));
+    QBENCHMARK {
+        spy.clear();
+        foreach (const QString& path, m_paths) {
+            counter.addDirectory(path);
+        }
+        while (spy.count() < DirectoryCount) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+
+    int totalCount = 0;
+    for (int i = 0; i < spy.count(); ++i) {
+        totalCount += spy.at(i).at(1).toInt();
+    }
+    QCOMPARE(totalCount, (DirectoryCount / 4) * (0 + 1 + 2 + 3));
+}
+
+QTEST_KDEMAIN(KDirectoryContentsCounterBenchmark, NoGUI)
+
+#include "kdirectorycontentscounterbenchmark.moc"
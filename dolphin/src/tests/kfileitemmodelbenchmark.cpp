@@ -63,6 +63,11 @@ private slots:
     void insertAndRemoveManyItems_data();
     void insertAndRemoveManyItems();
     void insertManyChildItems();
+    void bytesPerItem_data();
+    void bytesPerItem();
+    void parallelMergeSort_data();
+    void parallelMergeSort();
+    void typeNameFilter();
 
 private:
     static KFileItemList createFileItemList(const QStringList& fileNames, const QString& urlPrefix = QLatin1String("file:///"));
@@ -315,6 +320,146 @@ void KFileItemModelBenchmark::insertManyChildItems()
 #endif
 }
 
+void KFileItemModelBenchmark::bytesPerItem_data()
+{
+    QTest::addColumn<int>("itemCount");
+
+    QList<int> sizes;
+    sizes << 1000 << 16000 << 256000;
+
+    foreach (int n, sizes) {
+        const int bufferSize = 128;
+        char buffer[bufferSize];
+        snprintf(buffer, bufferSize, "n=%i", n);
+        QTest::newRow(buffer) << n;
+    }
+}
+
+void KFileItemModelBenchmark::bytesPerItem()
+{
+    QFETCH(int, itemCount);
+
+    QStringList allStrings;
+    for (int i = 0; i < itemCount; ++i) {
+        allStrings << QString::number(i);
+    }
+    allStrings.sort();
+
+    KFileItemModel model;
+    model.m_naturalSorting = false;
+    model.setRoles(QSet<QByteArray>() << "text" << "isDir" << "isLink" << "size" << "date" << "type");
+
+    model.slotItemsAdded(model.directory(), createFileItemList(allStrings));
+    model.slotCompleted();
+    QCOMPARE(model.count(), itemCount);
+
+    // Before the role values have been stored in a KFileItemModelRoleStore, each
+    // ItemData contained a QHash<QByteArray, QVariant>. Calculate the memory that
+    // these hashes would need for the same items. Like in
+    // KFileItemModelRoleStore::memoryUsage(), the heap memory of implicitly shared
+    // values is not counted.
+    qint64 hashBytes = 0;
+    for (int i = 0; i < model.count(); ++i) {
+        const KFileItemModel::ItemData* itemData = model.m_itemData.at(i);
+        QHash<QByteArray, QVariant> values = model.retrieveData(itemData->item, itemData->parent);
+        values.insert("url", itemData->item.url());
+        hashBytes += sizeof(QHash<QByteArray, QVariant>)
+                     + sizeof(QHashData)
+                     + values.capacity() * sizeof(void*)
+                     + values.count() * sizeof(QHashNode<QByteArray, QVariant>);
+    }
+
+    const qint64 storeBytes = model.m_roleStore.memoryUsage() + model.count() * sizeof(int);
+
+    printf("%i items: %lld bytes per item with a QHash per item, %lld bytes per item with KFileItemModelRoleStore\n",
+           itemCount,
+           static_cast<long long>(hashBytes / itemCount),
+           static_cast<long long>(storeBytes / itemCount));
+
+    QVERIFY(storeBytes < hashBytes);
+}
+
+void KFileItemModelBenchmark::parallelMergeSort_data()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::addColumn<int>("threadCount");
+
+    QList<int> sizes;
+    sizes << 10000 << 100000 << 1000000;
+
+    QList<int> threadCounts;
+    threadCounts << 1 << 2 << 4 << 8;
+
+    foreach (int n, sizes) {
+        foreach (int threads, threadCounts) {
+            const int bufferSize = 128;
+            char buffer[bufferSize];
+            snprintf(buffer, bufferSize, "n=%i, threads=%i", n, threads);
+            QTest::newRow(buffer) << n << threads;
+        }
+    }
+}
+
+void KFileItemModelBenchmark::parallelMergeSort()
+{
+    QFETCH(int, itemCount);
+    QFETCH(int, threadCount);
+
+    QStringList unsortedStrings;
+    for (int i = 0; i < itemCount; ++i) {
+        unsortedStrings << QString("file-%1.txt").arg(i);
+    }
+
+    KRandomSequence randomSequence(0);
+    randomSequence.randomize(unsortedStrings);
+
+    QStringList expectedStrings = unsortedStrings;
+    qStableSort(expectedStrings.begin(), expectedStrings.end());
+
+    KFileItemModelSortEngine engine(threadCount);
+    QCOMPARE(engine.threadCount(), threadCount);
+
+    QStringList strings;
+    QBENCHMARK {
+        strings = unsortedStrings;
+        ::parallelMergeSort(strings.begin(), strings.end(), qLess<QString>(), &engine);
+    }
+
+    QCOMPARE(strings, expectedStrings);
+}
+
+void KFileItemModelBenchmark::typeNameFilter()
+{
+    const int itemCount = 200000;
+
+    QStringList allStrings;
+    for (int i = 0; i < itemCount; ++i) {
+        allStrings << QString("File-%1.txt").arg(i);
+    }
+    allStrings.sort();
+
+    KFileItemModel model;
+    model.m_naturalSorting = false;
+    model.setRoles(QSet<QByteArray>() << "text");
+    model.slotItemsAdded(model.directory(), createFileItemList(allStrings));
+    model.slotCompleted();
+    QCOMPARE(model.count(), itemCount);
+
+    // Simulate typing a pattern into the filter bar character by
+    // character and removing it again with backspace.
+    const QString pattern = "file-1234";
+    QBENCHMARK {
+        for (int length = 1; length <= pattern.length(); ++length) {
+            model.setNameFilter(pattern.left(length));
+        }
+        QCOMPARE(model.count(), 111); // File-1234, File-1234x and File-1234xx
+        for (int length = pattern.length() - 1; length >= 0; --length) {
+            model.setNameFilter(pattern.left(length));
+        }
+        QCOMPARE(model.count(), itemCount);
+    }
+}
+
 KFileItemList KFileItemModelBenchmark::createFileItemList(const QStringList& fileNames, const QString& prefix)
 {
     // Suppress 'file does not exist anymore' messages from KFileItemPrivate::init().
@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kfileitemmodelfilter.h"
+#include "testdir.h"
+
+#include <KFileItem>
+
+Q_DECLARE_METATYPE(KFileItemModelFilter::FilterChange)
+
+class KFileItemModelFilterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testMatchesPattern();
+    void testPatternChange_data();
+    void testPatternChange();
+    void testMimeTypesChange_data();
+    void testMimeTypesChange();
+};
+
+void KFileItemModelFilterTest::testMatchesPattern()
+{
+    KFileItemModelFilter filter;
+    QVERIFY(filter.matches(TestDir::createFileItem("Abc.txt")));
+
+    filter.setPattern("bC");
+    QVERIFY(filter.matches(TestDir::createFileItem("Abc.txt")));
+    QVERIFY(filter.matches(TestDir::createFileItem("Abc.txt"), "abc.txt"));
+    QVERIFY(!filter.matches(TestDir::createFileItem("Acb.txt")));
+    QVERIFY(!filter.matches(TestDir::createFileItem("Acb.txt"), "acb.txt"));
+
+    filter.setPattern("*.TXT");
+    QVERIFY(filter.matches(TestDir::createFileItem("Abc.txt"), "abc.txt"));
+    QVERIFY(!filter.matches(TestDir::createFileItem("Abc.png"), "abc.png"));
+}
+
+void KFileItemModelFilterTest::testPatternChange_data()
+{
+    QTest::addColumn<QString>("previousPattern");
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<KFileItemModelFilter::FilterChange>("expectedChange");
+
+    QTest::newRow("Set pattern") << QString() << "a" << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Clear pattern") << "a" << QString() << KFileItemModelFilter::WideningChange;
+    QTest::newRow("Append character") << "ab" << "abc" << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Prepend character") << "ab" << "Xab" << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Remove character") << "abc" << "ab" << KFileItemModelFilter::WideningChange;
+    QTest::newRow("Change case") << "abc" << "ABC" << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Replace character") << "abc" << "abd" << KFileItemModelFilter::ArbitraryChange;
+    QTest::newRow("Set wildcard") << QString() << "*.txt" << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Append to wildcard") << "*.tx" << "*.txt" << KFileItemModelFilter::ArbitraryChange;
+    QTest::newRow("Clear wildcard") << "*.txt" << QString() << KFileItemModelFilter::WideningChange;
+}
+
+void KFileItemModelFilterTest::testPatternChange()
+{
+    QFETCH(QString, previousPattern);
+    QFETCH(QString, pattern);
+    QFETCH(KFileItemModelFilter::FilterChange, expectedChange);
+
+    KFileItemModelFilter filter;
+    filter.setPattern(previousPattern);
+    QCOMPARE(filter.setPattern(pattern), expectedChange);
+}
+
+void KFileItemModelFilterTest::testMimeTypesChange_data()
+{
+    QTest::addColumn<QStringList>("previousMimeTypes");
+    QTest::addColumn<QStringList>("mimeTypes");
+    QTest::addColumn<KFileItemModelFilter::FilterChange>("expectedChange");
+
+    const QString text = "text/plain";
+    const QString image = "image/png";
+    const QString video = "video/mpeg";
+
+    QTest::newRow("Set types") << QStringList() << (QStringList() << text) << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Clear types") << (QStringList() << text) << QStringList() << KFileItemModelFilter::WideningChange;
+    QTest::newRow("Remove type") << (QStringList() << text << image) << (QStringList() << image) << KFileItemModelFilter::NarrowingChange;
+    QTest::newRow("Add type") << (QStringList() << text) << (QStringList() << image << text) << KFileItemModelFilter::WideningChange;
+    QTest::newRow("Replace type") << (QStringList() << text << image) << (QStringList() << text << video) << KFileItemModelFilter::ArbitraryChange;
+}
+
+void KFileItemModelFilterTest::testMimeTypesChange()
+{
+    QFETCH(QStringList, previousMimeTypes);
+    QFETCH(QStringList, mimeTypes);
+    QFETCH(KFileItemModelFilter::FilterChange, expectedChange);
+
+    KFileItemModelFilter filter;
+    filter.setMimeTypes(previousMimeTypes);
+    QCOMPARE(filter.setMimeTypes(mimeTypes), expectedChange);
+}
+
+QTEST_KDEMAIN(KFileItemModelFilterTest, NoGUI)
+
+#include "kfileitemmodelfiltertest.moc"
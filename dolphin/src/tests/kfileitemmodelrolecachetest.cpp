@@ -0,0 +1,187 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kfileitemmodelrolecache.h"
+#include "testdir.h"
+
+#include <KFileItem>
+#include <KTempDir>
+
+class KFileItemModelRoleCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testLookup();
+    void testModifiedFile();
+    void testNonLocalFile();
+    void testSaveAndLoad();
+    void testBackgroundSave();
+
+private:
+    KTempDir* m_tempDir;
+    QString m_cacheFileName;
+};
+
+void KFileItemModelRoleCacheTest::init()
+{
+    m_tempDir = new KTempDir();
+    m_cacheFileName = m_tempDir->name() + "rolecache";
+}
+
+void KFileItemModelRoleCacheTest::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = 0;
+}
+
+void KFileItemModelRoleCacheTest::testLookup()
+{
+    KFileItemModelRoleCache cache(m_cacheFileName);
+
+    const KFileItem item = TestDir::createFileItem("a.txt", 1000, 10, 1);
+    KFileItemModelRoleCache::Entry entry;
+    QVERIFY(!cache.lookup(item, entry));
+
+    cache.setIconNameAndType(item, "text-plain", "Plain Text Document");
+    QVERIFY(cache.lookup(item, entry));
+    QCOMPARE(entry.iconName, QString("text-plain"));
+    QCOMPARE(entry.type, QString("Plain Text Document"));
+    QCOMPARE(entry.itemCount, -1);
+
+    const KFileItem dir = TestDir::createFileItem("dir", 1000, 4096, 2);
+    cache.setItemCount(dir, 42, 0);
+    QVERIFY(cache.lookup(dir, entry));
+    QVERIFY(entry.iconName.isEmpty());
+    QCOMPARE(entry.itemCount, 42);
+
+    QCOMPARE(cache.count(), 2);
+}
+
+void KFileItemModelRoleCacheTest::testModifiedFile()
+{
+    KFileItemModelRoleCache cache(m_cacheFileName);
+
+    const KFileItem item = TestDir::createFileItem("a.txt", 1000, 10, 1);
+    cache.setIconNameAndType(item, "text-plain", "Plain Text Document");
+
+    // A changed modification time or size must invalidate the entry.
+    KFileItemModelRoleCache::Entry entry;
+    QVERIFY(!cache.lookup(TestDir::createFileItem("a.txt", 2000, 10, 1), entry));
+    QVERIFY(!cache.lookup(TestDir::createFileItem("a.txt", 1000, 20, 1), entry));
+
+    // Storing a role for the modified file must not keep the other roles.
+    const KFileItem modifiedItem = TestDir::createFileItem("a.txt", 2000, 10, 1);
+    cache.setItemCount(modifiedItem, 3, 0);
+    QVERIFY(cache.lookup(modifiedItem, entry));
+    QVERIFY(entry.iconName.isEmpty());
+    QCOMPARE(entry.itemCount, 3);
+}
+
+void KFileItemModelRoleCacheTest::testNonLocalFile()
+{
+    KFileItemModelRoleCache cache(m_cacheFileName);
+
+    const KFileItem item = TestDir::createFileItem("a.txt", 1000, 10, 1, "ftp://host/");
+    cache.setIconNameAndType(item, "text-plain", "Plain Text Document");
+
+    KFileItemModelRoleCache::Entry entry;
+    QVERIFY(!cache.lookup(item, entry));
+    QCOMPARE(cache.count(), 0);
+}
+
+void KFileItemModelRoleCacheTest::testSaveAndLoad()
+{
+    const int itemCount = 1000;
+
+    {
+        KFileItemModelRoleCache cache(m_cacheFileName);
+        for (int i = 0; i < itemCount; ++i) {
+            const KFileItem item = TestDir::createFileItem(QString::number(i), 1000, i, i + 1);
+            cache.setIconNameAndType(item, (i % 2) ? "text-plain" : "image-png", "Type");
+        }
+        QVERIFY(cache.save());
+        QCOMPARE(cache.count(), itemCount);
+    }
+
+    KFileItemModelRoleCache cache(m_cacheFileName);
+    QCOMPARE(cache.count(), itemCount);
+
+    KFileItemModelRoleCache::Entry entry;
+    for (int i = 0; i < itemCount; ++i) {
+        const KFileItem item = TestDir::createFileItem(QString::number(i), 1000, i, i + 1);
+        QVERIFY(cache.lookup(item, entry));
+        QCOMPARE(entry.iconName, QString((i % 2) ? "text-plain" : "image-png"));
+        QCOMPARE(entry.type, QString("Type"));
+    }
+
+    // Entries that are changed after loading the file must be merged with
+    // the entries of the file when saving again.
+    cache.setItemCount(TestDir::createFileItem("dir", 1000, 4096, itemCount + 1), 5, 1);
+    QVERIFY(cache.save());
+    QCOMPARE(cache.count(), itemCount + 1);
+
+    QVERIFY(cache.lookup(TestDir::createFileItem("0", 1000, 0, 1), entry));
+    QCOMPARE(entry.iconName, QString("image-png"));
+
+    // The options that have been used for counting must be kept
+    KFileItemModelRoleCache savedCache(m_cacheFileName);
+    QVERIFY(savedCache.lookup(TestDir::createFileItem("dir", 1000, 4096, itemCount + 1), entry));
+    QCOMPARE(entry.itemCount, 5);
+    QCOMPARE(entry.itemCountOptions, 1);
+}
+
+void KFileItemModelRoleCacheTest::testBackgroundSave()
+{
+    KFileItemModelRoleCache cache(m_cacheFileName);
+    cache.setIconNameAndType(TestDir::createFileItem("a.txt", 1000, 10, 1), "text-plain", "Plain Text Document");
+    cache.setItemCount(TestDir::createFileItem("dir", 1000, 4096, 2), 7, 0);
+
+    // Start the background save immediately instead of waiting for the timer.
+    cache.scheduleSave();
+    QVERIFY(QMetaObject::invokeMethod(&cache, "startBackgroundSave"));
+
+    int timeout = 5000;
+    while (KFileItemModelRoleCache(m_cacheFileName).count() < 2 && timeout > 0) {
+        QTest::qWait(50);
+        timeout -= 50;
+    }
+
+    KFileItemModelRoleCache savedCache(m_cacheFileName);
+    KFileItemModelRoleCache::Entry entry;
+    QVERIFY(savedCache.lookup(TestDir::createFileItem("a.txt", 1000, 10, 1), entry));
+    QCOMPARE(entry.iconName, QString("text-plain"));
+    QVERIFY(savedCache.lookup(TestDir::createFileItem("dir", 1000, 4096, 2), entry));
+    QCOMPARE(entry.itemCount, 7);
+
+    // Changes that have been done after the background save must still be written.
+    cache.setItemCount(TestDir::createFileItem("dir", 1000, 4096, 2), 8, 0);
+    QVERIFY(cache.save());
+    QVERIFY(KFileItemModelRoleCache(m_cacheFileName).lookup(TestDir::createFileItem("dir", 1000, 4096, 2), entry));
+    QCOMPARE(entry.itemCount, 8);
+}
+
+QTEST_KDEMAIN(KFileItemModelRoleCacheTest, NoGUI)
+
+#include "kfileitemmodelrolecachetest.moc"
@@ -21,6 +21,7 @@
 #include <qtest_kde.h>
 
 #include <KDirLister>
+#include <KStringHandler>
 #include <kio/job.h>
 
 #include "kitemviews/kfileitemmodel.h"
@@ -68,16 +69,21 @@ private slots:
     void testRemoveItems();
     void testDirLoadingCompleted();
     void testSetData();
+    void testSetItemsData();
     void testSetDataWithModifiedSortRole_data();
     void testSetDataWithModifiedSortRole();
     void testChangeSortRole();
     void testResortAfterChangingName();
+    void testResortChangedItems();
     void testModelConsistencyWhenInsertingItems();
     void testItemRangeConsistencyWhenInsertingItems();
+    void testInsertItemsInBatches();
     void testExpandItems();
     void testExpandParentItems();
     void testMakeExpandedItemHidden();
     void testSorting();
+    void testNaturalSorting();
+    void testNaturalSortingPunctuation();
     void testIndexForKeyboardSearch();
     void testNameFilter();
     void testEmptyPath();
@@ -249,6 +255,38 @@ void KFileItemModelTest::testSetData()
     QVERIFY(m_model->isConsistent());
 }
 
+void KFileItemModelTest::testSetItemsData()
+{
+    m_testDir->createFiles(QStringList() << "a.txt" << "b.txt" << "c.txt" << "d.txt");
+
+    m_model->loadDirectory(m_testDir->url());
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(directoryLoadingCompleted()), DefaultTimeout));
+    QCOMPARE(m_model->count(), 4);
+
+    QHash<int, QHash<QByteArray, QVariant> > values;
+    values[0].insert("customRole", "Test0");
+    values[1].insert("customRole", "Test1");
+    values[3].insert("customRole", "Test3");
+
+    // One signal must be emitted for all changed items
+    QSignalSpy itemsChangedSpy(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)));
+    QVERIFY(m_model->setItemsData(values));
+    QCOMPARE(itemsChangedSpy.count(), 1);
+
+    const KItemRangeList itemRanges = itemsChangedSpy.first().at(0).value<KItemRangeList>();
+    QCOMPARE(itemRanges, KItemRangeList() << KItemRange(0, 2) << KItemRange(3, 1));
+
+    QCOMPARE(m_model->data(0).value("customRole").toString(), QString("Test0"));
+    QCOMPARE(m_model->data(1).value("customRole").toString(), QString("Test1"));
+    QVERIFY(!m_model->data(2).contains("customRole"));
+    QCOMPARE(m_model->data(3).value("customRole").toString(), QString("Test3"));
+
+    // Unchanged values must not result in a signal
+    QVERIFY(!m_model->setItemsData(values));
+    QCOMPARE(itemsChangedSpy.count(), 1);
+    QVERIFY(m_model->isConsistent());
+}
+
 void KFileItemModelTest::testSetDataWithModifiedSortRole_data()
 {
     QTest::addColumn<int>("changedIndex");
@@ -404,6 +442,84 @@ void KFileItemModelTest::testResortAfterChangingName()
 
     QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsMoved(KItemRange,QList<int>)), DefaultTimeout));
     QCOMPARE(itemsInModel(), QStringList() << "a.txt" << "b.txt" << "c.txt");
+
+    // Add more files, so that renaming a single item moves only this item
+    // instead of resorting the whole model.
+    files.clear();
+    for (char c = 'e'; c <= 'p'; ++c) {
+        files << QString(c) + ".txt";
+    }
+    m_testDir->createFiles(files);
+
+    m_model->loadDirectory(m_testDir->url());
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsInserted(KItemRangeList)), DefaultTimeout));
+    QCOMPARE(m_model->count(), 15);
+
+    // We rename c.txt to q.txt. The renamed item must be found by its new URL
+    // when the model is re-sorted.
+    data.clear();
+    data.insert("text", "q.txt");
+    m_model->setData(2, data);
+
+    KUrl urlQ = m_model->fileItem(2).url();
+    QCOMPARE(urlQ.fileName(), QString("q.txt"));
+    QCOMPARE(m_model->index(urlQ), 2);
+
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsMoved(KItemRange,QList<int>)), DefaultTimeout));
+    QCOMPARE(itemsInModel(), QStringList() << "a.txt" << "b.txt" << "e.txt" << "f.txt" << "g.txt"
+                                           << "h.txt" << "i.txt" << "j.txt" << "k.txt" << "l.txt"
+                                           << "m.txt" << "n.txt" << "o.txt" << "p.txt" << "q.txt");
+    QCOMPARE(m_model->index(urlQ), 14);
+    QCOMPARE(m_model->index(m_model->fileItem(2).url()), 2);
+}
+
+void KFileItemModelTest::testResortChangedItems()
+{
+    // If only a few items are changed, they must be moved to their new
+    // positions without resorting the whole model.
+    m_model->setSortRole("rating");
+
+    QStringList files;
+    for (char c = 'a'; c <= 'p'; ++c) {
+        files << QString(c) + ".txt";
+    }
+    m_testDir->createFiles(files);
+
+    m_model->loadDirectory(m_testDir->url());
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsInserted(KItemRangeList)), DefaultTimeout));
+    QCOMPARE(m_model->count(), 16);
+
+    // Assign the ratings 0, 2, 4, ..., 30. The ratings are assigned from the
+    // last to the first item to keep the sort order correct all the time.
+    for (int index = m_model->count() - 1; index >= 0; --index) {
+        QHash<QByteArray, QVariant> rating;
+        rating.insert("rating", index * 2);
+        m_model->setData(index, rating);
+    }
+    QVERIFY(!m_model->m_resortAllItemsTimer->isActive());
+
+    // Change the rating of d.txt from 6 to 25. It must be moved behind m.txt.
+    QSignalSpy spyItemsMoved(m_model, SIGNAL(itemsMoved(KItemRange,QList<int>)));
+
+    QHash<QByteArray, QVariant> rating;
+    rating.insert("rating", 25);
+    m_model->setData(3, rating);
+    QCOMPARE(m_model->m_itemsToResort.count(), 1);
+
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsMoved(KItemRange,QList<int>)), DefaultTimeout));
+    QCOMPARE(spyItemsMoved.count(), 1);
+
+    const QList<QVariant> arguments = spyItemsMoved.takeFirst();
+    const KItemRange range = arguments.at(0).value<KItemRange>();
+    QCOMPARE(range.index, 3);
+    QCOMPARE(range.count, 10);
+    QCOMPARE(arguments.at(1).value<QList<int> >(), QList<int>() << 12 << 3 << 4 << 5 << 6 << 7 << 8 << 9 << 10 << 11);
+
+    QCOMPARE(itemsInModel(), QStringList() << "a.txt" << "b.txt" << "c.txt" << "e.txt" << "f.txt" << "g.txt"
+                                           << "h.txt" << "i.txt" << "j.txt" << "k.txt" << "l.txt" << "m.txt"
+                                           << "d.txt" << "n.txt" << "o.txt" << "p.txt");
+    QVERIFY(m_model->m_itemsToResort.isEmpty());
+    QVERIFY(m_model->isConsistent());
 }
 
 void KFileItemModelTest::testModelConsistencyWhenInsertingItems()
@@ -491,6 +607,59 @@ void KFileItemModelTest::testItemRangeConsistencyWhenInsertingItems()
     QCOMPARE(itemRangeList, KItemRangeList() << KItemRange(0, 1) << KItemRange(1, 2) << KItemRange(2, 1));
 }
 
+/**
+ * Verifies that items which are received in many batches are pre-sorted in
+ * runs, and that the runs are merged correctly when the items are inserted.
+ */
+void KFileItemModelTest::testInsertItemsInBatches()
+{
+    const int batchCount = 8;
+    const int itemsPerBatch = 10;
+
+    QStringList expectedItems;
+    KFileItemList batches[batchCount];
+    for (int i = 0; i < batchCount * itemsPerBatch; ++i) {
+        const QString name = QString("file%1").arg(i, 2, 10, QChar('0'));
+        expectedItems << name;
+
+        // Distribute the items such that each batch contains items from the
+        // whole range and the order of the items inside a batch is reversed.
+        batches[i % batchCount].prepend(KFileItem(KUrl("file:///" + name), QString(), KFileItem::Unknown));
+    }
+
+    for (int i = 0; i < batchCount; ++i) {
+        m_model->slotItemsAdded(m_model->directory(), batches[i]);
+    }
+
+    // The batches are sorted by worker threads
+    m_model->finishSortingBatches();
+    QVERIFY(m_model->m_sortingBatches.isEmpty());
+
+    QCOMPARE(m_model->count(), 0);
+    QCOMPARE(m_model->m_pendingItemsToInsert.count(), batchCount * itemsPerBatch);
+    QVERIFY(m_model->m_pendingRunLengths.count() <= 4);
+
+    QSignalSpy spyItemsInserted(m_model, SIGNAL(itemsInserted(KItemRangeList)));
+    m_model->slotCompleted();
+
+    QCOMPARE(spyItemsInserted.count(), 1);
+    QCOMPARE(itemsInModel(), expectedItems);
+    QVERIFY(m_model->m_pendingRunLengths.isEmpty());
+    QVERIFY(m_model->isConsistent());
+
+    // Completing the listing must not wait for the queued notifications
+    // of the worker threads
+    m_model->slotClear();
+    for (int i = 0; i < batchCount; ++i) {
+        m_model->slotItemsAdded(m_model->directory(), batches[i]);
+    }
+    m_model->slotCompleted();
+
+    QCOMPARE(itemsInModel(), expectedItems);
+    QVERIFY(m_model->m_sortingBatches.isEmpty());
+    QVERIFY(m_model->isConsistent());
+}
+
 void KFileItemModelTest::testExpandItems()
 {
     // Test expanding subfolders in a folder with the items "a/", "a/a/", "a/a/1", "a/a-1/", "a/a-1/1".
@@ -876,6 +1045,61 @@ void KFileItemModelTest::testSorting()
     // TODO: Sort by other roles; show/hide hidden files
 }
 
+void KFileItemModelTest::testNaturalSorting()
+{
+    QStringList files;
+    files << "a10.txt" << "a2.txt" << "A1.txt" << "b9.txt" << "B10.txt" << "b1.txt";
+    m_testDir->createFiles(files);
+
+    m_model->m_naturalSorting = true;
+    m_model->loadDirectory(m_testDir->url());
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsInserted(KItemRangeList)), DefaultTimeout));
+
+    QCOMPARE(itemsInModel(), QStringList() << "A1.txt" << "a2.txt" << "a10.txt" << "b1.txt" << "b9.txt" << "B10.txt");
+    QVERIFY(m_model->isConsistent());
+
+    // Disabling the natural sorting requires to update the sort keys
+    m_model->m_naturalSorting = false;
+    m_model->updateSortKeys();
+    m_model->resortAllItems();
+
+    QCOMPARE(itemsInModel(), QStringList() << "A1.txt" << "a10.txt" << "a2.txt" << "b1.txt" << "B10.txt" << "b9.txt");
+    QVERIFY(m_model->isConsistent());
+
+    // Renaming an item must update its sort key
+    QHash<QByteArray, QVariant> data;
+    data.insert("text", "a3.txt");
+    m_model->setData(m_model->index(KUrl(m_testDir->url().url() + "b9.txt")), data);
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsMoved(KItemRange,QList<int>)), DefaultTimeout));
+
+    QCOMPARE(itemsInModel(), QStringList() << "A1.txt" << "a10.txt" << "a2.txt" << "a3.txt" << "b1.txt" << "B10.txt");
+    QVERIFY(m_model->isConsistent());
+}
+
+void KFileItemModelTest::testNaturalSortingPunctuation()
+{
+    // Punctuation characters and spaces are compared with the first digit of a
+    // number by their code unit, so ' ', '-' and '.' are sorted before numbers
+    // and '_' after them, like KStringHandler::naturalCompare() does.
+    const QStringList expectedItems = QStringList() << "a 1" << "a-1" << "a.1" << "a1" << "a2" << "a10"
+                                                    << "a_1" << "a_2" << "a_10" << "a_b";
+
+    QStringList files = expectedItems;
+    qSort(files.begin(), files.end(), qGreater<QString>());
+    m_testDir->createFiles(files);
+
+    m_model->m_naturalSorting = true;
+    m_model->loadDirectory(m_testDir->url());
+    QVERIFY(QTest::kWaitForSignal(m_model, SIGNAL(itemsInserted(KItemRangeList)), DefaultTimeout));
+
+    QCOMPARE(itemsInModel(), expectedItems);
+    QVERIFY(m_model->isConsistent());
+
+    for (int i = 1; i < expectedItems.count(); ++i) {
+        QVERIFY(KStringHandler::naturalCompare(expectedItems.at(i - 1), expectedItems.at(i)) < 0);
+    }
+}
+
 void KFileItemModelTest::testIndexForKeyboardSearch()
 {
     QStringList files;
@@ -950,6 +1174,15 @@ void KFileItemModelTest::testNameFilter()
     m_model->setNameFilter("bC"); // Shows "Abc" and "Bcd"
     QCOMPARE(m_model->count(), 2);
 
+    m_model->setNameFilter("bCd"); // Shows only "Bcd"
+    QCOMPARE(m_model->count(), 1);
+
+    m_model->setNameFilter("b"); // Shows "Abc" and "Bcd"
+    QCOMPARE(m_model->count(), 2);
+
+    m_model->setNameFilter("a?"); // Shows "A1" and "A2"
+    QCOMPARE(m_model->count(), 2);
+
     m_model->setNameFilter(QString()); // Shows again all items
     QCOMPARE(m_model->count(), 5);
 }
@@ -0,0 +1,115 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kitemlistoffsetindex.h"
+
+class KItemListOffsetIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPrefixSum();
+    void testSetValue();
+    void testTruncate();
+    void testLastIndex_data();
+    void testLastIndex();
+
+private:
+    static KItemListOffsetIndex createIndex(const QList<qreal>& values);
+};
+
+void KItemListOffsetIndexTest::testPrefixSum()
+{
+    const KItemListOffsetIndex index = createIndex(QList<qreal>() << 10 << 20 << 0 << 30 << 5);
+    QCOMPARE(index.count(), 5);
+    QCOMPARE(index.prefixSum(0), qreal(0));
+    QCOMPARE(index.prefixSum(1), qreal(10));
+    QCOMPARE(index.prefixSum(3), qreal(30));
+    QCOMPARE(index.prefixSum(5), qreal(65));
+}
+
+void KItemListOffsetIndexTest::testSetValue()
+{
+    KItemListOffsetIndex index = createIndex(QList<qreal>() << 10 << 20 << 30 << 40 << 50);
+
+    index.setValue(1, 25);
+    QCOMPARE(index.value(1), qreal(25));
+    QCOMPARE(index.prefixSum(1), qreal(10));
+    QCOMPARE(index.prefixSum(2), qreal(35));
+    QCOMPARE(index.prefixSum(5), qreal(155));
+    QCOMPARE(index.lastIndexBefore(35), 1);
+    QCOMPARE(index.lastIndexAtOrBefore(35), 2);
+}
+
+void KItemListOffsetIndexTest::testTruncate()
+{
+    KItemListOffsetIndex index = createIndex(QList<qreal>() << 1 << 2 << 3 << 4 << 5 << 6 << 7);
+
+    index.truncate(3);
+    QCOMPARE(index.count(), 3);
+    QCOMPARE(index.prefixSum(3), qreal(6));
+
+    index.append(10);
+    index.append(20);
+    QCOMPARE(index.count(), 5);
+    QCOMPARE(index.prefixSum(4), qreal(16));
+    QCOMPARE(index.prefixSum(5), qreal(36));
+}
+
+void KItemListOffsetIndexTest::testLastIndex_data()
+{
+    QTest::addColumn<qreal>("offset");
+    QTest::addColumn<int>("expectedLastIndexBefore");
+    QTest::addColumn<int>("expectedLastIndexAtOrBefore");
+
+    // The prefix sums are 0, 10, 30, 30, 60.
+    QTest::newRow("Negative offset") << qreal(-5) << -1 << -1;
+    QTest::newRow("Zero") << qreal(0) << -1 << 0;
+    QTest::newRow("Inside the first value") << qreal(5) << 0 << 0;
+    QTest::newRow("At the second value") << qreal(10) << 0 << 1;
+    QTest::newRow("At the empty value") << qreal(30) << 1 << 3;
+    QTest::newRow("Inside the last value") << qreal(61) << 4 << 4;
+    QTest::newRow("Behind the last value") << qreal(1000) << 4 << 4;
+}
+
+void KItemListOffsetIndexTest::testLastIndex()
+{
+    QFETCH(qreal, offset);
+    QFETCH(int, expectedLastIndexBefore);
+    QFETCH(int, expectedLastIndexAtOrBefore);
+
+    const KItemListOffsetIndex index = createIndex(QList<qreal>() << 10 << 20 << 0 << 30 << 5);
+    QCOMPARE(index.lastIndexBefore(offset), expectedLastIndexBefore);
+    QCOMPARE(index.lastIndexAtOrBefore(offset), expectedLastIndexAtOrBefore);
+}
+
+KItemListOffsetIndex KItemListOffsetIndexTest::createIndex(const QList<qreal>& values)
+{
+    KItemListOffsetIndex index;
+    foreach (qreal value, values) {
+        index.append(value);
+    }
+    return index;
+}
+
+QTEST_KDEMAIN(KItemListOffsetIndexTest, NoGUI)
+
+#include "kitemlistoffsetindextest.moc"
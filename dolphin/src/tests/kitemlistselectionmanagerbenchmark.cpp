@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/kitemmodelbase.h"
+#include "kitemviews/kitemlistselectionmanager.h"
+
+namespace {
+    const int ItemCount = 1000000;
+};
+
+class BenchmarkModel : public KItemModelBase
+{
+public:
+    BenchmarkModel(int count) : KItemModelBase(), m_count(count) {}
+    virtual int count() const { return m_count; }
+    virtual QHash<QByteArray, QVariant> data(int index) const
+    {
+        Q_UNUSED(index);
+        return QHash<QByteArray, QVariant>();
+    }
+
+private:
+    int m_count;
+};
+
+class KItemListSelectionManagerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void selectAll();
+    void invertSelection_data();
+    void invertSelection();
+    void insertAndRemoveItems();
+
+private:
+    KItemListSelectionManager* m_selectionManager;
+    BenchmarkModel* m_model;
+};
+
+void KItemListSelectionManagerBenchmark::init()
+{
+    m_model = new BenchmarkModel(ItemCount);
+    m_selectionManager = new KItemListSelectionManager();
+    m_selectionManager->setModel(m_model);
+}
+
+void KItemListSelectionManagerBenchmark::cleanup()
+{
+    delete m_selectionManager;
+    m_selectionManager = 0;
+
+    delete m_model;
+    m_model = 0;
+}
+
+void KItemListSelectionManagerBenchmark::selectAll()
+{
+    QBENCHMARK {
+        m_selectionManager->clearSelection();
+        m_selectionManager->setSelected(0, ItemCount);
+    }
+
+    QCOMPARE(m_selectionManager->selectedItems().count(), ItemCount);
+}
+
+void KItemListSelectionManagerBenchmark::invertSelection_data()
+{
+    QTest::addColumn<int>("selectedRangesCount");
+
+    QTest::newRow("Nothing selected") << 0;
+    QTest::newRow("10 ranges selected") << 10;
+    QTest::newRow("1000 ranges selected") << 1000;
+    QTest::newRow("Every second item selected") << ItemCount / 2;
+}
+
+void KItemListSelectionManagerBenchmark::invertSelection()
+{
+    QFETCH(int, selectedRangesCount);
+
+    KItemSet selectedItems;
+    if (selectedRangesCount > 0) {
+        const int distance = ItemCount / selectedRangesCount;
+        for (int index = 0; index < ItemCount; index += distance) {
+            selectedItems.insertRange(index, qMax(1, distance / 2));
+        }
+    }
+    m_selectionManager->setSelectedItems(selectedItems);
+
+    QBENCHMARK {
+        m_selectionManager->setSelected(0, ItemCount, KItemListSelectionManager::Toggle);
+    }
+}
+
+void KItemListSelectionManagerBenchmark::insertAndRemoveItems()
+{
+    // KItemListSelectionManager::itemsInserted() and itemsRemoved()
+    // forward the changes to KItemSet.
+    KItemSet selectedItems;
+    selectedItems.insertRange(0, ItemCount);
+
+    QBENCHMARK {
+        selectedItems.itemsInserted(KItemRangeList() << KItemRange(ItemCount / 2, 1));
+        selectedItems.itemsRemoved(KItemRangeList() << KItemRange(ItemCount / 2, 1));
+    }
+
+    QCOMPARE(selectedItems.count(), ItemCount);
+    QCOMPARE(selectedItems.ranges().count(), 1);
+}
+
+QTEST_KDEMAIN(KItemListSelectionManagerBenchmark, NoGUI)
+
+#include "kitemlistselectionmanagerbenchmark.moc"
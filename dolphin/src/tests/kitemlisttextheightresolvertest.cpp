@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kitemlisttextheightresolver.h"
+
+#include <QFontDatabase>
+#include <QSignalSpy>
+
+Q_DECLARE_METATYPE(const QObject*)
+
+namespace {
+    const int DefaultTimeout = 5000;
+};
+
+class KItemListTextHeightResolverTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testTextHeight();
+    void testRequester();
+    void testMaximumHeight();
+};
+
+void KItemListTextHeightResolverTest::initTestCase()
+{
+    qRegisterMetaType<const QObject*>("const QObject*");
+}
+
+void KItemListTextHeightResolverTest::testTextHeight()
+{
+    KItemListTextHeightResolver resolver;
+    QSignalSpy spy(&resolver, SIGNAL(textHeightsResolved(const QObject*,int,int)));
+
+    const QString text = "A rather long file name that must be wrapped.txt";
+    const QFont font = QApplication::font();
+    const qreal width = 60;
+    const qreal expectedHeight = KItemListTextHeightResolver::calculateTextHeight(text, font, width, 0);
+
+    bool isEstimated = false;
+    qreal height = resolver.textHeight(text, font, width, 0, &isEstimated);
+    if (QFontDatabase::supportsThreadedFontRendering()) {
+        QVERIFY(isEstimated);
+        QCOMPARE(resolver.estimatedCount(), quint64(1));
+        QVERIFY(QTest::kWaitForSignal(&resolver, SIGNAL(textHeightsResolved(const QObject*,int,int)), DefaultTimeout));
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.first().at(1).toInt(), -1);
+        QCOMPARE(spy.first().at(2).toInt(), -1);
+    } else {
+        QVERIFY(!isEstimated);
+        QCOMPARE(height, expectedHeight);
+    }
+
+    // The exact height must be cached now.
+    height = resolver.textHeight(text, font, width, 0, &isEstimated);
+    QVERIFY(!isEstimated);
+    QCOMPARE(height, expectedHeight);
+}
+
+void KItemListTextHeightResolverTest::testRequester()
+{
+    if (!QFontDatabase::supportsThreadedFontRendering()) {
+        QSKIP("The heights are calculated synchronously", SkipAll);
+    }
+
+    KItemListTextHeightResolver resolver;
+    QSignalSpy spy(&resolver, SIGNAL(textHeightsResolved(const QObject*,int,int)));
+
+    QObject firstRequester;
+    QObject secondRequester;
+    const QFont font = QApplication::font();
+
+    // The same text is requested by both requesters, so both must be notified.
+    resolver.textHeight("a.txt", font, 60, 0, 0, &firstRequester, 7);
+    resolver.textHeight("b.txt", font, 60, 0, 0, &firstRequester, 3);
+    resolver.textHeight("a.txt", font, 60, 0, 0, &secondRequester, 12);
+
+    int timeout = DefaultTimeout;
+    while (spy.count() < 2 && timeout > 0) {
+        QTest::qWait(50);
+        timeout -= 50;
+    }
+    QCOMPARE(spy.count(), 2);
+
+    QHash<const QObject*, QPair<int, int> > ranges;
+    for (int i = 0; i < spy.count(); ++i) {
+        const QList<QVariant> arguments = spy.at(i);
+        ranges.insert(arguments.at(0).value<const QObject*>(), qMakePair(arguments.at(1).toInt(), arguments.at(2).toInt()));
+    }
+    QCOMPARE(ranges.value(&firstRequester), qMakePair(3, 7));
+    QCOMPARE(ranges.value(&secondRequester), qMakePair(12, 12));
+}
+
+void KItemListTextHeightResolverTest::testMaximumHeight()
+{
+    const QString text = "A rather long file name that must be wrapped into many lines.txt";
+    const QFont font = QApplication::font();
+    const qreal lineHeight = KItemListTextHeightResolver::calculateTextHeight("A", font, 1000, 0);
+
+    const qreal fullHeight = KItemListTextHeightResolver::calculateTextHeight(text, font, 30, 0);
+    QVERIFY(fullHeight > 3 * lineHeight);
+
+    // The layout stops with the first line that exceeds the maximum height.
+    const qreal height = KItemListTextHeightResolver::calculateTextHeight(text, font, 30, 2 * lineHeight);
+    QVERIFY(height > 2 * lineHeight);
+    QVERIFY(height < fullHeight);
+}
+
+QTEST_KDEMAIN(KItemListTextHeightResolverTest, GUI)
+
+#include "kitemlisttextheightresolvertest.moc"
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kitemstatearray.h"
+
+namespace {
+    const quint8 FirstFlag = 0x01;
+    const quint8 SecondFlag = 0x02;
+}
+
+class KItemStateArrayTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSetFlag();
+    void testInsertItems();
+    void testRemoveItems();
+    void testMoveItems();
+
+private:
+    static KItemStateArray createArray(const QList<int>& firstFlagIndexes, int count);
+};
+
+void KItemStateArrayTest::testSetFlag()
+{
+    KItemStateArray array;
+    array.resize(10);
+
+    array.setFlag(2, FirstFlag);
+    array.setFlag(2, FirstFlag);
+    array.setFlag(5, FirstFlag);
+    array.setFlag(5, SecondFlag);
+    array.setFlag(10, FirstFlag);
+    QCOMPARE(array.flagCount(FirstFlag), 2);
+    QCOMPARE(array.flagCount(SecondFlag), 1);
+    QVERIFY(array.testFlag(5, FirstFlag));
+    QVERIFY(!array.testFlag(10, FirstFlag));
+    QCOMPARE(array.nextIndex(FirstFlag, 3), 5);
+    QCOMPARE(array.indexes(FirstFlag), QList<int>() << 2 << 5);
+
+    array.setFlag(2, FirstFlag, false);
+    QCOMPARE(array.flagCount(FirstFlag), 1);
+
+    array.clearFlag(FirstFlag);
+    QCOMPARE(array.flagCount(FirstFlag), 0);
+    QCOMPARE(array.nextIndex(FirstFlag), -1);
+    QVERIFY(array.testFlag(5, SecondFlag));
+
+    array.resize(4);
+    QCOMPARE(array.flagCount(SecondFlag), 0);
+}
+
+void KItemStateArrayTest::testInsertItems()
+{
+    KItemStateArray array = createArray(QList<int>() << 0 << 1 << 2, 3);
+
+    array.insertItems(KItemRangeList() << KItemRange(0, 1) << KItemRange(2, 2) << KItemRange(3, 1));
+    QCOMPARE(array.count(), 7);
+    QCOMPARE(array.indexes(FirstFlag), QList<int>() << 1 << 2 << 5);
+    QCOMPARE(array.flagCount(FirstFlag), 3);
+}
+
+void KItemStateArrayTest::testRemoveItems()
+{
+    KItemStateArray array = createArray(QList<int>() << 1 << 2 << 5 << 8, 10);
+
+    array.removeItems(KItemRangeList() << KItemRange(0, 2) << KItemRange(5, 3));
+    QCOMPARE(array.count(), 5);
+    QCOMPARE(array.indexes(FirstFlag), QList<int>() << 0 << 3);
+    QCOMPARE(array.flagCount(FirstFlag), 2);
+}
+
+void KItemStateArrayTest::testMoveItems()
+{
+    KItemStateArray array = createArray(QList<int>() << 1, 5);
+
+    // Move the items 1, 2 and 3 to the indexes 3, 1 and 2.
+    array.moveItems(KItemRange(1, 3), QList<int>() << 3 << 1 << 2);
+    QCOMPARE(array.indexes(FirstFlag), QList<int>() << 3);
+    QCOMPARE(array.flagCount(FirstFlag), 1);
+}
+
+KItemStateArray KItemStateArrayTest::createArray(const QList<int>& firstFlagIndexes, int count)
+{
+    KItemStateArray array;
+    array.resize(count);
+    foreach (int index, firstFlagIndexes) {
+        array.setFlag(index, FirstFlag);
+    }
+    return array;
+}
+
+QTEST_KDEMAIN(KItemStateArrayTest, NoGUI)
+
+#include "kitemstatearraytest.moc"
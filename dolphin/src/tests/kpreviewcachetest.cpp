@@ -0,0 +1,133 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kpreviewcache.h"
+#include "testdir.h"
+
+#include <KFileItem>
+
+class KPreviewCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFind();
+    void testModifiedFile();
+    void testDownscaling();
+    void testMaximumSize();
+
+private:
+    static QPixmap createPixmap(int width, int height);
+};
+
+void KPreviewCacheTest::testFind()
+{
+    KPreviewCache cache;
+    const KFileItem item = TestDir::createFileItem("a.png", 1000);
+
+    QPixmap pixmap;
+    QVERIFY(!cache.find(item, QSize(128, 128), pixmap));
+    QCOMPARE(cache.missCount(), quint64(1));
+
+    cache.insert(item, QSize(128, 128), createPixmap(128, 96));
+    QVERIFY(cache.find(item, QSize(128, 128), pixmap));
+    QCOMPARE(pixmap.size(), QSize(128, 96));
+
+    // Sizes of the same bucket share the preview, which is
+    // downscaled to the requested size
+    QVERIFY(cache.find(item, QSize(100, 100), pixmap));
+    QCOMPARE(pixmap.size(), QSize(100, 75));
+    QCOMPARE(cache.hitCount(), quint64(2));
+    QCOMPARE(cache.scaledHitCount(), quint64(0));
+
+    // A smaller preview must not be enlarged
+    QVERIFY(!cache.find(item, QSize(256, 256), pixmap));
+    QCOMPARE(cache.missCount(), quint64(2));
+}
+
+void KPreviewCacheTest::testModifiedFile()
+{
+    KPreviewCache cache;
+    cache.insert(TestDir::createFileItem("a.png", 1000), QSize(128, 128), createPixmap(128, 128));
+
+    QPixmap pixmap;
+    QVERIFY(!cache.find(TestDir::createFileItem("a.png", 2000), QSize(128, 128), pixmap));
+    QVERIFY(!cache.find(TestDir::createFileItem("b.png", 1000), QSize(128, 128), pixmap));
+}
+
+void KPreviewCacheTest::testDownscaling()
+{
+    KPreviewCache cache;
+    const KFileItem item = TestDir::createFileItem("a.png", 1000);
+    cache.insert(item, QSize(512, 512), createPixmap(512, 256));
+
+    QPixmap pixmap;
+    QVERIFY(cache.find(item, QSize(128, 128), pixmap));
+    QCOMPARE(pixmap.size(), QSize(128, 64));
+    QCOMPARE(cache.scaledHitCount(), quint64(1));
+
+    // The downscaled preview has been cached for the smaller bucket
+    QVERIFY(cache.find(item, QSize(128, 128), pixmap));
+    QCOMPARE(cache.scaledHitCount(), quint64(1));
+    QCOMPARE(cache.hitCount(), quint64(2));
+
+    // The preview of the larger bucket is downscaled to the requested size
+    QVERIFY(cache.find(item, QSize(200, 200), pixmap));
+    QCOMPARE(pixmap.size(), QSize(200, 100));
+
+    // Previews that are smaller than the bucket are not scaled
+    const KFileItem smallItem = TestDir::createFileItem("small.png", 1000);
+    cache.insert(smallItem, QSize(256, 256), createPixmap(64, 32));
+    QVERIFY(cache.find(smallItem, QSize(128, 128), pixmap));
+    QCOMPARE(pixmap.size(), QSize(64, 32));
+}
+
+void KPreviewCacheTest::testMaximumSize()
+{
+    // Memory for three pixmaps with 128 x 128 pixels
+    KPreviewCache cache(3 * 128 * 128 * 4);
+
+    for (int i = 0; i < 10; ++i) {
+        cache.insert(TestDir::createFileItem(QString::number(i), 1000), QSize(128, 128), createPixmap(128, 128));
+        QVERIFY(cache.size() <= cache.maximumSize());
+    }
+    QCOMPARE(cache.size(), cache.maximumSize());
+
+    // The most recently inserted previews are kept
+    QPixmap pixmap;
+    QVERIFY(cache.find(TestDir::createFileItem("9", 1000), QSize(128, 128), pixmap));
+    QVERIFY(!cache.find(TestDir::createFileItem("0", 1000), QSize(128, 128), pixmap));
+
+    cache.clear();
+    QCOMPARE(cache.size(), 0);
+    QVERIFY(!cache.find(TestDir::createFileItem("9", 1000), QSize(128, 128), pixmap));
+}
+
+QPixmap KPreviewCacheTest::createPixmap(int width, int height)
+{
+    QPixmap pixmap(width, height);
+    pixmap.fill(Qt::red);
+    return pixmap;
+}
+
+QTEST_KDEMAIN(KPreviewCacheTest, GUI)
+
+#include "kpreviewcachetest.moc"
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+
+#include <qtest_kde.h>
+
+#include "kitemviews/private/kpixmapmodifier.h"
+#include "kitemviews/private/kpreviewcompositor.h"
+
+#include <KFileItem>
+
+#include <QSignalSpy>
+
+class KPreviewCompositorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testBlend_data();
+    void testBlend();
+    void testProcess();
+    void testImageReady();
+    void testClear();
+    void testOutdatedRequest();
+
+private:
+    static QImage createImage(int width, int height, QRgb color);
+};
+
+void KPreviewCompositorTest::initTestCase()
+{
+    qRegisterMetaType<KFileItem>("KFileItem");
+}
+
+void KPreviewCompositorTest::testBlend_data()
+{
+    QTest::addColumn<qreal>("factor");
+    QTest::addColumn<QRgb>("expectedColor");
+
+    QTest::newRow("First image") << qreal(0.0) << qRgba(200, 100, 0, 255);
+    QTest::newRow("Second image") << qreal(1.0) << qRgba(0, 100, 200, 255);
+    QTest::newRow("Half") << qreal(0.5) << qRgba(100, 100, 100, 255);
+}
+
+void KPreviewCompositorTest::testBlend()
+{
+    QFETCH(qreal, factor);
+    QFETCH(QRgb, expectedColor);
+
+    const QImage image1 = createImage(16, 16, qRgba(200, 100, 0, 255));
+    const QImage image2 = createImage(16, 16, qRgba(0, 100, 200, 255));
+
+    const QImage result = KPixmapModifier::blend(image1, image2, factor);
+    QCOMPARE(result.size(), QSize(16, 16));
+    QCOMPARE(result.format(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(result.pixel(0, 0), expectedColor);
+    QCOMPARE(result.pixel(15, 15), expectedColor);
+}
+
+void KPreviewCompositorTest::testProcess()
+{
+    const QImage image = createImage(200, 100, qRgba(0, 0, 255, 255));
+
+    const QImage scaled = KPreviewCompositor::process(image, QSize(64, 64), KPreviewCompositor::Scale);
+    QCOMPARE(scaled.size(), QSize(64, 32));
+
+    const QImage framed = KPreviewCompositor::process(image, QSize(64, 64), KPreviewCompositor::ApplyFrame);
+    QVERIFY(framed.width() <= 64);
+    QVERIFY(framed.height() <= 64);
+    QVERIFY(framed.width() > framed.height());
+
+    // Small images are not enlarged, but shown within a frame of the enlarged size
+    const QImage small = createImage(20, 10, qRgba(0, 0, 255, 255));
+    const QImage notEnlarged = KPreviewCompositor::process(small, QSize(64, 64),
+                                                           KPreviewCompositor::ApplyFrameWithoutEnlarging);
+    QVERIFY(notEnlarged.width() > 40);
+    QCOMPARE(notEnlarged.pixel(notEnlarged.width() / 2, notEnlarged.height() / 2), qRgba(0, 0, 255, 255));
+}
+
+void KPreviewCompositorTest::testImageReady()
+{
+    KPreviewCompositor compositor;
+    QSignalSpy spy(&compositor, SIGNAL(imageReady(KFileItem,QImage,QSize)));
+
+    const KFileItem item(KUrl("file:///tmp/a.png"), QString(), KFileItem::Unknown);
+    compositor.addRequest(item, createImage(256, 256, qRgba(255, 0, 0, 255)), QSize(64, 64),
+                          KPreviewCompositor::Scale);
+
+    QVERIFY(QTest::kWaitForSignal(&compositor, SIGNAL(imageReady(KFileItem,QImage,QSize)), 5000));
+    QCOMPARE(spy.count(), 1);
+
+    const QList<QVariant> arguments = spy.takeFirst();
+    QCOMPARE(arguments.at(0).value<KFileItem>().url(), item.url());
+    QCOMPARE(arguments.at(1).value<QImage>().size(), QSize(64, 64));
+    QCOMPARE(arguments.at(2).toSize(), QSize(64, 64));
+}
+
+void KPreviewCompositorTest::testClear()
+{
+    KPreviewCompositor compositor;
+    QSignalSpy spy(&compositor, SIGNAL(imageReady(KFileItem,QImage,QSize)));
+
+    const KFileItem item(KUrl("file:///tmp/a.png"), QString(), KFileItem::Unknown);
+    for (int i = 0; i < 10; ++i) {
+        compositor.addRequest(item, createImage(256, 256, qRgba(255, 0, 0, 255)), QSize(64, 64),
+                              KPreviewCompositor::ApplyFrame);
+    }
+    compositor.clear();
+
+    // Results of discarded requests must not be emitted
+    QTest::qWait(500);
+    QCOMPARE(spy.count(), 0);
+}
+
+void KPreviewCompositorTest::testOutdatedRequest()
+{
+    KPreviewCompositor compositor;
+    QSignalSpy spy(&compositor, SIGNAL(imageReady(KFileItem,QImage,QSize)));
+
+    // The large image of the first request is probably finished after
+    // the second request, but only the second result may be emitted.
+    const KFileItem item(KUrl("file:///tmp/a.png"), QString(), KFileItem::Unknown);
+    compositor.addRequest(item, createImage(2048, 2048, qRgba(255, 0, 0, 255)), QSize(64, 64),
+                          KPreviewCompositor::ApplyFrame);
+    compositor.addRequest(item, createImage(256, 256, qRgba(0, 0, 255, 255)), QSize(32, 32),
+                          KPreviewCompositor::Scale);
+
+    QVERIFY(QTest::kWaitForSignal(&compositor, SIGNAL(imageReady(KFileItem,QImage,QSize)), 5000));
+    QTest::qWait(500);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(2).toSize(), QSize(32, 32));
+}
+
+QImage KPreviewCompositorTest::createImage(int width, int height, QRgb color)
+{
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(color);
+    return image;
+}
+
+QTEST_KDEMAIN(KPreviewCompositorTest, GUI)
+
+#include "kpreviewcompositortest.moc"
@@ -19,8 +19,12 @@
 
 #include "testdir.h"
 
+#include <kio/udsentry.h>
+
 #include <QDir>
 
+#include <sys/stat.h>
+
 #ifdef Q_OS_UNIX
 #include <utime.h>
 #else
@@ -104,6 +108,25 @@ void TestDir::removeFile(const QString& path)
     QFile::remove(absolutePath);
 }
 
+KFileItem TestDir::createFileItem(const QString& name, qint64 modificationTime, qint64 size, quint64 inode,
+                                  const QString& urlPrefix)
+{
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, name);
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+    if (inode != 0) {
+        entry.insert(KIO::UDSEntry::UDS_DEVICE_ID, 1);
+        entry.insert(KIO::UDSEntry::UDS_INODE, inode);
+    }
+    if (modificationTime >= 0) {
+        entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, modificationTime);
+    }
+    if (size >= 0) {
+        entry.insert(KIO::UDSEntry::UDS_SIZE, size);
+    }
+    return KFileItem(entry, KUrl(urlPrefix + name));
+}
+
 void TestDir::makePathAbsoluteAndCreateParents(QString& path)
 {
     QFileInfo fileInfo(path);
@@ -20,6 +20,7 @@
 #ifndef TESTDIR_H
 #define TESTDIR_H
 
+#include <KFileItem>
 #include <KTempDir>
 #include <KUrl>
 
@@ -51,6 +52,18 @@ public:
 
     void removeFile(const QString& path);
 
+    /**
+     * Creates a KFileItem for a regular file \a name inside the directory
+     * \a urlPrefix, which needs not exist. The modification time, size and
+     * inode are only set if \a modificationTime, \a size or \a inode
+     * are not negative or zero respectively.
+     */
+    static KFileItem createFileItem(const QString& name,
+                                    qint64 modificationTime = -1,
+                                    qint64 size = -1,
+                                    quint64 inode = 0,
+                                    const QString& urlPrefix = QLatin1String("file:///tmp/"));
+
 private:
     void makePathAbsoluteAndCreateParents(QString& path);
 
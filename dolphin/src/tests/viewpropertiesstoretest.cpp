@@ -0,0 +1,205 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include <qtest_kde.h>
+
+#include "views/viewpropertiesstore.h"
+
+#include <KTempDir>
+
+#include <QDir>
+#include <QFile>
+
+class ViewPropertiesStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testSetValue();
+    void testBatch();
+    void testCompact();
+    void testCompactRemovedFiles();
+    void testSeveralInstances();
+    void testIncompleteLogRecord();
+
+private:
+    KTempDir* m_tempDir;
+    QString m_storeFileName;
+};
+
+void ViewPropertiesStoreTest::init()
+{
+    m_tempDir = new KTempDir();
+    m_storeFileName = m_tempDir->name() + "store";
+}
+
+void ViewPropertiesStoreTest::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = 0;
+}
+
+void ViewPropertiesStoreTest::testSetValue()
+{
+    ViewPropertiesStore store(m_storeFileName);
+    QByteArray value;
+    QVERIFY(!store.value("/home/user", value));
+    QCOMPARE(store.count(), 0);
+
+    store.setValue("/home/user", "a");
+    store.setValue("global", "b");
+    store.setValue("/home/user", "c");
+    QVERIFY(store.value("/home/user", value));
+    QCOMPARE(value, QByteArray("c"));
+    QVERIFY(store.contains("global"));
+    QCOMPARE(store.count(), 2);
+
+    // The values must be available for new instances
+    ViewPropertiesStore loadedStore(m_storeFileName);
+    QVERIFY(loadedStore.value("/home/user", value));
+    QCOMPARE(value, QByteArray("c"));
+    QCOMPARE(loadedStore.count(), 2);
+}
+
+void ViewPropertiesStoreTest::testBatch()
+{
+    ViewPropertiesStore store(m_storeFileName);
+    ViewPropertiesStore otherStore(m_storeFileName);
+
+    store.beginBatch();
+    for (int i = 0; i < 1000; ++i) {
+        store.setValue(QString("/home/user/%1").arg(i), QByteArray::number(i));
+    }
+
+    // The values are available for the own instance, but are
+    // not written before the batch has been finished.
+    QCOMPARE(store.count(), 1000);
+    QVERIFY(!otherStore.contains("/home/user/0"));
+
+    store.endBatch();
+    QCOMPARE(otherStore.count(), 1000);
+
+    QByteArray value;
+    QVERIFY(otherStore.value("/home/user/999", value));
+    QCOMPARE(value, QByteArray("999"));
+}
+
+void ViewPropertiesStoreTest::testCompact()
+{
+    // Relative keys are not treated as paths of files
+    const int itemCount = 1000;
+
+    {
+        ViewPropertiesStore store(m_storeFileName);
+        for (int i = 0; i < itemCount; ++i) {
+            store.setValue(QString("home/user/%1").arg(i), QByteArray::number(i));
+        }
+        QVERIFY(store.compact());
+        QCOMPARE(QFile(m_storeFileName + ".log").size(), qint64(0));
+        QCOMPARE(store.count(), itemCount);
+
+        // Changing a value after compacting must override the value of the table
+        store.setValue("home/user/0", "changed");
+    }
+
+    ViewPropertiesStore store(m_storeFileName);
+    QCOMPARE(store.count(), itemCount);
+
+    QByteArray value;
+    for (int i = 1; i < itemCount; ++i) {
+        QVERIFY(store.value(QString("home/user/%1").arg(i), value));
+        QCOMPARE(value, QByteArray::number(i));
+    }
+    QVERIFY(store.value("home/user/0", value));
+    QCOMPARE(value, QByteArray("changed"));
+    QVERIFY(!store.contains("home/user/1000"));
+}
+
+void ViewPropertiesStoreTest::testCompactRemovedFiles()
+{
+    const QString existingFile = m_tempDir->name() + "existing/.directory";
+    const QString removedFile = m_tempDir->name() + "removed/.directory";
+    QVERIFY(QDir(m_tempDir->name()).mkdir("existing"));
+    QFile file(existingFile);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    ViewPropertiesStore store(m_storeFileName);
+    store.setValue(existingFile, "1");
+    store.setValue(removedFile, "2");
+    store.setValue("global", "3");
+    QCOMPARE(store.count(), 3);
+
+    // The value of the file that does not exist is dropped
+    QVERIFY(store.compact());
+    QCOMPARE(store.count(), 2);
+    QVERIFY(store.contains(existingFile));
+    QVERIFY(!store.contains(removedFile));
+    QVERIFY(store.contains("global"));
+}
+
+void ViewPropertiesStoreTest::testSeveralInstances()
+{
+    // The instances simulate several Dolphin processes
+    ViewPropertiesStore store(m_storeFileName);
+    ViewPropertiesStore otherStore(m_storeFileName);
+
+    store.setValue("a", "1");
+    QVERIFY(otherStore.contains("a"));
+
+    // Compacting by another instance must not lose any values
+    otherStore.setValue("b", "2");
+    QVERIFY(otherStore.compact());
+    store.setValue("c", "3");
+
+    QByteArray value;
+    QVERIFY(store.value("a", value));
+    QCOMPARE(value, QByteArray("1"));
+    QVERIFY(store.value("b", value));
+    QCOMPARE(value, QByteArray("2"));
+    QVERIFY(otherStore.value("c", value));
+    QCOMPARE(value, QByteArray("3"));
+    QCOMPARE(store.count(), 3);
+    QCOMPARE(otherStore.count(), 3);
+}
+
+void ViewPropertiesStoreTest::testIncompleteLogRecord()
+{
+    {
+        ViewPropertiesStore store(m_storeFileName);
+        store.setValue("a", "1");
+    }
+
+    // A record that has not been written completely must be ignored
+    QFile log(m_storeFileName + ".log");
+    QVERIFY(log.open(QIODevice::WriteOnly | QIODevice::Append));
+    log.write(QByteArray("\x05\x00\x00\x00", 4));
+    log.close();
+
+    ViewPropertiesStore store(m_storeFileName);
+    QCOMPARE(store.count(), 1);
+    QVERIFY(store.contains("a"));
+}
+
+QTEST_KDEMAIN(ViewPropertiesStoreTest, NoGUI)
+
+#include "viewpropertiesstoretest.moc"
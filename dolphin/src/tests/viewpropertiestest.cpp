@@ -23,6 +23,9 @@
 #include "views/viewproperties.h"
 #include "testdir.h"
 
+#include <KConfig>
+#include <KConfigGroup>
+
 #include <QDebug>
 #include <QDir>
 
@@ -36,6 +39,8 @@ private slots:
 
     void testReadOnlyBehavior();
     void testAutoSave();
+    void testChangedDirectoryFile();
+    void testRenamedDirectory();
 
 private:
     bool m_globalViewProps;
@@ -96,6 +101,54 @@ void ViewPropertiesTest::testAutoSave()
     QVERIFY(QFile::exists(dotDirectoryFile));
 }
 
+/**
+ * Test whether changes of a .directory file that have not been done
+ * by ViewProperties are respected although the properties are cached.
+ */
+void ViewPropertiesTest::testChangedDirectoryFile()
+{
+    const QString dotDirectoryFile = m_testDir->url().toLocalFile() + ".directory";
+    {
+        ViewProperties props(m_testDir->url());
+        props.setSortRole("date");
+    }
+    QCOMPARE(ViewProperties(m_testDir->url()).sortRole(), QByteArray("date"));
+
+    {
+        KConfig config(dotDirectoryFile, KConfig::SimpleConfig);
+        KConfigGroup group(&config, "Dolphin");
+        group.writeEntry("SortRole", "size");
+    }
+    QCOMPARE(ViewProperties(m_testDir->url()).sortRole(), QByteArray("size"));
+}
+
+/**
+ * Test whether the properties follow a renamed directory.
+ */
+void ViewPropertiesTest::testRenamedDirectory()
+{
+    m_testDir->createDir("a");
+    KUrl oldUrl = m_testDir->url();
+    oldUrl.addPath("a");
+    {
+        ViewProperties props(oldUrl);
+        props.setSortRole("size");
+    }
+    QVERIFY(ViewProperties(oldUrl).exist());
+
+    QVERIFY(QDir(m_testDir->name()).rename("a", "b"));
+    KUrl newUrl = m_testDir->url();
+    newUrl.addPath("b");
+
+    const ViewProperties props(newUrl);
+    QVERIFY(props.exist());
+    QCOMPARE(props.sortRole(), QByteArray("size"));
+
+    m_testDir->createDir("a");
+    QVERIFY(!ViewProperties(oldUrl).exist());
+    QCOMPARE(ViewProperties(oldUrl).sortRole(), ViewProperties(KUrl()).sortRole());
+}
+
 QTEST_KDEMAIN(ViewPropertiesTest, NoGUI)
 
 #include "viewpropertiestest.moc"
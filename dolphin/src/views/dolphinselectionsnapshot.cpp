@@ -0,0 +1,384 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "dolphinselectionsnapshot.h"
+
+#include <kitemviews/kfileitemmodel.h>
+
+#include <KProtocolManager>
+
+#include <QFileInfo>
+#include <QPointer>
+#include <QSharedData>
+
+/**
+ * Shared data of all copies of a DolphinSelectionSnapshot. Keeps the indexes
+ * in sync with the model and caches the values that require iterating
+ * the selected items.
+ */
+class DolphinSelectionSnapshotPrivate : public QObject, public QSharedData
+{
+    Q_OBJECT
+
+public:
+    DolphinSelectionSnapshotPrivate(KFileItemModel* model, const KItemSet& indexes);
+
+    void invalidateCache();
+
+    QPointer<KFileItemModel> model;
+    KItemSet indexes;
+
+    bool summaryValid;
+    int folderCount;
+    int fileCount;
+    KIO::filesize_t totalFileSize;
+
+    bool capabilitiesValid;
+    bool isLocal;
+    bool supportsDeleting;
+    bool supportsMoving;
+
+    bool itemsValid;
+    KFileItemList items;
+
+private slots:
+    void slotItemsInserted(const KItemRangeList& itemRanges);
+    void slotItemsRemoved(const KItemRangeList& itemRanges);
+    void slotItemsMoved(const KItemRange& itemRange, const QList<int>& movedToIndexes);
+    void slotItemsChanged(const KItemRangeList& itemRanges, const QSet<QByteArray>& roles);
+};
+
+DolphinSelectionSnapshotPrivate::DolphinSelectionSnapshotPrivate(KFileItemModel* model, const KItemSet& indexes) :
+    QObject(),
+    QSharedData(),
+    model(model),
+    indexes(indexes),
+    summaryValid(false),
+    folderCount(0),
+    fileCount(0),
+    totalFileSize(0),
+    capabilitiesValid(false),
+    isLocal(true),
+    supportsDeleting(false),
+    supportsMoving(false),
+    itemsValid(false),
+    items()
+{
+    if (model && !indexes.isEmpty()) {
+        connect(model, SIGNAL(itemsInserted(KItemRangeList)),
+                this, SLOT(slotItemsInserted(KItemRangeList)));
+        connect(model, SIGNAL(itemsRemoved(KItemRangeList)),
+                this, SLOT(slotItemsRemoved(KItemRangeList)));
+        connect(model, SIGNAL(itemsMoved(KItemRange,QList<int>)),
+                this, SLOT(slotItemsMoved(KItemRange,QList<int>)));
+        connect(model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
+                this, SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
+    }
+}
+
+void DolphinSelectionSnapshotPrivate::invalidateCache()
+{
+    summaryValid = false;
+    capabilitiesValid = false;
+    itemsValid = false;
+    items.clear();
+}
+
+void DolphinSelectionSnapshotPrivate::slotItemsInserted(const KItemRangeList& itemRanges)
+{
+    // The selected items are unchanged, so the cached values stay valid.
+    indexes.itemsInserted(itemRanges);
+}
+
+void DolphinSelectionSnapshotPrivate::slotItemsRemoved(const KItemRangeList& itemRanges)
+{
+    const int previousCount = indexes.count();
+    indexes.itemsRemoved(itemRanges);
+    if (indexes.count() != previousCount) {
+        invalidateCache();
+    }
+}
+
+void DolphinSelectionSnapshotPrivate::slotItemsMoved(const KItemRange& itemRange, const QList<int>& movedToIndexes)
+{
+    indexes.itemsMoved(itemRange, movedToIndexes);
+    // The list of items is sorted by the indexes.
+    itemsValid = false;
+    items.clear();
+}
+
+void DolphinSelectionSnapshotPrivate::slotItemsChanged(const KItemRangeList& itemRanges, const QSet<QByteArray>& roles)
+{
+    // Both the changed and the selected ranges are sorted.
+    const QVector<KItemRange>& selectedRanges = indexes.ranges();
+    bool affectsSelection = false;
+    int selectedIt = 0;
+    foreach (const KItemRange& range, itemRanges) {
+        while (selectedIt < selectedRanges.count()
+               && selectedRanges.at(selectedIt).index + selectedRanges.at(selectedIt).count <= range.index) {
+            ++selectedIt;
+        }
+        if (selectedIt == selectedRanges.count()) {
+            break;
+        }
+        if (selectedRanges.at(selectedIt).index < range.index + range.count) {
+            affectsSelection = true;
+            break;
+        }
+    }
+    if (!affectsSelection) {
+        return;
+    }
+
+    // The cached KFileItems are copies, so they get outdated by any change
+    // of a selected item.
+    itemsValid = false;
+    items.clear();
+
+    // Most changes, e.g. of previews or meta data, are irrelevant for the
+    // other cached values. An empty set of roles means that anything might
+    // have been changed.
+    const bool anyRole = roles.isEmpty();
+    if (anyRole || roles.contains("url") || roles.contains("permissions") || roles.contains("type")) {
+        capabilitiesValid = false;
+    }
+    if (anyRole || roles.contains("url") || roles.contains("isDir") || roles.contains("size")) {
+        summaryValid = false;
+    }
+}
+
+
+KFileItem DolphinSelectionSnapshot::const_iterator::operator*() const
+{
+    return m_model ? m_model->fileItem(*m_it) : KFileItem();
+}
+
+DolphinSelectionSnapshot::const_iterator& DolphinSelectionSnapshot::const_iterator::operator++()
+{
+    ++m_it;
+    return *this;
+}
+
+bool DolphinSelectionSnapshot::const_iterator::operator==(const const_iterator& other) const
+{
+    return m_it == other.m_it;
+}
+
+bool DolphinSelectionSnapshot::const_iterator::operator!=(const const_iterator& other) const
+{
+    return m_it != other.m_it;
+}
+
+DolphinSelectionSnapshot::const_iterator::const_iterator(const KFileItemModel* model, const KItemSet::const_iterator& it) :
+    m_model(model),
+    m_it(it)
+{
+}
+
+
+DolphinSelectionSnapshot::DolphinSelectionSnapshot() :
+    d(new DolphinSelectionSnapshotPrivate(0, KItemSet()))
+{
+}
+
+DolphinSelectionSnapshot::DolphinSelectionSnapshot(KFileItemModel* model, const KItemSet& indexes) :
+    d(new DolphinSelectionSnapshotPrivate(model, indexes))
+{
+}
+
+DolphinSelectionSnapshot::DolphinSelectionSnapshot(const DolphinSelectionSnapshot& other) :
+    d(other.d)
+{
+}
+
+DolphinSelectionSnapshot::~DolphinSelectionSnapshot()
+{
+}
+
+DolphinSelectionSnapshot& DolphinSelectionSnapshot::operator=(const DolphinSelectionSnapshot& other)
+{
+    d = other.d;
+    return *this;
+}
+
+int DolphinSelectionSnapshot::count() const
+{
+    return d->model ? d->indexes.count() : 0;
+}
+
+bool DolphinSelectionSnapshot::isEmpty() const
+{
+    return count() == 0;
+}
+
+KItemSet DolphinSelectionSnapshot::indexes() const
+{
+    return d->model ? d->indexes : KItemSet();
+}
+
+KFileItem DolphinSelectionSnapshot::first() const
+{
+    return isEmpty() ? KFileItem() : d->model->fileItem(d->indexes.first());
+}
+
+bool DolphinSelectionSnapshot::isSingleDirectory() const
+{
+    return count() == 1 && first().isDir();
+}
+
+int DolphinSelectionSnapshot::folderCount() const
+{
+    calculateSummary();
+    return d->folderCount;
+}
+
+int DolphinSelectionSnapshot::fileCount() const
+{
+    calculateSummary();
+    return d->fileCount;
+}
+
+KIO::filesize_t DolphinSelectionSnapshot::totalFileSize() const
+{
+    calculateSummary();
+    return d->totalFileSize;
+}
+
+bool DolphinSelectionSnapshot::isLocal() const
+{
+    calculateCapabilities();
+    return d->isLocal;
+}
+
+bool DolphinSelectionSnapshot::supportsDeleting() const
+{
+    calculateCapabilities();
+    return d->supportsDeleting;
+}
+
+bool DolphinSelectionSnapshot::supportsMoving() const
+{
+    calculateCapabilities();
+    return d->supportsMoving;
+}
+
+KFileItemList DolphinSelectionSnapshot::items() const
+{
+    if (!d->itemsValid) {
+        d->items.clear();
+        d->items.reserve(count());
+        const const_iterator endIt = end();
+        for (const_iterator it = begin(); it != endIt; ++it) {
+            d->items.append(*it);
+        }
+        d->itemsValid = true;
+    }
+    return d->items;
+}
+
+DolphinSelectionSnapshot::const_iterator DolphinSelectionSnapshot::begin() const
+{
+    return d->model ? const_iterator(d->model, d->indexes.begin())
+                    : const_iterator(0, d->indexes.end());
+}
+
+DolphinSelectionSnapshot::const_iterator DolphinSelectionSnapshot::end() const
+{
+    return const_iterator(d->model, d->indexes.end());
+}
+
+void DolphinSelectionSnapshot::calculateSummary() const
+{
+    if (d->summaryValid) {
+        return;
+    }
+
+    d->folderCount = 0;
+    d->fileCount = 0;
+    d->totalFileSize = 0;
+
+    const const_iterator endIt = end();
+    for (const_iterator it = begin(); it != endIt; ++it) {
+        const KFileItem item = *it;
+        if (item.isDir()) {
+            ++d->folderCount;
+        } else {
+            ++d->fileCount;
+            d->totalFileSize += item.size();
+        }
+    }
+    d->summaryValid = true;
+}
+
+void DolphinSelectionSnapshot::calculateCapabilities() const
+{
+    if (d->capabilitiesValid) {
+        return;
+    }
+
+    // The same rules as in KFileItemListProperties are used. The capabilities
+    // of the protocol and the permissions of the parent directory are only
+    // checked again if they differ from the previous item, which is rarely
+    // the case for the selected items of one view.
+    d->isLocal = true;
+    d->supportsDeleting = !isEmpty();
+    d->supportsMoving = !isEmpty();
+
+    QString protocol;
+    bool protocolSupportsDeleting = false;
+    bool protocolSupportsMoving = false;
+
+    QString directory;
+    bool directoryWritable = false;
+
+    const const_iterator endIt = end();
+    for (const_iterator it = begin(); it != endIt; ++it) {
+        if (!d->isLocal && !d->supportsDeleting && !d->supportsMoving) {
+            // The results cannot change anymore.
+            break;
+        }
+
+        const KUrl url = (*it).url();
+        d->isLocal = d->isLocal && url.isLocalFile();
+
+        if (protocol.isEmpty() || url.protocol() != protocol) {
+            protocol = url.protocol();
+            protocolSupportsDeleting = KProtocolManager::supportsDeleting(url);
+            protocolSupportsMoving = KProtocolManager::supportsMoving(url);
+        }
+        d->supportsDeleting = d->supportsDeleting && protocolSupportsDeleting;
+        d->supportsMoving = d->supportsMoving && protocolSupportsMoving;
+
+        // For local files the write permission of the parent directory is checked
+        if (d->isLocal && (d->supportsDeleting || d->supportsMoving)) {
+            const QString itemDirectory = url.directory();
+            if (directory.isEmpty() || itemDirectory != directory) {
+                directory = itemDirectory;
+                directoryWritable = QFileInfo(directory).isWritable();
+            }
+            if (!directoryWritable) {
+                d->supportsDeleting = false;
+                d->supportsMoving = false;
+            }
+        }
+    }
+    d->capabilitiesValid = true;
+}
+
+#include "dolphinselectionsnapshot.moc"
@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef DOLPHINSELECTIONSNAPSHOT_H
+#define DOLPHINSELECTIONSNAPSHOT_H
+
+#include "libdolphin_export.h"
+
+#include <kitemviews/kitemset.h>
+
+#include <KFileItem>
+#include <kio/global.h>
+
+#include <QExplicitlySharedDataPointer>
+
+class DolphinSelectionSnapshotPrivate;
+class KFileItemModel;
+
+/**
+ * @brief Lightweight description of the selected items of a DolphinView.
+ *
+ * Creating a snapshot only copies the selected indexes, which are stored
+ * as ranges (see KItemSet). The KFileItems are taken from the model when
+ * they are accessed:
+ * - count() and isSingleDirectory() are cheap.
+ * - folderCount(), fileCount() and totalFileSize() iterate the selected
+ *   items once. The results are cached.
+ * - isLocal(), supportsDeleting() and supportsMoving() iterate the selected
+ *   items once as well. The results are cached.
+ * - items() creates a KFileItemList. It is cached as well, so it should
+ *   only be used by code that really needs a list of all items.
+ *
+ * All copies of a snapshot share the cached values. The indexes of the
+ * snapshot are adjusted if items are inserted into, removed from or moved
+ * inside the model, so a snapshot can safely be stored.
+ */
+class LIBDOLPHINPRIVATE_EXPORT DolphinSelectionSnapshot
+{
+public:
+    class const_iterator
+    {
+    public:
+        KFileItem operator*() const;
+        const_iterator& operator++();
+
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+
+    private:
+        const_iterator(const KFileItemModel* model, const KItemSet::const_iterator& it);
+
+        const KFileItemModel* m_model;
+        KItemSet::const_iterator m_it;
+
+        friend class DolphinSelectionSnapshot;
+    };
+
+    DolphinSelectionSnapshot();
+    DolphinSelectionSnapshot(KFileItemModel* model, const KItemSet& indexes);
+    DolphinSelectionSnapshot(const DolphinSelectionSnapshot& other);
+    ~DolphinSelectionSnapshot();
+
+    DolphinSelectionSnapshot& operator=(const DolphinSelectionSnapshot& other);
+
+    int count() const;
+    bool isEmpty() const;
+
+    /**
+     * @return Indexes of the selected items in the model.
+     */
+    KItemSet indexes() const;
+
+    /**
+     * @return Selected item with the smallest index or a null item if
+     *         nothing is selected.
+     */
+    KFileItem first() const;
+
+    /**
+     * @return True if exactly one item is selected and if it is a directory.
+     */
+    bool isSingleDirectory() const;
+
+    int folderCount() const;
+    int fileCount() const;
+
+    /**
+     * @return Summed size of all selected files. The size of directories
+     *         is not taken into account.
+     */
+    KIO::filesize_t totalFileSize() const;
+
+    /**
+     * @return True if all selected items are local files.
+     */
+    bool isLocal() const;
+
+    /**
+     * @return True if all selected items may be deleted. The result is
+     *         the same as KFileItemListProperties::supportsDeleting()
+     *         for items(), but no list of the items is created.
+     */
+    bool supportsDeleting() const;
+
+    /**
+     * @return True if all selected items may be moved. The result is
+     *         the same as KFileItemListProperties::supportsMoving()
+     *         for items(), but no list of the items is created.
+     */
+    bool supportsMoving() const;
+
+    /**
+     * @return All selected items sorted by their index.
+     */
+    KFileItemList items() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    void calculateSummary() const;
+    void calculateCapabilities() const;
+
+private:
+    QExplicitlySharedDataPointer<DolphinSelectionSnapshotPrivate> d;
+};
+
+#endif
@@ -99,6 +99,7 @@ DolphinView::DolphinView(const KUrl& url, QWidget* parent) :
     m_container(0),
     m_toolTipManager(0),
     m_selectionChangedTimer(0),
+    m_selection(),
     m_currentItemUrl(),
     m_scrollToCurrentItem(false),
     m_restoredContentsPosition(),
@@ -145,7 +146,7 @@ DolphinView::DolphinView(const KUrl& url, QWidget* parent) :
 
     controller->setSelectionBehavior(KItemListController::MultiSelection);
     connect(controller, SIGNAL(itemActivated(int)), this, SLOT(slotItemActivated(int)));
-    connect(controller, SIGNAL(itemsActivated(QSet<int>)), this, SLOT(slotItemsActivated(QSet<int>)));
+    connect(controller, SIGNAL(itemsActivated(KItemSet)), this, SLOT(slotItemsActivated(KItemSet)));
     connect(controller, SIGNAL(itemMiddleClicked(int)), this, SLOT(slotItemMiddleClicked(int)));
     connect(controller, SIGNAL(itemContextMenuRequested(int,QPointF)), this, SLOT(slotItemContextMenuRequested(int,QPointF)));
     connect(controller, SIGNAL(viewContextMenuRequested(QPointF)), this, SLOT(slotViewContextMenuRequested(QPointF)));
@@ -183,8 +184,8 @@ DolphinView::DolphinView(const KUrl& url, QWidget* parent) :
             this, SLOT(slotHeaderColumnWidthChanged(QByteArray,qreal,qreal)));
 
     KItemListSelectionManager* selectionManager = controller->selectionManager();
-    connect(selectionManager, SIGNAL(selectionChanged(QSet<int>,QSet<int>)),
-            this, SLOT(slotSelectionChanged(QSet<int>,QSet<int>)));
+    connect(selectionManager, SIGNAL(selectionChanged(KItemSet,KItemSet)),
+            this, SLOT(slotSelectionChanged(KItemSet,KItemSet)));
 
     m_toolTipManager = new ToolTipManager(this);
 
@@ -193,6 +194,10 @@ DolphinView::DolphinView(const KUrl& url, QWidget* parent) :
     connect(m_versionControlObserver, SIGNAL(infoMessage(QString)), this, SIGNAL(infoMessage(QString)));
     connect(m_versionControlObserver, SIGNAL(errorMessage(QString)), this, SIGNAL(errorMessage(QString)));
     connect(m_versionControlObserver, SIGNAL(operationCompletedMessage(QString)), this, SIGNAL(operationCompletedMessage(QString)));
+    // The visible items are changed by scrolling, by layout changes and by resizing
+    connect(m_view, SIGNAL(scrollOffsetChanged(qreal,qreal)), this, SLOT(updateVisibleIndexRange()));
+    connect(m_view, SIGNAL(maximumScrollOffsetChanged(qreal,qreal)), this, SLOT(updateVisibleIndexRange()));
+    connect(m_view, SIGNAL(geometryChanged()), this, SLOT(updateVisibleIndexRange()), Qt::QueuedConnection);
 
     applyViewProperties();
     m_topLayout->addWidget(m_container);
@@ -348,18 +353,20 @@ int DolphinView::itemsCount() const
 
 KFileItemList DolphinView::selectedItems() const
 {
-    const KItemListSelectionManager* selectionManager = m_container->controller()->selectionManager();
-    QList<int> selectedIndexes = selectionManager->selectedItems().toList();
+    return selection().items();
+}
 
-    qSort(selectedIndexes);
+DolphinSelectionSnapshot DolphinView::selection() const
+{
+    const KItemListSelectionManager* selectionManager = m_container->controller()->selectionManager();
+    const KItemSet selectedIndexes = selectionManager->selectedItems();
 
-    KFileItemList selectedItems;
-    QListIterator<int> it(selectedIndexes);
-    while (it.hasNext()) {
-        const int index = it.next();
-        selectedItems.append(m_model->fileItem(index));
+    // The indexes of the snapshot are kept in sync with the model, so the
+    // snapshot can be reused as long as the selection is unchanged.
+    if (m_selection.indexes() != selectedIndexes) {
+        m_selection = DolphinSelectionSnapshot(m_model, selectedIndexes);
     }
-    return selectedItems;
+    return m_selection;
 }
 
 int DolphinView::selectedItemsCount() const
@@ -386,16 +393,23 @@ void DolphinView::selectItems(const QRegExp& pattern, bool enabled)
                                                         : KItemListSelectionManager::Deselect;
     KItemListSelectionManager* selectionManager = m_container->controller()->selectionManager();
 
+    // Collect the matching items first and change the selection in one go,
+    // such that the selectionChanged() signal is only emitted once.
+    KItemSet matchingItems;
     for (int index = 0; index < m_model->count(); index++) {
         const KFileItem item = m_model->fileItem(index);
         if (pattern.exactMatch(item.text())) {
-            // An alternative approach would be to store the matching items in a QSet<int> and
-            // select them in one go after the loop, but we'd need a new function
-            // KItemListSelectionManager::setSelected(QSet<int>, SelectionMode mode)
-            // for that.
-            selectionManager->setSelected(index, 1, mode);
+            matchingItems.insert(index);
         }
     }
+
+    if (!matchingItems.isEmpty()) {
+        selectionManager->endAnchoredSelection();
+        const KItemSet selectedItems = selectionManager->selectedItems();
+        selectionManager->setSelectedItems(mode == KItemListSelectionManager::Select
+                                           ? selectedItems + matchingItems
+                                           : selectedItems - matchingItems);
+    }
 }
 
 void DolphinView::setZoomLevel(int level)
@@ -404,6 +418,7 @@ void DolphinView::setZoomLevel(int level)
     m_view->setZoomLevel(level);
     if (zoomLevel() != oldZoomLevel) {
         hideToolTip();
+        updateVisibleIndexRange();
         emit zoomLevelChanged(zoomLevel(), oldZoomLevel);
     }
 }
@@ -545,21 +560,15 @@ QString DolphinView::statusBarText() const
 
     if (m_container->controller()->selectionManager()->hasSelection()) {
         // Give a summary of the status of the selected files
-        const KFileItemList list = selectedItems();
-        foreach (const KFileItem& item, list) {
-            if (item.isDir()) {
-                ++folderCount;
-            } else {
-                ++fileCount;
-                totalFileSize += item.size();
-            }
-        }
-
-        if (folderCount + fileCount == 1) {
+        const DolphinSelectionSnapshot selection = this->selection();
+        if (selection.count() == 1) {
             // If only one item is selected, show info about it
-            return list.first().getStatusBarInfo();
+            return selection.first().getStatusBarInfo();
         } else {
             // At least 2 items are selected
+            folderCount = selection.folderCount();
+            fileCount = selection.fileCount();
+            totalFileSize = selection.totalFileSize();
             foldersText = i18ncp("@info:status", "1 Folder selected", "%1 Folders selected", folderCount);
             filesText = i18ncp("@info:status", "1 File selected", "%1 Files selected", fileCount);
         }
@@ -802,7 +811,7 @@ void DolphinView::slotItemActivated(int index)
     }
 }
 
-void DolphinView::slotItemsActivated(const QSet<int>& indexes)
+void DolphinView::slotItemsActivated(const KItemSet& indexes)
 {
     Q_ASSERT(indexes.count() >= 2);
 
@@ -817,9 +826,7 @@ void DolphinView::slotItemsActivated(const QSet<int>& indexes)
     KFileItemList items;
     items.reserve(indexes.count());
 
-    QSetIterator<int> it(indexes);
-    while (it.hasNext()) {
-        const int index = it.next();
+    foreach (int index, indexes) {
         KFileItem item = m_model->fileItem(index);
         const KUrl& url = openItemAsFolderUrl(item);
 
@@ -1092,6 +1099,12 @@ void DolphinView::slotMouseButtonPressed(int itemIndex, Qt::MouseButtons buttons
     }
 }
 
+void DolphinView::updateVisibleIndexRange()
+{
+    const int index = m_view->firstVisibleIndex();
+    m_versionControlObserver->setVisibleIndexRange(index, m_view->lastVisibleIndex() - index + 1);
+}
+
 void DolphinView::slotAboutToCreate(const KUrl::List& urls)
 {
     if (!urls.isEmpty()) {
@@ -1103,7 +1116,7 @@ void DolphinView::slotAboutToCreate(const KUrl::List& urls)
     }
 }
 
-void DolphinView::slotSelectionChanged(const QSet<int>& current, const QSet<int>& previous)
+void DolphinView::slotSelectionChanged(const KItemSet& current, const KItemSet& previous)
 {
     const int currentCount = current.count();
     const int previousCount = previous.count();
@@ -1120,7 +1133,7 @@ void DolphinView::slotSelectionChanged(const QSet<int>& current, const QSet<int>
 void DolphinView::emitSelectionChangedSignal()
 {
     m_selectionChangedTimer->stop();
-    emit selectionChanged(selectedItems());
+    emit selectionChanged(selection());
 }
 
 void DolphinView::updateSortRole(const QByteArray& role)
@@ -1322,7 +1335,7 @@ void DolphinView::updateViewState()
             m_clearSelectionBeforeSelectingNewItems = false;
         }
 
-        QSet<int> selectedItems = selectionManager->selectedItems();
+        KItemSet selectedItems = selectionManager->selectedItems();
 
         QList<KUrl>::iterator it = m_selectedUrls.begin();
         while (it != m_selectedUrls.end()) {
@@ -1409,6 +1422,7 @@ void DolphinView::slotDirectoryLoadingCompleted()
     // because the view might not be in its final state yet.
     QTimer::singleShot(0, this, SLOT(updateViewState()));
 
+    updateVisibleIndexRange();
     emit directoryLoadingCompleted();
 
     updateWritableState();
@@ -1538,6 +1552,7 @@ void DolphinView::applyViewProperties(const ViewProperties& props)
         // that zoomLevelChanged() can get emitted.
         const int oldZoomLevel = m_view->zoomLevel();
         applyModeToView();
+        updateVisibleIndexRange();
 
         emit modeChanged(m_mode, previousMode);
 
@@ -1658,7 +1673,7 @@ KUrl::List DolphinView::simplifiedSelectedUrls() const
 QMimeData* DolphinView::selectionMimeData() const
 {
     const KItemListSelectionManager* selectionManager = m_container->controller()->selectionManager();
-    const QSet<int> selectedIndexes = selectionManager->selectedItems();
+    const KItemSet selectedIndexes = selectionManager->selectedItems();
 
     return m_model->createMimeData(selectedIndexes);
 }
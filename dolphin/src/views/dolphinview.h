@@ -24,6 +24,7 @@
 #include <config-nepomuk.h>
 
 #include "libdolphin_export.h"
+#include "dolphinselectionsnapshot.h"
 
 #include <kparts/part.h>
 #include <KFileItem>
@@ -45,6 +46,7 @@ class KActionCollection;
 class KFileItemModel;
 class KItemListContainer;
 class KItemModelBase;
+class KItemSet;
 class KUrl;
 class ToolTipManager;
 class VersionControlObserver;
@@ -162,10 +164,18 @@ public:
 
     /**
      * Returns the selected items. The list is empty if no item has been
-     * selected.
+     * selected. Prefer selection() if not all items are required.
      */
     KFileItemList selectedItems() const;
 
+    /**
+     * Returns a snapshot of the current selection. Creating the snapshot
+     * is cheap, the file items are only accessed on demand. Snapshots of
+     * an unchanged selection share the cached information, e.g., the list
+     * of items and the summed size of the files.
+     */
+    DolphinSelectionSnapshot selection() const;
+
     /**
      * Returns the number of selected items (this is faster than
      * invoking selectedItems().count()).
@@ -452,7 +462,7 @@ signals:
     /**
      * Is emitted whenever the selection has been changed.
      */
-    void selectionChanged(const KFileItemList& selection);
+    void selectionChanged(const DolphinSelectionSnapshot& selection);
 
     /**
      * Is emitted if a context menu is requested for the item \a item,
@@ -562,7 +572,7 @@ private slots:
     void activate();
 
     void slotItemActivated(int index);
-    void slotItemsActivated(const QSet<int>& indexes);
+    void slotItemsActivated(const KItemSet& indexes);
     void slotItemMiddleClicked(int index);
     void slotItemContextMenuRequested(int index, const QPointF& pos);
     void slotViewContextMenuRequested(const QPointF& pos);
@@ -574,6 +584,12 @@ private slots:
     void slotModelChanged(KItemModelBase* current, KItemModelBase* previous);
     void slotMouseButtonPressed(int itemIndex, Qt::MouseButtons buttons);
 
+    /**
+     * Passes the visible items to the version control observer,
+     * which updates the version states of these items first.
+     */
+    void updateVisibleIndexRange();
+
     /*
      * Is called when new items get pasted or dropped.
      */
@@ -581,16 +597,16 @@ private slots:
 
     /**
      * Emits the signal \a selectionChanged() with a small delay. This is
-     * because getting all file items for the selection can be an expensive
-     * operation. Fast selection changes are collected in this case and
-     * the signal is emitted only after no selection change has been done
+     * because evaluating the selected items can be an expensive operation
+     * for the receivers. Fast selection changes are collected in this case
+     * and the signal is emitted only after no selection change has been done
      * within a small delay.
      */
-    void slotSelectionChanged(const QSet<int>& current, const QSet<int>& previous);
+    void slotSelectionChanged(const KItemSet& current, const KItemSet& previous);
 
     /**
      * Is called by emitDelayedSelectionChangedSignal() and emits the
-     * signal \a selectionChanged() with all selected file items as parameter.
+     * signal \a selectionChanged() with a snapshot of the selection.
      */
     void emitSelectionChangedSignal();
 
@@ -780,6 +796,7 @@ private:
     ToolTipManager* m_toolTipManager;
 
     QTimer* m_selectionChangedTimer;
+    mutable DolphinSelectionSnapshot m_selection; // Last snapshot returned by selection()
 
     KUrl m_currentItemUrl; // Used for making the view to remember the current URL after F5
     bool m_scrollToCurrentItem; // Used for marking we need to scroll to current item or not
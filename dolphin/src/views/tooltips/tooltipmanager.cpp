@@ -20,6 +20,7 @@
 #include "tooltipmanager.h"
 
 #include "filemetadatatooltip.h"
+#include <kitemviews/private/kpreviewcache.h>
 #include <KIcon>
 #include <KIO/JobUiDelegate>
 #include <KIO/PreviewJob>
@@ -126,7 +127,14 @@ void ToolTipManager::startContentRetrieval()
     m_fileMetaDataToolTip->setItems(KFileItemList() << m_item);
     m_fileMetaDataToolTip->adjustSize();
 
-    // Request a preview of the item
+    // Request a preview of the item, unless it is available in the
+    // shared preview cache already
+    QPixmap cachedPixmap;
+    if (KPreviewCache::instance()->find(m_item, QSize(256, 256), cachedPixmap)) {
+        setPreviewPix(m_item, cachedPixmap);
+        return;
+    }
+
     m_fileMetaDataToolTip->setPreview(QPixmap());
 
     KIO::PreviewJob* job = new KIO::PreviewJob(KFileItemList() << m_item, QSize(256, 256));
@@ -153,6 +161,7 @@ void ToolTipManager::setPreviewPix(const KFileItem& item,
     if (pixmap.isNull()) {
         previewFailed();
     } else {
+        KPreviewCache::instance()->insert(item, QSize(256, 256), pixmap);
         m_fileMetaDataToolTip->setPreview(pixmap);
         if (!m_showToolTipTimer->isActive()) {
             showToolTip();
@@ -21,21 +21,26 @@
 
 #include <kversioncontrolplugin2.h>
 
+#include <QHash>
 #include <QMutexLocker>
 
+namespace {
+    // Number of item states that are retrieved before they are
+    // provided by UpdateItemStatesThread::takeItemStates().
+    const int BatchSize = 200;
+}
+
 UpdateItemStatesThread::UpdateItemStatesThread(KVersionControlPlugin* plugin,
-                                     const QList<VersionControlObserver::ItemState>& itemStates) :
+                                               const QString& directory,
+                                               const KFileItemList& items) :
     QThread(),
-    m_globalPluginMutex(0),
     m_plugin(plugin),
+    m_directory(directory),
+    m_items(items),
     m_retrievedItems(false),
-    m_itemStates(itemStates)
+    m_itemStatesMutex(),
+    m_itemStates()
 {
-    // Several threads may share one instance of a plugin. A global
-    // mutex is required to serialize the retrieval of version control
-    // states inside run().
-    static QMutex globalMutex;
-    m_globalPluginMutex = &globalMutex;
 }
 
 UpdateItemStatesThread::~UpdateItemStatesThread()
@@ -44,25 +49,39 @@ UpdateItemStatesThread::~UpdateItemStatesThread()
 
 void UpdateItemStatesThread::run()
 {
-    Q_ASSERT(!m_itemStates.isEmpty());
+    Q_ASSERT(!m_items.isEmpty());
     Q_ASSERT(m_plugin);
 
-    const QString directory = m_itemStates.first().item.url().directory(KUrl::AppendTrailingSlash);
     m_retrievedItems = false;
 
-    QMutexLocker pluginLocker(m_globalPluginMutex);
-    if (m_plugin->beginRetrieval(directory)) {
-        const int count = m_itemStates.count();
+    // Plugins that are not reentrant can be used by one thread at a time
+    // only. If no mutex is required, QMutexLocker does nothing.
+    const bool reentrant = m_plugin->property("reentrant").toBool();
+    QMutexLocker pluginLocker(reentrant ? 0 : pluginMutex(m_plugin));
 
+    if (m_plugin->beginRetrieval(m_directory)) {
         KVersionControlPlugin2* pluginV2 = qobject_cast<KVersionControlPlugin2*>(m_plugin);
-        if (pluginV2) {
-            for (int i = 0; i < count; ++i) {
-                m_itemStates[i].version = pluginV2->itemVersion(m_itemStates[i].item);
+
+        QList<VersionControlObserver::ItemState> itemStates;
+        const int count = m_items.count();
+        for (int i = 0; i < count; ++i) {
+            VersionControlObserver::ItemState itemState;
+            itemState.item = m_items.at(i);
+            if (pluginV2) {
+                itemState.version = pluginV2->itemVersion(itemState.item);
+            } else {
+                const KVersionControlPlugin::VersionState state = m_plugin->versionState(itemState.item);
+                itemState.version = static_cast<KVersionControlPlugin2::ItemVersion>(state);
             }
-        } else {
-            for (int i = 0; i < count; ++i) {
-                const KVersionControlPlugin::VersionState state = m_plugin->versionState(m_itemStates[i].item);
-                m_itemStates[i].version = static_cast<KVersionControlPlugin2::ItemVersion>(state);
+            itemStates.append(itemState);
+
+            if (itemStates.count() >= BatchSize || i == count - 1) {
+                QMutexLocker locker(&m_itemStatesMutex);
+                m_itemStates.append(itemStates);
+                locker.unlock();
+
+                itemStates.clear();
+                emit itemStatesAvailable();
             }
         }
 
@@ -71,24 +90,32 @@ void UpdateItemStatesThread::run()
     }
 }
 
-bool UpdateItemStatesThread::lockPlugin()
+QList<VersionControlObserver::ItemState> UpdateItemStatesThread::takeItemStates()
 {
-    return m_globalPluginMutex->tryLock(300);
+    QMutexLocker locker(&m_itemStatesMutex);
+    QList<VersionControlObserver::ItemState> itemStates = m_itemStates;
+    m_itemStates.clear();
+    return itemStates;
 }
 
-void UpdateItemStatesThread::unlockPlugin()
+bool UpdateItemStatesThread::retrievedItems() const
 {
-    m_globalPluginMutex->unlock();
+    return m_retrievedItems;
 }
 
-QList<VersionControlObserver::ItemState> UpdateItemStatesThread::itemStates() const
+QMutex* UpdateItemStatesThread::pluginMutex(KVersionControlPlugin* plugin)
 {
-    return m_itemStates;
-}
+    // The plugins are never deleted (see VersionControlObserver::searchPlugin()),
+    // so the mutexes are kept too.
+    static QMutex mutexesMutex;
+    static QHash<KVersionControlPlugin*, QMutex*> mutexes;
 
-bool UpdateItemStatesThread::retrievedItems() const
-{
-    return m_retrievedItems;
+    QMutexLocker locker(&mutexesMutex);
+    QMutex*& mutex = mutexes[plugin];
+    if (!mutex) {
+        mutex = new QMutex();
+    }
+    return mutex;
 }
 
 #include "updateitemstatesthread.moc"
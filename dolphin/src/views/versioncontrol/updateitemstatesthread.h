@@ -32,6 +32,10 @@ class KVersionControlPlugin;
  * The performance of updating the version state of items depends
  * on the used plugin. To prevent that Dolphin gets blocked by a
  * slow plugin, the updating is delegated to a thread.
+ *
+ * The states are retrieved in the order of the given items and are
+ * provided in batches, so that the caller can apply the states of the
+ * first items before the states of all items are available.
  */
 class LIBDOLPHINPRIVATE_EXPORT UpdateItemStatesThread : public QThread
 {
@@ -40,41 +44,51 @@ class LIBDOLPHINPRIVATE_EXPORT UpdateItemStatesThread : public QThread
 public:
     /**
      * @param plugin     Version control plugin that is used to update the
-     *                   state of the items. Whenever the plugin is accessed
-     *                   from the thread creator after starting the thread,
-     *                   UpdateItemStatesThread::lockPlugin() and
-     *                   UpdateItemStatesThread::unlockPlugin() must be used.
-     * @param itemStates List of items, where the states get updated.
+     *                   state of the items. Several threads may share one
+     *                   instance of a plugin, so the retrieval is serialized
+     *                   per plugin. Plugins that set the property "reentrant"
+     *                   to true are accessed by several threads in parallel.
+     * @param directory  Directory that is passed to KVersionControlPlugin::beginRetrieval().
+     * @param items      List of items, where the states get updated.
      */
     UpdateItemStatesThread(KVersionControlPlugin* plugin,
-                           const QList<VersionControlObserver::ItemState>& itemStates);
+                           const QString& directory,
+                           const KFileItemList& items);
     virtual ~UpdateItemStatesThread();
 
     /**
-     * Whenever the plugin is accessed by the thread creator, lockPlugin() must
-     * be invoked. True is returned, if the plugin could be locked within 300
-     * milliseconds.
+     * Returns the states that have been retrieved since the last
+     * invocation of takeItemStates(). May be invoked while the
+     * thread is running.
      */
-    bool lockPlugin();
+    QList<VersionControlObserver::ItemState> takeItemStates();
 
+    bool retrievedItems() const;
+
+signals:
     /**
-     * Must be invoked if lockPlugin() returned true and plugin has been accessed
-     * by the thread creator.
+     * Is emitted if the states of a batch of items have been retrieved.
+     * The states can be fetched by takeItemStates().
      */
-    void unlockPlugin();
-
-    QList<VersionControlObserver::ItemState> itemStates() const;
-
-    bool retrievedItems() const;
+    void itemStatesAvailable();
 
 protected:
     virtual void run();
 
 private:
-    QMutex* m_globalPluginMutex; // Protects the m_plugin globally
+    /**
+     * @return Mutex that serializes the access to \a plugin.
+     */
+    static QMutex* pluginMutex(KVersionControlPlugin* plugin);
+
+private:
     KVersionControlPlugin* m_plugin;
+    QString m_directory;
+    KFileItemList m_items;
 
     bool m_retrievedItems;
+
+    QMutex m_itemStatesMutex; // Protects m_itemStates
     QList<VersionControlObserver::ItemState> m_itemStates;
 };
 
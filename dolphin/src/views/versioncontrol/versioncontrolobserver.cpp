@@ -30,7 +30,6 @@
 #include "updateitemstatesthread.h"
 
 #include <QFile>
-#include <QMutexLocker>
 #include <QTimer>
 
 VersionControlObserver::VersionControlObserver(QObject* parent) :
@@ -39,6 +38,13 @@ VersionControlObserver::VersionControlObserver(QObject* parent) :
     m_versionedDirectory(false),
     m_silentUpdate(false),
     m_model(0),
+    m_directory(),
+    m_firstVisibleIndex(0),
+    m_lastVisibleIndex(-1),
+    m_allItemsChanged(true),
+    m_changedUrls(),
+    m_itemVersions(),
+    m_cachedVersionUrls(),
     m_dirVerificationTimer(0),
     m_plugin(0),
     m_updateItemStatesThread(0)
@@ -67,18 +73,27 @@ void VersionControlObserver::setModel(KFileItemModel* model)
 {
     if (m_model) {
         disconnect(m_model, SIGNAL(itemsInserted(KItemRangeList)),
-                   this, SLOT(delayedDirectoryVerification()));
+                   this, SLOT(slotItemsInserted(KItemRangeList)));
         disconnect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
-                   this, SLOT(delayedDirectoryVerification()));
+                   this, SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
+        disconnect(m_model, SIGNAL(directoryLoadingStarted()),
+                   this, SLOT(slotDirectoryLoadingStarted()));
     }
 
     m_model = model;
+    m_allItemsChanged = true;
+    m_changedUrls.clear();
+    m_itemVersions.clear();
+    m_cachedVersionUrls.clear();
+    m_directory = KUrl();
 
     if (model) {
         connect(m_model, SIGNAL(itemsInserted(KItemRangeList)),
-                this, SLOT(delayedDirectoryVerification()));
+                this, SLOT(slotItemsInserted(KItemRangeList)));
         connect(m_model, SIGNAL(itemsChanged(KItemRangeList,QSet<QByteArray>)),
-                this, SLOT(delayedDirectoryVerification()));
+                this, SLOT(slotItemsChanged(KItemRangeList,QSet<QByteArray>)));
+        connect(m_model, SIGNAL(directoryLoadingStarted()),
+                this, SLOT(slotDirectoryLoadingStarted()));
     }
 }
 
@@ -127,6 +142,12 @@ QList<QAction*> VersionControlObserver::actions(const KFileItemList& items) cons
     return actions;
 }
 
+void VersionControlObserver::setVisibleIndexRange(int index, int count)
+{
+    m_firstVisibleIndex = index;
+    m_lastVisibleIndex = index + count - 1;
+}
+
 void VersionControlObserver::delayedDirectoryVerification()
 {
     m_silentUpdate = false;
@@ -154,15 +175,22 @@ void VersionControlObserver::verifyDirectory()
         m_plugin->disconnect(this);
     }
 
+    KVersionControlPlugin* previousPlugin = m_plugin;
     m_plugin = searchPlugin(rootItem.url());
+    if (m_plugin != previousPlugin) {
+        // The cached states have been retrieved by another plugin
+        m_itemVersions.clear();
+        m_allItemsChanged = true;
+    }
+
     if (m_plugin) {
         KVersionControlPlugin2* pluginV2 = qobject_cast<KVersionControlPlugin2*>(m_plugin);
         if (pluginV2) {
             connect(pluginV2, SIGNAL(itemVersionsChanged()),
-                    this, SLOT(silentDirectoryVerification()));
+                    this, SLOT(slotItemVersionsChanged()));
         } else {
             connect(m_plugin, SIGNAL(versionStatesChanged()),
-                    this, SLOT(silentDirectoryVerification()));
+                    this, SLOT(slotItemVersionsChanged()));
         }
         connect(m_plugin, SIGNAL(infoMessage(QString)),
                 this, SIGNAL(infoMessage(QString)));
@@ -179,13 +207,140 @@ void VersionControlObserver::verifyDirectory()
             m_dirVerificationTimer->setInterval(100);
         }
         updateItemStates();
-    } else if (m_versionedDirectory) {
-        m_versionedDirectory = false;
+    } else {
+        // Remember that all items must be updated as soon as a
+        // plugin is found, instead of collecting the changed items.
+        m_allItemsChanged = true;
+        m_changedUrls.clear();
+
+        if (m_versionedDirectory) {
+            m_versionedDirectory = false;
+
+            // The directory is not versioned. Reset the verification timer to a higher
+            // value, so that browsing through non-versioned directories is not slown down
+            // by an immediate verification.
+            m_dirVerificationTimer->setInterval(500);
+        }
+    }
+}
+
+void VersionControlObserver::slotItemsInserted(const KItemRangeList& itemRanges)
+{
+    int insertedCount = 0;
+    foreach (const KItemRange& range, itemRanges) {
+        insertedCount += range.count;
+    }
+    if (insertedCount == m_model->count()) {
+        // All items have been inserted, e.g. because a directory has been loaded
+        m_allItemsChanged = true;
+        m_changedUrls.clear();
+    }
+
+    // Remember the items that have a cached state, so that the user sees
+    // the last known states until the plugin has verified them. The states
+    // are applied asynchronously, as changing the model from inside the
+    // itemsInserted() signal would make all other receivers of the signal
+    // handle an itemsChanged() signal before they have seen the insertion.
+    const bool applyPending = !m_cachedVersionUrls.isEmpty();
+    int previouslyInsertedCount = 0;
+    foreach (const KItemRange& range, itemRanges) {
+        const int startIndex = range.index + previouslyInsertedCount;
+        for (int index = startIndex; index < startIndex + range.count; ++index) {
+            const KUrl url = m_model->fileItem(index).url();
+            if (!m_allItemsChanged) {
+                m_changedUrls.insert(url);
+            }
+
+            if (m_itemVersions.contains(url)) {
+                m_cachedVersionUrls.append(url);
+            }
+        }
+        previouslyInsertedCount += range.count;
+    }
+
+    if (!applyPending && !m_cachedVersionUrls.isEmpty()) {
+        QMetaObject::invokeMethod(this, "applyCachedItemVersions", Qt::QueuedConnection);
+    }
+
+    delayedDirectoryVerification();
+}
+
+void VersionControlObserver::applyCachedItemVersions()
+{
+    if (!m_model) {
+        m_cachedVersionUrls.clear();
+        return;
+    }
+
+    QHash<int, QHash<QByteArray, QVariant> > cachedValues;
+    foreach (const KUrl& url, m_cachedVersionUrls) {
+        const int index = m_model->index(url);
+        if (index < 0) {
+            continue;
+        }
+
+        QHash<KUrl, KVersionControlPlugin2::ItemVersion>::const_iterator it = m_itemVersions.constFind(url);
+        if (it != m_itemVersions.constEnd()) {
+            cachedValues[index].insert("version", QVariant(it.value()));
+        }
+    }
+    m_cachedVersionUrls.clear();
+
+    m_model->setItemsData(cachedValues);
+}
+
+void VersionControlObserver::slotItemsChanged(const KItemRangeList& itemRanges, const QSet<QByteArray>& roles)
+{
+    // Only changes of the files are relevant. Most changes are caused by
+    // resolving roles like the icon or the version, which don't require
+    // a new request of the states.
+    if (!roles.contains("text") && !roles.contains("date") && !roles.contains("size")) {
+        return;
+    }
+
+    if (!m_allItemsChanged) {
+        foreach (const KItemRange& range, itemRanges) {
+            for (int index = range.index; index < range.index + range.count; ++index) {
+                m_changedUrls.insert(m_model->fileItem(index).url());
+            }
+        }
+    }
+
+    delayedDirectoryVerification();
+}
+
+void VersionControlObserver::slotDirectoryLoadingStarted()
+{
+    const KUrl directory = m_model->directory();
+    if (directory.equals(m_directory, KUrl::CompareWithoutTrailingSlash)) {
+        // The directory is reloaded or subdirectories are expanded
+        return;
+    }
+    m_directory = directory;
+
+    // Only the cached states of items inside the new directory can be
+    // used again. The other states are removed, so that the cache does
+    // not grow while the user browses through versioned directories.
+    QMutableHashIterator<KUrl, KVersionControlPlugin2::ItemVersion> it(m_itemVersions);
+    while (it.hasNext()) {
+        it.next();
+        if (!directory.isParentOf(it.key())) {
+            it.remove();
+        }
+    }
+}
+
+void VersionControlObserver::slotItemVersionsChanged()
+{
+    m_allItemsChanged = true;
+    m_changedUrls.clear();
+    silentDirectoryVerification();
+}
 
-        // The directory is not versioned. Reset the verification timer to a higher
-        // value, so that browsing through non-versioned directories is not slown down
-        // by an immediate verification.
-        m_dirVerificationTimer->setInterval(500);
+void VersionControlObserver::slotItemStatesAvailable()
+{
+    if (m_updateItemStatesThread && sender() == m_updateItemStatesThread) {
+        applyItemStates(m_updateItemStatesThread->takeItemStates());
     }
 }
 
@@ -199,17 +354,15 @@ void VersionControlObserver::slotThreadFinished()
     }
 
     if (!thread->retrievedItems()) {
+        // Request the states of all items with the next update
+        m_allItemsChanged = true;
+
         // Ignore m_silentUpdate for an error message
         emit errorMessage(i18nc("@info:status", "Update of version information failed."));
         return;
     }
 
-    const QList<ItemState> itemStates = thread->itemStates();
-    foreach (const ItemState& itemState, itemStates) {
-        QHash<QByteArray, QVariant> values;
-        values.insert("version", QVariant(itemState.version));
-        m_model->setData(itemState.index, values);
-    }
+    applyItemStates(thread->takeItemStates());
 
     if (!m_silentUpdate) {
         // Using an empty message results in clearing the previously shown information message and showing
@@ -233,24 +386,16 @@ void VersionControlObserver::updateItemStates()
         m_pendingItemStatesUpdate = true;
         return;
     }
-    QList<ItemState> itemStates;
-    const int itemCount = m_model->count();
-    itemStates.reserve(itemCount);
-
-    for (int i = 0; i < itemCount; ++i) {
-        ItemState itemState;
-        itemState.index = i;
-        itemState.item = m_model->fileItem(i);
-        itemState.version = KVersionControlPlugin2::UnversionedVersion;
 
-        itemStates.append(itemState);
-    }
-
-    if (!itemStates.isEmpty()) {
+    const KFileItemList items = takeChangedItems();
+    if (!items.isEmpty()) {
         if (!m_silentUpdate) {
             emit infoMessage(i18nc("@info:status", "Updating version information..."));
         }
-        m_updateItemStatesThread = new UpdateItemStatesThread(m_plugin, itemStates);
+        const QString directory = m_model->rootItem().url().path(KUrl::AddTrailingSlash);
+        m_updateItemStatesThread = new UpdateItemStatesThread(m_plugin, directory, items);
+        connect(m_updateItemStatesThread, SIGNAL(itemStatesAvailable()),
+                this, SLOT(slotItemStatesAvailable()));
         connect(m_updateItemStatesThread, SIGNAL(finished()),
                 this, SLOT(slotThreadFinished()));
         connect(m_updateItemStatesThread, SIGNAL(finished()),
@@ -260,6 +405,56 @@ void VersionControlObserver::updateItemStates()
     }
 }
 
+KFileItemList VersionControlObserver::takeChangedItems()
+{
+    KFileItemList visibleItems;
+    KFileItemList invisibleItems;
+
+    if (m_allItemsChanged) {
+        const int itemCount = m_model->count();
+        invisibleItems.reserve(itemCount);
+        for (int index = 0; index < itemCount; ++index) {
+            if (index >= m_firstVisibleIndex && index <= m_lastVisibleIndex) {
+                visibleItems.append(m_model->fileItem(index));
+            } else {
+                invisibleItems.append(m_model->fileItem(index));
+            }
+        }
+    } else {
+        foreach (const KUrl& url, m_changedUrls) {
+            // Items that have been removed in the meantime are skipped
+            const int index = m_model->index(url);
+            if (index >= m_firstVisibleIndex && index <= m_lastVisibleIndex) {
+                visibleItems.append(m_model->fileItem(index));
+            } else if (index >= 0) {
+                invisibleItems.append(m_model->fileItem(index));
+            }
+        }
+    }
+
+    m_allItemsChanged = false;
+    m_changedUrls.clear();
+
+    return visibleItems + invisibleItems;
+}
+
+void VersionControlObserver::applyItemStates(const QList<ItemState>& itemStates)
+{
+    QHash<int, QHash<QByteArray, QVariant> > values;
+    foreach (const ItemState& itemState, itemStates) {
+        const KUrl url = itemState.item.url();
+        m_itemVersions.insert(url, itemState.version);
+
+        // The indexes might have been changed since the items
+        // have been passed to the thread.
+        const int index = m_model->index(url);
+        if (index >= 0) {
+            values[index].insert("version", QVariant(itemState.version));
+        }
+    }
+    m_model->setItemsData(values);
+}
+
 KVersionControlPlugin* VersionControlObserver::searchPlugin(const KUrl& directory) const
 {
     static bool pluginsAvailable = true;
@@ -24,9 +24,11 @@
 
 #include <KFileItem>
 #include <kversioncontrolplugin2.h>
+#include <kitemviews/kitemrange.h>
+#include <QHash>
 #include <QList>
-#include <QMutex>
 #include <QObject>
+#include <QSet>
 #include <QString>
 
 class KFileItemList;
@@ -41,6 +43,11 @@ class UpdateItemStatesThread;
  * The items of the directory-model get updated automatically if the currently
  * shown directory is under version control.
  *
+ * Only the states of items that have been inserted or changed are requested
+ * from the plugin, unless the plugin reports that the versions of all items
+ * might have been changed. The retrieved states are cached per URL, and the
+ * states of the visible items are requested and applied first.
+ *
  * @see VersionControlPlugin
  */
 class LIBDOLPHINPRIVATE_EXPORT VersionControlObserver : public QObject
@@ -56,6 +63,12 @@ public:
 
     QList<QAction*> actions(const KFileItemList& items) const;
 
+    /**
+     * Sets the range of items that are visible currently. The version
+     * states of the visible items are updated first.
+     */
+    void setVisibleIndexRange(int index, int count);
+
 signals:
     /**
      * Is emitted if an information message with the content \a msg
@@ -93,6 +106,34 @@ private slots:
 
     void verifyDirectory();
 
+    void slotItemsInserted(const KItemRangeList& itemRanges);
+
+    /**
+     * Applies the cached states of the items that have been inserted
+     * since the last call. Is invoked asynchronously by slotItemsInserted().
+     */
+    void applyCachedItemVersions();
+
+    void slotItemsChanged(const KItemRangeList& itemRanges, const QSet<QByteArray>& roles);
+
+    /**
+     * Removes the cached states of the items that are not inside
+     * the directory that is loaded.
+     */
+    void slotDirectoryLoadingStarted();
+
+    /**
+     * Is invoked if the plugin reports that the versions of the items
+     * might have been changed. Requests the states of all items.
+     */
+    void slotItemVersionsChanged();
+
+    /**
+     * Is invoked if the thread m_updateItemStatesThread has retrieved
+     * a batch of item states and applies them.
+     */
+    void slotItemStatesAvailable();
+
     /**
      * Is invoked if the thread m_updateItemStatesThread has been finished
      * and applys the item states.
@@ -102,13 +143,24 @@ private slots:
 private:
     struct ItemState
     {
-        int index;
         KFileItem item;
         KVersionControlPlugin2::ItemVersion version;
     };
 
     void updateItemStates();
 
+    /**
+     * @return Items whose states must be requested from the plugin. The
+     *         visible items are at the beginning of the list. Afterwards
+     *         no items are marked as changed anymore.
+     */
+    KFileItemList takeChangedItems();
+
+    /**
+     * Stores the states in m_itemVersions and applies them to the model.
+     */
+    void applyItemStates(const QList<ItemState>& itemStates);
+
     /**
      * Returns a matching plugin for the given directory.
      * 0 is returned, if no matching plugin has been found.
@@ -127,6 +179,15 @@ private:
                          // of version states
 
     KFileItemModel* m_model;
+    KUrl m_directory; // Directory for which m_itemVersions has been pruned
+
+    int m_firstVisibleIndex;
+    int m_lastVisibleIndex;
+
+    bool m_allItemsChanged; // If true, the states of all items are requested
+    QSet<KUrl> m_changedUrls; // Items whose states must be requested if m_allItemsChanged is false
+    QHash<KUrl, KVersionControlPlugin2::ItemVersion> m_itemVersions; // Cached states for m_plugin
+    QList<KUrl> m_cachedVersionUrls; // Inserted items whose cached states have not been applied yet
 
     QTimer* m_dirVerificationTimer;
 
@@ -22,14 +22,18 @@
 
 #include "dolphin_directoryviewpropertysettings.h"
 #include "dolphin_generalsettings.h"
+#include "viewpropertiesstore.h"
 
 #include <KComponentData>
 #include <KLocale>
 #include <KStandardDirs>
 #include <KUrl>
+#include <kde_file.h>
 
 #include <QCryptographicHash>
+#include <QDataStream>
 #include <QDate>
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
 
@@ -47,10 +51,26 @@ namespace {
     const char* ViewPropertiesFileName = ".directory";
 }
 
+ViewProperties::Data::Data() :
+    version(-1),
+    viewMode(DolphinView::IconsView),
+    previewsShown(false),
+    hiddenFilesShown(false),
+    groupedSorting(false),
+    sortRole(QLatin1String("text")),
+    sortOrder(Qt::AscendingOrder),
+    sortFoldersFirst(true),
+    visibleRoles(),
+    headerColumnWidths(),
+    timestamp()
+{
+}
+
 ViewProperties::ViewProperties(const KUrl& url) :
     m_changedProps(false),
     m_autoSave(true),
-    m_node(0)
+    m_filePath(),
+    m_data()
 {
     GeneralSettings* settings = GeneralSettings::self();
     const bool useGlobalViewProps = settings->globalViewProps() || url.isEmpty();
@@ -87,13 +107,13 @@ ViewProperties::ViewProperties(const KUrl& url) :
     }
 
     const QString file = m_filePath + QDir::separator() + ViewPropertiesFileName;
-    m_node = new ViewPropertySettings(KSharedConfig::openConfig(file));
+    const bool exists = readProperties(file, m_data);
+    const bool converted = exists && (m_data.version < CurrentViewPropertiesVersion);
 
     // If the .directory file does not exist or the timestamp is too old,
     // use default values instead.
     const bool useDefaultProps = (!useGlobalViewProps || useDetailsViewWithPath) &&
-                                 (!QFile::exists(file) ||
-                                  (m_node->timestamp() < settings->viewPropsTimestamp()));
+                                 (!exists || (m_data.timestamp < settings->viewPropsTimestamp()));
     if (useDefaultProps) {
         if (useDetailsViewWithPath) {
             setViewMode(DolphinView::DetailsView);
@@ -111,21 +131,13 @@ ViewProperties::ViewProperties(const KUrl& url) :
         }
     }
 
-    if (m_node->version() < CurrentViewPropertiesVersion) {
-        // The view-properties have an outdated version. Convert the properties
-        // to the changes of the current version.
-        if (m_node->version() < AdditionalInfoViewPropertiesVersion) {
-            convertAdditionalInfo();
-            Q_ASSERT(m_node->version() == AdditionalInfoViewPropertiesVersion);
-        }
-
-        if (m_node->version() < NameRolePropertiesVersion) {
-            convertNameRoleToTextRole();
-            Q_ASSERT(m_node->version() == NameRolePropertiesVersion);
-        }
-
-        m_node->setVersion(CurrentViewPropertiesVersion);
+    if (converted) {
+        // The view-properties have been converted from an outdated
+        // version. Store the converted properties.
+        update();
     }
+
+    m_data.version = CurrentViewPropertiesVersion;
 }
 
 ViewProperties::~ViewProperties()
@@ -133,101 +145,98 @@ ViewProperties::~ViewProperties()
     if (m_changedProps && m_autoSave) {
         save();
     }
-
-    delete m_node;
-    m_node = 0;
 }
 
 void ViewProperties::setViewMode(DolphinView::Mode mode)
 {
-    if (m_node->viewMode() != mode) {
-        m_node->setViewMode(mode);
+    if (m_data.viewMode != mode) {
+        m_data.viewMode = mode;
         update();
     }
 }
 
 DolphinView::Mode ViewProperties::viewMode() const
 {
-    const int mode = qBound(0, m_node->viewMode(), 2);
+    const int mode = qBound(0, m_data.viewMode, 2);
     return static_cast<DolphinView::Mode>(mode);
 }
 
 void ViewProperties::setPreviewsShown(bool show)
 {
-    if (m_node->previewsShown() != show) {
-        m_node->setPreviewsShown(show);
+    if (m_data.previewsShown != show) {
+        m_data.previewsShown = show;
         update();
     }
 }
 
 bool ViewProperties::previewsShown() const
 {
-    return m_node->previewsShown();
+    return m_data.previewsShown;
 }
 
 void ViewProperties::setHiddenFilesShown(bool show)
 {
-    if (m_node->hiddenFilesShown() != show) {
-        m_node->setHiddenFilesShown(show);
+    if (m_data.hiddenFilesShown != show) {
+        m_data.hiddenFilesShown = show;
         update();
     }
 }
 
 void ViewProperties::setGroupedSorting(bool grouped)
 {
-    if (m_node->groupedSorting() != grouped) {
-        m_node->setGroupedSorting(grouped);
+    if (m_data.groupedSorting != grouped) {
+        m_data.groupedSorting = grouped;
         update();
     }
 }
 
 bool ViewProperties::groupedSorting() const
 {
-    return m_node->groupedSorting();
+    return m_data.groupedSorting;
 }
 
 bool ViewProperties::hiddenFilesShown() const
 {
-    return m_node->hiddenFilesShown();
+    return m_data.hiddenFilesShown;
 }
 
 void ViewProperties::setSortRole(const QByteArray& role)
 {
-    if (m_node->sortRole() != role) {
-        m_node->setSortRole(role);
+    if (m_data.sortRole != QLatin1String(role)) {
+        m_data.sortRole = QLatin1String(role);
         update();
     }
 }
 
 QByteArray ViewProperties::sortRole() const
 {
-    return m_node->sortRole().toLatin1();
+    return m_data.sortRole.toLatin1();
 }
 
 void ViewProperties::setSortOrder(Qt::SortOrder sortOrder)
 {
-    if (m_node->sortOrder() != sortOrder) {
-        m_node->setSortOrder(sortOrder);
+    if (m_data.sortOrder != sortOrder) {
+        m_data.sortOrder = sortOrder;
         update();
     }
 }
 
 Qt::SortOrder ViewProperties::sortOrder() const
 {
-    return static_cast<Qt::SortOrder>(m_node->sortOrder());
+    return static_cast<Qt::SortOrder>(m_data.sortOrder);
 }
 
 void ViewProperties::setSortFoldersFirst(bool foldersFirst)
 {
-    if (m_node->sortFoldersFirst() != foldersFirst) {
-        m_node->setSortFoldersFirst(foldersFirst);
+    if (m_data.sortFoldersFirst != foldersFirst) {
+        m_data.sortFoldersFirst = foldersFirst;
         update();
     }
 }
 
 bool ViewProperties::sortFoldersFirst() const
 {
-    return m_node->sortFoldersFirst();
+    return m_data.sortFoldersFirst;
 }
 
 void ViewProperties::setVisibleRoles(const QList<QByteArray>& roles)
@@ -240,7 +249,7 @@ void ViewProperties::setVisibleRoles(const QList<QByteArray>& roles)
     // of the additional information.
 
     // Remove the old values stored for the current view-mode
-    const QStringList oldVisibleRoles = m_node->visibleRoles();
+    const QStringList oldVisibleRoles = m_data.visibleRoles;
     const QString prefix = viewModePrefix();
     QStringList newVisibleRoles = oldVisibleRoles;
     for (int i = newVisibleRoles.count() - 1; i >= 0; --i) {
@@ -255,7 +264,7 @@ void ViewProperties::setVisibleRoles(const QList<QByteArray>& roles)
     }
 
     if (oldVisibleRoles != newVisibleRoles) {
-        const bool markCustomizedDetails = (m_node->viewMode() == DolphinView::DetailsView)
+        const bool markCustomizedDetails = (m_data.viewMode == DolphinView::DetailsView)
                                            && !newVisibleRoles.contains(CustomizedDetailsString);
         if (markCustomizedDetails) {
             // The additional information of the details-view has been modified. Set a marker,
@@ -264,7 +273,7 @@ void ViewProperties::setVisibleRoles(const QList<QByteArray>& roles)
             newVisibleRoles.append(CustomizedDetailsString);
         }
 
-        m_node->setVisibleRoles(newVisibleRoles);
+        m_data.visibleRoles = newVisibleRoles;
         update();
     }
 }
@@ -293,7 +302,7 @@ QList<QByteArray> ViewProperties::visibleRoles() const
     const QString prefix = viewModePrefix();
     const int prefixLength = prefix.length();
 
-    const QStringList visibleRoles = m_node->visibleRoles();
+    const QStringList& visibleRoles = m_data.visibleRoles;
     foreach (const QString& visibleRole, visibleRoles) {
         if (visibleRole.startsWith(prefix)) {
             const QByteArray role = visibleRole.right(visibleRole.length() - prefixLength).toLatin1();
@@ -306,7 +315,7 @@ QList<QByteArray> ViewProperties::visibleRoles() const
     // For the details view the size and date should be shown per default
     // until the additional information has been explicitly changed by the user
     const bool useDefaultValues = roles.count() == 1 // "text"
-                                  && (m_node->viewMode() == DolphinView::DetailsView)
+                                  && (m_data.viewMode == DolphinView::DetailsView)
                                   && !visibleRoles.contains(CustomizedDetailsString);
     if (useDefaultValues) {
         roles.append("size");
@@ -318,15 +327,15 @@ QList<QByteArray> ViewProperties::visibleRoles() const
 
 void ViewProperties::setHeaderColumnWidths(const QList<int>& widths)
 {
-    if (m_node->headerColumnWidths() != widths) {
-        m_node->setHeaderColumnWidths(widths);
+    if (m_data.headerColumnWidths != widths) {
+        m_data.headerColumnWidths = widths;
         update();
     }
 }
 
 QList<int> ViewProperties::headerColumnWidths() const
 {
-    return m_node->headerColumnWidths();
+    return m_data.headerColumnWidths;
 }
 
 void ViewProperties::setDirProperties(const ViewProperties& props)
@@ -340,7 +349,7 @@ void ViewProperties::setDirProperties(const ViewProperties& props)
     setSortFoldersFirst(props.sortFoldersFirst());
     setVisibleRoles(props.visibleRoles());
     setHeaderColumnWidths(props.headerColumnWidths());
-    m_node->setVersion(props.m_node->version());
+    m_data.version = props.m_data.version;
 }
 
 void ViewProperties::setAutoSaveEnabled(bool autoSave)
@@ -356,15 +365,15 @@ bool ViewProperties::isAutoSaveEnabled() const
 void ViewProperties::update()
 {
     m_changedProps = true;
-    m_node->setTimestamp(QDateTime::currentDateTime());
+    m_data.timestamp = QDateTime::currentDateTime();
 }
 
 void ViewProperties::save()
 {
     kDebug() << "Saving view-properties to" << m_filePath;
     KStandardDirs::makeDir(m_filePath);
-    m_node->setVersion(CurrentViewPropertiesVersion);
-    m_node->writeConfig();
+    m_data.version = CurrentViewPropertiesVersion;
+    writeDirectoryFile(m_filePath + QDir::separator() + ViewPropertiesFileName, m_data);
     m_changedProps = false;
 }
 
@@ -374,7 +383,7 @@ bool ViewProperties::exist() const
     return QFile::exists(file);
 }
 
-QString ViewProperties::destinationDir(const QString& subDir) const
+QString ViewProperties::destinationDir(const QString& subDir)
 {
     QString basePath = KGlobal::mainComponent().componentName();
     basePath.append("/view_properties/").append(subDir);
@@ -385,7 +394,7 @@ QString ViewProperties::viewModePrefix() const
 {
     QString prefix;
 
-    switch (m_node->viewMode()) {
+    switch (m_data.viewMode) {
     case DolphinView::IconsView:   prefix = "Icons_"; break;
     case DolphinView::CompactView: prefix = "Compact_"; break;
     case DolphinView::DetailsView: prefix = "Details_"; break;
@@ -395,11 +404,154 @@ QString ViewProperties::viewModePrefix() const
     return prefix;
 }
 
-void ViewProperties::convertAdditionalInfo()
+QByteArray ViewProperties::packData(const Data& data)
+{
+    QByteArray packedData;
+    QDataStream stream(&packedData, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << qint32(data.version)
+           << qint32(data.viewMode)
+           << data.previewsShown
+           << data.hiddenFilesShown
+           << data.groupedSorting
+           << data.sortRole
+           << qint32(data.sortOrder)
+           << data.sortFoldersFirst
+           << data.visibleRoles
+           << data.headerColumnWidths
+           << data.timestamp;
+    return packedData;
+}
+
+bool ViewProperties::unpackData(const QByteArray& packedData, Data& data)
+{
+    QDataStream stream(packedData);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    qint32 version;
+    qint32 viewMode;
+    qint32 sortOrder;
+    Data result;
+    stream >> version
+           >> viewMode
+           >> result.previewsShown
+           >> result.hiddenFilesShown
+           >> result.groupedSorting
+           >> result.sortRole
+           >> sortOrder
+           >> result.sortFoldersFirst
+           >> result.visibleRoles
+           >> result.headerColumnWidths
+           >> result.timestamp;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    result.version = version;
+    result.viewMode = viewMode;
+    result.sortOrder = sortOrder;
+    data = result;
+    return true;
+}
+
+QByteArray ViewProperties::fileState(const QString& fileName)
+{
+    QByteArray state;
+    KDE_struct_stat statBuffer;
+    if (KDE_stat(QFile::encodeName(fileName).constData(), &statBuffer) == 0) {
+        // KConfig replaces the file when writing it, so also
+        // changes within the same second result in a new inode.
+        QDataStream stream(&state, QIODevice::WriteOnly);
+        stream << qint64(statBuffer.st_size)
+               << quint64(statBuffer.st_ino)
+               << qint64(statBuffer.st_mtime);
+    }
+    return state;
+}
+
+bool ViewProperties::readProperties(const QString& fileName, Data& data)
+{
+    const QByteArray state = fileState(fileName);
+    if (state.isEmpty()) {
+        return false;
+    }
+
+    ViewPropertiesStore* store = ViewPropertiesStore::instance();
+    QByteArray cachedData;
+    if (store->value(fileName, cachedData) && cachedData.startsWith(state)
+        && unpackData(cachedData.mid(state.size()), data)) {
+        return true;
+    }
+
+    if (!readDirectoryFile(fileName, data)) {
+        return false;
+    }
+
+    store->setValue(fileName, state + packData(data));
+    return true;
+}
+
+bool ViewProperties::readDirectoryFile(const QString& fileName, Data& data)
+{
+    if (!QFile::exists(fileName)) {
+        return false;
+    }
+
+    const ViewPropertySettings settings(KSharedConfig::openConfig(fileName));
+    data.version = settings.version();
+    data.viewMode = settings.viewMode();
+    data.previewsShown = settings.previewsShown();
+    data.hiddenFilesShown = settings.hiddenFilesShown();
+    data.groupedSorting = settings.groupedSorting();
+    data.sortRole = settings.sortRole();
+    data.sortOrder = settings.sortOrder();
+    data.sortFoldersFirst = settings.sortFoldersFirst();
+    data.visibleRoles = settings.visibleRoles();
+    data.headerColumnWidths = settings.headerColumnWidths();
+    data.timestamp = settings.timestamp();
+
+    // The view-properties have an outdated version. Convert the properties
+    // to the changes of the current version.
+    if (data.version < AdditionalInfoViewPropertiesVersion) {
+        convertAdditionalInfo(data, settings.additionalInfo());
+        Q_ASSERT(data.version == AdditionalInfoViewPropertiesVersion);
+    }
+
+    if (data.version < NameRolePropertiesVersion) {
+        convertNameRoleToTextRole(data);
+        Q_ASSERT(data.version == NameRolePropertiesVersion);
+    }
+
+    return true;
+}
+
+void ViewProperties::writeDirectoryFile(const QString& fileName, const Data& data)
+{
+    ViewPropertySettings settings(KSharedConfig::openConfig(fileName));
+    settings.setVersion(data.version);
+    settings.setViewMode(data.viewMode);
+    settings.setPreviewsShown(data.previewsShown);
+    settings.setHiddenFilesShown(data.hiddenFilesShown);
+    settings.setGroupedSorting(data.groupedSorting);
+    settings.setSortRole(data.sortRole);
+    settings.setSortOrder(data.sortOrder);
+    settings.setSortFoldersFirst(data.sortFoldersFirst);
+    settings.setAdditionalInfo(QStringList());
+    settings.setVisibleRoles(data.visibleRoles);
+    settings.setHeaderColumnWidths(data.headerColumnWidths);
+    settings.setTimestamp(data.timestamp);
+    settings.writeConfig();
+
+    const QByteArray state = fileState(fileName);
+    if (!state.isEmpty()) {
+        ViewPropertiesStore::instance()->setValue(fileName, state + packData(data));
+    }
+}
+
+void ViewProperties::convertAdditionalInfo(Data& data, const QStringList& additionalInfo)
 {
     QStringList visibleRoles;
 
-    const QStringList additionalInfo = m_node->additionalInfo();
     if (!additionalInfo.isEmpty()) {
         // Convert the obsolete values like Icons_Size, Details_Date, ...
         // to Icons_size, Details_date, ... where the suffix just represents
@@ -421,15 +573,13 @@ void ViewProperties::convertAdditionalInfo()
         }
     }
 
-    m_node->setAdditionalInfo(QStringList());
-    m_node->setVisibleRoles(visibleRoles);
-    m_node->setVersion(AdditionalInfoViewPropertiesVersion);
-    update();
+    data.visibleRoles = visibleRoles;
+    data.version = AdditionalInfoViewPropertiesVersion;
 }
 
-void ViewProperties::convertNameRoleToTextRole()
+void ViewProperties::convertNameRoleToTextRole(Data& data)
 {
-    QStringList visibleRoles = m_node->visibleRoles();
+    QStringList& visibleRoles = data.visibleRoles;
     for (int i = 0; i < visibleRoles.count(); ++i) {
         if (visibleRoles[i].endsWith(QLatin1String("_name"))) {
             const int leftLength = visibleRoles[i].length() - 5;
@@ -437,15 +587,11 @@ void ViewProperties::convertNameRoleToTextRole()
         }
     }
 
-    QString sortRole = m_node->sortRole();
-    if (sortRole == QLatin1String("name")) {
-        sortRole = QLatin1String("text");
+    if (data.sortRole == QLatin1String("name")) {
+        data.sortRole = QLatin1String("text");
     }
 
-    m_node->setVisibleRoles(visibleRoles);
-    m_node->setSortRole(sortRole);
-    m_node->setVersion(NameRolePropertiesVersion);
-    update();
+    data.version = NameRolePropertiesVersion;
 }
 
 bool ViewProperties::isPartOfHome(const QString& filePath)
@@ -469,10 +615,3 @@ QString ViewProperties::directoryHashForUrl(const KUrl& url)
     hashString.replace('/', '-');
     return hashString;
 }
-
-KUrl ViewProperties::mirroredDirectory()
-{
-    QString basePath = KGlobal::mainComponent().componentName();
-    basePath.append("/view_properties/");
-    return KUrl(KStandardDirs::locateLocal("data", basePath));
-}
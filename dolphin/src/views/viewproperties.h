@@ -25,7 +25,9 @@
 #include <KUrl>
 #include <libdolphin_export.h>
 
-class ViewPropertySettings;
+#include <QDateTime>
+#include <QStringList>
+
 /**
  * @brief Maintains the view properties like 'view mode' or
  *        'show hidden files' for a directory.
@@ -46,6 +48,12 @@ class ViewPropertySettings;
  * If no .directory file is available or the global view mode is turned on
  * (see GeneralSettings::globalViewMode()), the values from the global .directory file
  * are used for initialization.
+ *
+ * The parsed content of the .directory files is cached in the
+ * ViewPropertiesStore together with the size, inode and modification time
+ * of the file. The cached content is only used as long as the file has not
+ * been changed, so a .directory file that has been moved, copied or edited
+ * is parsed again.
  */
 class LIBDOLPHINPRIVATE_EXPORT ViewProperties
 {
@@ -126,12 +134,33 @@ public:
     bool exist() const;
 
 private:
+    /**
+     * Values of the view properties, see dolphin_directoryviewpropertysettings.kcfg
+     * for the default values.
+     */
+    struct Data
+    {
+        Data();
+
+        int version;
+        int viewMode;
+        bool previewsShown;
+        bool hiddenFilesShown;
+        bool groupedSorting;
+        QString sortRole;
+        int sortOrder;
+        bool sortFoldersFirst;
+        QStringList visibleRoles;
+        QList<int> headerColumnWidths;
+        QDateTime timestamp;
+    };
+
     /**
      * Returns the destination directory path where the view
      * properties are stored. \a subDir specifies the used sub
      * directory.
      */
-    QString destinationDir(const QString& subDir) const;
+    static QString destinationDir(const QString& subDir);
 
     /**
      * Returns the view-mode prefix when storing additional properties for
@@ -139,19 +168,54 @@ private:
      */
     QString viewModePrefix() const;
 
+    static QByteArray packData(const Data& data);
+    static bool unpackData(const QByteArray& packedData, Data& data);
+
+    /**
+     * @return Size, inode and modification time of the file \a fileName
+     *         in a packed form, or an empty array if the file does not exist.
+     *         Is stored together with the cached properties of a .directory
+     *         file to detect whether the file has been changed.
+     */
+    static QByteArray fileState(const QString& fileName);
+
+    /**
+     * Reads the view properties from the .directory file \a fileName.
+     * The cached properties of the ViewPropertiesStore are used if the
+     * file has not been changed since they have been cached.
+     *
+     * @return False if the file does not exist.
+     */
+    static bool readProperties(const QString& fileName, Data& data);
+
+    /**
+     * Parses the .directory file \a fileName. Outdated properties are
+     * converted, in this case the version of \a data is lower than
+     * CurrentViewPropertiesVersion.
+     *
+     * @return False if the file does not exist.
+     */
+    static bool readDirectoryFile(const QString& fileName, Data& data);
+
+    /**
+     * Writes \a data to the .directory file \a fileName and
+     * updates the cached properties of the ViewPropertiesStore.
+     */
+    static void writeDirectoryFile(const QString& fileName, const Data& data);
+
     /**
      * Provides backward compatibility with .directory files created with
      * Dolphin < 2.0: Converts the old additionalInfo-property into
-     * the visibleRoles-property and clears the additionalInfo-property.
+     * the visibleRoles-property.
      */
-    void convertAdditionalInfo();
+    static void convertAdditionalInfo(Data& data, const QStringList& additionalInfo);
 
     /**
      * Provides backward compatibility with .directory files created with
      * Dolphin < 2.1: Converts the old name-role "name" to the generic
      * role "text".
      */
-    void convertNameRoleToTextRole();
+    static void convertNameRoleToTextRole(Data& data);
 
     /**
      * Returns true, if \a filePath is part of the home-path (see QDir::homePath()).
@@ -164,22 +228,13 @@ private:
      */
     static QString directoryHashForUrl(const KUrl& url);
 
-    /**
-     * Returns the URL of the directory, where the mirrored view properties
-     * are stored into. Mirrored view properties are used if:
-     * - there is no write access for storing the view properties into
-     *   the original directory
-     * - for non local directories
-     */
-    static KUrl mirroredDirectory();
-
     Q_DISABLE_COPY(ViewProperties)
 
 private:
     bool m_changedProps;
     bool m_autoSave;
     QString m_filePath;
-    ViewPropertySettings* m_node;
+    Data m_data;
 };
 
 #endif
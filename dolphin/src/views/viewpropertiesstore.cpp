@@ -0,0 +1,514 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#include "viewpropertiesstore.h"
+
+#include <KComponentData>
+#include <KGlobal>
+#include <KLockFile>
+#include <KSaveFile>
+#include <KStandardDirs>
+#include <kde_file.h>
+
+#include <QDir>
+#include <QVector>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+    // "DVP1" in the native byte order. Files that have been written on
+    // machines with another byte order are ignored.
+    const quint32 Magic = 0x31505644;
+    const quint32 Version = 1;
+
+    // Minimum size of the log in bytes that results in merging the log into
+    // the hash table. Larger tables are merged as soon as the log gets as
+    // large as the table, so that the costs of merging stay linear.
+    const qint64 MinimumCompactLogSize = 512 * 1024;
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint32 count;
+        quint32 bucketCount;
+        quint32 dataSize;
+    };
+
+    // The hash table consists of the header, the buckets and the records.
+    // Each bucket contains the offset + 1 of a record or 0 if it is empty.
+    struct RecordHeader
+    {
+        quint32 hash;
+        quint32 keySize;
+        quint32 valueSize;
+    };
+
+    struct LogRecordHeader
+    {
+        quint32 keySize;
+        quint32 valueSize;
+    };
+
+    /**
+     * FNV-1a hash of \a key. qHash() is not used, as the hash values
+     * are stored and must not change with the version of Qt.
+     */
+    quint32 hashKey(const QByteArray& key)
+    {
+        quint32 hash = 2166136261u;
+        const int size = key.size();
+        for (int i = 0; i < size; ++i) {
+            hash ^= static_cast<uchar>(key.at(i));
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    inline quint32 paddedSize(quint32 size)
+    {
+        return (size + 3) & ~3u;
+    }
+}
+
+class ViewPropertiesStoreSingleton
+{
+public:
+    ViewPropertiesStoreSingleton() :
+        instance(KStandardDirs::locateLocal("data", KGlobal::mainComponent().componentName() +
+                                                    QLatin1String("/view_properties/store")))
+    {
+    }
+
+    ViewPropertiesStore instance;
+};
+K_GLOBAL_STATIC(ViewPropertiesStoreSingleton, s_viewPropertiesStore)
+
+
+ViewPropertiesStore::ViewPropertiesStore(const QString& fileName) :
+    m_fileName(fileName),
+    m_logFileName(fileName + QLatin1String(".log")),
+    m_tableFile(),
+    m_table(0),
+    m_tableCount(0),
+    m_bucketCount(0),
+    m_dataSize(0),
+    m_tableInode(0),
+    m_tableModificationTime(0),
+    m_logReadSize(0),
+    m_logValues(),
+    m_batchDepth(0),
+    m_pendingValues()
+{
+    loadTable();
+    readLog();
+}
+
+ViewPropertiesStore::~ViewPropertiesStore()
+{
+    flush();
+    unloadTable();
+}
+
+ViewPropertiesStore* ViewPropertiesStore::instance()
+{
+    return &s_viewPropertiesStore->instance;
+}
+
+bool ViewPropertiesStore::value(const QString& key, QByteArray& value)
+{
+    refresh();
+
+    const QByteArray keyData = key.toUtf8();
+    QHash<QByteArray, QByteArray>::const_iterator it = m_logValues.constFind(keyData);
+    if (it != m_logValues.constEnd()) {
+        value = it.value();
+        return true;
+    }
+
+    return tableValue(keyData, value);
+}
+
+bool ViewPropertiesStore::contains(const QString& key)
+{
+    QByteArray unused;
+    return value(key, unused);
+}
+
+void ViewPropertiesStore::setValue(const QString& key, const QByteArray& value)
+{
+    const QByteArray keyData = key.toUtf8();
+    m_logValues.insert(keyData, value);
+    m_pendingValues.insert(keyData, value);
+
+    if (m_batchDepth == 0) {
+        flush();
+    }
+}
+
+void ViewPropertiesStore::beginBatch()
+{
+    ++m_batchDepth;
+}
+
+void ViewPropertiesStore::endBatch()
+{
+    Q_ASSERT(m_batchDepth > 0);
+    --m_batchDepth;
+    if (m_batchDepth == 0) {
+        flush();
+    }
+}
+
+bool ViewPropertiesStore::compact()
+{
+    // The lock assures that no values are appended to the log by other
+    // processes until the log has been merged and truncated.
+    KLockFile lock(m_fileName + QLatin1String(".lock"));
+    if (lock.lock() != KLockFile::LockOK) {
+        return false;
+    }
+
+    refresh();
+
+    QHash<QByteArray, QByteArray> values = tableValues();
+    QHashIterator<QByteArray, QByteArray> logIt(m_logValues);
+    while (logIt.hasNext()) {
+        logIt.next();
+        values.insert(logIt.key(), logIt.value());
+    }
+
+    // Drop the values of files that have been removed or renamed
+    QMutableHashIterator<QByteArray, QByteArray> valueIt(values);
+    while (valueIt.hasNext()) {
+        valueIt.next();
+        if (isRemovedFile(valueIt.key())) {
+            valueIt.remove();
+        }
+    }
+
+    // Use a load factor of at most 0.5 to keep the probe sequences short
+    quint32 bucketCount = 16;
+    while (bucketCount < 2 * quint32(values.count())) {
+        bucketCount *= 2;
+    }
+    QVector<quint32> buckets(bucketCount, 0);
+
+    QByteArray data;
+    QHashIterator<QByteArray, QByteArray> it(values);
+    while (it.hasNext()) {
+        it.next();
+
+        RecordHeader record;
+        record.hash = hashKey(it.key());
+        record.keySize = it.key().size();
+        record.valueSize = it.value().size();
+
+        quint32 bucket = record.hash & (bucketCount - 1);
+        while (buckets[bucket] != 0) {
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+        buckets[bucket] = data.size() + 1;
+
+        const int recordSize = sizeof(RecordHeader) + record.keySize + record.valueSize;
+        data.append(reinterpret_cast<const char*>(&record), sizeof(RecordHeader));
+        data.append(it.key());
+        data.append(it.value());
+        data.append(QByteArray(paddedSize(recordSize) - recordSize, '\0'));
+    }
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.count = values.count();
+    header.bucketCount = bucketCount;
+    header.dataSize = data.size();
+
+    // The old file must not be mapped while it is replaced.
+    unloadTable();
+
+    KSaveFile file(m_fileName);
+    const qint64 bucketsSize = bucketCount * sizeof(quint32);
+    bool success = file.open() &&
+                   file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header) &&
+                   file.write(reinterpret_cast<const char*>(buckets.constData()), bucketsSize) == bucketsSize &&
+                   file.write(data) == data.size() &&
+                   file.finalize();
+
+    if (success) {
+        QFile log(m_logFileName);
+        success = !log.exists() || log.resize(0);
+    }
+
+    m_logValues.clear();
+    m_logReadSize = 0;
+    loadTable();
+    readLog();
+    return success;
+}
+
+int ViewPropertiesStore::count()
+{
+    refresh();
+
+    int result = m_tableCount;
+    QByteArray unused;
+    QHashIterator<QByteArray, QByteArray> it(m_logValues);
+    while (it.hasNext()) {
+        it.next();
+        if (!tableValue(it.key(), unused)) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+void ViewPropertiesStore::refresh()
+{
+    KDE_struct_stat statBuffer;
+    const bool exists = (KDE_stat(QFile::encodeName(m_fileName).constData(), &statBuffer) == 0);
+    const quint64 inode = exists ? statBuffer.st_ino : 0;
+    const qint64 modificationTime = exists ? statBuffer.st_mtime : 0;
+    if (inode != m_tableInode || modificationTime != m_tableModificationTime) {
+        // The table has been replaced by another process, which
+        // has merged the log into the table.
+        m_logValues.clear();
+        m_logReadSize = 0;
+        loadTable();
+    }
+
+    readLog();
+}
+
+void ViewPropertiesStore::loadTable()
+{
+    unloadTable();
+
+    KDE_struct_stat statBuffer;
+    if (KDE_stat(QFile::encodeName(m_fileName).constData(), &statBuffer) == 0) {
+        m_tableInode = statBuffer.st_ino;
+        m_tableModificationTime = statBuffer.st_mtime;
+    }
+
+    m_tableFile.setFileName(m_fileName);
+    if (!m_tableFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 fileSize = m_tableFile.size();
+    if (fileSize < static_cast<qint64>(sizeof(Header))) {
+        m_tableFile.close();
+        return;
+    }
+
+    const uchar* data = m_tableFile.map(0, fileSize);
+    if (!data) {
+        m_tableFile.close();
+        return;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    const qint64 tableSize = sizeof(Header) + qint64(header.bucketCount) * sizeof(quint32) + header.dataSize;
+    const bool valid = header.magic == Magic &&
+                       header.version == Version &&
+                       header.bucketCount > 0 &&
+                       (header.bucketCount & (header.bucketCount - 1)) == 0 &&
+                       header.count < header.bucketCount &&
+                       tableSize <= fileSize;
+    if (!valid) {
+        m_tableFile.unmap(const_cast<uchar*>(data));
+        m_tableFile.close();
+        return;
+    }
+
+    m_table = data;
+    m_tableCount = header.count;
+    m_bucketCount = header.bucketCount;
+    m_dataSize = header.dataSize;
+}
+
+void ViewPropertiesStore::unloadTable()
+{
+    if (m_table) {
+        m_tableFile.unmap(const_cast<uchar*>(m_table));
+        m_table = 0;
+    }
+    m_tableFile.close();
+    m_tableCount = 0;
+    m_bucketCount = 0;
+    m_dataSize = 0;
+    m_tableInode = 0;
+    m_tableModificationTime = 0;
+}
+
+void ViewPropertiesStore::readLog()
+{
+    KDE_struct_stat statBuffer;
+    const qint64 logSize = (KDE_stat(QFile::encodeName(m_logFileName).constData(), &statBuffer) == 0) ? statBuffer.st_size : 0;
+    if (logSize < m_logReadSize) {
+        // The log has been truncated by another process
+        m_logValues.clear();
+        m_logReadSize = 0;
+        loadTable();
+    }
+
+    if (logSize == m_logReadSize) {
+        return;
+    }
+
+    QFile file(m_logFileName);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(m_logReadSize)) {
+        return;
+    }
+    const QByteArray data = file.read(logSize - m_logReadSize);
+
+    int pos = 0;
+    while (pos + static_cast<int>(sizeof(LogRecordHeader)) <= data.size()) {
+        LogRecordHeader header;
+        std::memcpy(&header, data.constData() + pos, sizeof(LogRecordHeader));
+
+        const qint64 recordSize = sizeof(LogRecordHeader) + qint64(header.keySize) + header.valueSize;
+        if (pos + recordSize > data.size()) {
+            // The record is being written by another process
+            break;
+        }
+
+        const char* key = data.constData() + pos + sizeof(LogRecordHeader);
+        m_logValues.insert(QByteArray(key, header.keySize), QByteArray(key + header.keySize, header.valueSize));
+        pos += recordSize;
+    }
+
+    m_logReadSize += pos;
+}
+
+void ViewPropertiesStore::flush()
+{
+    if (m_pendingValues.isEmpty()) {
+        return;
+    }
+
+    // Values that have been changed several times are only written once
+    QByteArray data;
+    QHashIterator<QByteArray, QByteArray> it(m_pendingValues);
+    while (it.hasNext()) {
+        it.next();
+
+        LogRecordHeader header;
+        header.keySize = it.key().size();
+        header.valueSize = it.value().size();
+        data.append(reinterpret_cast<const char*>(&header), sizeof(LogRecordHeader));
+        data.append(it.key());
+        data.append(it.value());
+    }
+
+    qint64 logSize = 0;
+    {
+        KLockFile lock(m_fileName + QLatin1String(".lock"));
+        if (lock.lock() != KLockFile::LockOK) {
+            return;
+        }
+
+        QFile file(m_logFileName);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            file.write(data);
+            logSize = file.size();
+        }
+    }
+    m_pendingValues.clear();
+
+    const qint64 tableSize = sizeof(Header) + qint64(m_bucketCount) * sizeof(quint32) + m_dataSize;
+    if (logSize > qMax(MinimumCompactLogSize, tableSize)) {
+        compact();
+    }
+}
+
+bool ViewPropertiesStore::tableValue(const QByteArray& key, QByteArray& value) const
+{
+    if (!m_table) {
+        return false;
+    }
+
+    const uchar* buckets = m_table + sizeof(Header);
+    const uchar* records = buckets + m_bucketCount * sizeof(quint32);
+
+    const quint32 hash = hashKey(key);
+    quint32 bucket = hash & (m_bucketCount - 1);
+    for (quint32 i = 0; i < m_bucketCount; ++i) {
+        // The table is copied to prevent unaligned access to the mapped memory
+        quint32 offset;
+        std::memcpy(&offset, buckets + bucket * sizeof(quint32), sizeof(quint32));
+        if (offset == 0 || offset - 1 + sizeof(RecordHeader) > m_dataSize) {
+            return false;
+        }
+
+        RecordHeader record;
+        std::memcpy(&record, records + offset - 1, sizeof(RecordHeader));
+        const char* recordKey = reinterpret_cast<const char*>(records + offset - 1 + sizeof(RecordHeader));
+        if (record.hash == hash && record.keySize == quint32(key.size()) &&
+            offset - 1 + sizeof(RecordHeader) + qint64(record.keySize) + record.valueSize <= m_dataSize &&
+            std::memcmp(recordKey, key.constData(), record.keySize) == 0) {
+            value = QByteArray(recordKey + record.keySize, record.valueSize);
+            return true;
+        }
+
+        bucket = (bucket + 1) & (m_bucketCount - 1);
+    }
+
+    return false;
+}
+
+bool ViewPropertiesStore::isRemovedFile(const QByteArray& key)
+{
+    const QString path = QString::fromUtf8(key);
+    if (!QDir::isAbsolutePath(path)) {
+        return false;
+    }
+
+    KDE_struct_stat statBuffer;
+    return KDE_stat(QFile::encodeName(path).constData(), &statBuffer) != 0 && errno == ENOENT;
+}
+
+QHash<QByteArray, QByteArray> ViewPropertiesStore::tableValues() const
+{
+    QHash<QByteArray, QByteArray> values;
+    if (!m_table) {
+        return values;
+    }
+
+    const uchar* records = m_table + sizeof(Header) + m_bucketCount * sizeof(quint32);
+    quint32 offset = 0;
+    while (offset + sizeof(RecordHeader) <= m_dataSize) {
+        RecordHeader record;
+        std::memcpy(&record, records + offset, sizeof(RecordHeader));
+
+        const qint64 recordSize = sizeof(RecordHeader) + qint64(record.keySize) + record.valueSize;
+        if (offset + recordSize > m_dataSize) {
+            break;
+        }
+
+        const char* key = reinterpret_cast<const char*>(records + offset + sizeof(RecordHeader));
+        values.insert(QByteArray(key, record.keySize), QByteArray(key + record.keySize, record.valueSize));
+        offset += paddedSize(recordSize);
+    }
+
+    return values;
+}
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by agent <agent@local>                             *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA            *
+ ***************************************************************************/
+
+#ifndef VIEWPROPERTIESSTORE_H
+#define VIEWPROPERTIESSTORE_H
+
+#include <libdolphin_export.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+/**
+ * @brief Persistent cache for the view properties of all directories.
+ *
+ * ViewProperties stores the parsed properties of each .directory file as
+ * value for the path of the file. All values are kept in one memory-mapped
+ * hash table, so reading the properties of a directory requires no parsing
+ * of the .directory file, only checking whether the file or the store has
+ * been changed.
+ *
+ * Changed values are appended to a log file, which is merged into the hash
+ * table as soon as it gets as large as the table. Keys that are absolute
+ * paths are treated as paths of local files: If the file has been removed
+ * or renamed, the value is dropped when merging.
+ *
+ * Several processes may use the store at the same time: Before a value is
+ * read, the entries that have been appended to the log by other processes
+ * are read, and a hash table that has been replaced by another process is
+ * loaded again.
+ *
+ * Values that are changed between beginBatch() and endBatch() are written
+ * with one write operation. A value that has been changed several times
+ * is only written once.
+ */
+class LIBDOLPHINPRIVATE_EXPORT ViewPropertiesStore
+{
+
+public:
+    /**
+     * @param fileName Path of the hash table. The log is stored in
+     *                 the same directory with the suffix ".log".
+     */
+    explicit ViewPropertiesStore(const QString& fileName);
+    ~ViewPropertiesStore();
+
+    /**
+     * @return Store that is used by all ViewProperties instances.
+     */
+    static ViewPropertiesStore* instance();
+
+    /**
+     * Sets \a value to the value that is stored for \a key.
+     * @return True if a value is stored for \a key.
+     */
+    bool value(const QString& key, QByteArray& value);
+    bool contains(const QString& key);
+
+    void setValue(const QString& key, const QByteArray& value);
+
+    /**
+     * Delays writing the values that are changed by setValue() until
+     * endBatch() is invoked. Batches may be nested.
+     */
+    void beginBatch();
+    void endBatch();
+
+    /**
+     * Merges the log into the hash table and drops the values
+     * of removed files.
+     */
+    bool compact();
+
+    /**
+     * @return Number of keys in the store.
+     */
+    int count();
+
+private:
+    /**
+     * Reads the changes of other processes.
+     */
+    void refresh();
+
+    void loadTable();
+    void unloadTable();
+
+    /**
+     * Reads the entries that have been appended to the log
+     * since it has been read the last time.
+     */
+    void readLog();
+
+    /**
+     * Writes the values that have been changed by setValue() to the log.
+     */
+    void flush();
+
+    bool tableValue(const QByteArray& key, QByteArray& value) const;
+
+    /**
+     * @return True if \a key is the absolute path of a file
+     *         that does not exist.
+     */
+    static bool isRemovedFile(const QByteArray& key);
+
+    /**
+     * @return All values of the hash table.
+     */
+    QHash<QByteArray, QByteArray> tableValues() const;
+
+private:
+    QString m_fileName;
+    QString m_logFileName;
+
+    QFile m_tableFile;
+    const uchar* m_table;
+    quint32 m_tableCount;
+    quint32 m_bucketCount;
+    quint32 m_dataSize;
+    quint64 m_tableInode; // Allows to detect whether the table has been replaced
+    qint64 m_tableModificationTime;
+
+    qint64 m_logReadSize;
+    QHash<QByteArray, QByteArray> m_logValues;
+
+    int m_batchDepth;
+    QHash<QByteArray, QByteArray> m_pendingValues;
+};
+
+#endif
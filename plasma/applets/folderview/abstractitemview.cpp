@@ -26,7 +26,6 @@
 #include "style.h"
 
 #include <QItemSelectionModel>
-#include <QPaintEngine>
 
 #include <KDirModel>
 #include <KFileItemDelegate>
@@ -36,22 +35,20 @@
 
 #include <limits.h>
 
-#ifdef Q_WS_X11
-#  include <QX11Info>
-#  include <X11/Xlib.h>
-#endif
-
 
 static const int sSmoothScrollTime = 140;
 static const int sSmoothScrollTick = 14;
 
+// The size of the back buffer tiles, and the number of tiles that are kept
+// when they are not visible (64 tiles of 256x256 pixels are 16 MB)
+static const int sTileSize = 256;
+static const int sMaxCachedTiles = 64;
+
 
 AbstractItemView::AbstractItemView(QGraphicsWidget *parent)
     : QGraphicsWidget(parent),
       m_itemFrame(0),
       m_delegate(0),
-      m_lastScrollValue(0),
-      m_viewScrolled(false),
       m_dx(0),
       m_ddx(0),
       m_dddx(0),
@@ -62,7 +59,8 @@ AbstractItemView::AbstractItemView(QGraphicsWidget *parent)
       m_rdy(0),
       m_smoothScrolling(false),
       m_autoScrollSpeed(0),
-      m_drawShadows(true)
+      m_drawShadows(true),
+      m_textSprites(8 * 1024)
 {
     m_scrollBar = new Plasma::ScrollBar(this);
     connect(m_scrollBar, SIGNAL(valueChanged(int)), SLOT(scrollBarValueChanged(int)));
@@ -171,100 +169,140 @@ QRect AbstractItemView::visibleArea() const
 // Marks the given rect in viewport coordinates, as dirty and schedules a repaint.
 void AbstractItemView::markAreaDirty(const QRect &rect)
 {
-    if (!rect.isEmpty() && rect.intersects(visibleArea())) {
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    const QRect visible = visibleArea();
+    if (rect.contains(visible)) {
+        // The whole view is repainted, which invalidates the tiles that
+        // are not visible as well.
+        m_tiles.clear();
+    }
+
+    if (rect.intersects(visible)) {
         m_dirtyRegion += rect;
         update(mapFromViewport(rect));
+    } else {
+        discardTiles(rect);
     }
 }
 
-// This function scrolls the contents of the backbuffer the distance the scrollbar
-// has moved since the last time this function was called.
-QRect AbstractItemView::scrollBackBuffer()
+static inline int tileIndex(int pos)
 {
-    const int value = m_scrollBar->value();
-    const int delta = m_lastScrollValue - value;
-    m_lastScrollValue = value;
+    // Round towards negative infinity
+    return pos >= 0 ? pos / sTileSize : -((-pos - 1) / sTileSize) - 1;
+}
 
-    if (qAbs(delta) >= m_pixmap.height()) {
-        return visibleArea();
-    }
+static inline quint64 tileKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
 
-    int sy, dy, h;
-    QRect dirty;
-    if (delta < 0) {
-        dy = 0;
-        sy = -delta;
-        h = m_pixmap.height() - sy;
-        dirty = QRect(0, m_pixmap.height() - sy, m_pixmap.width(), sy);
-    } else {
-        dy = delta;
-        sy = 0;
-        h = m_pixmap.height() - dy;
-        dirty = QRect(0, 0, m_pixmap.width(), dy);
-    }
-
-#if defined(Q_WS_X11)
-    const QPaintEngine::Type type = m_pixmap.paintEngine()->type();
-    if (type == QPaintEngine::X11) {
-        Display *dpy = QX11Info::display();
-        GC gc = XCreateGC(dpy, m_pixmap.handle(), 0, 0);
-        XCopyArea(dpy, m_pixmap.handle(), m_pixmap.handle(), gc, 0, sy, m_pixmap.width(), h, 0, dy);
-        XFreeGC(dpy, gc);
-    } else if (type == QPaintEngine::Raster) {
-        // Hack to prevent the image from detaching
-        const QImage image = m_pixmap.toImage();
-        const uchar *src = image.scanLine(sy);
-        uchar *dst = const_cast<uchar*>(image.scanLine(dy));
-        memmove((void*)dst, (const void*)src, h * image.bytesPerLine());
-    } else
-#endif
-    {
-        dirty = m_pixmap.rect();
-    }
+static inline QRect tileRect(quint64 key)
+{
+    return QRect(qint32(key >> 32) * sTileSize, qint32(key & 0xffffffff) * sTileSize, sTileSize, sTileSize);
+}
 
-    return mapToViewport(dirty.translated(contentsRect().topLeft().toPoint())).toAlignedRect();
+// Discards the tiles that intersect rect, which is given in viewport coordinates
+void AbstractItemView::discardTiles(const QRect &rect)
+{
+    foreach (quint64 key, m_tiles.keys()) {
+        if (tileRect(key).intersects(rect)) {
+            m_tiles.remove(key);
+        }
+    }
 }
 
+// The back buffer consists of tiles in viewport coordinates. Scrolling the view
+// doesn't touch the contents of the tiles, only the tiles that become visible
+// for the first time or that contain a dirty area are painted.
 void AbstractItemView::prepareBackBuffer()
 {
-    const QRect cr = contentsRect().toRect();
+    const QRect visible = visibleArea();
+    if (visible.size() != m_backBufferSize) {
+        // The items are usually laid out again when the size changes
+        m_tiles.clear();
+        m_backBufferSize = visible.size();
+    }
 
-    // Make sure the backbuffer pixmap has the same size as the content rect
-    if (m_pixmap.size() != cr.size()) {
-        QPixmap pixmap(cr.size());
-        pixmap.fill(Qt::transparent);
-        if (!m_pixmap.isNull()) {
-            // Static content optimization
-#ifdef Q_WS_X11
-            if (m_pixmap.paintEngine()->type() == QPaintEngine::X11) {
-                GC gc = XCreateGC(QX11Info::display(), pixmap.handle(), 0, NULL);
-                XCopyArea(QX11Info::display(), m_pixmap.handle(), pixmap.handle(), gc, 0, 0,
-                          m_pixmap.width(), m_pixmap.height(), 0, 0);
-                XFreeGC(QX11Info::display(), gc);
-            } else
-#endif
-            {
-                QPainter p(&pixmap);
-                p.setCompositionMode(QPainter::CompositionMode_Source);
-                p.drawPixmap(0, 0, m_pixmap);
+    const int firstColumn = tileIndex(visible.left());
+    const int lastColumn = tileIndex(visible.right());
+    const int firstRow = tileIndex(visible.top());
+    const int lastRow = tileIndex(visible.bottom());
+
+    // Make sure that the visible tiles are never evicted from the cache
+    const int visibleTiles = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+    m_tiles.setMaxCost(qMax(sMaxCachedTiles, 2 * visibleTiles));
+
+    // The view might have been scrolled since parts of the dirty region have been
+    // marked as dirty, so discard the tiles that are not visible anymore
+    if (!m_dirtyRegion.isEmpty()) {
+        foreach (quint64 key, m_tiles.keys()) {
+            const QRect rect = tileRect(key);
+            if (!rect.intersects(visible) && m_dirtyRegion.intersects(rect)) {
+                m_tiles.remove(key);
             }
-            QRegion region(pixmap.rect());
-            region -= m_pixmap.rect();
-            region.translate(0, m_scrollBar->value());
-            m_dirtyRegion |= region;
-        } else {
-            m_dirtyRegion = QRegion(visibleArea());
         }
-        m_pixmap = pixmap;
     }
 
-    if (m_viewScrolled) {
-        m_dirtyRegion += scrollBackBuffer();
-        m_viewScrolled = false;
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            const quint64 key = tileKey(column, row);
+            const QRect rect = tileRect(key);
+
+            QRegion region;
+            QPixmap *tile = m_tiles.object(key);
+            if (!tile) {
+                tile = new QPixmap(sTileSize, sTileSize);
+                m_tiles.insert(key, tile);
+                region = rect;
+            } else {
+                region = m_dirtyRegion & rect;
+                if (region.isEmpty()) {
+                    continue;
+                }
+            }
+
+            QPainter p(tile);
+            p.translate(-rect.topLeft());
+            p.setClipRegion(region);
+
+            // Clear the dirty region
+            p.setCompositionMode(QPainter::CompositionMode_Source);
+            p.fillRect(rect, Qt::transparent);
+            p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+            paintBackBuffer(&p, region);
+        }
     }
+
+    m_dirtyRegion = QRegion();
 }
 
-// This function draws the backbuffer pixmap on the widget, and fades out the top
+// Draws the part of the back buffer that is shown in rect, which is given in
+// the coordinates of the widget.
+void AbstractItemView::drawBackBuffer(QPainter *painter, const QRect &rect)
+{
+    const int offset = m_scrollBar->value();
+    const QRect area = mapToViewport(rect).toAlignedRect();
+
+    for (int row = tileIndex(area.top()); row <= tileIndex(area.bottom()); row++) {
+        for (int column = tileIndex(area.left()); column <= tileIndex(area.right()); column++) {
+            const quint64 key = tileKey(column, row);
+            const QPixmap *tile = m_tiles.object(key);
+            if (!tile) {
+                continue;
+            }
+
+            const QRect tr = tileRect(key);
+            const QRect r = tr & area;
+            painter->drawPixmap(r.topLeft() - QPoint(0, offset), *tile, r.translated(-tr.topLeft()));
+        }
+    }
+}
+
+// This function draws the backbuffer on the widget, and fades out the top
 // and bottom if as needed.
 void AbstractItemView::syncBackBuffer(QPainter *painter, const QRect &clipRect)
 {
@@ -276,60 +314,74 @@ void AbstractItemView::syncBackBuffer(QPainter *painter, const QRect &clipRect)
     int scrollValue = m_scrollBar->value();
     int maxValue = m_scrollBar->maximum();
 
+    const bool fadeTop = scrollValue > 0 && topFadeRect.intersects(clipRect);
+    const bool fadeBottom = scrollValue < maxValue && bottomFadeRect.intersects(clipRect);
+
     // Draw the backbuffer on the widget
     // =================================
-    if ((scrollValue > 0 && topFadeRect.intersects(clipRect)) ||
-        (scrollValue < maxValue && bottomFadeRect.intersects(clipRect)))
-    {
-        QPixmap pixmap = m_pixmap;
-        QPainter p(&pixmap);
-        p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    QRegion region(clipRect);
+    if (fadeTop) {
+        region -= topFadeRect;
+    }
+    if (fadeBottom) {
+        region -= bottomFadeRect;
+    }
+    foreach (const QRect &rect, region.rects()) {
+        drawBackBuffer(painter, rect);
+    }
 
-        // Fade out the top section of the pixmap if the scrollbar slider isn't at the top
-        if (scrollValue > 0 && topFadeRect.intersects(clipRect))
+    // Fade out the top section of the backbuffer if the scrollbar slider isn't at the top
+    if (fadeTop)
+    {
+        if (m_topFadeTile.isNull())
         {
-            if (m_topFadeTile.isNull())
-            {
-                m_topFadeTile = QPixmap(256, fadeHeight);
-                m_topFadeTile.fill(Qt::transparent);
-                QLinearGradient g(0, 0, 0, fadeHeight);
-                g.setColorAt(0, Qt::transparent);
-                g.setColorAt(1, Qt::black);
-                QPainter p(&m_topFadeTile);
-                p.setCompositionMode(QPainter::CompositionMode_Source);
-                p.fillRect(0, 0, 256, fadeHeight, g);
-                p.end();
-            }
-            p.drawTiledPixmap(0, 0, m_pixmap.width(), fadeHeight, m_topFadeTile);
+            m_topFadeTile = QPixmap(256, fadeHeight);
+            m_topFadeTile.fill(Qt::transparent);
+            QLinearGradient g(0, 0, 0, fadeHeight);
+            g.setColorAt(0, Qt::transparent);
+            g.setColorAt(1, Qt::black);
+            QPainter p(&m_topFadeTile);
+            p.setCompositionMode(QPainter::CompositionMode_Source);
+            p.fillRect(0, 0, 256, fadeHeight, g);
+            p.end();
         }
+        drawFadedBackBuffer(painter, topFadeRect, m_topFadeTile);
+    }
 
-        // Fade out the bottom part of the pixmap if the scrollbar slider isn't at the bottom
-        if (scrollValue < maxValue && bottomFadeRect.intersects(clipRect))
+    // Fade out the bottom part of the backbuffer if the scrollbar slider isn't at the bottom
+    if (fadeBottom)
+    {
+        if (m_bottomFadeTile.isNull())
         {
-            if (m_topFadeTile.isNull())
-            {
-                m_bottomFadeTile = QPixmap(256, fadeHeight);
-                m_bottomFadeTile.fill(Qt::transparent);
-                QLinearGradient g(0, 0, 0, fadeHeight);
-                g.setColorAt(0, Qt::black);
-                g.setColorAt(1, Qt::transparent);
-                QPainter p(&m_bottomFadeTile);
-                p.setCompositionMode(QPainter::CompositionMode_Source);
-                p.fillRect(0, 0, 256, fadeHeight, g);
-                p.end();
-            }
-            p.drawTiledPixmap(0, m_pixmap.height() - fadeHeight, m_pixmap.width(), fadeHeight, m_bottomFadeTile);
+            m_bottomFadeTile = QPixmap(256, fadeHeight);
+            m_bottomFadeTile.fill(Qt::transparent);
+            QLinearGradient g(0, 0, 0, fadeHeight);
+            g.setColorAt(0, Qt::black);
+            g.setColorAt(1, Qt::transparent);
+            QPainter p(&m_bottomFadeTile);
+            p.setCompositionMode(QPainter::CompositionMode_Source);
+            p.fillRect(0, 0, 256, fadeHeight, g);
+            p.end();
         }
-        p.end();
-
-        painter->drawPixmap(cr.topLeft(), pixmap);
-    }
-    else
-    {
-        painter->drawPixmap(cr.topLeft(), m_pixmap);
+        drawFadedBackBuffer(painter, bottomFadeRect, m_bottomFadeTile);
     }
 }
 
+void AbstractItemView::drawFadedBackBuffer(QPainter *painter, const QRect &rect, const QPixmap &fadeTile)
+{
+    QPixmap pixmap(rect.size());
+    pixmap.fill(Qt::transparent);
+
+    QPainter p(&pixmap);
+    p.translate(-rect.topLeft());
+    drawBackBuffer(&p, rect);
+    p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    p.drawTiledPixmap(rect, fadeTile);
+    p.end();
+
+    painter->drawPixmap(rect.topLeft(), pixmap);
+}
+
 QSize AbstractItemView::doTextLayout(QTextLayout &layout, const QSize &constraints, Qt::Alignment alignment,
                                      QTextOption::WrapMode wrapMode) const
 {
@@ -373,6 +425,53 @@ QSize AbstractItemView::doTextLayout(QTextLayout &layout, const QSize &constrain
 
 void AbstractItemView::drawTextLayout(QPainter *painter, const QTextLayout &layout, const QRect &rect) const
 {
+    const QColor color = painter->pen().color();
+
+    TextEffect effect = NoTextEffect;
+    if (drawShadows()) {
+        effect = (qGray(color.rgb()) < 192) ? TextHalo : TextShadow;
+    }
+
+    // The lines are part of the key, since the same text may be wrapped differently
+    QString key = layout.text();
+    key += QLatin1Char('\0') + layout.font().key();
+    key += QString::fromLatin1("_%1_%2_%3_%4_%5_%6_%7").arg(color.rgba()).arg(rect.width()).arg(rect.height())
+                                                      .arg(int(layout.textOption().textDirection()))
+                                                      .arg(int(layout.textOption().alignment()))
+                                                      .arg(int(layoutDirection())).arg(int(effect));
+    for (int i = 0; i < layout.lineCount(); i++) {
+        key += QLatin1Char('_') + QString::number(layout.lineAt(i).textStart());
+    }
+
+    TextSprite *sprite = m_textSprites.object(key);
+    if (!sprite) {
+        sprite = new TextSprite(renderTextSprite(layout, rect.size(), color, effect));
+        const TextSprite result = *sprite;
+        const int cost = qMax(1, sprite->pixmap.width() * sprite->pixmap.height() * 4 / 1024);
+        if (!m_textSprites.insert(key, sprite, cost)) {
+            // The sprite is larger than the cache and has been deleted
+            drawTextSprite(painter, result, rect);
+            return;
+        }
+    }
+
+    drawTextSprite(painter, *sprite, rect);
+}
+
+void AbstractItemView::drawTextSprite(QPainter *painter, const TextSprite &sprite, const QRect &rect) const
+{
+    foreach (const QRect &haloRect, sprite.haloRects) {
+        Plasma::PaintUtils::drawHalo(painter, haloRect.translated(rect.topLeft()));
+    }
+
+    painter->drawPixmap(rect.topLeft(), sprite.pixmap);
+}
+
+AbstractItemView::TextSprite AbstractItemView::renderTextSprite(const QTextLayout &layout, const QSize &size,
+                                                                const QColor &color, TextEffect effect) const
+{
+    const QRect rect(QPoint(), size);
+
     // Create the alpha gradient for the fade out effect
     QLinearGradient alphaGradient(0, 0, 1, 0);
     alphaGradient.setCoordinateMode(QGradient::ObjectBoundingMode);
@@ -412,7 +511,7 @@ void AbstractItemView::drawTextLayout(QPainter *painter, const QTextLayout &layo
     pixmap.fill(Qt::transparent);
 
     QPainter p(&pixmap);
-    p.setPen(painter->pen());
+    p.setPen(color);
 
     int y = 0;
     if (layout.textOption().alignment() & Qt::AlignVCenter) {
@@ -449,32 +548,80 @@ void AbstractItemView::drawTextLayout(QPainter *painter, const QTextLayout &layo
     }
     p.end();
 
-    if (drawShadows()) {
-        const QColor color = painter->pen().color();
-        if (qGray(color.rgb()) < 192) {
-            // Draw halos
-            painter->translate(0, y);
-            foreach (const QRect &haloRect, haloRects) {
-                Plasma::PaintUtils::drawHalo(painter, haloRect.translated(rect.topLeft()));
-            }
-            painter->translate(0, -y);
-        } else {
-            // Draw shadow
-            QImage shadow = pixmap.toImage();
-            Plasma::PaintUtils::shadowBlur(shadow, 2, Qt::black);
-
-            // Make the shadow twice as dark
-            quint32 * const pixels = reinterpret_cast<quint32*>(shadow.bits());
-            for (int i = 0; i < shadow.width() * shadow.height(); i++) {
-                pixels[i] = qMin(255, qAlpha(pixels[i]) * 2) << 24;
-            }
+    TextSprite sprite;
 
-            painter->drawImage(rect.topLeft() + QPoint(1, 1), shadow);
+    if (effect == TextHalo) {
+        foreach (const QRect &haloRect, haloRects) {
+            sprite.haloRects.append(haloRect.translated(0, y));
         }
+        sprite.pixmap = pixmap;
+    } else if (effect == TextShadow) {
+        // Draw the text over its shadow, which is offset by one pixel
+        const QImage shadow = createTextShadow(pixmap.toImage());
+
+        QImage image(size + QSize(1, 1), QImage::Format_ARGB32_Premultiplied);
+        image.fill(0);
+
+        QPainter painter(&image);
+        painter.drawImage(1, 1, shadow);
+        painter.drawPixmap(0, 0, pixmap);
+        painter.end();
+
+        sprite.pixmap = QPixmap::fromImage(image);
+    } else {
+        sprite.pixmap = pixmap;
     }
 
-    // Draw the text pixmap
-    painter->drawPixmap(rect.topLeft(), pixmap);
+    return sprite;
+}
+
+QImage AbstractItemView::createTextShadow(const QImage &text)
+{
+    // Blurs the alpha channel with the separable kernel [1 4 6 4 1] / 16 and
+    // doubles the alpha of the result. Both passes work on whole rows of
+    // integers, which allows the compiler to vectorize the inner loops.
+    const QImage source = text.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int width = source.width();
+    const int height = source.height();
+
+    QImage shadow(width, height, QImage::Format_ARGB32_Premultiplied);
+    if (width == 0 || height == 0) {
+        return shadow;
+    }
+
+    // The horizontally blurred rows, with two empty rows above and below
+    QVector<quint16> rows((height + 4) * width, 0);
+    QVector<quint8> alpha(width + 4, 0);
+
+    for (int y = 0; y < height; y++) {
+        const quint32 *pixels = reinterpret_cast<const quint32*>(source.constScanLine(y));
+        quint8 *a = alpha.data() + 2;
+        for (int x = 0; x < width; x++) {
+            a[x] = pixels[x] >> 24;
+        }
+
+        const quint8 *b = alpha.constData();
+        quint16 *row = rows.data() + (y + 2) * width;
+        for (int x = 0; x < width; x++) {
+            row[x] = b[x] + 4 * b[x + 1] + 6 * b[x + 2] + 4 * b[x + 3] + b[x + 4];
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        const quint16 *r0 = rows.constData() + y * width;
+        const quint16 *r1 = r0 + width;
+        const quint16 *r2 = r1 + width;
+        const quint16 *r3 = r2 + width;
+        const quint16 *r4 = r3 + width;
+        quint32 *pixels = reinterpret_cast<quint32*>(shadow.scanLine(y));
+        for (int x = 0; x < width; x++) {
+            // The sum is at most 255 * 256, so shifting by 7 instead of 8 doubles the alpha
+            const quint32 sum = r0[x] + 4 * r1[x] + 6 * r2[x] + 4 * r3[x] + r4[x];
+            pixels[x] = qMin(quint32(255), sum >> 7) << 24;
+        }
+    }
+
+    return shadow;
 }
 
 void AbstractItemView::rowsInserted(const QModelIndex &parent, int first, int last)
@@ -555,7 +702,6 @@ void AbstractItemView::scrollBarValueChanged(int value)
 {
     Q_UNUSED(value)
 
-    m_viewScrolled = true;
     update();
 }
 
@@ -94,10 +94,14 @@ signals:
     void contextMenuRequest(QWidget *widget, const QPoint &screenPos);
 
 protected:
-    QRect scrollBackBuffer();
     void prepareBackBuffer();
     void syncBackBuffer(QPainter *painter, const QRect &clipRect);
 
+    // Is called by prepareBackBuffer() to paint the region, which is given in viewport
+    // coordinates, into the back buffer. The painter is translated to viewport
+    // coordinates and clipped to the region, which has been cleared.
+    virtual void paintBackBuffer(QPainter *painter, const QRegion &region) = 0;
+
     QSize doTextLayout(QTextLayout &layout, const QSize &constraints, Qt::Alignment alignment,
                        QTextOption::WrapMode wrapMode) const;
     void drawTextLayout(QPainter *painter, const QTextLayout &layout, const QRect &rect) const; 
@@ -126,6 +130,26 @@ private slots:
     void scrollBarActionTriggered(int action);
     void scrollBarSliderReleased();
 
+private:
+    void discardTiles(const QRect &rect);
+    void drawBackBuffer(QPainter *painter, const QRect &rect);
+    void drawFadedBackBuffer(QPainter *painter, const QRect &rect, const QPixmap &fadeTile);
+
+    enum TextEffect { NoTextEffect, TextHalo, TextShadow };
+
+    // A rendered text label. The pixmap contains the shadow if it has been
+    // rendered with TextShadow, the halos are drawn separately.
+    struct TextSprite
+    {
+        QPixmap pixmap;
+        QList<QRect> haloRects;
+    };
+
+    void drawTextSprite(QPainter *painter, const TextSprite &sprite, const QRect &rect) const;
+    TextSprite renderTextSprite(const QTextLayout &layout, const QSize &size, const QColor &color,
+                                TextEffect effect) const;
+    static QImage createTextShadow(const QImage &text);
+
 protected:
     Plasma::FrameSvg *m_itemFrame;
     KFileItemDelegate *m_delegate;
@@ -134,14 +158,11 @@ protected:
     QPointer<QItemSelectionModel> m_selectionModel;
     QSize m_iconSize;
     QRegion m_dirtyRegion;
-    QPixmap m_pixmap;
     QPixmap m_topFadeTile;
     QPixmap m_bottomFadeTile;
     Plasma::ScrollBar *m_scrollBar;
     QStyle *m_style;
     QWidget *m_styleWidget;
-    int m_lastScrollValue;
-    bool m_viewScrolled;
 
     // These variables are for the smooth scrolling code
     int m_dx;
@@ -161,6 +182,13 @@ protected:
     int m_autoScrollSpeed;
     int m_autoScrollSetSpeed;
     bool m_drawShadows;
+
+    // The tiles of the back buffer, see prepareBackBuffer()
+    QCache<quint64, QPixmap> m_tiles;
+    QSize m_backBufferSize;
+
+    // The cost is the size of the pixmap in kilobytes
+    mutable QCache<QString, TextSprite> m_textSprites;
 };
 
 inline QPointF AbstractItemView::mapToViewport(const QPointF &point) const
@@ -64,6 +64,7 @@
 
 IconView::IconView(QGraphicsWidget *parent)
     : AbstractItemView(parent),
+      m_itemGridValid(false),
       m_columns(0),
       m_rows(0),
       m_validRows(0),
@@ -408,8 +409,8 @@ void IconView::updateGridSize()
                 }
             }
 
+            invalidateItemGrid();
             doLayoutSanityCheck();
-            m_regionCache.clear();
             markAreaDirty(visibleArea());
         } else if (m_validRows > 0) {
             m_validRows = 0;
@@ -435,12 +436,14 @@ bool IconView::listingInProgress() const
 void IconView::rowsInserted(const QModelIndex &parent, int first, int last)
 {
     Q_UNUSED(parent)
-    m_regionCache.clear();
 
     if (!m_layoutBroken || !m_savedPositions.isEmpty()) {
         if (first < m_validRows) {
             m_validRows = 0;
         }
+        // m_items is resized by layoutItems(), so the rows following
+        // the inserted rows don't match their items anymore.
+        invalidateItemLayouts(first);
         m_delayedLayoutTimer.start(10, this);
         emit busy(true);
     } else {
@@ -450,6 +453,7 @@ void IconView::rowsInserted(const QModelIndex &parent, int first, int last)
         QPoint pos = QPoint();
 
         m_items.insert(first, last - first + 1, ViewItem());
+        invalidateItemGrid();
 
         // If a single item was inserted and we have a saved position from a deleted file,
         // reuse that position.
@@ -457,6 +461,7 @@ void IconView::rowsInserted(const QModelIndex &parent, int first, int last)
             m_items[first].rect = QRect(m_lastDeletedPos, grid);
             m_items[first].layouted = true;
             m_items[first].needSizeAdjust = true;
+            updateItemGrid(first);
             markAreaDirty(m_items[first].rect);
             m_lastDeletedPos = QPoint();
             m_validRows = m_items.size();
@@ -469,6 +474,7 @@ void IconView::rowsInserted(const QModelIndex &parent, int first, int last)
             m_items[i].rect = QRect(pos, grid);
             m_items[i].layouted = true;
             m_items[i].needSizeAdjust = true;
+            updateItemGrid(i);
             markAreaDirty(m_items[i].rect);
         }
 
@@ -481,12 +487,13 @@ void IconView::rowsRemoved(const QModelIndex &parent, int first, int last)
 {
     Q_UNUSED(parent)
 
-    m_regionCache.clear();
+    invalidateItemGrid();
 
     if (!m_layoutBroken) {
         if (first < m_validRows) {
             m_validRows = 0;
         }
+        invalidateItemLayouts(first);
         if (m_model->rowCount() > 0) {
             m_delayedLayoutTimer.start(10, this);
             emit busy(true);
@@ -519,6 +526,7 @@ void IconView::modelReset()
     m_savedPositions.clear();
     m_layoutBroken = false;
     m_validRows = 0;
+    invalidateItemLayouts();
 
     m_delayedLayoutTimer.start(10, this);
     emit busy(true);
@@ -526,6 +534,9 @@ void IconView::modelReset()
 
 void IconView::layoutChanged()
 {
+    // The rows may have been reordered
+    invalidateItemLayouts();
+
     if (m_validRows > 0) {
         m_savedPositions.clear();
         m_layoutBroken = false;
@@ -543,15 +554,16 @@ void IconView::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottom
 {
     const QStyleOptionViewItemV4 option = viewOptions();
     const QSize grid = gridSize();
-    m_regionCache.clear();
 
     // Update the size of the items and center them in the grid cell
     for (int i = topLeft.row(); i <= bottomRight.row() && i < m_items.size(); i++) {
+        m_items[i].layout.clear();
         if (!m_items[i].layouted) {
             continue;
         }
         m_items[i].rect.setSize(grid);
         m_items[i].needSizeAdjust = true;
+        updateItemGrid(i);
         markAreaDirty(m_items[i].rect);
     }
 }
@@ -707,11 +719,8 @@ QPoint IconView::findNextEmptyPosition(const QPoint &prevPos, const QSize &gridS
         done = true;
         pos = nextGridPosition(pos, gridSize, contentRect);
         const QRect r(pos, gridSize);
-        for (int i = 0; i < m_items.count(); i++) {
-            if (m_items.at(i).layouted && m_items.at(i).rect.intersects(r)) {
-                done = false;
-                break;
-            }
+        if (!itemGrid().items(r).isEmpty()) {
+            done = false;
         }
     }
 
@@ -721,8 +730,10 @@ QPoint IconView::findNextEmptyPosition(const QPoint &prevPos, const QSize &gridS
 void IconView::layoutItems()
 {
     QStyleOptionViewItemV4 option = viewOptions();
-    m_items.resize(m_model->rowCount());
-    m_regionCache.clear();
+    if (m_items.size() != m_model->rowCount()) {
+        m_items.resize(m_model->rowCount());
+        invalidateItemGrid();
+    }
 
     const QRect visibleRect = mapToViewport(contentsRect()).toAlignedRect();
     const QRect rect = contentsRect().toRect();
@@ -770,6 +781,7 @@ void IconView::layoutItems()
                     m_items[i].rect = QRect(pos, grid);
                     m_items[i].layouted = true;
                     m_items[i].needSizeAdjust = true;
+                    updateItemGrid(i);
                     if (m_items[i].rect.intersects(visibleRect)) {
                         needUpdate = true;
                     }
@@ -779,6 +791,7 @@ void IconView::layoutItems()
                     m_items[i].rect = QRect(QPoint(), grid);
                     m_items[i].layouted = false;
                     m_items[i].needSizeAdjust = true;
+                    updateItemGrid(i);
                     m_needPostLayoutPass = true;
                 }
             }
@@ -796,6 +809,7 @@ void IconView::layoutItems()
                 m_items[i].rect = QRect(pos, grid);
                 m_items[i].layouted = true;
                 m_items[i].needSizeAdjust = true;
+                updateItemGrid(i);
                 if (m_items[i].rect.intersects(visibleRect)) {
                     needUpdate = true;
                 }
@@ -817,6 +831,7 @@ void IconView::layoutItems()
             pos = findNextEmptyPosition(pos, grid, rect);
             m_items[i].rect.moveTo(pos);
             m_items[i].layouted = true;
+            updateItemGrid(i);
             if (m_items[i].rect.intersects(visibleRect)) {
                 needUpdate = true;
             }
@@ -833,7 +848,7 @@ void IconView::layoutItems()
     }
 
     if (needUpdate) {
-        m_dirtyRegion = QRegion(visibleRect);
+        markAreaDirty(visibleRect);
         update();
     }
 
@@ -899,6 +914,7 @@ void IconView::alignIconsToGrid()
 
         if (pos != m_items[i].rect.topLeft()) {
             m_items[i].rect.moveTo(pos);
+            updateItemGrid(i);
             layoutChanged = true;
         }
     }
@@ -908,7 +924,6 @@ void IconView::alignIconsToGrid()
         markAreaDirty(visibleArea());
         m_layoutBroken = true;
         m_savedPositions.clear();
-        m_regionCache.clear();
     }
 }
 
@@ -927,6 +942,40 @@ QRect IconView::itemsBoundingRect() const
     return boundingRect;
 }
 
+const ItemGrid &IconView::itemGrid() const
+{
+    if (!m_itemGridValid) {
+        m_itemGrid.reset(gridSize() + QSize(10, 10));
+        for (int i = 0; i < m_items.size(); i++) {
+            if (m_items[i].layouted) {
+                m_itemGrid.setItemRect(i, m_items[i].rect);
+            }
+        }
+        m_itemGridValid = true;
+    }
+
+    return m_itemGrid;
+}
+
+void IconView::updateItemGrid(int row)
+{
+    if (m_itemGridValid) {
+        m_itemGrid.setItemRect(row, m_items[row].layouted ? m_items[row].rect : QRect());
+    }
+}
+
+void IconView::invalidateItemGrid()
+{
+    m_itemGridValid = false;
+}
+
+void IconView::invalidateItemLayouts(int first)
+{
+    for (int i = first; i < m_items.size(); i++) {
+        m_items[i].layout.clear();
+    }
+}
+
 bool IconView::doLayoutSanityCheck()
 {
     // Find the bounding rect of the items
@@ -957,6 +1006,7 @@ bool IconView::doLayoutSanityCheck()
                 m_items[i].rect.translate(delta);
             }
         }
+        invalidateItemGrid();
 
         // Adjust the bounding rect and the scrollbar value and range
         boundingRect = boundingRect.translated(delta) | cr;
@@ -971,7 +1021,6 @@ bool IconView::doLayoutSanityCheck()
             m_scrollBar->hide();
         }
 
-        m_regionCache.clear();
         return true;
     }
 
@@ -1034,11 +1083,11 @@ void IconView::finishedScrolling()
                     m_items[i].rect.translate(0, -deltaY);
                 }
             }
+            invalidateItemGrid();
             m_scrollBar->setValue(m_scrollBar->value() - deltaY);
             m_scrollBar->setRange(0, m_scrollBar->maximum() - deltaY);
             markAreaDirty(visibleArea());
             boundingRect.translate(0, -deltaY);
-            m_regionCache.clear();
         }
 
         // Remove any empty space below the visible area by adjusting the
@@ -1125,16 +1174,13 @@ void IconView::paintItem(QPainter *painter, const QStyleOptionViewItemV4 &option
         painter->drawPixmap(option.rect.topLeft(), from);
     }
 
-    qreal left, top, right, bottom;
-    m_itemFrame->getMargins(left, top, right, bottom);
-    const QRect r = option.rect.adjusted(left, top, -right, -bottom);
+    const ItemLayout &layout = itemLayout(option, index);
 
 
     // Draw the icon
     // =============
     QIcon icon = qvariant_cast<QIcon>(index.data(Qt::DecorationRole));
-    const QRect ir = QStyle::alignedRect(option.direction, Qt::AlignTop | Qt::AlignHCenter,
-                                         option.decorationSize, r);
+    const QRect ir = layout.iconRect.translated(option.rect.topLeft());
 
     if (selected) {
         const QColor color = option.palette.brush(QPalette::Normal, QPalette::Highlight).color();
@@ -1145,27 +1191,13 @@ void IconView::paintItem(QPainter *painter, const QStyleOptionViewItemV4 &option
 
     icon.paint(painter, ir);
 
-    const QRect tr = r.adjusted(0, ir.bottom() - r.top() + 2, 0, 0);
-
-    QFont font = option.font;
-
-    KFileItem item = qvariant_cast<KFileItem>(index.data(KDirModel::FileItemRole));
-    if (item.isLink()) {
-        font.setItalic(true);
-    }
+    const QRect tr = layout.textRect.translated(option.rect.topLeft());
+    const QSize size = layout.textSize;
 
     // Draw the text label
     // ===================
-    const QString text = index.data(Qt::DisplayRole).toString();
-
-    QTextLayout layout;
-    layout.setText(KStringHandler::preProcessWrap(text));
-    layout.setFont(font);
-    const QSize size = doTextLayout(layout, tr.size(), Qt::AlignHCenter,
-                                    QTextOption::WrapAtWordBoundaryOrAnywhere);
-
     painter->setPen(option.palette.color(QPalette::Text));
-    drawTextLayout(painter, layout, tr);
+    drawTextLayout(painter, layout.textLayout, tr);
 
 
     // Draw the focus rect
@@ -1201,6 +1233,58 @@ void IconView::paintItem(QPainter *painter, const QStyleOptionViewItemV4 &option
     }
 }
 
+const ItemLayout &IconView::itemLayout(const QStyleOptionViewItemV4 &option, const QModelIndex &index) const
+{
+    QSharedPointer<ItemLayout> &layout = m_items.at(index.row()).layout;
+    if (layout && layout->size == option.rect.size() && layout->decorationSize == option.decorationSize &&
+        layout->font == option.font && layout->direction == option.direction) {
+        return *layout;
+    }
+
+    layout = QSharedPointer<ItemLayout>(new ItemLayout);
+    layout->size = option.rect.size();
+    layout->decorationSize = option.decorationSize;
+    layout->font = option.font;
+    layout->direction = option.direction;
+
+    qreal left, top, right, bottom;
+    m_itemFrame->getMargins(left, top, right, bottom);
+
+    const QRect r = QRect(QPoint(), option.rect.size()).adjusted(left, top, -right, -bottom);
+    layout->iconRect = QStyle::alignedRect(option.direction, Qt::AlignTop | Qt::AlignHCenter,
+                                           option.decorationSize, r);
+    layout->textRect = r.adjusted(0, layout->iconRect.bottom() - r.top() + 2, 0, 0);
+
+    QFont font = option.font;
+
+    KFileItem item = qvariant_cast<KFileItem>(index.data(KDirModel::FileItemRole));
+    if (item.isLink()) {
+        font.setItalic(true);
+    }
+
+    const QString text = index.data(Qt::DisplayRole).toString();
+
+    layout->textLayout.setText(KStringHandler::preProcessWrap(text));
+    layout->textLayout.setFont(font);
+    layout->textSize = doTextLayout(layout->textLayout, layout->textRect.size(), Qt::AlignHCenter,
+                                    QTextOption::WrapAtWordBoundaryOrAnywhere);
+
+    // Extend the icon rect so it touches the text rect
+    QRect ir = layout->iconRect;
+    QRect tr = QStyle::alignedRect(layoutDirection(), Qt::AlignTop | Qt::AlignHCenter,
+                                   layout->textSize, layout->textRect);
+    if (ir.width() < tr.width()) {
+        ir.setBottom(tr.top());
+    } else {
+        tr.setTop(ir.bottom());
+    }
+
+    layout->region += ir;
+    layout->region += tr;
+
+    return *layout;
+}
+
 void IconView::paintMessage(QPainter *painter, const QRect &rect, const QString &message,
                             const QIcon &icon) const
 {
@@ -1227,99 +1311,87 @@ void IconView::paintMessage(QPainter *painter, const QRect &rect, const QString
     }
 }
 
-void IconView::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+void IconView::paintBackBuffer(QPainter *painter, const QRegion &region)
 {
-    Q_UNUSED(widget)
+    QStyleOptionViewItemV4 opt = viewOptions();
+    QSize oldDecorationSize;
 
-    int offset = m_scrollBar->value();
-    const QRect cr = contentsRect().toRect();
-    if (!cr.isValid()) {
-        return;
-    }
+    foreach (int i, itemGrid().items(region)) {
+        opt.rect = m_items[i].rect;
 
-    QRect clipRect = cr & option->exposedRect.toAlignedRect();
-    if (clipRect.isEmpty()) {
-        return;
-    }
-
-    prepareBackBuffer();
-
-    painter->setClipRect(clipRect, Qt::IntersectClip);
-
-    // Update the dirty region in the backbuffer
-    // =========================================
-    if (!m_dirtyRegion.isEmpty()) {
-        QStyleOptionViewItemV4 opt = viewOptions();
-        QSize oldDecorationSize;
-
-        QPainter p(&m_pixmap);
-        p.translate(-cr.topLeft() - QPoint(0, offset));
-        p.setClipRegion(m_dirtyRegion);
+        if (i >= m_validRows || !m_items[i].layouted || !region.intersects(opt.rect)) {
+            continue;
+        }
 
-        // Clear the dirty region
-        p.setCompositionMode(QPainter::CompositionMode_Source);
-        p.fillRect(mapToViewport(cr).toAlignedRect(), Qt::transparent);
-        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        const QModelIndex index = m_model->index(i, 0);
+        opt.state &= ~(QStyle::State_HasFocus | QStyle::State_MouseOver | QStyle::State_Selected);
 
-        for (int i = 0; i < m_validRows; i++) {
-            opt.rect = m_items[i].rect;
+        if (index == m_hoveredIndex) {
+            opt.state |= QStyle::State_MouseOver;
+        }
 
-            if (!m_items[i].layouted || !m_dirtyRegion.intersects(opt.rect)) {
+        if (m_selectionModel->isSelected(index)) {
+            if (m_dragInProgress) {
                 continue;
             }
+            opt.state |= QStyle::State_Selected;
+        }
 
-            const QModelIndex index = m_model->index(i, 0);
-            opt.state &= ~(QStyle::State_HasFocus | QStyle::State_MouseOver | QStyle::State_Selected);
-
-            if (index == m_hoveredIndex) {
-                opt.state |= QStyle::State_MouseOver;
-            }
+        if (hasFocus() && index == m_selectionModel->currentIndex()) {
+            opt.state |= QStyle::State_HasFocus;
+        }
 
-            if (m_selectionModel->isSelected(index)) {
-                if (m_dragInProgress) {
-                    continue;
-                }
-                opt.state |= QStyle::State_Selected;
-            }
+        if (m_items[i].needSizeAdjust) {
+            const QSize size = itemSize(opt, index);
+            m_items[i].rect.setHeight(size.height());
+            m_items[i].needSizeAdjust = false;
+            updateItemGrid(i);
+            opt.rect = m_items[i].rect;
+        }
 
-            if (hasFocus() && index == m_selectionModel->currentIndex()) {
-                opt.state |= QStyle::State_HasFocus;
-            }
+        if (m_pressedIndex == index && m_drawIconShrinked) {
+            opt.state |= QStyle::State_Sunken;
+            oldDecorationSize = opt.decorationSize;
+            opt.decorationSize *= 0.9;
+        }
 
-            if (m_items[i].needSizeAdjust) {
-                const QSize size = itemSize(opt, index);
-                m_items[i].rect.setHeight(size.height());
-                m_items[i].needSizeAdjust = false;
-                opt.rect = m_items[i].rect;
-            }
+        paintItem(painter, opt, index);
+        if (!oldDecorationSize.isEmpty()) {
+            opt.decorationSize = oldDecorationSize;
+            oldDecorationSize = QSize();
+        }
+    }
 
-            if (m_pressedIndex == index && m_drawIconShrinked) {
-                opt.state |= QStyle::State_Sunken;
-                oldDecorationSize = opt.decorationSize;
-                opt.decorationSize *= 0.9;
-            }
+    if (m_rubberBand.isValid())
+    {
+        QStyleOptionRubberBand opt;
+        initStyleOption(&opt);
+        opt.rect   = m_rubberBand;
+        opt.shape  = QRubberBand::Rectangle;
+        opt.opaque = false;
 
-            paintItem(&p, opt, index);
-            if (!oldDecorationSize.isEmpty()) {
-                opt.decorationSize = oldDecorationSize;
-                oldDecorationSize = QSize();
-            }
-        }
+        style()->drawControl(QStyle::CE_RubberBand, &opt, painter);
+    }
+}
 
-        if (m_rubberBand.isValid())
-        {
-            QStyleOptionRubberBand opt;
-            initStyleOption(&opt);
-            opt.rect   = m_rubberBand;
-            opt.shape  = QRubberBand::Rectangle;
-            opt.opaque = false;
+void IconView::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget)
 
-            style()->drawControl(QStyle::CE_RubberBand, &opt, &p);
-        }
+    const QRect cr = contentsRect().toRect();
+    if (!cr.isValid()) {
+        return;
+    }
 
-        m_dirtyRegion = QRegion();
+    QRect clipRect = cr & option->exposedRect.toAlignedRect();
+    if (clipRect.isEmpty()) {
+        return;
     }
 
+    prepareBackBuffer();
+
+    painter->setClipRect(clipRect, Qt::IntersectClip);
+
     syncBackBuffer(painter, clipRect);
 
     if (!m_errorMessage.isEmpty()) {
@@ -1369,8 +1441,8 @@ QModelIndex IconView::indexAt(const QPointF &point) const
         }
     }
 
-    for (int i = 0; i < m_validRows; i++) {
-        if (!m_items[i].layouted || !m_items[i].rect.contains(pt)) {
+    foreach (int i, itemGrid().items(QRect(pt, QSize(1, 1)))) {
+        if (i >= m_validRows || !m_items[i].layouted || !m_items[i].rect.contains(pt)) {
             continue;
         }
 
@@ -1396,47 +1468,15 @@ QRect IconView::visualRect(const QModelIndex &index) const
 
 QRegion IconView::visualRegion(const QModelIndex &index) const
 {
-    const quint64 key = index.row();
-    if (QRegion *region = m_regionCache.object(key)) {
-        return *region;
+    if (!index.isValid() || index.row() >= m_items.size()) {
+        return QRegion();
     }
 
     QStyleOptionViewItemV4 option = viewOptions();
     option.rect = m_items[index.row()].rect;
 
-    qreal left, top, right, bottom;
-    m_itemFrame->getMargins(left, top, right, bottom);
-
-    const QRect r = option.rect.adjusted(left, top, -right, -bottom);
-    QRect ir = QStyle::alignedRect(option.direction, Qt::AlignTop | Qt::AlignHCenter,
-                                   option.decorationSize, r);
-    QRect tr = r.adjusted(0, ir.bottom() - r.top() + 2, 0, 0);
-
-    KFileItem item = qvariant_cast<KFileItem>(index.data(KDirModel::FileItemRole));
-    QFont fnt = font();
-    if (item.isLink())
-        fnt.setBold(true);
-
-    QTextLayout layout;
-    layout.setText(index.data(Qt::DisplayRole).toString());
-    layout.setFont(font());
-    const QSize ts = doTextLayout(layout, tr.size(), Qt::AlignHCenter,
-                                  QTextOption::WrapAtWordBoundaryOrAnywhere);
-    tr = QStyle::alignedRect(layoutDirection(), Qt::AlignTop | Qt::AlignHCenter, ts, tr);
-
-    // Extend the icon rect so it touches the text rect
-    if (ir.width() < tr.width()) {
-        ir.setBottom(tr.top());
-    } else {
-        tr.setTop(ir.bottom());
-    }
-
-    QRegion region;
-    region += ir;
-    region += tr;
-
-    m_regionCache.insert(key, new QRegion(region));
-    return region;
+    const ItemLayout &layout = itemLayout(option, index);
+    return layout.region.translated(option.rect.topLeft());
 }
 
 void IconView::updateScrollBarGeometry()
@@ -1600,7 +1640,7 @@ void IconView::resizeEvent(QGraphicsSceneResizeEvent *e)
                 for (int i = 0; i < m_validRows; i++) {
                     m_items[i].rect.translate(dx, 0);
                 }
-                m_regionCache.clear();
+                invalidateItemGrid();
                 markAreaDirty(visibleArea());
             }
         }
@@ -1720,6 +1760,9 @@ void IconView::svgChanged()
         m_items[i].needSizeAdjust = true;
     }
 
+    // The margins of the item frame may have been changed
+    invalidateItemLayouts();
+
     // this updates the grid size, then calls layoutItems() which in turn repaints the view
     updateGridSize();
     updateActionButtons();
@@ -2451,12 +2494,12 @@ void IconView::dropEvent(QGraphicsSceneDragDropEvent *event)
     // Move the items
     foreach (const QModelIndex &index, indexes) {
         m_items[index.row()].rect.translate(delta);
+        updateItemGrid(index.row());
     }
 
     // Make sure no icons have negative coordinates etc.
     doLayoutSanityCheck();
     markAreaDirty(visibleArea());
-    m_regionCache.clear();
 
     m_layoutBroken = true;
     emit indexesMoved(indexes);
@@ -2544,7 +2587,7 @@ void IconView::changeEvent(QEvent *event)
                         m_items[i].rect.translate(delta);
                     }
                 }
-                m_regionCache.clear();
+                invalidateItemGrid();
                 markAreaDirty(mapToViewport(rect()).toAlignedRect());
                 updateScrollBar();
             }
@@ -2699,23 +2742,31 @@ void IconView::selectIconsInArea(const QRect &area, const QPoint &finalPos)
     QRect dirtyRect;
 
     // Select the indexes inside the area
+    // Consecutive rows are selected as one range
     QItemSelection selection;
-    for (int i = 0; i < m_items.size(); i++) {
-        QModelIndex index = m_model->index(i, 0);
+    int start = -1;
+    int end = -1;
+    foreach (int i, itemGrid().items(area)) {
+        const QModelIndex index = m_model->index(i, 0);
         if (!indexIntersectsRect(index, area))
             continue;
 
-        int start = i;
-
-        do {
-            dirtyRect |= m_items[i].rect;
-            if (m_items[i].rect.contains(finalPos) && visualRegion(index).contains(finalPos)) {
-               m_hoveredIndex = index;
-            }
-            index = m_model->index(++i, 0);
-        } while (i < m_items.size() && indexIntersectsRect(index, area));
+        dirtyRect |= m_items[i].rect;
+        if (m_items[i].rect.contains(finalPos) && visualRegion(index).contains(finalPos)) {
+           m_hoveredIndex = index;
+        }
 
-        selection.select(m_model->index(start, 0), m_model->index(i - 1, 0));
+        if (start != -1 && i != end + 1) {
+            selection.select(m_model->index(start, 0), m_model->index(end, 0));
+            start = -1;
+        }
+        if (start == -1) {
+            start = i;
+        }
+        end = i;
+    }
+    if (start != -1) {
+        selection.select(m_model->index(start, 0), m_model->index(end, 0));
     }
     m_selectionModel->select(selection, QItemSelectionModel::ToggleCurrent);
 
@@ -2864,9 +2915,9 @@ void IconView::timerEvent(QTimerEvent *event)
                 {
                     pos = findNextEmptyPosition(pos, grid, cr);
                     m_items[i].rect.moveTo(pos);
+                    updateItemGrid(i);
                 }
             }
-            m_regionCache.clear();
             markAreaDirty(visibleArea());
         } else {
             int maxWidth  = contentsRect().width();
@@ -25,10 +25,11 @@
 #include "popupview.h"
 #include "itemeditor.h"
 #include "actionoverlay.h"
+#include "itemgrid.h"
 
 #include <QAbstractItemDelegate>
 #include <QPointer>
-#include <QCache>
+#include <QSharedPointer>
 #include <QTime>
 #include <QBasicTimer>
 
@@ -46,10 +47,28 @@ namespace Plasma
     class ScrollBar;
 }
 
+// The geometry and the text layout of an item, which are shared by painting and
+// hit-testing. The rects and the region are relative to the top left corner of the
+// item rect, so the layout remains valid when the item is moved.
+struct ItemLayout
+{
+    QSize size;
+    QSize decorationSize;
+    QFont font;
+    Qt::LayoutDirection direction;
+    QRect iconRect;
+    QRect textRect;
+    QSize textSize;
+    QRegion region;
+    QTextLayout textLayout;
+};
+
 struct ViewItem
 {
     ViewItem() : rect(QRect()), layouted(false), needSizeAdjust(true) {}
     QRect rect;
+    // Created on demand by IconView::itemLayout()
+    mutable QSharedPointer<ItemLayout> layout;
     bool layouted:1;
     bool needSizeAdjust:1;
 };
@@ -187,7 +206,9 @@ protected:
     void finishedScrolling();
 
     QSize itemSize(const QStyleOptionViewItemV4 &option, const QModelIndex &index) const;
+    const ItemLayout &itemLayout(const QStyleOptionViewItemV4 &option, const QModelIndex &index) const;
     void paintItem(QPainter *painter, const QStyleOptionViewItemV4 &option, const QModelIndex &index) const;
+    void paintBackBuffer(QPainter *painter, const QRegion &region);
 
 public slots:
     void renameSelectedIcon();
@@ -237,10 +258,22 @@ private:
     void repaintSelectedIcons();
     QRect selectedItemsBoundingRect() const;
 
+    // The item grid is rebuilt on demand after invalidateItemGrid() has been called.
+    // updateItemGrid() must be called when the rect or the layouted flag of an item
+    // has been changed, as long as the rows of the items stay the same.
+    const ItemGrid &itemGrid() const;
+    void updateItemGrid(int row);
+    void invalidateItemGrid();
+
+    // Discards the item layouts of the rows starting with first. This is required when
+    // the rows of the model have been changed without changing m_items accordingly.
+    void invalidateItemLayouts(int first = 0);
+
 private:
     QVector<ViewItem> m_items;
     QHash<QString, QPoint> m_savedPositions;
-    mutable QCache<quint64, QRegion> m_regionCache;
+    mutable ItemGrid m_itemGrid;
+    mutable bool m_itemGridValid;
     qreal m_margins[4];
     int m_columns;
     int m_rows;
@@ -0,0 +1,159 @@
+/*
+ *   Copyright © 2026 agent <agent@local>
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Library General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Library General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Library General Public License
+ *   along with this library; see the file COPYING.LIB.  If not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#include "itemgrid.h"
+
+#include <qalgorithms.h>
+
+#include <algorithm>
+
+ItemGrid::ItemGrid()
+    : m_cellSize(100, 100),
+      m_itemCount(0)
+{
+}
+
+void ItemGrid::reset(const QSize &cellSize)
+{
+    m_cellSize = cellSize.expandedTo(QSize(1, 1));
+    m_rects.clear();
+    m_cells.clear();
+    m_itemCount = 0;
+}
+
+int ItemGrid::cellColumn(int x) const
+{
+    // Round towards negative infinity, items may have negative coordinates
+    return x >= 0 ? x / m_cellSize.width() : -((-x - 1) / m_cellSize.width()) - 1;
+}
+
+int ItemGrid::cellRow(int y) const
+{
+    return y >= 0 ? y / m_cellSize.height() : -((-y - 1) / m_cellSize.height()) - 1;
+}
+
+quint64 ItemGrid::cellKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+void ItemGrid::setItemRect(int row, const QRect &rect)
+{
+    if (row >= m_rects.size()) {
+        if (rect.isNull()) {
+            return;
+        }
+        m_rects.resize(row + 1);
+    }
+
+    const QRect oldRect = m_rects.at(row);
+    if (oldRect == rect) {
+        return;
+    }
+
+    if (!oldRect.isNull()) {
+        for (int y = cellRow(oldRect.top()); y <= cellRow(oldRect.bottom()); y++) {
+            for (int x = cellColumn(oldRect.left()); x <= cellColumn(oldRect.right()); x++) {
+                QHash<quint64, QVector<int> >::iterator it = m_cells.find(cellKey(x, y));
+                if (it == m_cells.end()) {
+                    continue;
+                }
+                QVector<int> &rows = it.value();
+                const int pos = rows.indexOf(row);
+                if (pos != -1) {
+                    rows.remove(pos);
+                }
+                if (rows.isEmpty()) {
+                    m_cells.erase(it);
+                }
+            }
+        }
+        m_itemCount--;
+    }
+
+    m_rects[row] = rect;
+
+    if (!rect.isNull()) {
+        for (int y = cellRow(rect.top()); y <= cellRow(rect.bottom()); y++) {
+            for (int x = cellColumn(rect.left()); x <= cellColumn(rect.right()); x++) {
+                m_cells[cellKey(x, y)].append(row);
+            }
+        }
+        m_itemCount++;
+    }
+}
+
+void ItemGrid::collectItems(const QRect &rect, QVector<int> *rows) const
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    const int left = cellColumn(rect.left());
+    const int right = cellColumn(rect.right());
+    const int top = cellRow(rect.top());
+    const int bottom = cellRow(rect.bottom());
+
+    if (qint64(right - left + 1) * (bottom - top + 1) > m_itemCount) {
+        // The area covers more cells than there are items
+        for (int row = 0; row < m_rects.size(); row++) {
+            if (!m_rects.at(row).isNull() && m_rects.at(row).intersects(rect)) {
+                rows->append(row);
+            }
+        }
+        return;
+    }
+
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            QHash<quint64, QVector<int> >::const_iterator it = m_cells.constFind(cellKey(x, y));
+            if (it == m_cells.constEnd()) {
+                continue;
+            }
+            foreach (int row, it.value()) {
+                if (m_rects.at(row).intersects(rect)) {
+                    rows->append(row);
+                }
+            }
+        }
+    }
+}
+
+QVector<int> ItemGrid::items(const QRect &rect) const
+{
+    QVector<int> rows;
+    collectItems(rect, &rows);
+
+    // Items that span several cells are found more than once
+    qSort(rows);
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+QVector<int> ItemGrid::items(const QRegion &region) const
+{
+    QVector<int> rows;
+    foreach (const QRect &rect, region.rects()) {
+        collectItems(rect, &rows);
+    }
+
+    qSort(rows);
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
@@ -0,0 +1,74 @@
+/*
+ *   Copyright © 2026 agent <agent@local>
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Library General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Library General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Library General Public License
+ *   along with this library; see the file COPYING.LIB.  If not, write to
+ *   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *   Boston, MA 02110-1301, USA.
+ */
+
+#ifndef ITEMGRID_H
+#define ITEMGRID_H
+
+#include <QHash>
+#include <QRect>
+#include <QRegion>
+#include <QSize>
+#include <QVector>
+
+/**
+ * A uniform grid over the item rects of a view, which allows looking up
+ * the items at a position or in an area without walking all items.
+ *
+ * Every item is stored in each cell its rect intersects. The items are
+ * identified by their row.
+ */
+class ItemGrid
+{
+public:
+    ItemGrid();
+
+    /**
+     * Removes all items and sets the size of the cells.
+     */
+    void reset(const QSize &cellSize);
+    QSize cellSize() const { return m_cellSize; }
+
+    /**
+     * Sets the rect of the item in @p row. The item is removed
+     * from the grid when @p rect is null.
+     */
+    void setItemRect(int row, const QRect &rect);
+    void removeItem(int row) { setItemRect(row, QRect()); }
+
+    /**
+     * Returns the rows of the items that intersect @p rect or
+     * @p region in ascending order.
+     */
+    QVector<int> items(const QRect &rect) const;
+    QVector<int> items(const QRegion &region) const;
+
+private:
+    int cellColumn(int x) const;
+    int cellRow(int y) const;
+    static quint64 cellKey(int column, int row);
+    void collectItems(const QRect &rect, QVector<int> *rows) const;
+
+private:
+    QSize m_cellSize;
+    QVector<QRect> m_rects;
+    QHash<quint64, QVector<int> > m_cells;
+    int m_itemCount;
+};
+
+#endif
@@ -330,75 +330,70 @@ void ListView::paintItem(QPainter *painter, const QStyleOptionViewItemV4 &option
     }
 }
 
-void ListView::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+void ListView::paintBackBuffer(QPainter *painter, const QRegion &region)
 {
-    Q_UNUSED(widget)
-
     const QRect cr = contentsRect().toRect();
-    if (!cr.isValid()) {
-        return;
-    }
+    QStyleOptionViewItemV4 opt = viewOptions();
+    int width = m_scrollBar->isVisible() ? cr.width() - m_scrollBar->geometry().width() : cr.width();
 
+    if (m_rowHeight == -1 && m_model->rowCount() > 0) {
+        // Use the height of the first item for all items
+        const QSize size = itemSize(opt, m_model->index(0, 0));
+        m_rowHeight = size.height();
+    }
 
-    QRect clipRect = cr & option->exposedRect.toAlignedRect();
-    if (clipRect.isEmpty()) {
+    if (m_rowHeight <= 0) {
         return;
     }
-    int offset = m_scrollBar->value();
-
-    prepareBackBuffer();
-
-    painter->setClipRect(clipRect);
 
+    // All rows have the same height, so only the rows in the region are visited
+    const QRect boundingRect = region.boundingRect();
+    const int first = qMax(0, (boundingRect.top() - cr.top()) / m_rowHeight);
+    const int last = qMin(m_model->rowCount() - 1, (boundingRect.bottom() - cr.top()) / m_rowHeight);
 
-    // Update the dirty region in the backbuffer
-    // =========================================
-    if (!m_dirtyRegion.isEmpty()) {
-        QStyleOptionViewItemV4 opt = viewOptions();
-        int width = m_scrollBar->isVisible() ? cr.width() - m_scrollBar->geometry().width() : cr.width();
+    for (int i = first; i <= last; i++) {
+        opt.rect = QRect(cr.left(), cr.top() + i * m_rowHeight, width, m_rowHeight);
 
-        if (m_rowHeight == -1 && m_model->rowCount() > 0) {
-            // Use the height of the first item for all items
-            const QSize size = itemSize(opt, m_model->index(0, 0));
-            m_rowHeight = size.height();
+        if (!region.intersects(opt.rect)) {
+            continue;
         }
 
-        QPainter p(&m_pixmap);
-        p.translate(-cr.topLeft() - QPoint(0, offset));
-        p.setClipRegion(m_dirtyRegion);
+        const QModelIndex index = m_model->index(i, 0);
+        opt.state &= ~(QStyle::State_HasFocus | QStyle::State_MouseOver | QStyle::State_Selected);
 
-        // Clear the dirty region
-        p.setCompositionMode(QPainter::CompositionMode_Source);
-        p.fillRect(mapToViewport(cr).toAlignedRect(), Qt::transparent);
-        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
-
-        for (int i = 0; i < m_model->rowCount(); i++) {
-            opt.rect = QRect(cr.left(), cr.top() + i * m_rowHeight, width, m_rowHeight);
-
-            if (!m_dirtyRegion.intersects(opt.rect)) {
+        if (m_selectionModel->isSelected(index)) {
+            if (m_dragInProgress) {
                 continue;
             }
+            opt.state |= QStyle::State_Selected | QStyle::State_MouseOver;
+        }
 
-            const QModelIndex index = m_model->index(i, 0);
-            opt.state &= ~(QStyle::State_HasFocus | QStyle::State_MouseOver | QStyle::State_Selected);
+        if (hasFocus() && index == m_selectionModel->currentIndex()) {
+            opt.state |= QStyle::State_HasFocus;
+        }
 
-            if (m_selectionModel->isSelected(index)) {
-                if (m_dragInProgress) {
-                    continue;
-                }
-                opt.state |= QStyle::State_Selected | QStyle::State_MouseOver;
-            }
- 
-            if (hasFocus() && index == m_selectionModel->currentIndex()) {
-                opt.state |= QStyle::State_HasFocus;
-            }
+        paintItem(painter, opt, index);
+    }
+}
 
-            paintItem(&p, opt, index);
-        }
+void ListView::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget)
+
+    const QRect cr = contentsRect().toRect();
+    if (!cr.isValid()) {
+        return;
+    }
 
-        m_dirtyRegion = QRegion();
+    QRect clipRect = cr & option->exposedRect.toAlignedRect();
+    if (clipRect.isEmpty()) {
+        return;
     }
 
+    prepareBackBuffer();
+
+    painter->setClipRect(clipRect);
+
     syncBackBuffer(painter, clipRect);
 }
 
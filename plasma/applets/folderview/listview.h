@@ -62,6 +62,7 @@ protected:
 
     QSize itemSize(const QStyleOptionViewItemV4 &option, const QModelIndex &index) const;
     void paintItem(QPainter *painter, const QStyleOptionViewItemV4 &option, const QModelIndex &index) const;
+    void paintBackBuffer(QPainter *painter, const QRegion &region);
     
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
 
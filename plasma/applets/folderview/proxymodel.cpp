@@ -36,7 +36,8 @@ ProxyModel::ProxyModel(QObject *parent)
       m_filterMode(NoFilter),
       m_sortDirsFirst(true),
       m_parseDesktopFiles(false),
-      m_patternMatchAll(true)
+      m_patternMatchAll(true),
+      m_sortRanksValid(false)
 {
     setSupportedDragActions(Qt::CopyAction | Qt::MoveAction | Qt::LinkAction);
 }
@@ -45,6 +46,32 @@ ProxyModel::~ProxyModel()
 {
 }
 
+void ProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (this->sourceModel()) {
+        disconnect(this->sourceModel(), 0, this, 0);
+    }
+
+    invalidateSortKeys();
+
+    // The sort keys must be updated before QSortFilterProxyModel handles
+    // the changes, so the connections are made before it makes its own.
+    if (sourceModel) {
+        connect(sourceModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                SLOT(sourceRowsInserted(QModelIndex,int,int)));
+        connect(sourceModel, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                SLOT(sourceRowsRemoved(QModelIndex,int,int)));
+        connect(sourceModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                SLOT(sourceDataChanged(QModelIndex,QModelIndex)));
+        connect(sourceModel, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+                SLOT(invalidateSortKeys()));
+        connect(sourceModel, SIGNAL(layoutChanged()), SLOT(invalidateSortKeys()));
+        connect(sourceModel, SIGNAL(modelReset()), SLOT(invalidateSortKeys()));
+    }
+
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
 void ProxyModel::setFilterMode(FilterMode filterMode)
 {
     m_filterMode = filterMode;
@@ -100,7 +127,17 @@ bool ProxyModel::sortDirectoriesFirst() const
 
 void ProxyModel::setParseDesktopFiles(bool enable)
 {
+    if (m_parseDesktopFiles == enable) {
+        return;
+    }
+
     m_parseDesktopFiles = enable;
+
+    // Whether a desktop file is a folder has to be determined again,
+    // but the order of the names is still valid
+    for (int i = 0; i < m_sortKeys.count(); i++) {
+        m_sortKeys[i].fields = 0;
+    }
 }
 
 bool ProxyModel::parseDesktopFiles() const
@@ -145,85 +182,227 @@ bool ProxyModel::isDir(const QModelIndex &index, const KDirModel *dirModel) cons
     return false;
 }
 
-#include <KDebug>
-bool ProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+const ProxyModel::SortKey &ProxyModel::sortKey(const QModelIndex &index, int fields, SortKey *scratch) const
 {
     const KDirModel *dirModel = static_cast<KDirModel*>(sourceModel());
 
+    SortKey *key = scratch;
+    if (!index.parent().isValid()) {
+        if (m_sortKeys.count() != dirModel->rowCount()) {
+            m_sortKeys = QVector<SortKey>(dirModel->rowCount());
+            m_sortRanksValid = false;
+        }
+        key = &m_sortKeys[index.row()];
+    }
+
+    if (!(key->fields & BaseFields)) {
+        const KFileItem item = dirModel->itemForIndex(index);
+        const KDateTime time = item.time(KFileItem::ModificationTime);
+
+        key->isDir = isDir(index, dirModel);
+        key->size = item.size();
+        key->modificationTime = time.isValid() ? qint64(time.toTime_t()) : -1;
+        key->text = item.text();
+        key->name = item.name();
+        key->url = item.url().url();
+        key->fields = BaseFields;
+    }
+
+    // Only folders are compared using the number of items in them
+    if ((fields & ChildCountField) && !(key->fields & ChildCountField) && key->isDir) {
+        key->childCount = dirModel->data(index, KDirModel::ChildCountRole).toInt();
+        key->fields |= ChildCountField;
+    }
+
+    // KDirModel::data(index, Qt::DisplayRole) returns the data in index.column()
+    if ((fields & TypeField) && !(key->fields & TypeField)) {
+        key->type = dirModel->data(index, Qt::DisplayRole).toString();
+        key->fields |= TypeField;
+    }
+
+    return *key;
+}
+
+// The following code is taken from dolphin/src/kfileitemmodel.cpp
+// and ensures that the sorting order is always determined
+// Copyright (C) 2011 by Peter Penz <peter.penz91@gmail.com>
+int ProxyModel::naturalCompare(const SortKey *left, const SortKey *right)
+{
+    int result = KStringHandler::naturalCompare(left->text, right->text, Qt::CaseSensitive);
+
+    if (result != 0)
+        return result;
+
+    result = KStringHandler::naturalCompare(left->name, right->name, Qt::CaseSensitive);
+
+    if (result != 0)
+        return result;
+
+    return QString::compare(left->url, right->url, Qt::CaseSensitive);
+}
+
+bool ProxyModel::naturalLessThan(const SortKey *left, const SortKey *right)
+{
+    return naturalCompare(left, right) < 0;
+}
+
+bool ProxyModel::rankLessThan(const SortKey *left, const SortKey *right)
+{
+    return left->rank < right->rank;
+}
+
+// The natural comparison of the names is by far the most expensive part of
+// sorting, so the position of each row in the natural order is determined
+// once and the ranks are compared instead. Rows that have been inserted or
+// changed since the last update are merged into the existing order.
+void ProxyModel::updateSortRanks() const
+{
+    const KDirModel *dirModel = static_cast<KDirModel*>(sourceModel());
+    const int count = dirModel->rowCount();
+
+    if (m_sortKeys.count() != count) {
+        m_sortKeys = QVector<SortKey>(count);
+    }
+
+    QVector<SortKey*> ranked;
+    QVector<SortKey*> unranked;
+    ranked.reserve(count);
+
+    for (int row = 0; row < count; row++) {
+        SortKey *key = &m_sortKeys[row];
+        if (!(key->fields & BaseFields)) {
+            sortKey(dirModel->index(row, KDirModel::Name), BaseFields, 0);
+        }
+
+        if (key->rank >= 0) {
+            ranked.append(key);
+        } else {
+            unranked.append(key);
+        }
+    }
+
+    qSort(ranked.begin(), ranked.end(), rankLessThan);
+    qSort(unranked.begin(), unranked.end(), naturalLessThan);
+
+    int rank = 0;
+    SortKey * const *pos = ranked.constBegin();
+    foreach (SortKey *key, unranked) {
+        SortKey * const *end = qUpperBound(pos, ranked.constEnd(), key, naturalLessThan);
+        for (; pos != end; ++pos) {
+            (*pos)->rank = rank++;
+        }
+        key->rank = rank++;
+    }
+    for (; pos != ranked.constEnd(); ++pos) {
+        (*pos)->rank = rank++;
+    }
+
+    m_sortRanksValid = true;
+}
+
+bool ProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (!m_sortRanksValid) {
+        updateSortRanks();
+    }
+
+    const int column = left.column();
+    int fields = BaseFields;
+    if (column == KDirModel::Size) {
+        fields |= ChildCountField;
+    } else if (column == KDirModel::Type) {
+        fields |= TypeField;
+    }
+
+    SortKey leftScratch;
+    SortKey rightScratch;
+    const SortKey &leftKey = sortKey(left, fields, &leftScratch);
+    const SortKey &rightKey = sortKey(right, fields, &rightScratch);
+
     // When sorting by size, folders are compared using the number of items in them,
     // so they need to be given precedence over regular files as the comparison criteria is different
-    if (m_sortDirsFirst || left.column() == KDirModel::Size) {
-        bool leftIsDir = isDir(left, dirModel);
-        bool rightIsDir = isDir(right, dirModel);
-        if (leftIsDir && !rightIsDir) {
+    if (m_sortDirsFirst || column == KDirModel::Size) {
+        if (leftKey.isDir && !rightKey.isDir) {
             return (sortOrder() == Qt::AscendingOrder); // folders > files independent of the sorting order
         }
-        if (!leftIsDir && rightIsDir) {
+        if (!leftKey.isDir && rightKey.isDir) {
             return (sortOrder() == Qt::DescendingOrder); // same here
         }
     }
 
-    const KFileItem leftItem = dirModel->data(left, KDirModel::FileItemRole).value<KFileItem>();
-    const KFileItem rightItem = dirModel->data(right, KDirModel::FileItemRole).value<KFileItem>();
-    const int column = left.column();
     int result = 0;
 
     switch (column) {
-      case KDirModel::Name:
-            // fall through to the naturalCompare call
+        case KDirModel::Name:
+            // fall through to the natural comparison
             break;
-        case KDirModel::ModifiedTime: {
-            const KDateTime leftTime = leftItem.time(KFileItem::ModificationTime);
-            const KDateTime rightTime = rightItem.time(KFileItem::ModificationTime);
-            if (leftTime < rightTime)
+        case KDirModel::ModifiedTime:
+            if (leftKey.modificationTime < rightKey.modificationTime)
                 result = -1;
-            else if (leftTime > rightTime)
+            else if (leftKey.modificationTime > rightKey.modificationTime)
                 result = +1;
             break;
-            }
-        case KDirModel::Size: {
-            if (isDir(left, dirModel) && isDir(right, dirModel)) {
-                const int leftChildCount = dirModel->data(left, KDirModel::ChildCountRole).toInt();
-                const int rightChildCount = dirModel->data(right, KDirModel::ChildCountRole).toInt();
-                if (leftChildCount < rightChildCount)
+        case KDirModel::Size:
+            if (leftKey.isDir && rightKey.isDir) {
+                if (leftKey.childCount < rightKey.childCount)
                     result = -1;
-                else if (leftChildCount > rightChildCount)
+                else if (leftKey.childCount > rightKey.childCount)
                     result = +1;
             } else {
-                const KIO::filesize_t leftSize = leftItem.size();
-                const KIO::filesize_t rightSize = rightItem.size();
-                if (leftSize < rightSize)
+                if (leftKey.size < rightKey.size)
                     result = -1;
-                else if (leftSize > rightSize)
+                else if (leftKey.size > rightKey.size)
                     result = +1;
             }
             break;
-            }
         case KDirModel::Type:
             // add other sorting modes here
-            // KDirModel::data(index, Qt::DisplayRole) returns the data in index.column()
-            result = QString::compare(dirModel->data(left, Qt::DisplayRole).toString(),
-                                      dirModel->data(right, Qt::DisplayRole).toString());
+            result = QString::compare(leftKey.type, rightKey.type);
             break;
     }
 
     if (result != 0)
         return result < 0;
 
-    // The following code is taken from dolphin/src/kfileitemmodel.cpp
-    // and ensures that the sorting order is always determined
-    // Copyright (C) 2011 by Peter Penz <peter.penz91@gmail.com>
-    result = KStringHandler::naturalCompare(leftItem.text(), rightItem.text(), Qt::CaseSensitive);
+    if (leftKey.rank >= 0 && rightKey.rank >= 0)
+        return leftKey.rank < rightKey.rank;
 
-    if (result != 0)
-        return result < 0;
+    return naturalCompare(&leftKey, &rightKey) < 0;
+}
 
-    result = KStringHandler::naturalCompare(leftItem.name(), rightItem.name(), Qt::CaseSensitive);
+void ProxyModel::sourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (!parent.isValid() && first <= m_sortKeys.count()) {
+        m_sortKeys.insert(first, last - first + 1, SortKey());
+    }
+    m_sortRanksValid = false;
+}
 
-    if (result != 0)
-        return result < 0;
+void ProxyModel::sourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    // The ranks of the remaining rows are still in the natural order
+    if (!parent.isValid() && first < m_sortKeys.count()) {
+        m_sortKeys.remove(first, qMin(last, m_sortKeys.count() - 1) - first + 1);
+    }
+}
+
+void ProxyModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (topLeft.parent().isValid()) {
+        return;
+    }
 
-    return QString::compare(leftItem.url().url(), rightItem.url().url(), Qt::CaseSensitive);
+    const int last = qMin(bottomRight.row(), m_sortKeys.count() - 1);
+    for (int row = topLeft.row(); row <= last; row++) {
+        m_sortKeys[row] = SortKey();
+        m_sortRanksValid = false;
+    }
+}
+
+void ProxyModel::invalidateSortKeys()
+{
+    m_sortKeys.clear();
+    m_sortRanksValid = false;
 }
 
 inline bool ProxyModel::matchMimeType(const KFileItem &item) const
@@ -269,3 +448,4 @@ bool ProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent
     }
 }
 
+#include "proxymodel.moc"
@@ -24,6 +24,9 @@
 #include <QStringList>
 #include <QSet>
 #include <QRegExp>
+#include <QVector>
+
+#include <kio/global.h>
 
 class KDirModel;
 class KFileItem;
@@ -31,6 +34,8 @@ class KUrl;
 
 class ProxyModel : public QSortFilterProxyModel
 {
+    Q_OBJECT
+
 public:
     enum FilterMode {
         NoFilter = 0,
@@ -41,6 +46,8 @@ public:
     ProxyModel(QObject *parent = 0);
     ~ProxyModel();
 
+    void setSourceModel(QAbstractItemModel *sourceModel);
+
     void setFilterMode(FilterMode filterMode);
     FilterMode filterMode() const;
 
@@ -66,7 +73,42 @@ protected:
     bool matchMimeType(const KFileItem &item) const;
     bool matchPattern(const KFileItem &item) const;
 
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void invalidateSortKeys();
+
 private:
+    enum SortKeyField {
+        BaseFields      = 1,
+        ChildCountField = 2,
+        TypeField       = 4
+    };
+
+    // The sort criteria of a source row. The fields are determined when
+    // they are needed for a comparison for the first time.
+    struct SortKey {
+        SortKey() : fields(0), rank(-1), isDir(false), childCount(0), size(KIO::invalidFilesize), modificationTime(0) {}
+
+        int fields;
+        int rank;               // Position in the natural order of the names, or -1
+        bool isDir;
+        int childCount;
+        KIO::filesize_t size;   // KIO::invalidFilesize if unknown
+        qint64 modificationTime;
+        QString text;
+        QString name;
+        QString url;
+        QString type;
+    };
+
+    const SortKey &sortKey(const QModelIndex &index, int fields, SortKey *scratch) const;
+    void updateSortRanks() const;
+    static int naturalCompare(const SortKey *left, const SortKey *right);
+    static bool naturalLessThan(const SortKey *left, const SortKey *right);
+    static bool rankLessThan(const SortKey *left, const SortKey *right);
+
     FilterMode m_filterMode;
     QSet<QString> m_mimeSet;
     QList<QRegExp> m_regExps;
@@ -74,6 +116,8 @@ private:
     bool m_sortDirsFirst;
     bool m_parseDesktopFiles;
     bool m_patternMatchAll;
+    mutable QVector<SortKey> m_sortKeys;
+    mutable bool m_sortRanksValid;
 };
 
 #endif